@@ -63,10 +63,22 @@ static guint  suspend_counter = 0;
 /* Some code foolishly uses 0 instead of NO_COMPONENT, so we start with 1. */
 static gint   next_component_id = 1;
 static GList *components = NULL;
+/* component id --> ComponentInfo, for the lookups by id */
+static GHashTable *components_by_id = NULL;
 
 static ComponentEventInfo changes = { NULL, NULL, FALSE };
 static ComponentEventInfo changes_backup = { NULL, NULL, FALSE };
 
+/* Reverse index of the components' watches, so a refresh only looks at
+ * the components watching something that changed.
+ * watched_entities: GncGUID --> GList of ComponentInfo
+ * watched_types:    entity type (string cache) --> GList of ComponentInfo */
+static GHashTable *watched_entities = NULL;
+static GHashTable *watched_types = NULL;
+
+/* component class --> GNCComponentRefreshStats */
+static GHashTable *refresh_stats = NULL;
+
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_GUI;
@@ -252,6 +264,89 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
         *mask = event_mask;
 }
 
+static void
+index_watch (GHashTable *index, gconstpointer key, ComponentInfo *ci)
+{
+    GList *list;
+
+    if (!index)
+        return;
+
+    list = g_hash_table_lookup (index, key);
+    if (list)
+    {
+        /* the head stays the same, so the entry doesn't change */
+        list = g_list_append (list, ci);
+        return;
+    }
+
+    if (index == watched_entities)
+    {
+        GncGUID *guid = guid_malloc ();
+        *guid = *(const GncGUID *) key;
+        key = guid;
+    }
+    else
+        key = qof_string_cache_insert (key);
+
+    g_hash_table_insert (index, (gpointer) key, g_list_prepend (NULL, ci));
+}
+
+static void
+unindex_watch (GHashTable *index, gconstpointer key, ComponentInfo *ci)
+{
+    gpointer orig_key;
+    gpointer value;
+    GList *list;
+
+    if (!index || !g_hash_table_lookup_extended (index, key, &orig_key, &value))
+        return;
+
+    list = g_list_remove (value, ci);
+    if (list)
+    {
+        g_hash_table_insert (index, orig_key, list);
+        return;
+    }
+
+    g_hash_table_remove (index, key);
+    if (index == watched_entities)
+        guid_free (orig_key);
+    else
+        qof_string_cache_remove (orig_key);
+}
+
+static void
+unindex_entity_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    unindex_watch (watched_entities, key, user_data);
+}
+
+static void
+unindex_type_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    unindex_watch (watched_types, key, user_data);
+}
+
+static gboolean
+destroy_index_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    if (user_data == watched_entities)
+        guid_free (key);
+    else
+        qof_string_cache_remove (key);
+    g_list_free (value);
+
+    return TRUE;
+}
+
+static void
+destroy_index (GHashTable *index)
+{
+    g_hash_table_foreach_remove (index, destroy_index_helper, index);
+    g_hash_table_destroy (index);
+}
+
 static void
 gnc_cm_event_handler (QofInstance *entity,
                       QofEventId event_type,
@@ -285,6 +380,16 @@ gnc_cm_event_handler (QofInstance *entity,
 
 static gint handler_id;
 
+static void
+log_refresh_stats_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    GNCComponentRefreshStats *stats = value;
+
+    PINFO ("%s: %u refreshes, %" G_GINT64_FORMAT " us total, %"
+           G_GINT64_FORMAT " us max", (const char *) key, stats->refreshes,
+           stats->total_usecs, stats->max_usecs);
+}
+
 void
 gnc_component_manager_init (void)
 {
@@ -300,6 +405,12 @@ gnc_component_manager_init (void)
     changes_backup.event_masks = g_hash_table_new (g_str_hash, g_str_equal);
     changes_backup.entity_events = guid_hash_table_new ();
 
+    watched_entities = guid_hash_table_new ();
+    watched_types = g_hash_table_new (g_str_hash, g_str_equal);
+
+    refresh_stats = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, g_free);
+
     handler_id = qof_event_register_handler (gnc_cm_event_handler, NULL);
 }
 
@@ -324,23 +435,27 @@ gnc_component_manager_shutdown (void)
     destroy_event_hash (changes_backup.entity_events);
     changes_backup.entity_events = NULL;
 
+    destroy_index (watched_entities);
+    watched_entities = NULL;
+
+    destroy_index (watched_types);
+    watched_types = NULL;
+
+    g_hash_table_foreach (refresh_stats, log_refresh_stats_helper, NULL);
+    g_hash_table_destroy (refresh_stats);
+    refresh_stats = NULL;
+
     qof_event_unregister_handler (handler_id);
 }
 
 static ComponentInfo *
 find_component (gint component_id)
 {
-    GList *node;
-
-    for (node = components; node; node = node->next)
-    {
-        ComponentInfo *ci = node->data;
-
-        if (ci->component_id == component_id)
-            return ci;
-    }
+    if (!components_by_id)
+        return NULL;
 
-    return NULL;
+    return g_hash_table_lookup (components_by_id,
+                                GINT_TO_POINTER (component_id));
 }
 
 static GList *
@@ -410,6 +525,9 @@ gnc_register_gui_component_internal (const char * component_class)
     ci->session = NULL;
 
     components = g_list_prepend (components, ci);
+    if (!components_by_id)
+        components_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_hash_table_insert (components_by_id, GINT_TO_POINTER (component_id), ci);
 
     /* update id for next registration */
     next_component_id = component_id + 1;
@@ -465,6 +583,14 @@ gnc_gui_component_watch_entity (gint component_id,
         return;
     }
 
+    if (event_mask == 0)
+    {
+        if (g_hash_table_lookup (ci->watch_info.entity_events, entity))
+            unindex_watch (watched_entities, entity, ci);
+    }
+    else if (!g_hash_table_lookup (ci->watch_info.entity_events, entity))
+        index_watch (watched_entities, entity, ci);
+
     add_event (&ci->watch_info, entity, event_mask, FALSE);
 }
 
@@ -482,6 +608,12 @@ gnc_gui_component_watch_entity_type (gint component_id,
         return;
     }
 
+    /* The type stays indexed even if the mask becomes 0, just as it
+     * stays in event_masks; the mask is checked when matching. */
+    if (entity_type &&
+            !g_hash_table_lookup (ci->watch_info.event_masks, entity_type))
+        index_watch (watched_types, entity_type, ci);
+
     add_event_type (&ci->watch_info, entity_type, event_mask, FALSE);
 }
 
@@ -506,6 +638,8 @@ gnc_gui_component_clear_watches (gint component_id)
         return;
     }
 
+    g_hash_table_foreach (ci->watch_info.entity_events,
+                          unindex_entity_helper, ci);
     clear_event_info (&ci->watch_info);
 }
 
@@ -528,8 +662,10 @@ gnc_unregister_gui_component (gint component_id)
 #endif
 
     gnc_gui_component_clear_watches (component_id);
+    g_hash_table_foreach (ci->watch_info.event_masks, unindex_type_helper, ci);
 
     components = g_list_remove (components, ci);
+    g_hash_table_remove (components_by_id, GINT_TO_POINTER (component_id));
 
     destroy_mask_hash (ci->watch_info.event_masks);
     ci->watch_info.event_masks = NULL;
@@ -596,70 +732,117 @@ gnc_resume_gui_refresh (void)
         gnc_gui_refresh_internal (FALSE);
 }
 
+/* Look up the components watching a changed entity or type in the
+ * index, and set watch_info.match on the ones whose mask agrees.  Each
+ * of them is added to the list of ids in user_data once. */
 static void
-match_type_helper (gpointer key, gpointer value, gpointer user_data)
+match_entity_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    ComponentEventInfo *cei = user_data;
-    QofIdType id_type = key;
-    QofEventId * et = value;
-    QofEventId * et_2;
+    EventInfo *ei_1 = value;
+    GList **matched = user_data;
+    GList *node;
 
-    et_2 = g_hash_table_lookup (cei->event_masks, id_type);
-    if (!et_2)
-        return;
+    for (node = g_hash_table_lookup (watched_entities, key); node;
+            node = node->next)
+    {
+        ComponentInfo *ci = node->data;
+        EventInfo *ei_2;
+
+        if (ci->watch_info.match)
+            continue;
 
-    if (*et & *et_2)
-        cei->match = TRUE;
+        ei_2 = g_hash_table_lookup (ci->watch_info.entity_events, key);
+        if (ei_2 && (ei_1->event_mask & ei_2->event_mask))
+        {
+            ci->watch_info.match = TRUE;
+            *matched = g_list_prepend (*matched,
+                                       GINT_TO_POINTER (ci->component_id));
+        }
+    }
 }
 
 static void
-match_helper (gpointer key, gpointer value, gpointer user_data)
+match_type_helper (gpointer key, gpointer value, gpointer user_data)
 {
-    GncGUID *guid = key;
-    EventInfo *ei_1 = value;
-    EventInfo *ei_2;
-    ComponentEventInfo *cei = user_data;
+    QofEventId *et = value;
+    GList **matched = user_data;
+    GList *node;
 
-    ei_2 = g_hash_table_lookup (cei->entity_events, guid);
-    if (!ei_2)
-        return;
+    for (node = g_hash_table_lookup (watched_types, key); node;
+            node = node->next)
+    {
+        ComponentInfo *ci = node->data;
+        QofEventId *et_2;
 
-    if (ei_1->event_mask & ei_2->event_mask)
-        cei->match = TRUE;
+        if (ci->watch_info.match)
+            continue;
+
+        et_2 = g_hash_table_lookup (ci->watch_info.event_masks, key);
+        if (et_2 && (*et & *et_2))
+        {
+            ci->watch_info.match = TRUE;
+            *matched = g_list_prepend (*matched,
+                                       GINT_TO_POINTER (ci->component_id));
+        }
+    }
 }
 
-static gboolean
-changes_match (ComponentEventInfo *cei, ComponentEventInfo *changes)
+static gint
+compare_component_ids (gconstpointer a, gconstpointer b)
+{
+    gint id_a = GPOINTER_TO_INT (a);
+    gint id_b = GPOINTER_TO_INT (b);
+
+    return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/* Marks the components watching something in changes and returns their
+ * ids in registration order, which is the order of the ids. */
+static GList *
+mark_matching_components (ComponentEventInfo *changes)
 {
-    ComponentEventInfo *big_cei;
-    GHashTable *smalltable;
+    GList *matched = NULL;
 
-    if (cei == NULL)
-        return FALSE;
+    g_hash_table_foreach (changes->event_masks, match_type_helper, &matched);
+    g_hash_table_foreach (changes->entity_events, match_entity_helper,
+                          &matched);
+
+    return g_list_sort (matched, compare_component_ids);
+}
 
-    /* check types first, for efficiency */
-    cei->match = FALSE;
-    g_hash_table_foreach (changes->event_masks, match_type_helper, cei);
-    if (cei->match)
-        return TRUE;
+static void
+call_refresh_handler (ComponentInfo *ci, GHashTable *changes)
+{
+    GNCComponentRefreshStats *stats;
+    gint64 start;
+    gint64 elapsed;
 
-    if (g_hash_table_size (cei->entity_events) <=
-            g_hash_table_size (changes->entity_events))
+#if CM_DEBUG
+    fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
+#endif
+    if (!refresh_stats)
     {
-        smalltable = cei->entity_events;
-        big_cei = changes;
+        ci->refresh_handler (changes, ci->user_data);
+        return;
     }
-    else
+
+    stats = g_hash_table_lookup (refresh_stats, ci->component_class);
+    if (!stats)
     {
-        smalltable = changes->entity_events;
-        big_cei = cei;
+        stats = g_new0 (GNCComponentRefreshStats, 1);
+        g_hash_table_insert (refresh_stats, g_strdup (ci->component_class),
+                             stats);
     }
 
-    big_cei->match = FALSE;
+    start = g_get_monotonic_time ();
+    ci->refresh_handler (changes, ci->user_data);
+    elapsed = g_get_monotonic_time () - start;
 
-    g_hash_table_foreach (smalltable, match_helper, big_cei);
-
-    return big_cei->match;
+    /* ci may be gone now, the handler can close its component */
+    stats->refreshes++;
+    stats->total_usecs += elapsed;
+    if (elapsed > stats->max_usecs)
+        stats->max_usecs = elapsed;
 }
 
 static void
@@ -689,15 +872,25 @@ gnc_gui_refresh_internal (gboolean force)
     fprintf (stderr, "%srefresh!\n", force ? "forced " : "");
 #endif
 
-    list = find_component_ids_by_class (NULL);
+    /* Only the matching components need a look, unless all of them are
+     * to be refreshed.  Handlers may unregister components, so they are
+     * looked up by id as they come. */
+    if (force)
+        list = find_component_ids_by_class (NULL);
+    else
+        list = mark_matching_components (&changes_backup);
 
     for (node = list; node; node = node->next)
     {
         ComponentInfo *ci = find_component (GPOINTER_TO_INT (node->data));
+        gboolean match;
 
         if (!ci)
             continue;
 
+        match = ci->watch_info.match;
+        ci->watch_info.match = FALSE;
+
         if (!ci->refresh_handler)
         {
 #if CM_DEBUG
@@ -707,25 +900,9 @@ gnc_gui_refresh_internal (gboolean force)
         }
 
         if (force)
-        {
-            if (ci->refresh_handler)
-            {
-#if CM_DEBUG
-                fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
-#endif
-                ci->refresh_handler (NULL, ci->user_data);
-            }
-        }
-        else if (changes_match (&ci->watch_info, &changes_backup))
-        {
-            if (ci->refresh_handler)
-            {
-#if CM_DEBUG
-                fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
-#endif
-                ci->refresh_handler (changes_backup.entity_events, ci->user_data);
-            }
-        }
+            call_refresh_handler (ci, NULL);
+        else if (match)
+            call_refresh_handler (ci, changes_backup.entity_events);
         else
         {
 #if CM_DEBUG
@@ -742,6 +919,34 @@ gnc_gui_refresh_internal (gboolean force)
     gnc_resume_gui_refresh ();
 }
 
+static void
+refresh_stats_helper (gpointer key, gpointer value, gpointer user_data)
+{
+    GNCComponentRefreshStats *stats = value;
+    GList **list = user_data;
+
+    stats->component_class = key;
+    *list = g_list_prepend (*list, stats);
+}
+
+GList *
+gnc_gui_refresh_get_stats (void)
+{
+    GList *list = NULL;
+
+    if (refresh_stats)
+        g_hash_table_foreach (refresh_stats, refresh_stats_helper, &list);
+
+    return list;
+}
+
+void
+gnc_gui_refresh_reset_stats (void)
+{
+    if (refresh_stats)
+        g_hash_table_remove_all (refresh_stats);
+}
+
 void
 gnc_gui_refresh_all (void)
 {
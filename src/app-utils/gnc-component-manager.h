@@ -253,6 +253,30 @@ void gnc_gui_refresh_all (void);
  */
 gboolean gnc_gui_refresh_suspended (void);
 
+/* GNCComponentRefreshStats
+ *   How long the refresh handlers of one component class took,
+ *   counted since the manager was initialized or the stats reset.
+ */
+typedef struct
+{
+    const char *component_class;
+    guint refreshes;
+    gint64 total_usecs;
+    gint64 max_usecs;
+} GNCComponentRefreshStats;
+
+/* gnc_gui_refresh_get_stats
+ *   Return a list of GNCComponentRefreshStats, one per component
+ *   class that has been refreshed. The caller frees the list, but
+ *   not its elements, which are only valid until the next refresh.
+ */
+GList * gnc_gui_refresh_get_stats (void);
+
+/* gnc_gui_refresh_reset_stats
+ *   Reset the refresh statistics.
+ */
+void gnc_gui_refresh_reset_stats (void);
+
 /* gnc_close_gui_component
  *   Invoke the close handler for the indicated component.
  *
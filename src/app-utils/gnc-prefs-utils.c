@@ -27,6 +27,7 @@
 #include "gnc-prefs-utils.h"
 #include "gnc-prefs.h"
 #include "backend/xml/gnc-backend-xml.h"
+#include "TransLog.h"
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
@@ -36,6 +37,12 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 #define GNC_PREF_RETAIN_TYPE_DAYS    "retain-type-days"
 #define GNC_PREF_RETAIN_TYPE_FOREVER "retain-type-forever"
 #define GNC_PREF_RETAIN_DAYS         "retain-days"
+#define GNC_PREF_SQL_LOAD_ON_DEMAND  "sql-load-on-demand"
+#define GNC_PREF_TRANSLOG_BINARY     "translog-binary"
+#define GNC_PREF_TRANSLOG_SYNC_COMMIT   "translog-sync-commit"
+#define GNC_PREF_TRANSLOG_SYNC_INTERVAL "translog-sync-interval"
+#define GNC_PREF_TRANSLOG_SYNC_SAVE     "translog-sync-save"
+#define GNC_PREF_TRANSLOG_SYNC_SECONDS  "translog-sync-seconds"
 
 /***************************************************************
  * Initialization                                              *
@@ -78,6 +85,44 @@ file_compression_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
     }
 }
 
+static void
+sql_load_on_demand_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean on_demand = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LOAD_ON_DEMAND);
+        gnc_prefs_set_sql_load_on_demand (on_demand);
+    }
+}
+
+static void
+translog_format_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean binary = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_BINARY);
+        xaccLogSetFormat (binary ? XACC_LOG_BINARY : XACC_LOG_TEXT);
+    }
+}
+
+static void
+translog_sync_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    XaccLogSync sync = XACC_LOG_SYNC_INTERVAL;
+
+    if (gnc_prefs_is_set_up())
+    {
+        gint seconds = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_SECONDS);
+
+        if (gnc_prefs_get_bool (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_COMMIT))
+            sync = XACC_LOG_SYNC_COMMIT;
+        else if (gnc_prefs_get_bool (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_SAVE))
+            sync = XACC_LOG_SYNC_SAVE;
+
+        xaccLogSetSync (sync, seconds > 0 ? seconds : 1);
+    }
+}
+
 
 void gnc_prefs_init (void)
 {
@@ -89,6 +134,9 @@ void gnc_prefs_init (void)
     file_retain_changed_cb (NULL, NULL, NULL);
     file_retain_type_changed_cb (NULL, NULL, NULL);
     file_compression_changed_cb (NULL, NULL, NULL);
+    sql_load_on_demand_changed_cb (NULL, NULL, NULL);
+    translog_format_changed_cb (NULL, NULL, NULL);
+    translog_sync_changed_cb (NULL, NULL, NULL);
 
     /* Check for invalid retain_type (days)/retain_days (0) combo.
      * This can happen either because a user changed the preferences
@@ -122,5 +170,17 @@ void gnc_prefs_init (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_SQL_LOAD_ON_DEMAND,
+                           sql_load_on_demand_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_BINARY,
+                           translog_format_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_COMMIT,
+                           translog_sync_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_INTERVAL,
+                           translog_sync_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_SAVE,
+                           translog_sync_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_TRANSLOG_SYNC_SECONDS,
+                           translog_sync_changed_cb, NULL);
 
 }
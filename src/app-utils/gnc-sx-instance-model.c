@@ -60,6 +60,7 @@ static void gnc_sx_instance_model_init(GTypeInstance *instance, gpointer klass);
 static GncSxInstanceModel* gnc_sx_instance_model_new(void);
 
 static GncSxInstance* gnc_sx_instance_new(GncSxInstances *parent, GncSxInstanceState state, GDate *date, void *temporal_state, gint sequence_num);
+static void gnc_sx_instance_free(GncSxInstance *instance);
 
 static gint _get_vars_helper(Transaction *txn, void *var_hash_data);
 
@@ -286,6 +287,18 @@ _clone_sx_var_hash_entry(gpointer key, gpointer value, gpointer user_data)
     g_hash_table_insert(to, g_strdup(key), var);
 }
 
+static void
+_gnc_sx_instances_parse_variables(GncSxInstances *instances)
+{
+    if (instances->variable_names_parsed)
+        return;
+
+    instances->variable_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
+    gnc_sx_get_variables(instances->sx, instances->variable_names);
+    g_hash_table_foreach(instances->variable_names, (GHFunc)_wipe_parsed_sx_var, NULL);
+    instances->variable_names_parsed = TRUE;
+}
+
 static GncSxInstance*
 gnc_sx_instance_new(GncSxInstances *parent, GncSxInstanceState state, GDate *date, void *temporal_state, gint sequence_num)
 {
@@ -297,13 +310,7 @@ gnc_sx_instance_new(GncSxInstances *parent, GncSxInstanceState state, GDate *dat
     rtn->date = *date;
     rtn->temporal_state = gnc_sx_clone_temporal_state(temporal_state);
 
-    if (! parent->variable_names_parsed)
-    {
-        parent->variable_names = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
-        gnc_sx_get_variables(parent->sx, parent->variable_names);
-        g_hash_table_foreach(parent->variable_names, (GHFunc)_wipe_parsed_sx_var, NULL);
-        parent->variable_names_parsed = TRUE;
-    }
+    _gnc_sx_instances_parse_variables(parent);
 
     rtn->variable_bindings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)gnc_sx_variable_free);
     g_hash_table_foreach(parent->variable_names, _clone_sx_var_hash_entry, rtn->variable_bindings);
@@ -344,17 +351,50 @@ gnc_sx_instance_get_variables(GncSxInstance *inst)
     return vars;
 }
 
-static GncSxInstances*
-_gnc_sx_gen_instances(gpointer *data, gpointer user_data)
+/* Takes the next instance for the instance list being built: the first
+ * of *reuse if it has the same date, otherwise a new one.  Once the
+ * dates stop matching nothing further in *reuse can be kept. */
+static GncSxInstance*
+_gnc_sx_instances_take(GncSxInstances *instances, GList **reuse,
+                       GDate *date, GncSxInstanceState state,
+                       SXTmpStateData *temporal_state)
 {
-    GncSxInstances *instances = g_new0(GncSxInstances, 1);
-    SchedXaction *sx = (SchedXaction*)data;
-    const GDate *range_end = (const GDate*)user_data;
+    if (reuse != NULL && *reuse != NULL)
+    {
+        GncSxInstance *inst = (GncSxInstance*)(*reuse)->data;
+        if (g_date_compare(&inst->date, date) == 0)
+        {
+            *reuse = g_list_delete_link(*reuse, *reuse);
+            inst->parent = instances;
+            /* leave instances the user has changed alone */
+            if (inst->state == inst->orig_state)
+                inst->state = inst->orig_state = state;
+            return inst;
+        }
+        g_list_foreach(*reuse, (GFunc)gnc_sx_instance_free, NULL);
+        g_list_free(*reuse);
+        *reuse = NULL;
+    }
+
+    return gnc_sx_instance_new(instances, state, date, temporal_state,
+                               gnc_sx_get_instance_count(instances->sx, temporal_state));
+}
+
+/* Builds the instance list of instances->sx up to range_end.  The dates
+ * come from gnc_sx_get_instance_dates() in one go; the instances at the
+ * front of *reuse (may be NULL) that fall on the same dates are kept
+ * rather than created again.  Whatever is left in *reuse belongs to the
+ * caller. */
+static void
+_gnc_sx_instances_fill(GncSxInstances *instances, const GDate *range_end,
+                       GList **reuse)
+{
+    SchedXaction *sx = instances->sx;
     GDate creation_end, remind_end;
-    GDate cur_date;
     SXTmpStateData *temporal_state = gnc_sx_create_temporal_state(sx);
-
-    instances->sx = sx;
+    GList *instance_list = NULL;
+    GArray *dates;
+    guint i;
 
     creation_end = *range_end;
     g_date_add_days(&creation_end, xaccSchedXactionGetAdvanceCreation(sx));
@@ -367,52 +407,50 @@ _gnc_sx_gen_instances(gpointer *data, gpointer user_data)
         for ( ; postponed != NULL; postponed = postponed->next)
         {
             GDate inst_date;
-            int seq_num;
             GncSxInstance *inst;
 
             g_date_clear(&inst_date, 1);
             inst_date = xaccSchedXactionGetNextInstance(sx, postponed->data);
-            seq_num = gnc_sx_get_instance_count(sx, postponed->data);
-            inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_POSTPONED,
-                                       &inst_date, postponed->data, seq_num);
-            instances->instance_list =
-                g_list_append(instances->instance_list, inst);
+            inst = _gnc_sx_instances_take(instances, reuse, &inst_date,
+                                          SX_INSTANCE_STATE_POSTPONED,
+                                          postponed->data);
+            instance_list = g_list_prepend(instance_list, inst);
             gnc_sx_destroy_temporal_state(temporal_state);
             temporal_state = gnc_sx_clone_temporal_state(postponed->data);
             gnc_sx_incr_temporal_state(sx, temporal_state);
         }
     }
 
-    /* to-create */
-    g_date_clear(&cur_date, 1);
-    cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
-    instances->next_instance_date = cur_date;
-    while (g_date_valid(&cur_date) && g_date_compare(&cur_date, &creation_end) <= 0)
+    /* to-create and reminders */
+    instances->next_instance_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+    dates = g_array_new(FALSE, FALSE, sizeof(GDate));
+    gnc_sx_get_instance_dates(sx, temporal_state, &remind_end, dates);
+    for (i = 0; i < dates->len; i++)
     {
+        GDate *date = &g_array_index(dates, GDate, i);
+        GncSxInstanceState state;
         GncSxInstance *inst;
-        int seq_num;
-        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
-        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_TO_CREATE,
-                                   &cur_date, temporal_state, seq_num);
-        instances->instance_list = g_list_append(instances->instance_list, inst);
-        gnc_sx_incr_temporal_state(sx, temporal_state);
-        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
-    }
 
-    /* reminders */
-    while (g_date_valid(&cur_date) &&
-           g_date_compare(&cur_date, &remind_end) <= 0)
-    {
-        GncSxInstance *inst;
-        int seq_num;
-        seq_num = gnc_sx_get_instance_count(sx, temporal_state);
-        inst = gnc_sx_instance_new(instances, SX_INSTANCE_STATE_REMINDER,
-                                   &cur_date, temporal_state, seq_num);
-        instances->instance_list = g_list_append(instances->instance_list,
-                                                 inst);
-        gnc_sx_incr_temporal_state(sx, temporal_state);
-        cur_date = xaccSchedXactionGetNextInstance(sx, temporal_state);
+        state = g_date_compare(date, &creation_end) <= 0
+                ? SX_INSTANCE_STATE_TO_CREATE : SX_INSTANCE_STATE_REMINDER;
+        inst = _gnc_sx_instances_take(instances, reuse, date, state,
+                                      temporal_state);
+        instance_list = g_list_prepend(instance_list, inst);
+        gnc_sx_incr_temporal_state_to(sx, temporal_state, date);
     }
+    g_array_free(dates, TRUE);
+    gnc_sx_destroy_temporal_state(temporal_state);
+
+    instances->instance_list = g_list_reverse(instance_list);
+}
+
+static GncSxInstances*
+_gnc_sx_gen_instances(gpointer *data, gpointer user_data)
+{
+    GncSxInstances *instances = g_new0(GncSxInstances, 1);
+
+    instances->sx = (SchedXaction*)data;
+    _gnc_sx_instances_fill(instances, (const GDate*)user_data, NULL);
 
     return instances;
 }
@@ -736,8 +774,9 @@ _find_unreferenced_vars(gchar *key,
 void
 gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXaction *sx)
 {
-    GncSxInstances *existing, *new_instances;
-    GList *link;
+    GncSxInstances *existing;
+    GHashTable *old_variable_names;
+    GList *link, *reuse;
 
     link = g_list_find_custom(model->sx_instance_list, sx, (GCompareFunc)_gnc_sx_instance_find_by_sx);
     if (link == NULL)
@@ -746,90 +785,46 @@ gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXactio
         return;
     }
 
-    // merge the new instance data into the existing structure, mutating as little as possible.
+    // rebuild the instance list in place, keeping the existing instances
+    // for as long as their dates match the new ones, so only what changed
+    // (e.g. the tail past an old range end) is created or freed.
     existing = (GncSxInstances*)link->data;
-    new_instances = _gnc_sx_gen_instances((gpointer)sx, &model->range_end);
-    existing->sx = new_instances->sx;
-    existing->next_instance_date = new_instances->next_instance_date;
-    {
-        GList *existing_iter, *new_iter;
-        gboolean existing_remain, new_remain;
-
-        // step through the lists pairwise, and retain the existing
-        // instance if the dates align, as soon as they don't stop and
-        // cleanup.
-        existing_iter = existing->instance_list;
-        new_iter = new_instances->instance_list;
-        for (; existing_iter != NULL && new_iter != NULL; existing_iter = existing_iter->next, new_iter = new_iter->next)
-        {
-            GncSxInstance *existing_inst, *new_inst;
-            gboolean same_instance_date;
-            existing_inst = (GncSxInstance*)existing_iter->data;
-            new_inst = (GncSxInstance*)new_iter->data;
-
-            same_instance_date = g_date_compare(&existing_inst->date, &new_inst->date) == 0;
-            if (!same_instance_date)
-                break;
-        }
+    old_variable_names = existing->variable_names;
+    existing->variable_names = NULL;
+    existing->variable_names_parsed = FALSE;
+    _gnc_sx_instances_parse_variables(existing);
 
-        existing_remain = (existing_iter != NULL);
-        new_remain = (new_iter != NULL);
-
-        if (existing_remain)
-        {
-            // delete excess
-            gnc_g_list_cut(&existing->instance_list, existing_iter);
-            g_list_foreach(existing_iter, (GFunc)gnc_sx_instance_free, NULL);
-        }
-
-        if (new_remain)
-        {
-            // append new
-            GList *new_iter_iter;
-            gnc_g_list_cut(&new_instances->instance_list, new_iter);
-
-            for (new_iter_iter = new_iter; new_iter_iter != NULL; new_iter_iter = new_iter_iter->next)
-            {
-                GncSxInstance *inst = (GncSxInstance*)new_iter_iter->data;
-                inst->parent = existing;
-                existing->instance_list = g_list_append(existing->instance_list, new_iter_iter->data);
-            }
-            g_list_free(new_iter);
-        }
-    }
+    reuse = existing->instance_list;
+    existing->instance_list = NULL;
+    _gnc_sx_instances_fill(existing, &model->range_end, &reuse);
+    g_list_foreach(reuse, (GFunc)gnc_sx_instance_free, NULL);
+    g_list_free(reuse);
 
     // handle variables
     {
         GList *removed_var_names = NULL, *added_var_names = NULL;
         GList *inst_iter = NULL;
 
-        if (existing->variable_names != NULL)
+        if (old_variable_names != NULL)
         {
             HashListPair removed_cb_data;
-            removed_cb_data.hash = new_instances->variable_names;
+            removed_cb_data.hash = existing->variable_names;
             removed_cb_data.list = NULL;
-            g_hash_table_foreach(existing->variable_names, (GHFunc)_find_unreferenced_vars, &removed_cb_data);
+            g_hash_table_foreach(old_variable_names, (GHFunc)_find_unreferenced_vars, &removed_cb_data);
             removed_var_names = removed_cb_data.list;
         }
         g_debug("%d removed variables", g_list_length(removed_var_names));
 
-        if (new_instances->variable_names != NULL)
+        if (existing->variable_names != NULL)
         {
             HashListPair added_cb_data;
-            added_cb_data.hash = existing->variable_names;
+            added_cb_data.hash = old_variable_names;
             added_cb_data.list = NULL;
-            g_hash_table_foreach(new_instances->variable_names, (GHFunc)_find_unreferenced_vars, &added_cb_data);
+            g_hash_table_foreach(existing->variable_names, (GHFunc)_find_unreferenced_vars, &added_cb_data);
             added_var_names = added_cb_data.list;
         }
         g_debug("%d added variables", g_list_length(added_var_names));
 
-        if (existing->variable_names != NULL)
-        {
-            g_hash_table_destroy(existing->variable_names);
-        }
-        existing->variable_names = new_instances->variable_names;
-        new_instances->variable_names = NULL;
-
         for (inst_iter = existing->instance_list; inst_iter != NULL; inst_iter = inst_iter->next)
         {
             GList *var_iter;
@@ -857,8 +852,111 @@ gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXactio
                 }
             }
         }
+        g_list_free(removed_var_names);
+        g_list_free(added_var_names);
+    }
+
+    if (old_variable_names != NULL)
+    {
+        g_hash_table_destroy(old_variable_names);
+    }
+}
+
+/* Moves the end of the range of instances->sx to range_end.  Rather
+ * than generating every instance again, the ones past the new end are
+ * dropped and the ones past the old end appended, continuing from the
+ * last instance kept. */
+static void
+_gnc_sx_instances_set_range_end(GncSxInstances *instances, const GDate *range_end)
+{
+    SchedXaction *sx = instances->sx;
+    GDate creation_end, remind_end;
+    GncSxInstance *last = NULL;
+    SXTmpStateData *temporal_state;
+    GList *iter, *next, *added = NULL;
+    GArray *dates;
+    guint i;
+
+    creation_end = *range_end;
+    g_date_add_days(&creation_end, xaccSchedXactionGetAdvanceCreation(sx));
+    remind_end = creation_end;
+    g_date_add_days(&remind_end, xaccSchedXactionGetAdvanceReminder(sx));
+
+    for (iter = instances->instance_list; iter != NULL; iter = next)
+    {
+        GncSxInstance *inst = (GncSxInstance*)iter->data;
+        next = iter->next;
+
+        /* postponed instances don't depend on the range */
+        if (inst->orig_state == SX_INSTANCE_STATE_POSTPONED)
+            continue;
+        if (g_date_compare(&inst->date, &remind_end) > 0)
+        {
+            instances->instance_list
+                = g_list_delete_link(instances->instance_list, iter);
+            gnc_sx_instance_free(inst);
+            continue;
+        }
+        /* leave instances the user has changed alone */
+        if (inst->state == inst->orig_state)
+            inst->state = inst->orig_state
+                          = g_date_compare(&inst->date, &creation_end) <= 0
+                            ? SX_INSTANCE_STATE_TO_CREATE : SX_INSTANCE_STATE_REMINDER;
+        last = inst;
+    }
+
+    if (last == NULL)
+    {
+        /* nothing to continue from; only postponed instances to keep */
+        GList *reuse = instances->instance_list;
+        instances->instance_list = NULL;
+        _gnc_sx_instances_fill(instances, range_end, &reuse);
+        g_list_foreach(reuse, (GFunc)gnc_sx_instance_free, NULL);
+        g_list_free(reuse);
+        return;
+    }
+
+    temporal_state = gnc_sx_clone_temporal_state(last->temporal_state);
+    gnc_sx_incr_temporal_state_to(sx, temporal_state, &last->date);
+    dates = g_array_new(FALSE, FALSE, sizeof(GDate));
+    gnc_sx_get_instance_dates(sx, temporal_state, &remind_end, dates);
+    for (i = 0; i < dates->len; i++)
+    {
+        GDate *date = &g_array_index(dates, GDate, i);
+        GncSxInstanceState state;
+
+        state = g_date_compare(date, &creation_end) <= 0
+                ? SX_INSTANCE_STATE_TO_CREATE : SX_INSTANCE_STATE_REMINDER;
+        added = g_list_prepend(added, gnc_sx_instance_new(
+                                   instances, state, date, temporal_state,
+                                   gnc_sx_get_instance_count(sx, temporal_state)));
+        gnc_sx_incr_temporal_state_to(sx, temporal_state, date);
+    }
+    g_array_free(dates, TRUE);
+    gnc_sx_destroy_temporal_state(temporal_state);
+
+    instances->instance_list = g_list_concat(instances->instance_list,
+                               g_list_reverse(added));
+}
+
+void
+gnc_sx_instance_model_set_range_end(GncSxInstanceModel *model, const GDate *range_end)
+{
+    GList *iter;
+
+    g_return_if_fail(GNC_IS_SX_INSTANCE_MODEL(model));
+    g_return_if_fail(range_end != NULL && g_date_valid(range_end));
+
+    if (g_date_compare(&model->range_end, range_end) == 0)
+        return;
+    model->range_end = *range_end;
+
+    for (iter = model->sx_instance_list; iter != NULL; iter = iter->next)
+    {
+        GncSxInstances *instances = (GncSxInstances*)iter->data;
+        _gnc_sx_instances_set_range_end(instances, range_end);
+        g_signal_emit_by_name(model, "updated", (gpointer)instances->sx);
     }
-    gnc_sx_instances_free(new_instances);
 }
 
 void
@@ -132,8 +132,21 @@ GncSxInstanceModel* gnc_sx_get_instances(const GDate *range_end, gboolean includ
  * consumers are probably going to call this in response to seeing the
  * "update" signal, unless they need to be doing something else like
  * finishing an iteration over an existing GncSxInstances*.
+ *
+ * Existing instances are kept, with their variable bindings, for as
+ * long as their dates agree with the regenerated schedule.
  **/
 void gnc_sx_instance_model_update_sx_instances(GncSxInstanceModel *model, SchedXaction *sx);
+
+/**
+ * Moves the end of the model's range.  The instances within both the
+ * old and the new range are kept; instances are only added past the old
+ * end or dropped past the new one.  Instances the user hasn't changed
+ * switch between to-create and reminder as the range dictates.  Emits
+ * "updated" for every SX in the model.
+ **/
+void gnc_sx_instance_model_set_range_end(GncSxInstanceModel *model, const GDate *range_end);
+
 void gnc_sx_instance_model_remove_sx_instances(GncSxInstanceModel *model, SchedXaction *sx);
 
 /** @return GList<GncSxVariable*>. Caller owns the list, but not the items. **/
@@ -0,0 +1,169 @@
+/********************************************************************\
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+#include <stdlib.h>
+#include <glib.h>
+#include "qof.h"
+#include "gnc-component-manager.h"
+
+#include "test-stuff.h"
+
+#define TEST_CLASS "test-component"
+#define TEST_TYPE "TestEntity"
+#define N_COMPONENTS 4
+
+static gint ids[N_COMPONENTS];
+static GString *refreshed = NULL;
+/* The component whose refresh handler unregisters the one after it. */
+static gint unregister_next = -1;
+
+/* Appends the index of the refreshed component, so that the order of
+ * the calls can be checked as a string. */
+static void
+refresh_handler (GHashTable *changes, gpointer user_data)
+{
+    gint i = GPOINTER_TO_INT (user_data);
+
+    g_string_append_c (refreshed, '0' + i);
+    if (i == unregister_next && i + 1 < N_COMPONENTS)
+    {
+        gnc_unregister_gui_component (ids[i + 1]);
+        ids[i + 1] = NO_COMPONENT;
+    }
+}
+
+static void
+check_refreshed (const char *expected, const char *msg)
+{
+    do_test_args (g_strcmp0 (refreshed->str, expected) == 0, msg,
+                  __FILE__, __LINE__, "refreshed \"%s\", expected \"%s\"",
+                  refreshed->str, expected);
+    g_string_truncate (refreshed, 0);
+}
+
+static QofInstance *
+make_entity (QofBook *book)
+{
+    QofInstance *inst = g_object_new (QOF_TYPE_INSTANCE, NULL);
+
+    qof_instance_init_data (inst, TEST_TYPE, book);
+    return inst;
+}
+
+static void
+modify (QofInstance *inst)
+{
+    qof_event_gen (inst, QOF_EVENT_MODIFY, NULL);
+}
+
+static void
+test_refresh (QofBook *book)
+{
+    QofInstance *e1 = make_entity (book);
+    QofInstance *e2 = make_entity (book);
+    QofInstance *e3 = make_entity (book);
+    gint i;
+
+    for (i = 0; i < N_COMPONENTS; i++)
+        ids[i] = gnc_register_gui_component (TEST_CLASS, refresh_handler,
+                                             NULL, GINT_TO_POINTER (i));
+
+    /* 0 and 3 watch e1, 1 watches the type, 2 watches e2 */
+    gnc_gui_component_watch_entity (ids[3], qof_instance_get_guid (e1),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity (ids[0], qof_instance_get_guid (e1),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity_type (ids[1], TEST_TYPE, QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity (ids[2], qof_instance_get_guid (e2),
+                                    QOF_EVENT_MODIFY | QOF_EVENT_DESTROY);
+
+    gnc_suspend_gui_refresh ();
+    modify (e2);
+    modify (e1);
+    gnc_resume_gui_refresh ();
+    check_refreshed ("0123", "all watchers, in registration order");
+
+    modify (e2);
+    check_refreshed ("12", "entity and type watchers");
+
+    qof_event_gen (e2, QOF_EVENT_DESTROY, NULL);
+    check_refreshed ("2", "only the watcher of that event");
+
+    modify (e3);
+    check_refreshed ("1", "only the type watcher");
+
+    gnc_gui_component_clear_watches (ids[2]);
+    modify (e2);
+    check_refreshed ("1", "watches cleared");
+
+    gnc_gui_component_watch_entity (ids[2], qof_instance_get_guid (e2),
+                                    QOF_EVENT_MODIFY);
+    gnc_gui_component_watch_entity (ids[2], qof_instance_get_guid (e2), 0);
+    modify (e2);
+    check_refreshed ("1", "watch removed with an empty mask");
+
+    gnc_unregister_gui_component (ids[1]);
+    ids[1] = NO_COMPONENT;
+    modify (e3);
+    check_refreshed ("", "unregistered type watcher");
+    modify (e1);
+    check_refreshed ("03", "unregistered watcher left out");
+
+    /* A handler closing a later component keeps it from being called. */
+    unregister_next = 2;
+    gnc_gui_component_watch_entity (ids[2], qof_instance_get_guid (e1),
+                                    QOF_EVENT_MODIFY);
+    modify (e1);
+    check_refreshed ("02", "component unregistered during the refresh");
+    unregister_next = -1;
+
+    gnc_gui_refresh_all ();
+    check_refreshed ("02", "forced refresh");
+
+    for (i = 0; i < N_COMPONENTS; i++)
+        if (ids[i] != NO_COMPONENT)
+            gnc_unregister_gui_component (ids[i]);
+    modify (e1);
+    check_refreshed ("", "all unregistered");
+
+    g_object_unref (e1);
+    g_object_unref (e2);
+    g_object_unref (e3);
+}
+
+int
+main (int argc, char **argv)
+{
+    QofBook *book;
+
+    qof_init ();
+    gnc_component_manager_init ();
+    refreshed = g_string_new (NULL);
+    book = qof_book_new ();
+
+    test_refresh (book);
+
+    qof_book_destroy (book);
+    g_string_free (refreshed, TRUE);
+    gnc_component_manager_shutdown ();
+    print_test_results ();
+    exit (get_rv ());
+}
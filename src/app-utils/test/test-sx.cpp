@@ -213,6 +213,81 @@ test_state_changes()
     remove_sx(foo);
 }
 
+/* The instances of a daily SX from start: one a day up to n, the last
+ * two of them reminders, and the one at ignored left as the user set it. */
+static void
+check_daily_instances(GncSxInstances *insts, const GDate *start, int n,
+                      int ignored, const char *msg)
+{
+    GList *iter;
+    int i = 0;
+
+    do_test_args(g_list_length(insts->instance_list) == (guint)n, msg,
+                 __FILE__, __LINE__, "%d instances, expected %d",
+                 g_list_length(insts->instance_list), n);
+    for (iter = insts->instance_list; iter != NULL; iter = iter->next, i++)
+    {
+        GncSxInstance *inst = (GncSxInstance*)iter->data;
+        GncSxInstanceState state;
+        GDate date = *start;
+
+        g_date_add_days(&date, i);
+        do_test(g_date_compare(&inst->date, &date) == 0, msg);
+        if (i == ignored)
+            state = SX_INSTANCE_STATE_IGNORED;
+        else if (i >= n - 2)
+            state = SX_INSTANCE_STATE_REMINDER;
+        else
+            state = SX_INSTANCE_STATE_TO_CREATE;
+        do_test(inst->state == state, msg);
+    }
+}
+
+static void
+test_range_end()
+{
+    SchedXaction *foo;
+    GDate today, end;
+    GncSxInstanceModel *model;
+    GncSxInstances *insts;
+    GncSxInstance *first, *ignored;
+
+    g_date_clear(&today, 1);
+    gnc_gdate_set_today (&today);
+
+    foo = add_daily_sx("foo", &today, NULL, NULL);
+    xaccSchedXactionSetAdvanceReminder(foo, 2);
+
+    end = today;
+    g_date_add_days(&end, 3);
+    model = gnc_sx_get_instances(&end, TRUE);
+    insts = (GncSxInstances*)g_list_nth_data(model->sx_instance_list, 0);
+    first = _nth_instance(insts, 0);
+    ignored = _nth_instance(insts, 1);
+    gnc_sx_instance_model_change_instance_state(model, ignored, SX_INSTANCE_STATE_IGNORED);
+    check_daily_instances(insts, &today, 6, 1, "initial range");
+
+    g_date_add_days(&end, 7);
+    gnc_sx_instance_model_set_range_end(model, &end);
+    do_test(g_date_compare(&model->range_end, &end) == 0, "range end moved");
+    check_daily_instances(insts, &today, 13, 1, "extended range");
+    do_test(_nth_instance(insts, 0) == first && _nth_instance(insts, 1) == ignored,
+            "instances kept when extending");
+
+    g_date_subtract_days(&end, 8);
+    gnc_sx_instance_model_set_range_end(model, &end);
+    check_daily_instances(insts, &today, 5, 1, "shrunk range");
+    do_test(_nth_instance(insts, 0) == first && _nth_instance(insts, 1) == ignored,
+            "instances kept when shrinking");
+
+    g_date_add_days(&end, 3);
+    gnc_sx_instance_model_set_range_end(model, &end);
+    check_daily_instances(insts, &today, 8, 1, "extended again");
+
+    g_object_unref(model);
+    remove_sx(foo);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -228,6 +303,7 @@ main(int argc, char **argv)
     }
     test_basic();
     test_state_changes();
+    test_range_end();
 
     print_test_results();
     exit(get_rv());
@@ -1437,6 +1437,11 @@ gnc_dbi_session_end( QofBackend *be_start )
         be->sql_be.conn = NULL;
     }
     gnc_sql_finalize_version_info( &be->sql_be );
+    if ( be->sql_be.tx_loaded_from != NULL )
+    {
+        g_hash_table_destroy( be->sql_be.tx_loaded_from );
+        be->sql_be.tx_loaded_from = NULL;
+    }
 
     LEAVE (" ");
 }
@@ -52,6 +52,10 @@ extern "C"
 /* For version_control */
 #include <gnc-prefs.h>
 #include <qofsession-p.h>
+/* For slot_commit */
+#include <qofinstance-p.h>
+/* For load_on_demand */
+#include <Query.h>
 }
 /* For test_conn_index_functions */
 #include "test-dbi-stuff.h"
@@ -496,6 +500,203 @@ cleanup:
     }
     return;
 }
+/* Committing a change to one slot of a saved account should only
+ * replace that slot instead of rewriting all of them. */
+static void
+test_dbi_slot_commit (Fixture *fixture, gconstpointer pData)
+{
+    auto url = (gchar*)pData;
+    QofSession *session_1 = NULL, *session_2 = NULL;
+    GncSqlBackend *sql_be;
+    Account *acct;
+    guint count;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags>(G_LOG_LEVEL_WARNING | G_LOG_FLAG_FATAL);
+    TestErrorStruct *check = test_error_struct_new (log_domain, loglevel, msg);
+
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_1 = qof_session_new ();
+    qof_session_begin (session_1, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_1);
+    qof_session_save (session_1, NULL);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+
+    sql_be = (GncSqlBackend*)qof_book_get_backend (qof_session_get_book (session_1));
+    acct = gnc_account_lookup_by_name (
+               gnc_book_get_root_account (qof_session_get_book (session_1)),
+               "Bank 1");
+    g_assert (acct != NULL);
+
+    count = gnc_sql_get_statement_count (sql_be);
+    xaccAccountBeginEdit (acct);
+    delete qof_instance_get_slots (QOF_INSTANCE (acct))->set ("string-val",
+            new KvpValue ("qrstuvwxyz"));
+    delete qof_instance_get_slots (QOF_INSTANCE (acct))->set ("double-val",
+            nullptr);
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+    /* The commodity check, the account row, reading the slots back, one
+     * DELETE for both changed slots and the new string.  The timespec
+     * slot lost its nanoseconds in the db but isn't rewritten for that.
+     * Rewriting everything takes 9. */
+    g_assert_cmpuint (gnc_sql_get_statement_count (sql_be) - count, ==, 5);
+
+    /* Nothing changed: the commodity check, the account row and reading
+     * the slots back. */
+    count = gnc_sql_get_statement_count (sql_be);
+    xaccAccountBeginEdit (acct);
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpuint (gnc_sql_get_statement_count (sql_be) - count, ==, 3);
+
+    /* The same value with another denominator is saved as another value. */
+    count = gnc_sql_get_statement_count (sql_be);
+    xaccAccountBeginEdit (acct);
+    delete qof_instance_get_slots (QOF_INSTANCE (acct))->set ("numeric-val",
+            new KvpValue (gnc_numeric_create (0, 100)));
+    qof_instance_set_dirty (QOF_INSTANCE (acct));
+    xaccAccountCommitEdit (acct);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+    g_assert_cmpuint (gnc_sql_get_statement_count (sql_be) - count, ==, 5);
+
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_load (session_2, NULL);
+    compare_books (qof_session_get_book (session_1),
+                   qof_session_get_book (session_2));
+    acct = gnc_account_lookup_by_name (
+               gnc_book_get_root_account (qof_session_get_book (session_2)),
+               "Bank 1");
+    g_assert (acct != NULL);
+    {
+        auto value = qof_instance_get_slots (QOF_INSTANCE (acct))->get_slot ("numeric-val");
+        g_assert (value != NULL);
+        g_assert_cmpint (value->get<gnc_numeric>().num, ==, 0);
+        g_assert_cmpint (value->get<gnc_numeric>().denom, ==, 100);
+    }
+
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                     (GLogFunc)test_checked_handler);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_1);
+    qof_session_destroy (session_1);
+}
+/* Test that with sql-load-on-demand set the accounts come up with their
+ * full balances but no splits, and that queries and balances by date load
+ * what they need. */
+static void
+test_dbi_load_on_demand (Fixture *fixture, gconstpointer pData)
+{
+    auto url = (gchar*)pData;
+    QofSession *session_1 = NULL, *session_2 = NULL;
+    QofBook *book_1, *book_2;
+    Account *acct_1 = NULL, *acct_2;
+    GList *accounts, *node;
+    QofQuery *query;
+
+    auto msg = "[gnc_dbi_unlock()] There was no lock entry in the Lock table";
+    auto log_domain = "gnc.backend.dbi";
+    auto loglevel = static_cast<GLogLevelFlags>(G_LOG_LEVEL_WARNING | G_LOG_FLAG_FATAL);
+    TestErrorStruct *check = test_error_struct_new (log_domain, loglevel, msg);
+
+    if (fixture->filename)
+        url = fixture->filename;
+
+    session_1 = qof_session_new ();
+    qof_session_begin (session_1, url, FALSE, TRUE, TRUE);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+    qof_session_swap_data (fixture->session, session_1);
+    qof_session_save (session_1, NULL);
+    g_assert_cmpint (qof_session_get_error (session_1), ==, ERR_BACKEND_NO_ERR);
+    book_1 = qof_session_get_book (session_1);
+
+    gnc_prefs_set_sql_load_on_demand (TRUE);
+    session_2 = qof_session_new ();
+    qof_session_begin (session_2, url, TRUE, FALSE, FALSE);
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    qof_session_load (session_2, NULL);
+    gnc_prefs_set_sql_load_on_demand (FALSE);
+    g_assert_cmpint (qof_session_get_error (session_2), ==, ERR_BACKEND_NO_ERR);
+    book_2 = qof_session_get_book (session_2);
+
+    accounts = gnc_account_get_descendants (gnc_book_get_root_account (book_1));
+    for (node = accounts; node != NULL; node = node->next)
+    {
+        Account *acct = static_cast<Account*>(node->data);
+
+        acct_2 = xaccAccountLookup (qof_instance_get_guid (QOF_INSTANCE (acct)),
+                                    book_2);
+        g_assert (acct_2 != NULL);
+        g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct),
+                                     xaccAccountGetBalance (acct_2)));
+        g_assert (gnc_numeric_equal (xaccAccountGetClearedBalance (acct),
+                                     xaccAccountGetClearedBalance (acct_2)));
+        g_assert (gnc_numeric_equal (xaccAccountGetReconciledBalance (acct),
+                                     xaccAccountGetReconciledBalance (acct_2)));
+        if (acct_1 == NULL && xaccAccountGetSplitList (acct) != NULL)
+            acct_1 = acct;
+    }
+    g_assert (acct_1 != NULL);
+
+    acct_2 = xaccAccountLookup (qof_instance_get_guid (QOF_INSTANCE (acct_1)),
+                                book_2);
+    g_assert (xaccAccountGetSplitList (acct_2) == NULL);
+    query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book_2);
+    xaccQueryAddSingleAccountMatch (query, acct_2, QOF_QUERY_AND);
+    g_assert_cmpuint (g_list_length (qof_query_run (query)), ==,
+                      g_list_length (xaccAccountGetSplitList (acct_1)));
+    qof_query_destroy (query);
+    g_assert (gnc_numeric_equal (xaccAccountGetBalance (acct_1),
+                                 xaccAccountGetBalance (acct_2)));
+
+    /* Only acct_1 has been loaded, which brought in some splits of the
+     * other accounts without their later ones.  Their balances by date
+     * must still come out as if everything was there, latest first so
+     * that each account is loaded further back step by step. */
+    for (node = accounts; node != NULL; node = node->next)
+    {
+        Account *acct = static_cast<Account*>(node->data);
+        GList *snode = g_list_last (xaccAccountGetSplitList (acct));
+
+        acct_2 = xaccAccountLookup (qof_instance_get_guid (QOF_INSTANCE (acct)),
+                                    book_2);
+        for (; snode != NULL; snode = snode->prev)
+        {
+            auto date = xaccTransGetDate (xaccSplitGetParent (
+                                              static_cast<Split*>(snode->data)));
+            g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct, date + 1),
+                                         xaccAccountGetBalanceAsOfDate (acct_2, date + 1)));
+            g_assert (gnc_numeric_equal (xaccAccountGetBalanceAsOfDate (acct, date),
+                                         xaccAccountGetBalanceAsOfDate (acct_2, date)));
+        }
+        g_assert (gnc_numeric_equal (xaccAccountGetPresentBalance (acct),
+                                     xaccAccountGetPresentBalance (acct_2)));
+    }
+    g_list_free (accounts);
+
+    /* A query on nothing in particular has to load everything. */
+    query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, book_2);
+    qof_query_run (query);
+    qof_query_destroy (query);
+    compare_books (book_1, book_2);
+
+    fixture->hdlrs = test_log_set_fatal_handler (fixture->hdlrs, check,
+                     (GLogFunc)test_checked_handler);
+    qof_session_end (session_2);
+    qof_session_destroy (session_2);
+    qof_session_end (session_1);
+    qof_session_destroy (session_1);
+}
 /* Test the gnc_dbi_load logic that forces a newer database to be
  * opened read-only and an older one to be safe-saved. Again, it would
  * be better to do this starting from a fresh file, but instead we're
@@ -608,6 +809,10 @@ create_dbi_test_suite (const char *dbm_name, const char *url)
                   test_dbi_store_and_reload, teardown);
     GNC_TEST_ADD (subsuite, "safe_save", Fixture, url, setup_memory,
                   test_dbi_safe_save, teardown);
+    GNC_TEST_ADD (subsuite, "slot_commit", Fixture, url, setup_memory,
+                  test_dbi_slot_commit, teardown);
+    GNC_TEST_ADD (subsuite, "load_on_demand", Fixture, url, setup,
+                  test_dbi_load_on_demand, teardown);
     GNC_TEST_ADD (subsuite, "version_control", Fixture, url, setup_memory,
                   test_dbi_version_control, teardown);
     GNC_TEST_ADD (subsuite, "business_store_and_reload", Fixture, url,
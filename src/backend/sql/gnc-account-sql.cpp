@@ -204,7 +204,7 @@ load_all_accounts( GncSqlBackend* be )
     GncSqlResult* result;
     QofBook* pBook;
     GList* l_accounts_needing_parents = NULL;
-    GSList* bal_slist;
+    GSList* bal_slist = NULL;
     GSList* bal;
 
     g_return_if_fail( be != NULL );
@@ -290,8 +290,12 @@ load_all_accounts( GncSqlBackend* be )
             }
         }
 
-        /* Load starting balances */
-        bal_slist = gnc_sql_get_account_balances_slist( be );
+        /* If transactions are only loaded as they are needed, the accounts
+         * start out with the balances of all of their splits. */
+        if ( be->load_tx_on_demand )
+        {
+            bal_slist = gnc_sql_get_account_balances_slist( be );
+        }
         for ( bal = bal_slist; bal != NULL; bal = bal->next )
         {
             acct_balances_t* balances = (acct_balances_t*)bal->data;
@@ -304,10 +308,12 @@ load_all_accounts( GncSqlBackend* be )
                           NULL);
 
 	    qof_instance_decrease_editlevel (balances->acct);
+            gnc_account_set_splits_loaded_from( balances->acct, G_MAXINT64 );
+            xaccAccountRecomputeBalance( balances->acct );
         }
         if ( bal_slist != NULL )
         {
-            g_slist_free( bal_slist );
+            g_slist_free_full( bal_slist, g_free );
         }
     }
 
@@ -84,6 +84,10 @@ static void update_progress( GncSqlBackend* be );
 static void finish_progress( GncSqlBackend* be );
 static void register_standard_col_type_handlers( void );
 static gboolean reset_version_info( GncSqlBackend* be );
+static gboolean flush_insert_batches( GncSqlBackend* be, const gchar* table_name );
+static gboolean add_to_insert_batch( GncSqlBackend* be, const gchar* table_name,
+                                     QofIdTypeConst obj_name, gpointer pObject,
+                                     const GncSqlColumnTableEntry* table );
 /*@ null @*/
 static GncSqlStatement* build_insert_statement( GncSqlBackend* be,
         const gchar* table_name,
@@ -244,6 +248,18 @@ gnc_sql_load( GncSqlBackend* be, /*@ dependent @*/ QofBook *book, QofBackendLoad
         g_assert( be->book == NULL );
         be->book = book;
 
+        /* Transactions are either all read below or read later by
+         * accounts and date ranges as queries need them. */
+        be->load_tx_on_demand = gnc_prefs_get_sql_load_on_demand();
+        be->all_tx_loaded = FALSE;
+        if ( be->tx_loaded_from != NULL )
+        {
+            g_hash_table_destroy( be->tx_loaded_from );
+        }
+        be->tx_loaded_from = g_hash_table_new_full( guid_hash_to_guint,
+                             guid_g_hash_table_equal,
+                             (GDestroyNotify)guid_free, g_free );
+
         /* Load any initial stuff. Some of this needs to happen in a certain order */
         for ( i = 0; fixed_load_order[i] != NULL; i++ )
         {
@@ -476,6 +492,7 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     be->operations_done = 0;
 
     is_ok = gnc_sql_connection_begin_transaction( be->conn );
+    gnc_sql_begin_insert_batch( be );
 
     // FIXME: should write the set of commodities that are used
     //write_commodities( be, book );
@@ -503,6 +520,12 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     {
         qof_object_foreach_backend( GNC_SQL_BACKEND, write_cb, be );
     }
+    /* Everything is inserted into an empty database, so the rows still
+     * waiting in a batch have to go in before the commit. */
+    if ( !gnc_sql_end_insert_batch( be ) )
+    {
+        is_ok = FALSE;
+    }
     if ( is_ok )
     {
         is_ok = gnc_sql_connection_commit_transaction( be->conn );
@@ -510,6 +533,9 @@ gnc_sql_sync_all( GncSqlBackend* be, /*@ dependent @*/ QofBook *book )
     if ( is_ok )
     {
         be->is_pristine_db = FALSE;
+        /* The database was written from memory, so there is nothing left
+         * in it to load. */
+        be->all_tx_loaded = TRUE;
 
         /* Mark the session as clean -- though it shouldn't ever get
 	 * marked dirty with this backend
@@ -965,12 +991,13 @@ gnc_sql_free_query( QofBackend* pBEnd, gpointer pQuery )
     // Try various objects first
     be_data.is_ok = FALSE;
     be_data.be = be;
-    be_data.pCompiledQuery = pQuery;
+    be_data.pCompiledQuery = pQueryInfo->pCompiledQuery;
     be_data.pQueryInfo = pQueryInfo;
 
     qof_object_foreach_backend( GNC_SQL_BACKEND, free_query_cb, &be_data );
     if ( be_data.is_ok )
     {
+        g_free( pQueryInfo );
         LEAVE( "" );
         return;
     }
@@ -2539,14 +2566,12 @@ create_single_col_select_statement( GncSqlBackend* be,
 
 /* ================================================================= */
 
-/*@ null @*/ GncSqlResult*
-gnc_sql_execute_select_statement( GncSqlBackend* be, GncSqlStatement* stmt )
+/*@ null @*/ static GncSqlResult*
+execute_select_statement( GncSqlBackend* be, GncSqlStatement* stmt )
 {
     GncSqlResult* result;
 
-    g_return_val_if_fail( be != NULL, NULL );
-    g_return_val_if_fail( stmt != NULL, NULL );
-
+    be->statement_count++;
     result = gnc_sql_connection_execute_select_statement( be->conn, stmt );
     if ( result == NULL )
     {
@@ -2557,6 +2582,16 @@ gnc_sql_execute_select_statement( GncSqlBackend* be, GncSqlStatement* stmt )
     return result;
 }
 
+/*@ null @*/ GncSqlResult*
+gnc_sql_execute_select_statement( GncSqlBackend* be, GncSqlStatement* stmt )
+{
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( stmt != NULL, NULL );
+
+    (void)flush_insert_batches( be, NULL );
+    return execute_select_statement( be, stmt );
+}
+
 /*@ null @*/ GncSqlStatement*
 gnc_sql_create_statement_from_sql( GncSqlBackend* be, const gchar* sql )
 {
@@ -2584,11 +2619,13 @@ gnc_sql_execute_select_sql( GncSqlBackend* be, const gchar* sql )
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( sql != NULL, NULL );
 
+    (void)flush_insert_batches( be, NULL );
     stmt = gnc_sql_create_statement_from_sql( be, sql );
     if ( stmt == NULL )
     {
         return NULL;
     }
+    be->statement_count++;
     result = gnc_sql_connection_execute_select_statement( be->conn, stmt );
     gnc_sql_statement_dispose( stmt );
     if ( result == NULL )
@@ -2609,11 +2646,13 @@ gnc_sql_execute_nonselect_sql( GncSqlBackend* be, const gchar* sql )
     g_return_val_if_fail( be != NULL, 0 );
     g_return_val_if_fail( sql != NULL, 0 );
 
+    (void)flush_insert_batches( be, NULL );
     stmt = gnc_sql_create_statement_from_sql( be, sql );
     if ( stmt == NULL )
     {
         return -1;
     }
+    be->statement_count++;
     result = gnc_sql_connection_execute_nonselect_statement( be->conn, stmt );
     gnc_sql_statement_dispose( stmt );
     return result;
@@ -2628,7 +2667,7 @@ execute_statement_get_count( GncSqlBackend* be, GncSqlStatement* stmt )
     g_return_val_if_fail( be != NULL, 0 );
     g_return_val_if_fail( stmt != NULL, 0 );
 
-    result = gnc_sql_execute_select_statement( be, stmt );
+    result = execute_select_statement( be, stmt );
     if ( result != NULL )
     {
         count = gnc_sql_result_get_num_rows( result );
@@ -2684,6 +2723,11 @@ gnc_sql_object_is_it_in_db( GncSqlBackend* be, const gchar* table_name,
     g_return_val_if_fail( pObject != NULL, FALSE );
     g_return_val_if_fail( table != NULL, FALSE );
 
+    /* Only this table's rows matter here; leaving the other batches alone
+     * keeps e.g. the commodity check for each transaction from flushing
+     * the splits. */
+    (void)flush_insert_batches( be, table_name );
+
     /* SELECT * FROM */
     sqlStmt = create_single_col_select_statement( be, table_name, table );
     g_assert( sqlStmt != NULL );
@@ -2723,6 +2767,15 @@ gnc_sql_do_db_operation( GncSqlBackend* be,
     g_return_val_if_fail( pObject != NULL, FALSE );
     g_return_val_if_fail( table != NULL, FALSE );
 
+    if ( op == OP_DB_INSERT && be->batching_inserts )
+    {
+        return add_to_insert_batch( be, table_name, obj_name, pObject, table );
+    }
+    if ( !flush_insert_batches( be, NULL ) )
+    {
+        return FALSE;
+    }
+
     if ( op == OP_DB_INSERT )
     {
         stmt = build_insert_statement( be, table_name, obj_name, pObject, table );
@@ -2743,6 +2796,7 @@ gnc_sql_do_db_operation( GncSqlBackend* be,
     {
         gint result;
 
+        be->statement_count++;
         result = gnc_sql_connection_execute_nonselect_statement( be->conn, stmt );
         if ( result == -1 )
         {
@@ -2867,32 +2921,64 @@ free_gvalue_list( GSList* list )
     g_slist_free( list );
 }
 
-/*@ null @*/ static GncSqlStatement*
-build_insert_statement( GncSqlBackend* be,
-                        const gchar* table_name,
-                        QofIdTypeConst obj_name, gpointer pObject,
-                        const GncSqlColumnTableEntry* table )
+/* The parts of the statements that only depend on the table description
+ * are built the first time the table is written and kept from then on. */
+typedef struct
 {
-    GncSqlStatement* stmt;
-    GString* sql;
-    GSList* values;
-    GSList* node;
-    gchar* sqlbuf;
+    /*@ only @*/ gchar* table_name;
+    /*@ dependent @*/ const GncSqlColumnTableEntry* table;
+    /*@ only @*/ gchar* insert_sql;		/* INSERT INTO t(c1,c2,...) VALUES */
+    /*@ only @*/ gchar* update_sql;		/* UPDATE t SET */
+    /*@ only @*/ GPtrArray* colnames;
+} GncSqlTableStatements;
+
+static /*@ null @*//*@ only @*/ GHashTable* g_tableStatementsHash = NULL;
+
+static guint
+table_statements_hash( gconstpointer key )
+{
+    const GncSqlTableStatements* stmts = static_cast<const GncSqlTableStatements*>(key);
+
+    return g_str_hash( stmts->table_name ) ^ g_direct_hash( stmts->table );
+}
+
+static gboolean
+table_statements_equal( gconstpointer a, gconstpointer b )
+{
+    const GncSqlTableStatements* stmts_a = static_cast<const GncSqlTableStatements*>(a);
+    const GncSqlTableStatements* stmts_b = static_cast<const GncSqlTableStatements*>(b);
+
+    return stmts_a->table == stmts_b->table &&
+           g_strcmp0( stmts_a->table_name, stmts_b->table_name ) == 0;
+}
+
+/*@ dependent @*/ static const GncSqlTableStatements*
+get_table_statements( const gchar* table_name, const GncSqlColumnTableEntry* table )
+{
+    GncSqlTableStatements key;
+    GncSqlTableStatements* stmts;
     GList* colnames = NULL;
     GList* colname;
     const GncSqlColumnTableEntry* table_row;
+    GString* sql;
+    guint i;
 
-    g_return_val_if_fail( be != NULL, NULL );
-    g_return_val_if_fail( table_name != NULL, NULL );
-    g_return_val_if_fail( obj_name != NULL, NULL );
-    g_return_val_if_fail( pObject != NULL, NULL );
-    g_return_val_if_fail( table != NULL, NULL );
+    if ( g_tableStatementsHash == NULL )
+    {
+        g_tableStatementsHash = g_hash_table_new( table_statements_hash,
+                                table_statements_equal );
+    }
 
-    sqlbuf = g_strdup_printf( "INSERT INTO %s(", table_name );
-    sql = g_string_new( sqlbuf );
-    g_free( sqlbuf );
+    key.table_name = const_cast<gchar*>(table_name);
+    key.table = table;
+    stmts = static_cast<GncSqlTableStatements*>(
+                g_hash_table_lookup( g_tableStatementsHash, &key ));
+    if ( stmts != NULL )
+    {
+        return stmts;
+    }
 
-    // Get all col names and all values
+    // Get all col names
     for ( table_row = table; table_row->col_name != NULL; table_row++ )
     {
         if (( table_row->flags & COL_AUTOINC ) == 0 )
@@ -2907,18 +2993,44 @@ build_insert_statement( GncSqlBackend* be,
     }
     g_assert( colnames != NULL );
 
+    stmts = g_new0( GncSqlTableStatements, 1 );
+    stmts->table_name = g_strdup( table_name );
+    stmts->table = table;
+    stmts->colnames = g_ptr_array_new();
     for ( colname = colnames; colname != NULL; colname = colname->next )
     {
-        if ( colname != colnames )
+        g_ptr_array_add( stmts->colnames, colname->data );
+    }
+    g_list_free( colnames );
+
+    sql = g_string_new( NULL );
+    g_string_printf( sql, "INSERT INTO %s(", table_name );
+    for ( i = 0; i < stmts->colnames->len; i++ )
+    {
+        if ( i != 0 )
         {
-            g_string_append( sql, "," );
+            (void)g_string_append( sql, "," );
         }
-        g_string_append( sql, (gchar*)colname->data );
-        g_free( colname->data );
+        (void)g_string_append( sql, (gchar*)g_ptr_array_index( stmts->colnames, i ) );
     }
-    g_list_free( colnames );
+    (void)g_string_append( sql, ") VALUES" );
+    stmts->insert_sql = g_string_free( sql, FALSE );
+    stmts->update_sql = g_strdup_printf( "UPDATE %s SET ", table_name );
+
+    g_hash_table_insert( g_tableStatementsHash, stmts, stmts );
+    return stmts;
+}
 
-    g_string_append( sql, ") VALUES(" );
+/* Appends the object's values as "(v1,v2,...)". */
+static void
+append_insert_values( GncSqlBackend* be, GString* sql,
+                      QofIdTypeConst obj_name, gpointer pObject,
+                      const GncSqlColumnTableEntry* table )
+{
+    GSList* values;
+    GSList* node;
+
+    (void)g_string_append( sql, "(" );
     values = create_gslist_from_values( be, obj_name, pObject, table );
     for ( node = values; node != NULL; node = node->next )
     {
@@ -2935,6 +3047,25 @@ build_insert_statement( GncSqlBackend* be,
     }
     free_gvalue_list( values );
     (void)g_string_append( sql, ")" );
+}
+
+/*@ null @*/ static GncSqlStatement*
+build_insert_statement( GncSqlBackend* be,
+                        const gchar* table_name,
+                        QofIdTypeConst obj_name, gpointer pObject,
+                        const GncSqlColumnTableEntry* table )
+{
+    GncSqlStatement* stmt;
+    GString* sql;
+
+    g_return_val_if_fail( be != NULL, NULL );
+    g_return_val_if_fail( table_name != NULL, NULL );
+    g_return_val_if_fail( obj_name != NULL, NULL );
+    g_return_val_if_fail( pObject != NULL, NULL );
+    g_return_val_if_fail( table != NULL, NULL );
+
+    sql = g_string_new( get_table_statements( table_name, table )->insert_sql );
+    append_insert_values( be, sql, obj_name, pObject, table );
 
     stmt = gnc_sql_connection_create_statement_from_sql( be->conn, sql->str );
     (void)g_string_free( sql, TRUE );
@@ -2949,14 +3080,11 @@ build_update_statement( GncSqlBackend* be,
                         const GncSqlColumnTableEntry* table )
 {
     GncSqlStatement* stmt;
+    const GncSqlTableStatements* stmts;
     GString* sql;
     GSList* values;
-    GList* colnames = NULL;
     GSList* value;
-    GList* colname;
-    gboolean firstCol;
-    const GncSqlColumnTableEntry* table_row;
-    gchar* sqlbuf;
+    guint colname;
 
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( table_name != NULL, NULL );
@@ -2965,49 +3093,28 @@ build_update_statement( GncSqlBackend* be,
     g_return_val_if_fail( table != NULL, NULL );
 
     // Get all col names and all values
-    for ( table_row = table; table_row->col_name != NULL; table_row++ )
-    {
-        if (( table_row->flags & COL_AUTOINC ) == 0 )
-        {
-            GncSqlColumnTypeHandler* pHandler;
-
-            // Add col names to the list
-            pHandler = get_handler( table_row );
-            g_assert( pHandler != NULL );
-            pHandler->add_colname_to_list_fn( table_row, &colnames );
-        }
-    }
-    g_assert( colnames != NULL );
+    stmts = get_table_statements( table_name, table );
     values = create_gslist_from_values( be, obj_name, pObject, table );
 
     // Create the SQL statement
-    sqlbuf = g_strdup_printf( "UPDATE %s SET ", table_name );
-    sql = g_string_new( sqlbuf );
-    g_free( sqlbuf );
+    sql = g_string_new( stmts->update_sql );
 
-    firstCol = TRUE;
-    for ( colname = colnames->next, value = values->next;
-            colname != NULL && value != NULL;
-            colname = colname->next, value = value->next )
+    for ( colname = 1, value = values->next;
+            colname < stmts->colnames->len && value != NULL;
+            colname++, value = value->next )
     {
         gchar* value_str;
-        if ( !firstCol )
+        if ( colname != 1 )
         {
             (void)g_string_append( sql, "," );
         }
-        (void)g_string_append( sql, (gchar*)colname->data );
+        (void)g_string_append( sql, (gchar*)g_ptr_array_index( stmts->colnames, colname ) );
         (void)g_string_append( sql, "=" );
         value_str = gnc_sql_get_sql_value( be->conn, (GValue*)(value->data) );
         (void)g_string_append( sql, value_str );
         g_free( value_str );
-        firstCol = FALSE;
-    }
-    for ( colname = colnames; colname != NULL; colname = colname->next )
-    {
-        g_free( colname->data );
     }
-    g_list_free( colnames );
-    if ( value != NULL || colname != NULL )
+    if ( value != NULL || colname != stmts->colnames->len )
     {
         PERR( "Mismatch in number of column names and values" );
     }
@@ -3052,6 +3159,161 @@ build_delete_statement( GncSqlBackend* be,
     return stmt;
 }
 
+/* ================================================================= */
+/* While a batch is open, rows inserted into a table are collected into a
+ * single "INSERT INTO t(...) VALUES(...),(...),..." and sent when it has
+ * grown big enough or something else needs the database.  The row limit
+ * stays below SQLite's default limit of 500 terms in a compound SELECT,
+ * which is what older versions turn multi-row VALUES into. */
+#define INSERT_BATCH_MAX_ROWS 250
+#define INSERT_BATCH_MAX_BYTES (256 * 1024)
+
+typedef struct
+{
+    /*@ dependent @*/ const GncSqlTableStatements* stmts;
+    /*@ only @*/ GString* sql;
+    guint rows;
+} GncSqlInsertBatch;
+
+static gboolean
+send_insert_batch( GncSqlBackend* be, GncSqlInsertBatch* batch )
+{
+    GncSqlStatement* stmt;
+    gboolean ok = FALSE;
+
+    if ( batch->rows == 0 )
+    {
+        return TRUE;
+    }
+
+    stmt = gnc_sql_connection_create_statement_from_sql( be->conn, batch->sql->str );
+    if ( stmt != NULL )
+    {
+        be->statement_count++;
+        ok = gnc_sql_connection_execute_nonselect_statement( be->conn, stmt ) != -1;
+        gnc_sql_statement_dispose( stmt );
+    }
+    if ( !ok )
+    {
+        PERR( "SQL error inserting %u rows into %s", batch->rows,
+              batch->stmts->table_name );
+        qof_backend_set_error( &be->be, ERR_BACKEND_SERVER_ERR );
+        be->insert_batch_ok = FALSE;
+    }
+
+    (void)g_string_assign( batch->sql, batch->stmts->insert_sql );
+    batch->rows = 0;
+
+    return ok;
+}
+
+/* Sends the batched rows for table_name, or for all tables if it is NULL. */
+static gboolean
+flush_insert_batches( GncSqlBackend* be, /*@ null @*/ const gchar* table_name )
+{
+    GList* node;
+    gboolean ok = TRUE;
+
+    for ( node = be->insert_batches; node != NULL; node = node->next )
+    {
+        GncSqlInsertBatch* batch = static_cast<GncSqlInsertBatch*>(node->data);
+
+        if ( table_name == NULL ||
+                g_strcmp0( table_name, batch->stmts->table_name ) == 0 )
+        {
+            if ( !send_insert_batch( be, batch ) )
+            {
+                ok = FALSE;
+            }
+        }
+    }
+
+    return ok;
+}
+
+static gboolean
+add_to_insert_batch( GncSqlBackend* be, const gchar* table_name,
+                     QofIdTypeConst obj_name, gpointer pObject,
+                     const GncSqlColumnTableEntry* table )
+{
+    const GncSqlTableStatements* stmts;
+    GncSqlInsertBatch* batch = NULL;
+    GList* node;
+
+    stmts = get_table_statements( table_name, table );
+    for ( node = be->insert_batches; node != NULL; node = node->next )
+    {
+        if ( static_cast<GncSqlInsertBatch*>(node->data)->stmts == stmts )
+        {
+            batch = static_cast<GncSqlInsertBatch*>(node->data);
+            break;
+        }
+    }
+    if ( batch == NULL )
+    {
+        batch = g_new0( GncSqlInsertBatch, 1 );
+        batch->stmts = stmts;
+        batch->sql = g_string_new( stmts->insert_sql );
+        be->insert_batches = g_list_append( be->insert_batches, batch );
+    }
+
+    if ( batch->rows != 0 )
+    {
+        (void)g_string_append( batch->sql, "," );
+    }
+    append_insert_values( be, batch->sql, obj_name, pObject, table );
+    batch->rows++;
+
+    if ( batch->rows >= INSERT_BATCH_MAX_ROWS ||
+            batch->sql->len >= INSERT_BATCH_MAX_BYTES )
+    {
+        return send_insert_batch( be, batch );
+    }
+    return TRUE;
+}
+
+void
+gnc_sql_begin_insert_batch( GncSqlBackend* be )
+{
+    g_return_if_fail( be != NULL );
+
+    be->batching_inserts = TRUE;
+    be->insert_batch_ok = TRUE;
+}
+
+gboolean
+gnc_sql_end_insert_batch( GncSqlBackend* be )
+{
+    GList* node;
+    gboolean ok;
+
+    g_return_val_if_fail( be != NULL, FALSE );
+
+    (void)flush_insert_batches( be, NULL );
+    ok = be->insert_batch_ok;
+
+    for ( node = be->insert_batches; node != NULL; node = node->next )
+    {
+        GncSqlInsertBatch* batch = static_cast<GncSqlInsertBatch*>(node->data);
+
+        (void)g_string_free( batch->sql, TRUE );
+        g_free( batch );
+    }
+    g_list_free( be->insert_batches );
+    be->insert_batches = NULL;
+    be->batching_inserts = FALSE;
+
+    return ok;
+}
+
+guint
+gnc_sql_get_statement_count( const GncSqlBackend* be )
+{
+    g_return_val_if_fail( be != NULL, 0 );
+
+    return be->statement_count;
+}
+
 /* ================================================================= */
 gboolean
 gnc_sql_commit_standard_item( GncSqlBackend* be, QofInstance* inst, const gchar* tableName,
@@ -64,6 +64,13 @@ struct GncSqlBackend
     gint operations_done;			/**< Number of operations (save/load) done */
     GHashTable* versions;			/**< Version number for each table */
     const gchar* timespec_format;	/**< Format string for SQL for timespec values */
+    GList* insert_batches;		/**< Pending multi-row INSERTs, one per table */
+    gboolean batching_inserts;	/**< Are inserts being batched? */
+    gboolean insert_batch_ok;		/**< Have all batched inserts succeeded? */
+    guint statement_count;		/**< Number of queries and updates sent */
+    gboolean load_tx_on_demand;	/**< Are transactions only loaded when needed? */
+    gboolean all_tx_loaded;		/**< Are all transactions in memory? */
+    GHashTable* tx_loaded_from;	/**< Account GUID -> earliest post date loaded */
 };
 typedef struct GncSqlBackend GncSqlBackend;
 
@@ -672,6 +679,39 @@ void gnc_sql_add_subtable_colnames_to_list( const GncSqlColumnTableEntry* table_
  */
 gchar* gnc_sql_get_sql_value( const GncSqlConnection* conn, const GValue* value );
 
+/**
+ * Starts collecting inserts made with gnc_sql_do_db_operation().
+ *
+ * Until gnc_sql_end_insert_batch(), rows inserted into the same table are
+ * sent as one multi-row INSERT once enough of them have piled up.  Any
+ * other statement sends the pending rows first, except that
+ * gnc_sql_object_is_it_in_db() only sends those for its own table.  Rows
+ * for different tables may therefore reach the database in a different
+ * order than they were inserted.
+ *
+ * @param be SQL backend struct
+ */
+void gnc_sql_begin_insert_batch( GncSqlBackend* be );
+
+/**
+ * Sends whatever is left of the batched inserts and stops batching.
+ *
+ * @param be SQL backend struct
+ * @return TRUE if all batched inserts succeeded, FALSE otherwise
+ */
+gboolean gnc_sql_end_insert_batch( GncSqlBackend* be );
+
+/**
+ * Returns the number of queries and updates sent to the database so far,
+ * counting each batch of inserts once.  Table creation and other schema
+ * changes aren't counted.  Comparing the count before and after a commit
+ * shows how many statements the commit needed.
+ *
+ * @param be SQL backend struct
+ * @return Number of statements
+ */
+guint gnc_sql_get_statement_count( const GncSqlBackend* be );
+
 /**
  * Initializes DB table version information.
  *
@@ -94,6 +94,7 @@ static GDate* get_gdate_val( gpointer pObject );
 static void set_gdate_val( gpointer pObject, GDate* value );
 static slot_info_t *slot_info_copy( slot_info_t *pInfo, GncGUID *guid );
 static void slots_load_info( slot_info_t *pInfo );
+static void slots_load_rows( slot_info_t *pInfo, /*@ null @*/ GHashTable* saved_rows );
 
 #define SLOT_MAX_PATHNAME_LEN 4096
 #define SLOT_MAX_STRINGVAL_LEN 4096
@@ -706,6 +707,253 @@ save_slot( const gchar* key, KvpValue* value, gpointer data )
     (void)g_string_truncate( pSlot_info->path, curlen );
 }
 
+/* A row of the object's slots as it is in the db.  Rows of frames and
+ * lists point to the rows holding their contents. */
+typedef struct
+{
+    gint64 id;
+    GncGUID child_guid;
+    gboolean has_child;
+} saved_slot_t;
+
+static void
+free_saved_slots( gpointer data )
+{
+    GSList* node;
+
+    for ( node = (GSList*)data; node != NULL; node = node->next )
+    {
+        g_slice_free( saved_slot_t, node->data );
+    }
+    g_slist_free( (GSList*)data );
+}
+
+/* Files the row under the top-level key it belongs to. */
+static void
+add_saved_slot( GHashTable* saved_rows, GncSqlRow* row )
+{
+    const GValue* val;
+    saved_slot_t* saved;
+    gchar* key;
+    gchar* sep;
+    GSList* list;
+
+    val = gnc_sql_row_get_value_at_col_name( row, col_table[name_col].col_name );
+    if ( val == NULL || !G_VALUE_HOLDS_STRING( val ) ||
+            g_value_get_string( val ) == NULL )
+    {
+        return;
+    }
+    key = g_strdup( g_value_get_string( val ) );
+    sep = strchr( key, '/' );
+    if ( sep != NULL )
+    {
+        *sep = '\0';
+    }
+
+    saved = g_slice_new0( saved_slot_t );
+    val = gnc_sql_row_get_value_at_col_name( row, col_table[id_col].col_name );
+    if ( val != NULL )
+    {
+        saved->id = gnc_sql_get_integer_value( val );
+    }
+    val = gnc_sql_row_get_value_at_col_name( row, col_table[slot_type_col].col_name );
+    if ( val != NULL )
+    {
+        auto type = static_cast<KvpValue::Type>(gnc_sql_get_integer_value( val ));
+        if ( type == KvpValue::Type::FRAME || type == KvpValue::Type::GLIST )
+        {
+            val = gnc_sql_row_get_value_at_col_name( row, col_table[guid_val_col].col_name );
+        }
+        else
+        {
+            val = NULL;
+        }
+    }
+    if ( val != NULL && G_VALUE_HOLDS_STRING( val ) &&
+            g_value_get_string( val ) != NULL )
+    {
+        saved->has_child = string_to_guid( g_value_get_string( val ),
+                                           &saved->child_guid );
+    }
+
+    list = (GSList*)g_hash_table_lookup( saved_rows, key );
+    if ( list != NULL )
+    {
+        // Appending keeps the head, so the table still points to the list
+        (void)g_slist_append( list, saved );
+        g_free( key );
+    }
+    else
+    {
+        g_hash_table_insert( saved_rows, key, g_slist_append( NULL, saved ) );
+    }
+}
+
+/* Deletes the rows, together with whatever frames and lists they hold. */
+static gboolean
+delete_saved_slots( GncSqlBackend* be, GHashTable* saved_rows, GSList* keys )
+{
+    GString* sql;
+    GSList* key;
+    gboolean first = TRUE;
+    gboolean is_ok = TRUE;
+
+    if ( keys == NULL ) return TRUE;
+
+    sql = g_string_new( NULL );
+    g_string_printf( sql, "DELETE FROM %s WHERE id IN (", TABLE_NAME );
+    for ( key = keys; key != NULL; key = key->next )
+    {
+        GSList* node;
+
+        for ( node = (GSList*)g_hash_table_lookup( saved_rows, key->data );
+                node != NULL; node = node->next )
+        {
+            saved_slot_t* saved = (saved_slot_t*)node->data;
+
+            if ( saved->has_child && is_ok )
+            {
+                is_ok = gnc_sql_slots_delete( be, &saved->child_guid );
+            }
+            g_string_append_printf( sql, "%s%" G_GINT64_FORMAT,
+                                    first ? "" : ",", saved->id );
+            first = FALSE;
+        }
+    }
+    (void)g_string_append( sql, ")" );
+
+    if ( is_ok && gnc_sql_execute_nonselect_sql( be, sql->str ) == -1 )
+    {
+        PERR( "SQL error: %s\n", sql->str );
+        qof_backend_set_error( &be->be, ERR_BACKEND_SERVER_ERR );
+        is_ok = FALSE;
+    }
+    (void)g_string_free( sql, TRUE );
+
+    return is_ok;
+}
+
+static gboolean slot_value_is_saved( const KvpValue* saved, const KvpValue* value );
+
+static gboolean
+slot_frame_is_saved( KvpFrame* saved, KvpFrame* frame )
+{
+    if ( saved == NULL || frame == NULL ) return saved == frame;
+    if ( saved->get_keys().size() != frame->get_keys().size() ) return FALSE;
+    for ( auto& key : frame->get_keys() )
+    {
+        if ( !slot_value_is_saved( saved->get_slot( key.c_str() ),
+                                   frame->get_slot( key.c_str() ) ) )
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Whether saving value would write the rows saved was loaded from.  This
+ * isn't compare(): a numeric is saved with its denominator, so 1/2 and
+ * 50/100 differ, while a timespec is only saved to the second. */
+static gboolean
+slot_value_is_saved( const KvpValue* saved, const KvpValue* value )
+{
+    if ( saved == NULL || value == NULL ) return saved == value;
+    if ( saved->get_type() != value->get_type() ) return FALSE;
+
+    switch ( value->get_type() )
+    {
+    case KvpValue::Type::NUMERIC:
+    {
+        auto saved_num = saved->get<gnc_numeric>();
+        auto num = value->get<gnc_numeric>();
+        return saved_num.num == num.num && saved_num.denom == num.denom;
+    }
+    case KvpValue::Type::TIMESPEC:
+        return timespecToTime64( saved->get<Timespec>() ) ==
+               timespecToTime64( value->get<Timespec>() );
+    case KvpValue::Type::FRAME:
+        return slot_frame_is_saved( saved->get<KvpFrame*>(),
+                                    value->get<KvpFrame*>() );
+    case KvpValue::Type::GLIST:
+    {
+        GList* saved_node = saved->get<GList*>();
+        GList* node = value->get<GList*>();
+
+        for ( ; saved_node != NULL && node != NULL;
+                saved_node = saved_node->next, node = node->next )
+        {
+            if ( !slot_value_is_saved( (KvpValue*)saved_node->data,
+                                       (KvpValue*)node->data ) )
+            {
+                return FALSE;
+            }
+        }
+        return saved_node == NULL && node == NULL;
+    }
+    default:
+        return compare( saved, value ) == 0;
+    }
+}
+
+/* Reads back what is saved for the object and only replaces the top-level
+ * slots whose value isn't the same any more.  A change anywhere inside a
+ * frame or list replaces all of it. */
+static void
+save_changed_slots( slot_info_t* pInfo, KvpFrame* pFrame )
+{
+    KvpFrame saved_frame;
+    slot_info_t load_info = { pInfo->be, pInfo->guid, TRUE, &saved_frame,
+                              KvpValue::Type::INVALID, NULL, NONE, NULL,
+                              g_string_new(NULL)
+                            };
+    GHashTable* saved_rows;
+    GHashTableIter iter;
+    gpointer key;
+    GSList* changed = NULL;
+
+    saved_rows = g_hash_table_new_full( g_str_hash, g_str_equal,
+                                        g_free, free_saved_slots );
+    slots_load_rows( &load_info, saved_rows );
+    if ( load_info.path != NULL )
+    {
+        (void)g_string_free( load_info.path, TRUE );
+    }
+
+    /* A slot whose rows are in the db is kept if saving its value now
+     * would write the same rows again. */
+    g_hash_table_iter_init( &iter, saved_rows );
+    while ( g_hash_table_iter_next( &iter, &key, NULL ) )
+    {
+        auto saved_value = saved_frame.get_slot( (const gchar*)key );
+        auto value = pFrame->get_slot( (const gchar*)key );
+
+        if ( saved_value == NULL || value == NULL ||
+                !slot_value_is_saved( saved_value, value ) )
+        {
+            changed = g_slist_prepend( changed, key );
+        }
+    }
+    pInfo->is_ok = delete_saved_slots( pInfo->be, saved_rows, changed );
+
+    for ( auto& key_str : pFrame->get_keys() )
+    {
+        const gchar* slot_key = key_str.c_str();
+
+        if ( !pInfo->is_ok ) break;
+
+        if ( g_hash_table_lookup( saved_rows, slot_key ) == NULL ||
+                g_slist_find_custom( changed, slot_key,
+                                     (GCompareFunc)g_strcmp0 ) != NULL )
+        {
+            save_slot( slot_key, pFrame->get_slot( slot_key ), pInfo );
+        }
+    }
+
+    g_slist_free( changed );
+    g_hash_table_destroy( saved_rows );
+}
+
 gboolean
 gnc_sql_slots_save( GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
                     QofInstance *inst)
@@ -717,15 +965,18 @@ gnc_sql_slots_save( GncSqlBackend* be, const GncGUID* guid, gboolean is_infant,
     g_return_val_if_fail( guid != NULL, FALSE );
     g_return_val_if_fail( pFrame != NULL, FALSE );
 
-    // If this is not saving into a new db, clear out the old saved slots first
+    slot_info.be = be;
+    slot_info.guid = guid;
+
+    // If this is not saving into a new db, only rewrite what has changed
     if ( !be->is_pristine_db && !is_infant )
     {
-        (void)gnc_sql_slots_delete( be, guid );
+        save_changed_slots( &slot_info, pFrame );
+    }
+    else
+    {
+        pFrame->for_each_slot(save_slot, &slot_info);
     }
-
-    slot_info.be = be;
-    slot_info.guid = guid;
-    pFrame->for_each_slot(save_slot, &slot_info);
     (void)g_string_free( slot_info.path, TRUE );
 
     return slot_info.is_ok;
@@ -834,6 +1085,14 @@ gnc_sql_slots_load( GncSqlBackend* be, QofInstance* inst )
 
 static void
 slots_load_info ( slot_info_t *pInfo )
+{
+    slots_load_rows( pInfo, NULL );
+}
+
+/* Loads the slots into pInfo's frame and, if saved_rows isn't NULL, keeps
+ * track of which rows they came from. */
+static void
+slots_load_rows( slot_info_t *pInfo, /*@ null @*/ GHashTable* saved_rows )
 {
     gchar* buf;
     GncSqlResult* result;
@@ -862,6 +1121,10 @@ slots_load_info ( slot_info_t *pInfo )
             while ( row != NULL )
             {
                 load_slot( pInfo, row );
+                if ( saved_rows != NULL )
+                {
+                    add_saved_slot( saved_rows, row );
+                }
                 row = gnc_sql_result_get_next_row( result );
             }
             gnc_sql_result_dispose( result );
@@ -39,6 +39,11 @@ extern "C"
 /**
  * gnc_sql_slots_save - Saves slots for an object to the db.
  *
+ * If the object is already in the db, its saved slots are read back and
+ * only the top-level slots that changed are deleted and reinserted.
+ * Reading them back takes one query, plus one for each frame or list
+ * among the saved slots, however deeply nested.
+ *
  * @param be SQL backend
  * @param guid Object guid
  * @param is_infant Is this an infant object?
@@ -36,6 +36,7 @@ extern "C"
 #include "qofquerycore-p.h"
 
 #include "Account.h"
+#include "AccountP.h"
 #include "Transaction.h"
 #include "gnc-lot.h"
 #include "engine-helpers.h"
@@ -47,15 +48,11 @@ extern "C"
 #endif
 }
 
-#include "escape.h"
-
 #include "gnc-backend-sql.h"
 #include "gnc-transaction-sql.h"
 #include "gnc-commodity-sql.h"
 #include "gnc-slots-sql.h"
 
-#define SIMPLE_QUERY_COMPILATION 1
-#define LOAD_TRANSACTIONS_AS_NEEDED 0
 
 static QofLogModule log_module = G_LOG_DOMAIN;
 
@@ -318,21 +315,108 @@ load_single_tx( GncSqlBackend* be, GncSqlRow* row )
 }
 
 /**
- * Structure to hold start/end balances for each account.  The values are
- * saved before splits are loaded, and then used to adjust the start balances
- * so that the end balances (which are calculated and correct on initial load)
- * are unchanged.
+ * Amounts of the splits just loaded into an account.
  */
 typedef struct
 {
-    /*@ dependent @*/ Account* acc;
-    gnc_numeric start_bal;
-    gnc_numeric end_bal;
-    gnc_numeric start_cleared_bal;
-    gnc_numeric end_cleared_bal;
-    gnc_numeric start_reconciled_bal;
-    gnc_numeric end_reconciled_bal;
-} full_acct_balances_t;
+    gnc_numeric balance;
+    gnc_numeric cleared_balance;
+    gnc_numeric reconciled_balance;
+} loaded_amounts_t;
+
+static void
+adjust_start_balance_cb( gpointer key, gpointer value, gpointer user_data )
+{
+    Account* acc = GNC_ACCOUNT(key);
+    loaded_amounts_t* amounts = (loaded_amounts_t*)value;
+    gnc_numeric* start_bal;
+    gnc_numeric* start_c_bal;
+    gnc_numeric* start_r_bal;
+    gnc_numeric bal, c_bal, r_bal;
+
+    g_object_get( acc,
+                  "start-balance", &start_bal,
+                  "start-cleared-balance", &start_c_bal,
+                  "start-reconciled-balance", &start_r_bal,
+                  NULL );
+    bal = gnc_numeric_sub( *start_bal, amounts->balance,
+                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+    c_bal = gnc_numeric_sub( *start_c_bal, amounts->cleared_balance,
+                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+    r_bal = gnc_numeric_sub( *start_r_bal, amounts->reconciled_balance,
+                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+
+    qof_instance_increase_editlevel (acc);
+    g_object_set( acc,
+                  "start-balance", &bal,
+                  "start-cleared-balance", &c_bal,
+                  "start-reconciled-balance", &r_bal,
+                  NULL );
+    qof_instance_decrease_editlevel (acc);
+
+    g_free( start_bal );
+    g_free( start_c_bal );
+    g_free( start_r_bal );
+}
+
+/**
+ * When transactions are loaded on demand, the account starting balances
+ * include every split which hasn't been loaded yet.  Takes the splits of
+ * the newly loaded transactions back out of them so that the end balances
+ * stay the same.
+ *
+ * @param tx_list List of newly loaded transactions
+ */
+static void
+adjust_start_balances( GList* tx_list )
+{
+    GHashTable* amounts_by_acct;
+    GList* node;
+
+    amounts_by_acct = g_hash_table_new_full( g_direct_hash, g_direct_equal,
+                      NULL, g_free );
+    for ( node = tx_list; node != NULL; node = node->next )
+    {
+        GList* snode;
+
+        for ( snode = xaccTransGetSplitList( GNC_TRANSACTION(node->data) );
+                snode != NULL; snode = snode->next )
+        {
+            Split* split = GNC_SPLIT(snode->data);
+            Account* acc = xaccSplitGetAccount( split );
+            gnc_numeric amount = xaccSplitGetAmount( split );
+            char state = xaccSplitGetReconcile( split );
+            loaded_amounts_t* amounts;
+
+            if ( acc == NULL ) continue;
+            amounts = static_cast<decltype(amounts)>(
+                g_hash_table_lookup( amounts_by_acct, acc ));
+            if ( amounts == NULL )
+            {
+                amounts = g_new( loaded_amounts_t, 1 );
+                amounts->balance = gnc_numeric_zero();
+                amounts->cleared_balance = gnc_numeric_zero();
+                amounts->reconciled_balance = gnc_numeric_zero();
+                g_hash_table_insert( amounts_by_acct, acc, amounts );
+            }
+
+            amounts->balance = gnc_numeric_add( amounts->balance, amount,
+                                                GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+            if ( state != NREC )
+            {
+                amounts->cleared_balance = gnc_numeric_add( amounts->cleared_balance, amount,
+                                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+            }
+            if ( state == YREC || state == FREC )
+            {
+                amounts->reconciled_balance = gnc_numeric_add( amounts->reconciled_balance, amount,
+                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+            }
+        }
+    }
+    g_hash_table_foreach( amounts_by_acct, adjust_start_balance_cb, NULL );
+    g_hash_table_destroy( amounts_by_acct );
+}
 
 /**
  * Executes a transaction query statement and loads the transactions and all
@@ -356,20 +440,6 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
         GList* node;
         GncSqlRow* row;
         Transaction* tx;
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        GSList* bal_list = NULL;
-        GSList* nextbal;
-        Account* root = gnc_book_get_root_account( be->book );
-
-        qof_event_suspend();
-        xaccAccountBeginEdit( root );
-
-        // Save the start/ending balances (balance, cleared and reconciled) for
-        // every account.
-        gnc_account_foreach_descendant( gnc_book_get_root_account( be->primary_book ),
-                                        save_account_balances,
-                                        &bal_list );
-#endif
 
         // Load the transactions
         row = gnc_sql_result_get_first_row( result );
@@ -391,6 +461,12 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
             load_splits_for_tx_list( be, tx_list );
         }
 
+        // The account balances already count these splits
+        if ( be->load_tx_on_demand && tx_list != NULL )
+        {
+            adjust_start_balances( tx_list );
+        }
+
         // Commit all of the transactions
         for ( node = tx_list; node != NULL; node = node->next )
         {
@@ -398,67 +474,6 @@ query_transactions( GncSqlBackend* be, GncSqlStatement* stmt )
             xaccTransCommitEdit( pTx );
         }
         g_list_free( tx_list );
-
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        // Update the account balances based on the loaded splits.  If the end
-        // balance has changed, update the start balance so that the end
-        // balance is the same as it was before the splits were loaded.
-        // Repeat for cleared and reconciled balances.
-        for ( nextbal = bal_list; nextbal != NULL; nextbal = nextbal->next )
-        {
-            full_acct_balances_t* balns = (full_acct_balances_t*)nextbal->data;
-            gnc_numeric* pnew_end_bal;
-            gnc_numeric* pnew_end_c_bal;
-            gnc_numeric* pnew_end_r_bal;
-            gnc_numeric adj;
-
-            g_object_get( balns->acc,
-                          "end-balance", &pnew_end_bal,
-                          "end-cleared-balance", &pnew_end_c_bal,
-                          "end-reconciled-balance", &pnew_end_r_bal,
-                          NULL );
-
-	    qof_instance_increase_editlevel (balns-acc);
-            if ( !gnc_numeric_eq( *pnew_end_bal, balns->end_bal ) )
-            {
-                adj = gnc_numeric_sub( balns->end_bal, *pnew_end_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_bal = gnc_numeric_add( balns->start_bal, adj,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-balance", &balns->start_bal, NULL );
-		qof_instance_decrease_editlevel (balns-acc);
-            }
-            if ( !gnc_numeric_eq( *pnew_end_c_bal, balns->end_cleared_bal ) )
-            {
-                adj = gnc_numeric_sub( balns->end_cleared_bal, *pnew_end_c_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_cleared_bal = gnc_numeric_add( balns->start_cleared_bal, adj,
-                                           GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-cleared-balance", &balns->start_cleared_bal, NULL );
-            }
-            if ( !gnc_numeric_eq( *pnew_end_r_bal, balns->end_reconciled_bal ) )
-            {
-                adj = gnc_numeric_sub( balns->end_reconciled_bal, *pnew_end_r_bal,
-                                       GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                balns->start_reconciled_bal = gnc_numeric_add( balns->start_reconciled_bal, adj,
-                                              GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                g_object_set( balns->acc, "start-reconciled-balance", &balns->start_reconciled_bal, NULL );
-            }
-	    qof_instance_decrease_editlevel (balns-acc);
-            xaccAccountRecomputeBalance( balns->acc );
-            g_free( pnew_end_bal );
-            g_free( pnew_end_c_bal );
-            g_free( pnew_end_r_bal );
-            g_free( balns );
-        }
-        if ( bal_list != NULL )
-        {
-            g_slist_free( bal_list );
-        }
-
-        xaccAccountCommitEdit( root );
-        qof_event_resume();
-#endif
     }
 }
 
@@ -798,6 +813,61 @@ commit_transaction( GncSqlBackend* be, QofInstance* inst )
 }
 
 /* ================================================================= */
+/* When transactions are loaded on demand, be->tx_loaded_from maps the guid
+ * of each account which has been read to the earliest post date read for
+ * it.  Every transaction with a split in the account posted on or after
+ * that date is in memory, so the running balances from there on are
+ * right.  The account is told the same date, so that it only trusts
+ * those and asks for more before looking further back. */
+#define TX_ALL_DATES G_MININT64
+
+static gboolean
+tx_loaded_for_account( const GncSqlBackend* be, const GncGUID* guid, time64 from )
+{
+    time64* loaded_from;
+
+    if ( be->all_tx_loaded ) return TRUE;
+    if ( be->tx_loaded_from == NULL ) return FALSE;
+
+    loaded_from = static_cast<decltype(loaded_from)>(
+        g_hash_table_lookup( be->tx_loaded_from, guid ));
+    return loaded_from != NULL && *loaded_from <= from;
+}
+
+static void
+set_tx_loaded_for_account( GncSqlBackend* be, const GncGUID* guid, time64 from )
+{
+    time64* loaded_from;
+    Account* account;
+
+    if ( be->tx_loaded_from == NULL ) return;
+
+    loaded_from = static_cast<decltype(loaded_from)>(
+        g_hash_table_lookup( be->tx_loaded_from, guid ));
+    if ( loaded_from == NULL )
+    {
+        loaded_from = g_new( time64, 1 );
+        *loaded_from = from;
+        g_hash_table_insert( be->tx_loaded_from, guid_copy( guid ), loaded_from );
+    }
+    else if ( from < *loaded_from )
+    {
+        *loaded_from = from;
+    }
+
+    account = xaccAccountLookup( guid, be->book );
+    if ( account != NULL )
+    {
+        gnc_account_set_splits_loaded_from( account, *loaded_from );
+    }
+}
+
+static void
+set_all_tx_loaded_cb( Account* account, gpointer data )
+{
+    gnc_account_set_splits_loaded_from( account, TX_ALL_DATES );
+}
+
 /**
  * Loads all transactions for an account.
  *
@@ -815,6 +885,8 @@ void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* accoun
     g_return_if_fail( account != NULL );
 
     guid = qof_instance_get_guid( QOF_INSTANCE(account) );
+    if ( tx_loaded_for_account( be, guid, TX_ALL_DATES ) ) return;
+
     (void)guid_to_string_buff( guid, guid_buf );
     query_sql = g_strdup_printf(
                     "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND s.account_guid ='%s'",
@@ -825,6 +897,7 @@ void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* accoun
     {
         query_transactions( be, stmt );
         gnc_sql_statement_dispose( stmt );
+        set_tx_loaded_for_account( be, guid, TX_ALL_DATES );
     }
 }
 
@@ -841,6 +914,8 @@ void gnc_sql_transaction_load_all_tx( GncSqlBackend* be )
 
     g_return_if_fail( be != NULL );
 
+    if ( be->all_tx_loaded ) return;
+
     query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
     stmt = gnc_sql_create_statement_from_sql( be, query_sql );
     g_free( query_sql );
@@ -848,422 +923,296 @@ void gnc_sql_transaction_load_all_tx( GncSqlBackend* be )
     {
         query_transactions( be, stmt );
         gnc_sql_statement_dispose( stmt );
+        be->all_tx_loaded = TRUE;
+        gnc_account_foreach_descendant( gnc_book_get_root_account( be->book ),
+                                        set_all_tx_loaded_cb, NULL );
     }
 }
 
+/**
+ * Initial load of the transactions.  Nothing is read if they are to be
+ * loaded on demand; the accounts then start out with the balances of all
+ * of their splits.
+ *
+ * @param be SQL backend
+ */
 static void
-convert_query_comparison_to_sql( QofQueryPredData* pPredData, gboolean isInverted, GString* sql )
+load_initial_tx( GncSqlBackend* be )
 {
-    if ( pPredData->how == QOF_COMPARE_LT
-            || ( isInverted && pPredData->how == QOF_COMPARE_GTE ) )
-    {
-        g_string_append( sql, "<" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_LTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_GT ) )
-    {
-        g_string_append( sql, "<=" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_EQUAL
-              || ( isInverted && pPredData->how == QOF_COMPARE_NEQ ) )
-    {
-        g_string_append( sql, "=" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_GT
-              || ( isInverted && pPredData->how == QOF_COMPARE_LTE ) )
-    {
-        g_string_append( sql, ">" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_GTE
-              || ( isInverted && pPredData->how == QOF_COMPARE_LT ) )
-    {
-        g_string_append( sql, ">=" );
-    }
-    else if ( pPredData->how == QOF_COMPARE_NEQ
-              || ( isInverted && pPredData->how == QOF_COMPARE_EQUAL ) )
-    {
-        g_string_append( sql, "~=" );
-    }
-    else
-    {
-        PERR( "Unknown comparison type\n" );
-        g_string_append( sql, "??" );
-    }
+    g_return_if_fail( be != NULL );
+
+    if ( be->load_tx_on_demand ) return;
+    gnc_sql_transaction_load_all_tx( be );
 }
 
-static void
-convert_query_term_to_sql( const GncSqlBackend* be, const gchar* fieldName, QofQueryTerm* pTerm, GString* sql )
+/* ----------------------------------------------------------------- */
+/* Split queries are run by the engine against the splits in memory.  All
+ * the backend has to do is make sure that every split the query could
+ * match has been loaded, and loading more is harmless, so each OR term is
+ * reduced to the accounts it is limited to and the earliest post date it
+ * can match.  A term which isn't limited to some accounts makes the query
+ * load everything. */
+typedef struct
 {
-    QofQueryPredData* pPredData;
-    gboolean isInverted;
+    GList* account_guids;		/* GncGUID copies */
+    time64 from;				/* Earliest post date needed */
+} split_query_term_t;
 
-    g_return_if_fail( pTerm != NULL );
-    g_return_if_fail( sql != NULL );
+typedef struct
+{
+    gboolean load_all;
+    GList* terms;				/* split_query_term_t, one per OR term */
+} split_query_info_t;
 
-    pPredData = qof_query_term_get_pred_data( pTerm );
-    isInverted = qof_query_term_is_inverted( pTerm );
+static const gchar* split_account_path[] =
+{ SPLIT_ACCOUNT, QOF_PARAM_GUID, NULL };
+static const gchar* split_account_guid_path[] =
+{ SPLIT_ACCOUNT_GUID, NULL };
+static const gchar* tx_split_account_path[] =
+{ SPLIT_TRANS, TRANS_SPLITLIST, SPLIT_ACCOUNT_GUID, NULL };
+static const gchar* tx_date_posted_path[] =
+{ SPLIT_TRANS, TRANS_DATE_POSTED, NULL };
 
-    if ( g_strcmp0( pPredData->type_name, QOF_TYPE_GUID ) == 0 )
+static gboolean
+param_path_equal( GSList* path, const gchar** names )
+{
+    for ( ; path != NULL && *names != NULL; path = path->next, names++ )
     {
-        query_guid_t guid_data = (query_guid_t)pPredData;
-        GList* guid_entry;
-
-        g_string_append( sql, "(" );
-        g_string_append( sql, fieldName );
+        if ( g_strcmp0( (const gchar*)path->data, *names ) != 0 ) return FALSE;
+    }
+    return path == NULL && *names == NULL;
+}
 
-        switch ( guid_data->options )
-        {
-        case QOF_GUID_MATCH_ANY:
-            if ( isInverted ) g_string_append( sql, " NOT IN (" );
-            else g_string_append( sql, " IN (" );
-            break;
+/* The accounts an account guid term limits the splits to, or NULL. */
+static GList*
+get_term_account_guids( QofQueryTerm* term )
+{
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data( term );
+    query_guid_t guid_data = (query_guid_t)pPredData;
+    GList* guids = NULL;
+    GList* node;
 
-        case QOF_GUID_MATCH_NONE:
-            if ( isInverted ) g_string_append( sql, " IN (" );
-            else g_string_append( sql, " NOT IN (" );
-            break;
+    if ( g_strcmp0( pPredData->type_name, QOF_TYPE_GUID ) != 0 ) return NULL;
+    if ( qof_query_term_is_inverted( term ) ) return NULL;
+    if ( guid_data->options != QOF_GUID_MATCH_ANY
+            && guid_data->options != QOF_GUID_MATCH_ALL ) return NULL;
 
-        default:
-            PERR( "Unexpected GncGUID match type: %d\n", guid_data->options );
-        }
+    for ( node = guid_data->guids; node != NULL; node = node->next )
+    {
+        guids = g_list_prepend( guids,
+                                guid_copy( static_cast<GncGUID*>(node->data) ));
+    }
+    return guids;
+}
 
-        for ( guid_entry = guid_data->guids; guid_entry != NULL; guid_entry = guid_entry->next )
-        {
-            gchar guid_buf[GUID_ENCODING_LENGTH+1];
+/* The earliest post date a date term can match. */
+static time64
+get_term_from_date( QofQueryTerm* term )
+{
+    QofQueryPredData* pPredData = qof_query_term_get_pred_data( term );
+    query_date_t date_data = (query_date_t)pPredData;
+    gboolean isInverted = qof_query_term_is_inverted( term );
+    time64 from;
 
-            if ( guid_entry != guid_data->guids ) g_string_append( sql, "," );
-            (void)guid_to_string_buff(static_cast<GncGUID*>(guid_entry->data),
-                                      guid_buf );
-            g_string_append_printf( sql, "'%s'", guid_buf );
-        }
-        g_string_append( sql, "))" );
+    if ( g_strcmp0( pPredData->type_name, QOF_TYPE_DATE ) != 0 ) return TX_ALL_DATES;
 
-    }
-    else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_CHAR ) == 0 )
+    from = date_data->date.tv_sec;
+    if ( date_data->options == QOF_DATE_MATCH_DAY )
     {
-        query_char_t char_data = (query_char_t)pPredData;
-        int i;
-
-        if ( isInverted )
-        {
-            g_string_append( sql, "NOT(" );
-        }
-        if ( char_data->options == QOF_CHAR_MATCH_NONE )
-        {
-            g_string_append( sql, "NOT " );
-        }
-        g_string_append( sql, "(" );
-        for ( i = 0; char_data->char_list[i] != '\0'; i++ )
-        {
-            if ( i != 0 )
-            {
-                g_string_append( sql, " OR " );
-            }
-            g_string_append( sql, fieldName );
-            g_string_append( sql, " = '" );
-            g_string_append_c( sql, char_data->char_list[i] );
-            g_string_append( sql, "'" );
-        }
-        g_string_append( sql, ") " );
-        if ( isInverted )
-        {
-            g_string_append( sql, ") " );
-        }
-
+        from = gnc_time64_get_day_start( from );
     }
-    else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_STRING ) == 0 )
-    {
-        query_string_t string_data = (query_string_t)pPredData;
-        sqlEscape* escape = sqlEscape_new();
-
-        if ( isInverted )
-        {
-            g_string_append( sql, "NOT(" );
-        }
-        if ( pPredData->how == QOF_COMPARE_NEQ )
-        {
-            g_string_append( sql, "NOT(" );
-        }
-        g_string_append( sql, fieldName );
-        if ( string_data->is_regex || string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE )
-        {
-            PWARN( "String is_regex || option = QOF_STRING_MATCH_INSENSITIVE\n" );
-        }
-//			g_string_append( sql, " ~" );
-//		} else {
-        g_string_append( sql, " =" );
-//		}
-//		if( string_data->options == QOF_STRING_MATCH_CASEINSENSITIVE ) {
-//			g_string_append( sql, "*" );
-//		}
-        g_string_append( sql, "'" );
-        g_string_append( sql, sqlEscapeString( escape, string_data->matchstring ) );
-        g_string_append( sql, "'" );
-        if ( pPredData->how == QOF_COMPARE_NEQ )
-        {
-            g_string_append( sql, ")" );
-        }
-        if ( isInverted )
-        {
-            g_string_append( sql, ")" );
-        }
-        sqlEscape_destroy( escape );
 
+    if ( isInverted )
+    {
+        if ( pPredData->how == QOF_COMPARE_LT
+                || pPredData->how == QOF_COMPARE_LTE ) return from;
     }
-    else
+    else if ( pPredData->how == QOF_COMPARE_GT
+              || pPredData->how == QOF_COMPARE_GTE
+              || pPredData->how == QOF_COMPARE_EQUAL )
     {
-        g_string_append( sql, "(" );
-        g_string_append( sql, fieldName );
-        convert_query_comparison_to_sql( pPredData, isInverted, sql );
-
-        if ( strcmp( pPredData->type_name, QOF_TYPE_NUMERIC ) == 0 )
-        {
-            query_numeric_t pData = (query_numeric_t)pPredData;
-            double d = gnc_numeric_to_double( pData->amount );
-
-            g_string_append_printf( sql, "%f", d );
-
-        }
-        else if ( g_strcmp0( pPredData->type_name, QOF_TYPE_DATE ) == 0 )
-        {
-            query_date_t date_data = (query_date_t)pPredData;
-            gchar* datebuf;
-
-            datebuf = gnc_sql_convert_timespec_to_string( be, date_data->date );
-            g_string_append_printf( sql, "'%s'", datebuf );
-
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_INT32 ) == 0 )
-        {
-            query_int32_t pData = (query_int32_t)pPredData;
-
-            g_string_append_printf( sql, "%d", pData->val );
-
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_INT64 ) == 0 )
-        {
-            query_int64_t pData = (query_int64_t)pPredData;
-
-            g_string_append_printf( sql, "%" G_GINT64_FORMAT, pData->val );
-
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_DOUBLE ) == 0 )
-        {
-            query_double_t pData = (query_double_t)pPredData;
-
-            g_string_append_printf( sql, "%f", pData->val );
-
-        }
-        else if ( strcmp( pPredData->type_name, QOF_TYPE_BOOLEAN ) == 0 )
-        {
-            query_boolean_t pData = (query_boolean_t)pPredData;
-
-            g_string_append_printf( sql, "%d", pData->val );
-
-        }
-        else
-        {
-            PERR( "Unknown query predicate type: %s\n", pPredData->type_name );
-        }
-
-        g_string_append( sql, ")" );
+        return from;
     }
+    return TX_ALL_DATES;
 }
 
-typedef struct
-{
-    GncSqlStatement* stmt;
-    gboolean has_been_run;
-} split_query_info_t;
-
-#define TX_GUID_CHECK 0
-
-G_GNUC_UNUSED static /*@ null @*/ gpointer
+static /*@ null @*/ gpointer
 compile_split_query( GncSqlBackend* be, QofQuery* query )
 {
-    split_query_info_t* query_info = NULL;
-    gchar* query_sql;
+    split_query_info_t* query_info;
+    GList* orTerm;
 
     g_return_val_if_fail( be != NULL, NULL );
     g_return_val_if_fail( query != NULL, NULL );
 
-    query_info = static_cast<decltype(query_info)>(
-        g_malloc(sizeof(split_query_info_t)));
-    g_assert( query_info != NULL );
-    query_info->has_been_run = FALSE;
+    query_info = g_new0( split_query_info_t, 1 );
+    if ( !qof_query_has_terms( query ) )
+    {
+        query_info->load_all = TRUE;
+        return query_info;
+    }
 
-    if ( qof_query_has_terms( query ) )
+    for ( orTerm = qof_query_get_terms( query ); orTerm != NULL; orTerm = orTerm->next )
     {
-        GList* orterms = qof_query_get_terms( query );
-        GList* orTerm;
-        GString* sql = g_string_new( "" );
-        gboolean need_OR = FALSE;
+        split_query_term_t* sq_term = g_new0( split_query_term_t, 1 );
+        GList* andTerm;
 
-        for ( orTerm = orterms; orTerm != NULL; orTerm = orTerm->next )
+        sq_term->from = TX_ALL_DATES;
+        for ( andTerm = (GList*)orTerm->data; andTerm != NULL; andTerm = andTerm->next )
         {
-            GList* andterms = (GList*)orTerm->data;
-            GList* andTerm;
-            gboolean need_AND = FALSE;
-#if TX_GUID_CHECK
-            gboolean has_tx_guid_check = FALSE;
-#endif
-            if ( need_OR )
+            QofQueryTerm* term = (QofQueryTerm*)andTerm->data;
+            GSList* paramPath = qof_query_term_get_param_path( term );
+
+            // Anything else only narrows down what the engine picks out
+            // of the loaded splits.
+            if ( sq_term->account_guids == NULL
+                    && ( param_path_equal( paramPath, split_account_path )
+                         || param_path_equal( paramPath, split_account_guid_path )
+                         || param_path_equal( paramPath, tx_split_account_path ) ) )
             {
-                g_string_append( sql, " OR " );
+                sq_term->account_guids = get_term_account_guids( term );
             }
-            g_string_append( sql, "(" );
-            for ( andTerm = andterms; andTerm != NULL; andTerm = andTerm->next )
+            else if ( param_path_equal( paramPath, tx_date_posted_path ) )
             {
-                QofQueryTerm* term;
-                GSList* paramPath;
-                gboolean unknownPath = FALSE;
-
-                term = (QofQueryTerm*)andTerm->data;
-                paramPath = qof_query_term_get_param_path( term );
-                const char *path = static_cast<decltype(path)>(paramPath->data);
-                const char *next_path =
-                    static_cast<decltype(next_path)>(paramPath->next->data);
-                if (strcmp(path, QOF_PARAM_BOOK) == 0) continue;
-
-#if SIMPLE_QUERY_COMPILATION
-                if ( strcmp(path, SPLIT_ACCOUNT) != 0 ||
-                     strcmp(next_path, QOF_PARAM_GUID) != 0 ) continue;
-#endif
+                sq_term->from = MAX( sq_term->from, get_term_from_date( term ) );
+            }
+        }
 
-                if ( need_AND ) g_string_append( sql, " AND " );
+        query_info->terms = g_list_prepend( query_info->terms, sq_term );
+        if ( sq_term->account_guids == NULL )
+        {
+            query_info->load_all = TRUE;
+            break;
+        }
+    }
 
-                if ( strcmp(path, SPLIT_ACCOUNT) == 0 &&
-                     strcmp(next_path, QOF_PARAM_GUID) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.account_guid", term, sql );
-#if SIMPLE_QUERY_COMPILATION
-                    goto done_compiling_query;
-#endif
+    return query_info;
+}
 
-                }
-                else if ( strcmp(path, SPLIT_RECONCILE) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.reconcile_state", term, sql );
+static void
+run_split_query( GncSqlBackend* be, gpointer pQuery )
+{
+    split_query_info_t* query_info = (split_query_info_t*)pQuery;
+    GString* sql;
+    GList* node;
 
-                }
-                else if ( strcmp(path, SPLIT_TRANS) == 0 )
-                {
-#if TX_GUID_CHECK
-                    if ( !has_tx_guid_check )
-                    {
-                        g_string_append( sql, "(splits.tx_guid = transactions.guid) AND " );
-                        has_tx_guid_check = TRUE;
-                    }
-#endif
-                    if (strcmp(next_path, TRANS_DATE_POSTED) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.post_date", term, sql );
-                    }
-                    else if (strcmp(next_path, TRANS_DESCRIPTION) == 0 )
-                    {
-                        convert_query_term_to_sql( be, "t.description", term, sql );
-                    }
-                    else
-                    {
-                        unknownPath = TRUE;
-                    }
+    g_return_if_fail( be != NULL );
+    g_return_if_fail( pQuery != NULL );
 
-                }
-                else if ( strcmp(path, SPLIT_VALUE) == 0 )
-                {
-                    convert_query_term_to_sql( be, "s.value_num/s.value_denom", term, sql );
+    if ( be->all_tx_loaded ) return;
+    if ( query_info->load_all )
+    {
+        gnc_sql_transaction_load_all_tx( be );
+        return;
+    }
 
-                }
-                else
-                {
-                    unknownPath = TRUE;
-                }
+    // Only ask for the accounts which haven't been loaded far enough back
+    sql = g_string_new( "" );
+    for ( node = query_info->terms; node != NULL; node = node->next )
+    {
+        split_query_term_t* sq_term = (split_query_term_t*)node->data;
+        GList* guid_node;
+        gboolean has_guids = FALSE;
 
-                if ( unknownPath )
-                {
-                    GString* name = g_string_new( (gchar*)paramPath->data );
-                    while ( paramPath->next != NULL )
-                    {
-                        g_string_append( name, "." );
-                        g_string_append( name, next_path );
-                        paramPath = paramPath->next;
-                    }
-                    PERR( "Unknown SPLIT query field: %s\n", name->str );
-                    g_string_free( name, TRUE );
-                }
-                need_AND = TRUE;
-            }
+        for ( guid_node = sq_term->account_guids; guid_node != NULL; guid_node = guid_node->next )
+        {
+            const GncGUID* guid = (const GncGUID*)guid_node->data;
+            gchar guid_buf[GUID_ENCODING_LENGTH+1];
+
+            if ( tx_loaded_for_account( be, guid, sq_term->from ) ) continue;
 
-            /* If the last char in the string is a '(', then for some reason, there were
-               no terms added to the SQL.  If so, remove it and ignore the OR term. */
-            if ( sql->str[sql->len-1] == '(' )
+            if ( has_guids )
             {
-                g_string_truncate( sql, sql->len - 1 );
-                need_OR = FALSE;
+                g_string_append( sql, "," );
             }
             else
             {
-                g_string_append( sql, ")" );
-                need_OR = TRUE;
+                if ( sql->len != 0 ) g_string_append( sql, " OR " );
+                g_string_append( sql, "(s.account_guid IN (" );
+                has_guids = TRUE;
             }
+            (void)guid_to_string_buff( guid, guid_buf );
+            g_string_append_printf( sql, "'%s'", guid_buf );
         }
+        if ( !has_guids ) continue;
 
-#if SIMPLE_QUERY_COMPILATION
-done_compiling_query:
-#endif
-        if ( sql->len != 0 )
-        {
-#if SIMPLE_QUERY_COMPILATION
-            g_string_append( sql, ")" );
-#endif
-            query_sql = g_strdup_printf(
-                            "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND %s",
-                            TRANSACTION_TABLE, SPLIT_TABLE, sql->str );
-        }
-        else
+        g_string_append( sql, ")" );
+        if ( sq_term->from != TX_ALL_DATES )
         {
-            query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-        }
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
-
-        g_string_free( sql, TRUE );
-        g_free( query_sql );
+            Timespec ts = { sq_term->from, 0 };
+            gchar* datebuf = gnc_sql_convert_timespec_to_string( be, ts );
 
+            g_string_append_printf( sql, " AND t.post_date>='%s'", datebuf );
+            g_free( datebuf );
+        }
+        g_string_append( sql, ")" );
     }
-    else
+
+    if ( sql->len != 0 )
     {
-        query_sql = g_strdup_printf( "SELECT * FROM %s", TRANSACTION_TABLE );
-        query_info->stmt = gnc_sql_create_statement_from_sql( be, query_sql );
+        gchar* query_sql;
+        GncSqlStatement* stmt;
+
+        query_sql = g_strdup_printf(
+                        "SELECT DISTINCT t.* FROM %s AS t, %s AS s WHERE s.tx_guid=t.guid AND (%s)",
+                        TRANSACTION_TABLE, SPLIT_TABLE, sql->str );
+        stmt = gnc_sql_create_statement_from_sql( be, query_sql );
         g_free( query_sql );
-    }
+        if ( stmt != NULL )
+        {
+            query_transactions( be, stmt );
+            gnc_sql_statement_dispose( stmt );
 
-    return query_info;
+            for ( node = query_info->terms; node != NULL; node = node->next )
+            {
+                split_query_term_t* sq_term = (split_query_term_t*)node->data;
+                GList* guid_node;
+
+                for ( guid_node = sq_term->account_guids; guid_node != NULL; guid_node = guid_node->next )
+                {
+                    set_tx_loaded_for_account( be, (const GncGUID*)guid_node->data,
+                                               sq_term->from );
+                }
+            }
+        }
+    }
+    g_string_free( sql, TRUE );
 }
 
-G_GNUC_UNUSED static void
-run_split_query( GncSqlBackend* be, gpointer pQuery )
+static void
+free_split_query( GncSqlBackend* be, gpointer pQuery )
 {
     split_query_info_t* query_info = (split_query_info_t*)pQuery;
+    GList* node;
 
     g_return_if_fail( be != NULL );
     g_return_if_fail( pQuery != NULL );
 
-    if ( !query_info->has_been_run )
+    for ( node = query_info->terms; node != NULL; node = node->next )
     {
-        query_transactions( be, query_info->stmt );
-        query_info->has_been_run = TRUE;
-        gnc_sql_statement_dispose( query_info->stmt );
-        query_info->stmt = NULL;
+        split_query_term_t* sq_term = (split_query_term_t*)node->data;
+
+        g_list_free_full( sq_term->account_guids, (GDestroyNotify)guid_free );
+        g_free( sq_term );
     }
+    g_list_free( query_info->terms );
+    g_free( query_info );
 }
 
-G_GNUC_UNUSED static void
-free_split_query( GncSqlBackend* be, gpointer pQuery )
+/* Transaction queries aren't narrowed down; they load whatever hasn't been
+ * loaded yet. */
+static /*@ null @*/ gpointer
+compile_tx_query( GncSqlBackend* be, QofQuery* query )
+{
+    return NULL;
+}
+
+static void
+run_tx_query( GncSqlBackend* be, gpointer pQuery )
 {
     g_return_if_fail( be != NULL );
-    g_return_if_fail( pQuery != NULL );
 
-    g_free( pQuery );
+    gnc_sql_transaction_load_all_tx( be );
 }
 
 /* ----------------------------------------------------------------- */
@@ -1320,7 +1269,7 @@ static const GncSqlColumnTableEntry acct_balances_col_table[] =
     /*@ +full_init_block @*/
 };
 
-G_GNUC_UNUSED static /*@ null @*/ single_acct_balance_t*
+static /*@ null @*/ single_acct_balance_t*
 load_single_acct_balances( const GncSqlBackend* be, GncSqlRow* row )
 {
     single_acct_balance_t* bal = NULL;
@@ -1340,7 +1289,6 @@ load_single_acct_balances( const GncSqlBackend* be, GncSqlRow* row )
 /*@ null @*/ GSList*
 gnc_sql_get_account_balances_slist( GncSqlBackend* be )
 {
-#if LOAD_TRANSACTIONS_AS_NEEDED
     GncSqlResult* result;
     GncSqlStatement* stmt;
     gchar* buf;
@@ -1365,65 +1313,51 @@ gnc_sql_get_account_balances_slist( GncSqlBackend* be )
         {
             single_acct_balance_t* single_bal;
 
-            // Get the next reconcile state balance and merge with other balances
+            // Get the next reconcile state balance and merge with other
+            // balances the same way xaccAccountRecomputeBalance() does.
             single_bal = load_single_acct_balances( be, row );
-            if ( single_bal != NULL )
+            if ( single_bal != NULL && single_bal->acct != NULL )
             {
                 if ( bal != NULL && bal->acct != single_bal->acct )
                 {
-                    bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, bal->reconciled_balance,
-                                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                    bal->balance = gnc_numeric_add( bal->balance, bal->cleared_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                    bal_slist = g_slist_append( bal_slist, bal );
+                    bal_slist = g_slist_prepend( bal_slist, bal );
                     bal = NULL;
                 }
                 if ( bal == NULL )
                 {
-                    bal = g_malloc( (gsize)sizeof(acct_balances_t) );
-                    g_assert( bal != NULL );
-
+                    bal = g_new( acct_balances_t, 1 );
                     bal->acct = single_bal->acct;
                     bal->balance = gnc_numeric_zero();
                     bal->cleared_balance = gnc_numeric_zero();
                     bal->reconciled_balance = gnc_numeric_zero();
                 }
-                if ( single_bal->reconcile_state == 'n' )
-                {
-                    bal->balance = gnc_numeric_add( bal->balance, single_bal->balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-                }
-                else if ( single_bal->reconcile_state == 'c' )
+                bal->balance = gnc_numeric_add( bal->balance, single_bal->balance,
+                                                GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
+                if ( single_bal->reconcile_state != NREC )
                 {
                     bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, single_bal->balance,
                                                             GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
                 }
-                else if ( single_bal->reconcile_state == 'y' )
+                if ( single_bal->reconcile_state == YREC
+                        || single_bal->reconcile_state == FREC )
                 {
                     bal->reconciled_balance = gnc_numeric_add( bal->reconciled_balance, single_bal->balance,
                                               GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
                 }
-                g_free( single_bal );
             }
+            g_free( single_bal );
             row = gnc_sql_result_get_next_row( result );
         }
 
         // Add the final balance
         if ( bal != NULL )
         {
-            bal->cleared_balance = gnc_numeric_add( bal->cleared_balance, bal->reconciled_balance,
-                                                    GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-            bal->balance = gnc_numeric_add( bal->balance, bal->cleared_balance,
-                                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD );
-            bal_slist = g_slist_append( bal_slist, bal );
+            bal_slist = g_slist_prepend( bal_slist, bal );
         }
         gnc_sql_result_dispose( result );
     }
 
     return bal_slist;
-#else
-    return NULL;
-#endif
 }
 
 /* ----------------------------------------------------------------- */
@@ -1496,14 +1430,10 @@ gnc_sql_init_transaction_handler( void )
         GNC_SQL_BACKEND_VERSION,
         GNC_ID_TRANS,
         commit_transaction,          /* commit */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        NULL,                        /* initial load */
-#else
-        gnc_sql_transaction_load_all_tx,
-#endif
+        load_initial_tx,             /* initial load */
         create_transaction_tables,   /* create tables */
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
+        compile_tx_query,            /* compile_query */
+        run_tx_query,                /* run_query */
         NULL,                        /* free_query */
         NULL                         /* write */
     };
@@ -1514,15 +1444,9 @@ gnc_sql_init_transaction_handler( void )
         commit_split,                /* commit */
         NULL,                        /* initial_load */
         NULL,                        /* create tables */
-#if LOAD_TRANSACTIONS_AS_NEEDED
-        compile_split_query,
-        run_split_query,
-        free_split_query,
-#else
-        NULL,                        /* compile_query */
-        NULL,                        /* run_query */
-        NULL,                        /* free_query */
-#endif
+        compile_split_query,         /* compile_query */
+        run_split_query,             /* run_query */
+        free_split_query,            /* free_query */
         NULL                         /* write */
     };
 
@@ -56,7 +56,8 @@ void gnc_sql_transaction_commit_splits( GncSqlBackend* be, Transaction* pTx );
 gboolean gnc_sql_save_transaction( GncSqlBackend* be, QofInstance* inst );
 
 /**
- * Loads all transactions which have splits for a specific account.
+ * Loads all transactions which have splits for a specific account, unless
+ * they have already been loaded.
  *
  * @param be SQL backend
  * @param account Account
@@ -64,7 +65,7 @@ gboolean gnc_sql_save_transaction( GncSqlBackend* be, QofInstance* inst );
 void gnc_sql_transaction_load_tx_for_account( GncSqlBackend* be, Account* account );
 
 /**
- * Loads all transactions.
+ * Loads all transactions which haven't been loaded yet.
  *
  * @param be SQL backend
  */
@@ -80,7 +81,8 @@ typedef struct
 
 /**
  * Returns a list of acct_balances_t structures, one for each account which
- * has splits.
+ * has splits, with the balances of all of its splits in the database.  The
+ * caller frees the list and the structures.
  *
  * @param be SQL backend
  * @return GSList of acct_balances_t structures
@@ -806,6 +806,209 @@ gnc_sql_do_db_operation (GncSqlBackend* be,// C: 22 in 12 */
 test_gnc_sql_do_db_operation (Fixture *fixture, gconstpointer pData)
 {
 }*/
+/* add_to_insert_batch, flush_insert_batches, gnc_sql_end_insert_batch
+ * A fake connection records the statements it is given; rows inserted
+ * through a batch must be the rows inserted one at a time. */
+/* INSERT_BATCH_MAX_ROWS in gnc-backend-sql.cpp */
+#define BATCH_MAX_ROWS 250
+
+typedef struct
+{
+    GncSqlStatement base;
+    gchar* sql;
+} FakeStatement;
+
+typedef struct
+{
+    gint id;
+    const gchar* name;
+} FakeRow;
+
+static GList* fake_executed = nullptr;
+
+static void
+fake_stmt_dispose (GncSqlStatement* stmt)
+{
+    g_free (((FakeStatement*)stmt)->sql);
+    g_free (stmt);
+}
+
+static gchar*
+fake_stmt_to_sql (GncSqlStatement* stmt)
+{
+    return ((FakeStatement*)stmt)->sql;
+}
+
+static GncSqlStatement*
+fake_create_statement (GncSqlConnection* conn, const gchar* sql)
+{
+    FakeStatement* stmt = g_new0 (FakeStatement, 1);
+    stmt->base.dispose = fake_stmt_dispose;
+    stmt->base.toSql = fake_stmt_to_sql;
+    stmt->sql = g_strdup (sql);
+    return (GncSqlStatement*)stmt;
+}
+
+static gint
+fake_execute_nonselect (GncSqlConnection* conn, GncSqlStatement* stmt)
+{
+    fake_executed = g_list_append (fake_executed,
+                                   g_strdup (gnc_sql_statement_to_sql (stmt)));
+    return 1;
+}
+
+static gchar*
+fake_quote_string (const GncSqlConnection* conn, gchar* str)
+{
+    return g_strdup_printf ("'%s'", str);
+}
+
+static gint
+fake_row_get_id (gpointer row)
+{
+    return ((FakeRow*)row)->id;
+}
+
+static gpointer
+fake_row_get_name (gpointer row, QofParam* param)
+{
+    return (gpointer)((FakeRow*)row)->name;
+}
+
+static GncSqlColumnTableEntry fake_col_table[] =
+{
+    { "id", CT_INT, 0, COL_PKEY | COL_NNUL, nullptr, nullptr,
+      (QofAccessFunc)fake_row_get_id, nullptr },
+    { "name", CT_STRING, 20, 0, nullptr, nullptr,
+      (QofAccessFunc)fake_row_get_name, nullptr },
+    { nullptr }
+};
+
+/* Maps "INSERT INTO t(...) VALUES" to all rows sent for it, in order. */
+static GHashTable*
+collect_inserted_rows (GList* statements)
+{
+    GHashTable* rows = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              g_free, nullptr);
+    GList* node;
+
+    for (node = statements; node != nullptr; node = node->next)
+    {
+        const gchar* sql = static_cast<const gchar*>(node->data);
+        const gchar* values = strstr (sql, " VALUES");
+        gchar* head;
+        GString* table_rows;
+
+        g_assert (g_str_has_prefix (sql, "INSERT INTO "));
+        g_assert (values != nullptr);
+        values += strlen (" VALUES");
+        head = g_strndup (sql, values - sql);
+        table_rows = static_cast<GString*>(g_hash_table_lookup (rows, head));
+        if (table_rows == nullptr)
+        {
+            g_hash_table_insert (rows, head, g_string_new (values));
+        }
+        else
+        {
+            g_string_append_printf (table_rows, ",%s", values);
+            g_free (head);
+        }
+    }
+    return rows;
+}
+
+static void
+assert_rows_equal (GHashTable* expected, GHashTable* actual)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_assert_cmpuint (g_hash_table_size (expected), ==,
+                      g_hash_table_size (actual));
+    g_hash_table_iter_init (&iter, expected);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        GString* other = static_cast<GString*>(g_hash_table_lookup (actual, key));
+        g_assert (other != nullptr);
+        g_assert_cmpstr (((GString*)value)->str, ==, other->str);
+        g_string_free (other, TRUE);
+        g_string_free ((GString*)value, TRUE);
+    }
+    g_hash_table_destroy (expected);
+    g_hash_table_destroy (actual);
+}
+
+static void
+insert_fake_rows (GncSqlBackend* be, FakeRow* rows, gint n_rows,
+                  gboolean batch)
+{
+    gint i;
+
+    for (i = 0; i < n_rows; i++)
+    {
+        /* Every tenth row goes to a second table in between. */
+        const gchar* table_name = i % 10 == 9 ? "fake_other" : "fake_rows";
+
+        g_assert (gnc_sql_do_db_operation (be, OP_DB_INSERT, table_name,
+                                           "FakeRow", &rows[i],
+                                           fake_col_table));
+        if (batch && i == BATCH_MAX_ROWS * 10 / 9)
+        {
+            /* fake_rows has just reached the limit and gone out */
+            g_assert_cmpuint (g_list_length (fake_executed), ==, 1);
+        }
+    }
+}
+
+static void
+test_gnc_sql_insert_batch (void)
+{
+    GncSqlBackend be;
+    GncSqlConnection conn;
+    const gint n_rows = BATCH_MAX_ROWS * 10 / 9 + 20;
+    FakeRow* rows = g_new0 (FakeRow, n_rows);
+    const gchar* names[] = { "Alpha", "Beta", "", "Gamma" };
+    GList* singles;
+    guint single_count;
+    gint i;
+
+    memset (&be, 0, sizeof (be));
+    memset (&conn, 0, sizeof (conn));
+    conn.createStatementFromSql = fake_create_statement;
+    conn.executeNonSelectStatement = fake_execute_nonselect;
+    conn.quoteString = fake_quote_string;
+    be.conn = &conn;
+    gnc_sql_init (&be);
+
+    for (i = 0; i < n_rows; i++)
+    {
+        rows[i].id = i;
+        rows[i].name = names[i % G_N_ELEMENTS (names)];
+    }
+
+    insert_fake_rows (&be, rows, n_rows, FALSE);
+    singles = fake_executed;
+    single_count = be.statement_count;
+    g_assert_cmpuint (single_count, ==, n_rows);
+    fake_executed = nullptr;
+
+    gnc_sql_begin_insert_batch (&be);
+    insert_fake_rows (&be, rows, n_rows, TRUE);
+    g_assert (gnc_sql_end_insert_batch (&be));
+    /* fake_rows: one full batch and the rest; fake_other: one batch */
+    g_assert_cmpuint (g_list_length (fake_executed), ==, 3);
+    g_assert_cmpuint (be.statement_count - single_count, ==, 3);
+    g_assert (be.insert_batches == nullptr);
+    g_assert (!be.batching_inserts);
+
+    assert_rows_equal (collect_inserted_rows (singles),
+                       collect_inserted_rows (fake_executed));
+
+    g_list_free_full (singles, g_free);
+    g_list_free_full (fake_executed, g_free);
+    fake_executed = nullptr;
+    g_free (rows);
+}
 /* create_gslist_from_values
 static GSList*
 create_gslist_from_values (GncSqlBackend* be,// 3
@@ -1004,6 +1207,7 @@ test_suite_gnc_backend_sql (void)
 // GNC_TEST_ADD (suitename, "gnc sql add gvalue objectref guid to slist", Fixture, nullptr, test_gnc_sql_add_gvalue_objectref_guid_to_slist,  teardown);
 // GNC_TEST_ADD (suitename, "gnc sql add objectref guid col info to list", Fixture, nullptr, test_gnc_sql_add_objectref_guid_col_info_to_list,  teardown);
     GNC_TEST_ADD_FUNC (suitename, "gnc sql convert timespec to string", test_gnc_sql_convert_timespec_to_string);
+    GNC_TEST_ADD_FUNC (suitename, "gnc sql insert batch", test_gnc_sql_insert_batch);
 // GNC_TEST_ADD (suitename, "load timespec", Fixture, nullptr, test_load_timespec,  teardown);
 // GNC_TEST_ADD (suitename, "add timespec col info to list", Fixture, nullptr, test_add_timespec_col_info_to_list,  teardown);
 // GNC_TEST_ADD (suitename, "add gvalue timespec to slist", Fixture, nullptr, test_add_gvalue_timespec_to_slist,  teardown);
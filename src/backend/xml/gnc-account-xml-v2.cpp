@@ -40,6 +40,7 @@ extern "C"
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
 
 #include "gnc-xml.h"
 #include "io-gncxml-gen.h"
@@ -166,6 +167,77 @@ gnc_account_dom_tree_create(Account *act,
     return ret;
 }
 
+void
+gnc_account_to_xml_stream(GncXmlWriter& writer, Account *act,
+                          gboolean exporting, gboolean allow_incompat)
+{
+    const char *str;
+    GList *lots, *n;
+    Account *parent;
+    gnc_commodity *acct_commodity;
+
+    ENTER ("(account=%p)", act);
+
+    writer.start_element(gnc_account_string);
+    writer.add_attribute("version", account_version_string);
+
+    str = xaccAccountGetName(act);
+    if (str)
+        text_to_xml_stream(writer, act_name_string, str);
+
+    guid_to_xml_stream(writer, act_id_string, xaccAccountGetGUID(act));
+
+    text_to_xml_stream(writer, act_type_string,
+                       xaccAccountTypeEnumAsString(xaccAccountGetType(act)));
+
+    acct_commodity = xaccAccountGetCommodity(act);
+    if (acct_commodity != NULL)
+    {
+        commodity_ref_to_xml_stream(writer, act_commodity_string,
+                                    acct_commodity);
+
+        int_to_xml_stream(writer, act_commodity_scu_string,
+                          xaccAccountGetCommoditySCUi(act));
+
+        if (xaccAccountGetNonStdSCU(act))
+            empty_to_xml_stream(writer, act_non_standard_scu_string);
+    }
+
+    str = xaccAccountGetCode(act);
+    if (str && strlen(str) > 0)
+        text_to_xml_stream(writer, act_code_string, str);
+
+    str = xaccAccountGetDescription(act);
+    if (str && strlen(str) > 0)
+        text_to_xml_stream(writer, act_description_string, str);
+
+    qof_instance_slots_to_xml_stream(writer, act_slots_string,
+                                     QOF_INSTANCE(act));
+    parent = gnc_account_get_parent(act);
+    if (parent)
+    {
+        if (!gnc_account_is_root(parent) || allow_incompat)
+            guid_to_xml_stream(writer, act_parent_string,
+                               xaccAccountGetGUID(parent));
+    }
+
+    lots = xaccAccountGetLotList (act);
+    if (lots && !exporting)
+    {
+        writer.start_element(act_lots_string);
+
+        lots = g_list_sort(lots, qof_instance_guid_compare);
+
+        for (n = lots; n; n = n->next)
+            gnc_lot_to_xml_stream(writer, static_cast<GNCLot*>(n->data));
+        writer.end_element();
+    }
+    g_list_free(lots);
+
+    writer.end_element();
+    LEAVE("");
+}
+
 /***********************************************************************/
 
 struct account_pdata
@@ -690,6 +690,21 @@ gnc_xml_be_backup_file(FileBackend *be)
 
 /* ================================================================= */
 
+/* Files are saved gzipped when the preference asks for compression,
+ * except that one which is already Zstandard compressed stays that way;
+ * recompressing a file with zstd is how to choose it. */
+static GncXmlCompression
+gnc_xml_be_save_compression(const gchar *datafile)
+{
+    if (!gnc_prefs_get_file_save_compressed())
+        return GNC_XML_COMPRESSION_NONE;
+
+    if (gnc_xml_file_compression(datafile) == GNC_XML_COMPRESSION_ZSTD)
+        return GNC_XML_COMPRESSION_ZSTD;
+
+    return GNC_XML_COMPRESSION_GZIP;
+}
+
 static gboolean
 gnc_xml_be_write_to_file(FileBackend *fbe,
                          QofBook *book,
@@ -737,7 +752,8 @@ gnc_xml_be_write_to_file(FileBackend *fbe,
         }
     }
 
-    if (gnc_book_write_to_xml_file_v2(book, tmp_name, gnc_prefs_get_file_save_compressed()))
+    if (gnc_book_write_to_xml_file_v2(book, tmp_name,
+                                      gnc_xml_be_save_compression(datafile)))
     {
         /* Record the file's permissions before g_unlinking it */
         rc = g_stat(datafile, &statbuf);
@@ -38,6 +38,7 @@ extern "C"
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
 
 #include "gnc-xml.h"
 #include "io-gncxml-gen.h"
@@ -118,6 +119,59 @@ gnc_commodity_dom_tree_create(const gnc_commodity *com)
     return ret;
 }
 
+gboolean
+gnc_commodity_to_xml_stream(GncXmlWriter& writer, const gnc_commodity *com)
+{
+    gnc_quote_source *source;
+    const char *string;
+    gboolean currency = gnc_commodity_is_iso(com);
+    gboolean has_slots = qof_instance_get_slots(QOF_INSTANCE(com)) != NULL;
+
+    if (currency && !gnc_commodity_get_quote_flag(com) && !has_slots)
+        return FALSE;
+
+    writer.start_element(gnc_commodity_string);
+    writer.add_attribute("version", commodity_version_string);
+
+    text_to_xml_stream(writer, cmdty_namespace,
+                       gnc_commodity_get_namespace_compat(com));
+    text_to_xml_stream(writer, cmdty_id, gnc_commodity_get_mnemonic(com));
+
+    if (!currency)
+    {
+        if (gnc_commodity_get_fullname(com))
+            text_to_xml_stream(writer, cmdty_name,
+                               gnc_commodity_get_fullname(com));
+
+        if (gnc_commodity_get_cusip(com) &&
+                strlen(gnc_commodity_get_cusip(com)) > 0)
+            text_to_xml_stream(writer, cmdty_xcode,
+                               gnc_commodity_get_cusip(com));
+
+        int_to_xml_stream(writer, cmdty_fraction,
+                          gnc_commodity_get_fraction(com));
+    }
+
+    if (gnc_commodity_get_quote_flag(com))
+    {
+        empty_to_xml_stream(writer, cmdty_get_quotes);
+        source = gnc_commodity_get_quote_source(com);
+        if (source)
+            text_to_xml_stream(writer, cmdty_quote_source,
+                               gnc_quote_source_get_internal_name(source));
+        string = gnc_commodity_get_quote_tz(com);
+        if (string)
+            text_to_xml_stream(writer, cmdty_quote_tz, string);
+    }
+
+    if (has_slots)
+        qof_instance_slots_to_xml_stream(writer, cmdty_slots,
+                                         QOF_INSTANCE(com));
+
+    writer.end_element();
+    return TRUE;
+}
+
 /***********************************************************************/
 
 struct com_char_handler
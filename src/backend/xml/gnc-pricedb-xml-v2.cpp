@@ -35,7 +35,9 @@ extern "C"
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
 #include "io-gncxml-gen.h"
+#include "io-gncxml-pipeline.h"
 #include "io-gncxml-v2.h"
 
 /* This static indicates the debugging module that this .o belongs to.  */
@@ -142,50 +144,18 @@ price_parse_xml_sub_node(GNCPrice *p, xmlNodePtr sub_node, QofBook *book)
     return TRUE;
 }
 
-static gboolean
-price_parse_xml_end_handler(gpointer data_for_children,
-                            GSList* data_from_children,
-                            GSList* sibling_data,
-                            gpointer parent_data,
-                            gpointer global_data,
-                            gpointer *result,
-                            const gchar *tag)
+static GNCPrice*
+dom_tree_to_price(xmlNodePtr price_xml, QofBook *book)
 {
-    gboolean ok = TRUE;
-    xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
     xmlNodePtr child;
     GNCPrice *p = NULL;
-    gxpf_data *gdata = static_cast<decltype(gdata)>(global_data);
-    QofBook *book = static_cast<decltype(book)>(gdata->bookdata);
-
-    /* we haven't been handed the *top* level node yet... */
-    if (parent_data) return TRUE;
 
-    *result = NULL;
-
-    if (!price_xml) return FALSE;
-    if (price_xml->next)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (price_xml->prev)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (!price_xml->xmlChildrenNode)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    if (price_xml->next) return NULL;
+    if (price_xml->prev) return NULL;
+    if (!price_xml->xmlChildrenNode) return NULL;
 
     p = gnc_price_create(book);
-    if (!p)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    if (!p) return NULL;
 
     for (child = price_xml->xmlChildrenNode; child; child = child->next)
     {
@@ -197,31 +167,92 @@ price_parse_xml_end_handler(gpointer data_for_children,
         case XML_ELEMENT_NODE:
             if (!price_parse_xml_sub_node(p, child, book))
             {
-                ok = FALSE;
-                goto cleanup_and_exit;
+                gnc_price_unref(p);
+                return NULL;
             }
             break;
         default:
             PERR("Unknown node type (%d) while parsing gnc-price xml.", child->type);
-            child = NULL;
-            ok = FALSE;
-            goto cleanup_and_exit;
-            break;
+            gnc_price_unref(p);
+            return NULL;
         }
     }
 
-cleanup_and_exit:
-    if (ok)
-    {
-        *result = p;
-    }
-    else
+    return p;
+}
+
+static const struct dom_tree_cache_tag price_cache_tags[] =
+{
+    { "price:id", DOM_TREE_GUID },
+    { "price:time", DOM_TREE_TIMESPEC },
+    { "price:source", DOM_TREE_TEXT },
+    { "price:type", DOM_TREE_TEXT },
+    { "price:value", DOM_TREE_NUMERIC },
+    { NULL, DOM_TREE_GUID },
+};
+
+/* Runs on a load worker; the commodities are looked up in the engine by
+ * dom_tree_to_price. */
+static void
+price_cache_values(xmlNodePtr price_xml, DomTreeCache& cache)
+{
+    cache.add_children(price_xml, price_cache_tags);
+}
+
+static void
+pricedb_add_loaded_price(GNCPriceDB *db, GNCPrice *p, sixtp_gdv2 *gd)
+{
+    gnc_pricedb_add_price(db, p);
+    gd->counter.prices_loaded++;
+    sixtp_run_callback(gd, "prices");
+}
+
+static gboolean
+price_commit(xmlNodePtr price_xml, gpointer data)
+{
+    gxpf_data *gdata = static_cast<decltype(gdata)>(data);
+    QofBook *book = static_cast<decltype(book)>(gdata->bookdata);
+    sixtp_gdv2 *gd = static_cast<decltype(gd)>(gdata->parsedata);
+    GNCPrice *p = dom_tree_to_price(price_xml, book);
+
+    if (!p) return FALSE;
+
+    pricedb_add_loaded_price(gnc_pricedb_get_db(book), p, gd);
+    gnc_price_unref(p);
+    return TRUE;
+}
+
+static gboolean
+price_parse_xml_end_handler(gpointer data_for_children,
+                            GSList* data_from_children,
+                            GSList* sibling_data,
+                            gpointer parent_data,
+                            gpointer global_data,
+                            gpointer *result,
+                            const gchar *tag)
+{
+    xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
+    gxpf_data *gdata = static_cast<decltype(gdata)>(global_data);
+    QofBook *book = static_cast<decltype(book)>(gdata->bookdata);
+
+    /* we haven't been handed the *top* level node yet... */
+    if (parent_data) return TRUE;
+
+    *result = NULL;
+
+    if (!price_xml) return FALSE;
+
+    /* The pipeline adds the price to the db once it's converted. */
+    if (gdata->pipeline)
     {
-        *result = NULL;
-        gnc_price_unref(p);
+        gdata->pipeline->push(price_xml, price_cache_values, price_commit,
+                              gdata);
+        return TRUE;
     }
+
+    *result = dom_tree_to_price(price_xml, book);
     xmlFreeNode(price_xml);
-    return ok;
+    return *result != NULL;
 }
 
 static void
@@ -298,10 +329,11 @@ pricedb_after_child_handler(gpointer data_for_children,
     {
         GNCPrice *p = (GNCPrice *) child_result->data;
 
+        /* queued on the load pipeline */
+        if (!p && gdata->pipeline) return TRUE;
+
         g_return_val_if_fail(p, FALSE);
-        gnc_pricedb_add_price(db, p);
-        gd->counter.prices_loaded++;
-        sixtp_run_callback(gd, "prices");
+        pricedb_add_loaded_price(db, p, gd);
         return TRUE;
     }
     else
@@ -331,6 +363,7 @@ pricedb_v2_end_handler(
 {
     GNCPriceDB *db = static_cast<decltype(db)>(*result);
     gxpf_data *gdata = (gxpf_data*)global_data;
+    gboolean ok = TRUE;
 
     if (parent_data)
     {
@@ -342,12 +375,15 @@ pricedb_v2_end_handler(
         return TRUE;
     }
 
+    if (gdata->pipeline)
+        ok = gdata->pipeline->drain();
+
     gdata->cb(tag, gdata->parsedata, db);
     *result = NULL;
 
     gnc_pricedb_set_bulk_update(db, FALSE);
 
-    return TRUE;
+    return ok;
 }
 
 static sixtp*
@@ -513,3 +549,96 @@ gnc_pricedb_dom_tree_create(GNCPriceDB *db)
 {
     return gnc_pricedb_to_dom_tree(BAD_CAST "gnc:pricedb", db);
 }
+
+/* The same elements as gnc_price_to_dom_tree builds, except that a price
+ * which can't be written leaves the writer mid-element. */
+static gboolean
+gnc_price_to_xml_stream(GncXmlWriter& writer, const char *tag, GNCPrice *price)
+{
+    const gchar *typestr, *sourcestr;
+    gnc_commodity *commodity;
+    gnc_commodity *currency;
+    Timespec timesp;
+    gnc_numeric value;
+
+    if (!(tag && price)) return FALSE;
+
+    commodity = gnc_price_get_commodity(price);
+    currency = gnc_price_get_currency(price);
+
+    if (!(commodity && currency)) return FALSE;
+
+    writer.start_element(tag);
+    if (!guid_to_xml_stream(writer, "price:id", gnc_price_get_guid(price)) ||
+            !commodity_ref_to_xml_stream(writer, "price:commodity", commodity) ||
+            !commodity_ref_to_xml_stream(writer, "price:currency", currency))
+        return FALSE;
+
+    timesp = gnc_price_get_time(price);
+    if (!timespec_to_xml_stream(writer, "price:time", &timesp))
+        return FALSE;
+
+    sourcestr = gnc_price_get_source_string(price);
+    if (sourcestr && (strlen(sourcestr) != 0))
+        text_to_xml_stream(writer, "price:source", sourcestr);
+
+    typestr = gnc_price_get_typestr(price);
+    if (typestr && (strlen(typestr) != 0))
+        text_to_xml_stream(writer, "price:type", typestr);
+
+    value = gnc_price_get_value(price);
+    gnc_numeric_to_xml_stream(writer, "price:value", &value);
+
+    writer.end_element();
+    return TRUE;
+}
+
+struct price_stream_data
+{
+    GncXmlWriter *writer;
+    int n_prices;
+};
+
+static gboolean
+xml_stream_gnc_price_adapter(GNCPrice *p, gpointer data)
+{
+    auto psd = static_cast<price_stream_data*>(data);
+
+    if (!p)
+        return TRUE;
+    if (!gnc_price_to_xml_stream(*psd->writer, "price", p))
+        return FALSE;
+    psd->n_prices++;
+    return TRUE;
+}
+
+gboolean
+gnc_pricedb_to_xml_stream(GncXmlWriter& writer, GNCPriceDB *db,
+                          sixtp_gdv2 *gd)
+{
+    price_stream_data psd = { &writer, 0 };
+
+    /* The whole price db is one element, so nothing reaches the file
+     * until it's closed and it can still be dropped if a price fails, as
+     * gnc_pricedb_dom_tree_create returns NULL then. */
+    writer.start_element("gnc:pricedb");
+    writer.add_attribute("version", "1");
+    if (!gnc_pricedb_foreach_price(db, xml_stream_gnc_price_adapter, &psd,
+                                   TRUE) || psd.n_prices == 0)
+    {
+        writer.discard();
+        return FALSE;
+    }
+    writer.end_element();
+
+    /* Only now are the prices written, so only now do they count, as
+     * the DOM writer counted each price as it dumped it. */
+    if (writer.error())
+        return FALSE;
+    if (gd)
+    {
+        gd->counter.prices_loaded += psd.n_prices;
+        sixtp_run_callback(gd, "prices");
+    }
+    return TRUE;
+}
@@ -41,10 +41,12 @@ extern "C"
 #include "sixtp-utils.h"
 #include "sixtp-dom-parsers.h"
 #include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
 
 #include "gnc-xml.h"
 
 #include "io-gncxml-gen.h"
+#include "io-gncxml-pipeline.h"
 
 #include "sixtp-dom-parsers.h"
 
@@ -194,6 +196,100 @@ gnc_transaction_dom_tree_create(Transaction *trn)
     return ret;
 }
 
+/* The same elements as gnc_transaction_dom_tree_create builds. */
+
+static void
+stream_timespec (GncXmlWriter& writer, const gchar *tag, Timespec tms,
+                 gboolean always)
+{
+    if (always || !((tms.tv_sec == 0) && (tms.tv_nsec == 0)))
+        timespec_to_xml_stream (writer, tag, &tms);
+}
+
+static void
+split_to_xml_stream (GncXmlWriter& writer, const gchar *tag, Split *spl)
+{
+    const char *str;
+    char tmp[2];
+    GNCLot *lot;
+    gnc_numeric num;
+
+    writer.start_element (tag);
+
+    guid_to_xml_stream (writer, "split:id", xaccSplitGetGUID (spl));
+
+    str = xaccSplitGetMemo (spl);
+    if (str && g_strcmp0 (str, "") != 0)
+        text_child_to_xml_stream (writer, "split:memo", str);
+
+    str = xaccSplitGetAction (spl);
+    if (str && g_strcmp0 (str, "") != 0)
+        text_child_to_xml_stream (writer, "split:action", str);
+
+    tmp[0] = xaccSplitGetReconcile (spl);
+    tmp[1] = '\0';
+    writer.start_element ("split:reconciled-state");
+    writer.add_text (tmp, FALSE);
+    writer.end_element ();
+
+    stream_timespec (writer, "split:reconcile-date",
+                     xaccSplitRetDateReconciledTS (spl), FALSE);
+
+    num = xaccSplitGetValue (spl);
+    gnc_numeric_to_xml_stream (writer, "split:value", &num);
+
+    num = xaccSplitGetAmount (spl);
+    gnc_numeric_to_xml_stream (writer, "split:quantity", &num);
+
+    guid_to_xml_stream (writer, "split:account",
+                        xaccAccountGetGUID (xaccSplitGetAccount (spl)));
+
+    lot = xaccSplitGetLot (spl);
+    if (lot)
+        guid_to_xml_stream (writer, "split:lot", gnc_lot_get_guid (lot));
+
+    qof_instance_slots_to_xml_stream (writer, "split:slots",
+                                      QOF_INSTANCE (spl));
+    writer.end_element ();
+}
+
+void
+gnc_transaction_to_xml_stream (GncXmlWriter& writer, Transaction *trn)
+{
+    const char *str;
+    GList *n;
+
+    writer.start_element ("gnc:transaction");
+    writer.add_attribute ("version", transaction_version_string);
+
+    guid_to_xml_stream (writer, "trn:id", xaccTransGetGUID (trn));
+
+    commodity_ref_to_xml_stream (writer, "trn:currency",
+                                 xaccTransGetCurrency (trn));
+    str = xaccTransGetNum (trn);
+    if (str && (g_strcmp0 (str, "") != 0))
+        text_child_to_xml_stream (writer, "trn:num", str);
+
+    stream_timespec (writer, "trn:date-posted",
+                     xaccTransRetDatePostedTS (trn), TRUE);
+    stream_timespec (writer, "trn:date-entered",
+                     xaccTransRetDateEnteredTS (trn), TRUE);
+
+    str = xaccTransGetDescription (trn);
+    if (str)
+        text_child_to_xml_stream (writer, "trn:description", str);
+
+    qof_instance_slots_to_xml_stream (writer, "trn:slots", QOF_INSTANCE (trn));
+
+    writer.start_element ("trn:splits");
+    for (n = xaccTransGetSplitList (trn); n; n = n->next)
+        split_to_xml_stream (writer, "trn:split",
+                             static_cast<Split*>(n->data));
+    writer.end_element ();
+
+    writer.end_element ();
+}
+
 /***********************************************************************/
 
 struct split_pdata
@@ -573,15 +669,73 @@ struct dom_tree_handler trn_dom_handlers[] =
     { NULL, NULL, 0, 0 },
 };
 
+static const struct dom_tree_cache_tag trn_cache_tags[] =
+{
+    { "trn:id", DOM_TREE_GUID },
+    { "trn:num", DOM_TREE_TEXT },
+    { "trn:date-posted", DOM_TREE_TIMESPEC },
+    { "trn:date-entered", DOM_TREE_TIMESPEC },
+    { "trn:description", DOM_TREE_TEXT },
+    { NULL, DOM_TREE_GUID },
+};
+
+static const struct dom_tree_cache_tag spl_cache_tags[] =
+{
+    { "split:id", DOM_TREE_GUID },
+    { "split:memo", DOM_TREE_TEXT },
+    { "split:action", DOM_TREE_TEXT },
+    { "split:reconciled-state", DOM_TREE_TEXT },
+    { "split:reconcile-date", DOM_TREE_TIMESPEC },
+    { "split:value", DOM_TREE_NUMERIC },
+    { "split:quantity", DOM_TREE_NUMERIC },
+    { "split:account", DOM_TREE_GUID },
+    { "split:lot", DOM_TREE_GUID },
+    { NULL, DOM_TREE_GUID },
+};
+
+/* Runs on a load worker; the currency and the slots need the engine and
+ * are left to dom_tree_to_transaction. */
+static void
+gnc_transaction_cache_values(xmlNodePtr node, DomTreeCache& cache)
+{
+    cache.add_children(node, trn_cache_tags);
+
+    for (auto child = node->xmlChildrenNode; child; child = child->next)
+    {
+        if (g_strcmp0("trn:splits", (char*)child->name))
+            continue;
+
+        for (auto spl = child->xmlChildrenNode; spl; spl = spl->next)
+            if (g_strcmp0("trn:split", (char*)spl->name) == 0)
+                cache.add_children(spl, spl_cache_tags);
+    }
+}
+
+static gboolean
+gnc_transaction_commit(xmlNodePtr tree, gpointer data)
+{
+    gxpf_data *gdata = static_cast<decltype(gdata)>(data);
+    Transaction *trn;
+
+    trn = dom_tree_to_transaction(tree,
+                                  static_cast<QofBook*>(gdata->bookdata));
+    if (trn != NULL)
+    {
+        gdata->cb((char*)tree->name, gdata->parsedata, trn);
+    }
+
+    return trn != NULL;
+}
+
 static gboolean
 gnc_transaction_end_handler(gpointer data_for_children,
                             GSList* data_from_children, GSList* sibling_data,
                             gpointer parent_data, gpointer global_data,
                             gpointer *result, const gchar *tag)
 {
-    Transaction *trn = NULL;
     xmlNodePtr tree = (xmlNodePtr)data_for_children;
     gxpf_data *gdata = (gxpf_data*)global_data;
+    gboolean ok;
 
     if (parent_data)
     {
@@ -597,16 +751,17 @@ gnc_transaction_end_handler(gpointer data_for_children,
 
     g_return_val_if_fail(tree, FALSE);
 
-    trn = dom_tree_to_transaction(tree,
-                                  static_cast<QofBook*>(gdata->bookdata));
-    if (trn != NULL)
+    if (gdata->pipeline)
     {
-        gdata->cb(tag, gdata->parsedata, trn);
+        gdata->pipeline->push(tree, gnc_transaction_cache_values,
+                              gnc_transaction_commit, gdata);
+        return TRUE;
     }
 
+    ok = gnc_transaction_commit(tree, gdata);
     xmlFreeNode(tree);
 
-    return trn != NULL;
+    return ok;
 }
 
 Transaction *
@@ -35,9 +35,12 @@ extern "C"
 
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
+#include "sixtp-stream-generators.h"
 
 xmlNodePtr gnc_account_dom_tree_create(Account *act, gboolean exporting,
                                        gboolean allow_incompat);
+void gnc_account_to_xml_stream(GncXmlWriter& writer, Account *act,
+                               gboolean exporting, gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create(void);
 
 xmlNodePtr gnc_book_dom_tree_create(QofBook *book);
@@ -46,14 +49,19 @@ sixtp* gnc_book_id_sixtp_parser_create(void);
 sixtp* gnc_book_slots_sixtp_parser_create(void);
 
 xmlNodePtr gnc_commodity_dom_tree_create(const gnc_commodity *com);
+gboolean gnc_commodity_to_xml_stream(GncXmlWriter& writer,
+                                     const gnc_commodity *com);
 sixtp* gnc_commodity_sixtp_parser_create(void);
 
 sixtp* gnc_freqSpec_sixtp_parser_create(void);
 
 xmlNodePtr gnc_lot_dom_tree_create(GNCLot *);
+void gnc_lot_to_xml_stream(GncXmlWriter& writer, GNCLot *lot);
 sixtp* gnc_lot_sixtp_parser_create(void);
 
 xmlNodePtr gnc_pricedb_dom_tree_create(GNCPriceDB *db);
+gboolean gnc_pricedb_to_xml_stream(GncXmlWriter& writer, GNCPriceDB *db,
+                                   sixtp_gdv2 *gd);
 sixtp* gnc_pricedb_sixtp_parser_create(void);
 
 xmlNodePtr gnc_schedXaction_dom_tree_create( SchedXaction *sx );
@@ -63,6 +71,7 @@ xmlNodePtr gnc_budget_dom_tree_create( GncBudget *bgt );
 sixtp* gnc_budget_sixtp_parser_create(void);
 
 xmlNodePtr gnc_transaction_dom_tree_create(Transaction *txn);
+void gnc_transaction_to_xml_stream(GncXmlWriter& writer, Transaction *txn);
 sixtp* gnc_transaction_sixtp_parser_create(void);
 
 sixtp* gnc_template_transaction_sixtp_parser_create(void);
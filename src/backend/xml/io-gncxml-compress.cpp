@@ -0,0 +1,863 @@
+/********************************************************************
+ * io-gncxml-compress.cpp -- compressed reading and writing of files*
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include "config.h"
+
+#include <platform.h>
+#if PLATFORM(WINDOWS)
+#include <io.h>
+#endif
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include <errno.h>
+}
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "io-gncxml-compress.h"
+
+/* How much is compressed or read in one go.  Gzip blocks this size are
+ * big enough that cutting the deflate history at their boundaries costs
+ * little. */
+#define GNC_XML_BLOCK_SIZE (128 * 1024)
+
+/* The gzip member header: no name, no time stamp, Unix. */
+static const Bytef gzip_header[] = { 037, 0213, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
+/* An empty final deflate block with fixed codes. */
+static const Bytef deflate_last_block[] = { 0x03, 0x00 };
+
+static guint
+compress_threads (void)
+{
+    guint n_threads = std::thread::hardware_concurrency ();
+
+    return n_threads > 0 ? n_threads : 1;
+}
+
+/* Everything below may run on the (de)compression threads, so it warns
+ * with g_warning() rather than the qof logging macros. */
+
+class GncXmlCompressor
+{
+public:
+    virtual ~GncXmlCompressor () {}
+    virtual bool write (const char *data, size_t len) = 0;
+    /** Writes out whatever is buffered and closes the file. */
+    virtual bool finish () = 0;
+};
+
+class GncXmlDecompressor
+{
+public:
+    virtual ~GncXmlDecompressor () {}
+    /** Like read(2): the number of bytes read, 0 at the end of the
+     * data, -1 on error. */
+    virtual gssize read (char *buf, size_t len) = 0;
+};
+
+/* pigz-style gzip writer: the data is cut into blocks which the pool
+ * deflates independently, each ending on a sync flush so that it stops
+ * on a byte boundary without being marked last.  The blocks' deflate
+ * streams then concatenate into one, which an empty last block ends. */
+class GzipBlockCompressor : public GncXmlCompressor
+{
+public:
+    GzipBlockCompressor (FILE *out, const gchar *filename);
+    ~GzipBlockCompressor ();
+    bool write (const char *data, size_t len) override;
+    bool finish () override;
+
+private:
+    struct Block
+    {
+        std::vector<Bytef> in;
+        std::vector<Bytef> out;
+        uLong crc;
+        bool ok;
+        bool done;
+    };
+
+    static void deflate_block (gpointer block_p, gpointer compressor_p);
+    void submit ();
+    void write_head ();
+    void write_bytes (const Bytef *data, size_t len);
+    void write_le32 (uLong value);
+
+    FILE *m_out;
+    gchar *m_filename;
+    GThreadPool *m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_block_done;
+    std::deque<Block*> m_pending;
+    Block *m_current;
+    size_t m_max_pending;
+    uLong m_crc;
+    uLong m_size;
+    bool m_ok;
+};
+
+GzipBlockCompressor::GzipBlockCompressor (FILE *out, const gchar *filename)
+    : m_out (out), m_filename (g_strdup (filename)), m_pool (NULL),
+      m_current (NULL), m_crc (crc32 (0L, Z_NULL, 0)), m_size (0), m_ok (true)
+{
+    guint n_threads = compress_threads ();
+    GError *error = NULL;
+
+    /* Enough to keep every worker busy while the head is written. */
+    m_max_pending = 2 * n_threads;
+    m_pool = g_thread_pool_new (deflate_block, this, n_threads, FALSE, &error);
+    if (!m_pool)
+    {
+        g_warning ("Could not create compression threads, compressing in line: %s",
+                   error ? error->message : "(unknown)");
+        g_clear_error (&error);
+    }
+    write_bytes (gzip_header, sizeof (gzip_header));
+}
+
+GzipBlockCompressor::~GzipBlockCompressor ()
+{
+    if (m_pool)
+        g_thread_pool_free (m_pool, FALSE, TRUE);
+    for (auto block : m_pending)
+        delete block;
+    delete m_current;
+    if (m_out)
+        fclose (m_out);
+    g_free (m_filename);
+}
+
+void
+GzipBlockCompressor::deflate_block (gpointer block_p, gpointer compressor_p)
+{
+    auto block = static_cast<Block*>(block_p);
+    auto compressor = static_cast<GzipBlockCompressor*>(compressor_p);
+    z_stream strm;
+
+    block->crc = crc32 (crc32 (0L, Z_NULL, 0), block->in.data (),
+                        block->in.size ());
+
+    memset (&strm, 0, sizeof (strm));
+    block->ok = deflateInit2 (&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                              -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (block->ok)
+    {
+        /* deflateBound() doesn't count the sync flush marker. */
+        block->out.resize (deflateBound (&strm, block->in.size ()) + 16);
+        strm.next_in = block->in.data ();
+        strm.avail_in = block->in.size ();
+        strm.next_out = block->out.data ();
+        strm.avail_out = block->out.size ();
+
+        for (;;)
+        {
+            int zval = deflate (&strm, Z_SYNC_FLUSH);
+            size_t used;
+
+            if (zval != Z_OK && zval != Z_BUF_ERROR)
+            {
+                block->ok = false;
+                break;
+            }
+            if (strm.avail_out != 0)
+                break;
+
+            used = block->out.size ();
+            block->out.resize (2 * used);
+            strm.next_out = block->out.data () + used;
+            strm.avail_out = block->out.size () - used;
+        }
+        block->out.resize (block->out.size () - strm.avail_out);
+        deflateEnd (&strm);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (compressor->m_mutex);
+        block->done = true;
+    }
+    compressor->m_block_done.notify_all ();
+}
+
+bool
+GzipBlockCompressor::write (const char *data, size_t len)
+{
+    while (len > 0)
+    {
+        size_t room, n;
+
+        if (!m_current)
+        {
+            m_current = new Block;
+            m_current->in.reserve (GNC_XML_BLOCK_SIZE);
+            m_current->ok = false;
+            m_current->done = false;
+        }
+
+        room = GNC_XML_BLOCK_SIZE - m_current->in.size ();
+        n = MIN (len, room);
+        m_current->in.insert (m_current->in.end (),
+                              reinterpret_cast<const Bytef*>(data),
+                              reinterpret_cast<const Bytef*>(data) + n);
+        data += n;
+        len -= n;
+
+        if (m_current->in.size () == GNC_XML_BLOCK_SIZE)
+            submit ();
+    }
+
+    return m_ok;
+}
+
+void
+GzipBlockCompressor::submit ()
+{
+    auto block = m_current;
+
+    m_current = NULL;
+    m_pending.push_back (block);
+    if (m_pool)
+        g_thread_pool_push (m_pool, block, NULL);
+    else
+        deflate_block (block, this);
+
+    while (!m_pending.empty ())
+    {
+        {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            if (m_pending.size () <= m_max_pending && !m_pending.front ()->done)
+                break;
+        }
+        write_head ();
+    }
+}
+
+void
+GzipBlockCompressor::write_head ()
+{
+    auto block = m_pending.front ();
+
+    {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_block_done.wait (lock, [block] { return block->done; });
+    }
+    m_pending.pop_front ();
+
+    if (!block->ok)
+    {
+        if (m_ok)
+            g_warning ("Could not compress the data for '%s'", m_filename);
+        m_ok = false;
+    }
+    else
+    {
+        m_crc = crc32_combine (m_crc, block->crc, block->in.size ());
+        m_size += block->in.size ();
+        write_bytes (block->out.data (), block->out.size ());
+    }
+    delete block;
+}
+
+void
+GzipBlockCompressor::write_bytes (const Bytef *data, size_t len)
+{
+    if (m_ok && fwrite (data, 1, len, m_out) != len)
+    {
+        g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
+                   m_filename, g_strerror (errno), errno);
+        m_ok = false;
+    }
+}
+
+void
+GzipBlockCompressor::write_le32 (uLong value)
+{
+    Bytef bytes[4];
+
+    for (int i = 0; i < 4; i++)
+        bytes[i] = (value >> (8 * i)) & 0xff;
+    write_bytes (bytes, sizeof (bytes));
+}
+
+bool
+GzipBlockCompressor::finish ()
+{
+    if (m_current && !m_current->in.empty ())
+        submit ();
+    while (!m_pending.empty ())
+        write_head ();
+
+    write_bytes (deflate_last_block, sizeof (deflate_last_block));
+    write_le32 (m_crc);
+    write_le32 (m_size);     /* ISIZE is the length mod 2^32 */
+
+    if (fclose (m_out) != 0)
+    {
+        g_warning ("Could not close the compressed file '%s'. The error is: '%s' (%d)",
+                   m_filename, g_strerror (errno), errno);
+        m_ok = false;
+    }
+    m_out = NULL;
+
+    return m_ok;
+}
+
+/* Inflates by hand rather than with gzread(), which takes a file cut off
+ * right after one of the blocks above for a complete one. */
+class GzipDecompressor : public GncXmlDecompressor
+{
+public:
+    GzipDecompressor (FILE *file, const gchar *filename)
+        : m_file (file), m_filename (g_strdup (filename)),
+          m_buffer (GNC_XML_BLOCK_SIZE), m_ended (false)
+    {
+        memset (&m_strm, 0, sizeof (m_strm));
+        /* Expect a gzip header and trailer. */
+        m_ok = inflateInit2 (&m_strm, 16 + MAX_WBITS) == Z_OK;
+    }
+    ~GzipDecompressor ()
+    {
+        if (m_ok)
+            inflateEnd (&m_strm);
+        fclose (m_file);
+        g_free (m_filename);
+    }
+    gssize read (char *buf, size_t len) override
+    {
+        if (!m_ok)
+        {
+            g_warning ("Could not set up decompression for '%s'", m_filename);
+            return -1;
+        }
+
+        m_strm.next_out = reinterpret_cast<Bytef*>(buf);
+        m_strm.avail_out = len;
+        while (m_strm.avail_out == len)
+        {
+            int zval;
+
+            if (m_strm.avail_in == 0)
+            {
+                size_t bytes = fread (m_buffer.data (), 1, m_buffer.size (), m_file);
+
+                if (bytes == 0)
+                {
+                    if (ferror (m_file) || !m_ended)
+                    {
+                        g_warning ("Could not read from compressed file '%s': %s",
+                                   m_filename, ferror (m_file) ?
+                                   g_strerror (errno) : "truncated data");
+                        return -1;
+                    }
+                    return 0;
+                }
+                m_strm.next_in = m_buffer.data ();
+                m_strm.avail_in = bytes;
+            }
+
+            /* Like gunzip, read concatenated members as one. */
+            if (m_ended)
+            {
+                inflateReset (&m_strm);
+                m_ended = false;
+            }
+
+            zval = inflate (&m_strm, Z_NO_FLUSH);
+            if (zval == Z_STREAM_END)
+                m_ended = true;
+            else if (zval != Z_OK && zval != Z_BUF_ERROR)
+            {
+                g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
+                           m_filename, m_strm.msg ? m_strm.msg : "", zval);
+                return -1;
+            }
+        }
+        return len - m_strm.avail_out;
+    }
+
+private:
+    FILE *m_file;
+    gchar *m_filename;
+    std::vector<Bytef> m_buffer;
+    z_stream m_strm;
+    bool m_ok;
+    bool m_ended;
+};
+
+#ifdef HAVE_ZSTD
+class ZstdCompressor : public GncXmlCompressor
+{
+public:
+    ZstdCompressor (FILE *out, ZSTD_CCtx *cctx, const gchar *filename)
+        : m_out (out), m_cctx (cctx), m_filename (g_strdup (filename)),
+          m_buffer (ZSTD_CStreamOutSize ()), m_ok (true)
+    {
+        ZSTD_CCtx_setParameter (m_cctx, ZSTD_c_checksumFlag, 1);
+        /* A libzstd built without threads refuses this and compresses in
+         * line, which is fine. */
+        ZSTD_CCtx_setParameter (m_cctx, ZSTD_c_nbWorkers, compress_threads ());
+    }
+    ~ZstdCompressor ()
+    {
+        ZSTD_freeCCtx (m_cctx);
+        if (m_out)
+            fclose (m_out);
+        g_free (m_filename);
+    }
+    bool write (const char *data, size_t len) override
+    {
+        ZSTD_inBuffer in = { data, len, 0 };
+
+        while (m_ok && in.pos < in.size)
+            compress (&in, ZSTD_e_continue);
+        return m_ok;
+    }
+    bool finish () override
+    {
+        ZSTD_inBuffer in = { NULL, 0, 0 };
+
+        while (m_ok && compress (&in, ZSTD_e_end) != 0)
+            ;
+        if (fclose (m_out) != 0)
+        {
+            g_warning ("Could not close the compressed file '%s'. The error is: '%s' (%d)",
+                       m_filename, g_strerror (errno), errno);
+            m_ok = false;
+        }
+        m_out = NULL;
+        return m_ok;
+    }
+
+private:
+    /* Returns what ZSTD_compressStream2() has left to flush. */
+    size_t compress (ZSTD_inBuffer *in, ZSTD_EndDirective end)
+    {
+        ZSTD_outBuffer out = { m_buffer.data (), m_buffer.size (), 0 };
+        size_t remaining = ZSTD_compressStream2 (m_cctx, &out, in, end);
+
+        if (ZSTD_isError (remaining))
+        {
+            g_warning ("Could not compress the data for '%s'. The error is: '%s'",
+                       m_filename, ZSTD_getErrorName (remaining));
+            m_ok = false;
+            return 0;
+        }
+        if (fwrite (out.dst, 1, out.pos, m_out) != out.pos)
+        {
+            g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
+                       m_filename, g_strerror (errno), errno);
+            m_ok = false;
+        }
+        return remaining;
+    }
+
+    FILE *m_out;
+    ZSTD_CCtx *m_cctx;
+    gchar *m_filename;
+    std::vector<char> m_buffer;
+    bool m_ok;
+};
+
+class ZstdDecompressor : public GncXmlDecompressor
+{
+public:
+    ZstdDecompressor (FILE *file, ZSTD_DCtx *dctx, const gchar *filename)
+        : m_file (file), m_dctx (dctx), m_filename (g_strdup (filename)),
+          m_buffer (ZSTD_DStreamInSize ()), m_remaining (1), m_flushing (false)
+    {
+        m_in.src = m_buffer.data ();
+        m_in.size = 0;
+        m_in.pos = 0;
+    }
+    ~ZstdDecompressor ()
+    {
+        ZSTD_freeDCtx (m_dctx);
+        fclose (m_file);
+        g_free (m_filename);
+    }
+    gssize read (char *buf, size_t len) override
+    {
+        ZSTD_outBuffer out = { buf, len, 0 };
+
+        while (out.pos == 0)
+        {
+            /* A full output buffer may have left data in the context, so
+             * only read more once it has been flushed. */
+            if (m_in.pos == m_in.size && !m_flushing)
+            {
+                size_t bytes = fread (m_buffer.data (), 1, m_buffer.size (), m_file);
+
+                if (bytes == 0)
+                {
+                    if (ferror (m_file) || m_remaining != 0)
+                    {
+                        g_warning ("Could not read from compressed file '%s': %s",
+                                   m_filename, ferror (m_file) ?
+                                   g_strerror (errno) : "truncated data");
+                        return -1;
+                    }
+                    return 0;
+                }
+                m_in.size = bytes;
+                m_in.pos = 0;
+            }
+
+            m_remaining = ZSTD_decompressStream (m_dctx, &out, &m_in);
+            if (ZSTD_isError (m_remaining))
+            {
+                g_warning ("Could not read from compressed file '%s'. The error is: '%s'",
+                           m_filename, ZSTD_getErrorName (m_remaining));
+                return -1;
+            }
+            m_flushing = out.pos == out.size;
+        }
+        return out.pos;
+    }
+
+private:
+    FILE *m_file;
+    ZSTD_DCtx *m_dctx;
+    gchar *m_filename;
+    std::vector<char> m_buffer;
+    ZSTD_inBuffer m_in;
+    size_t m_remaining;
+    bool m_flushing;
+};
+#endif /* HAVE_ZSTD */
+
+static GncXmlCompressor *
+compressor_new (const gchar *filename, GncXmlCompression compression)
+{
+    FILE *out;
+
+#ifndef HAVE_ZSTD
+    if (compression == GNC_XML_COMPRESSION_ZSTD)
+    {
+        g_warning ("Cannot write '%s': built without Zstandard support",
+                   filename);
+        return NULL;
+    }
+#endif
+
+    out = g_fopen (filename, "wb");
+    if (!out)
+    {
+        g_warning ("Could not open '%s' for writing: %s", filename,
+                   g_strerror (errno));
+        return NULL;
+    }
+
+#ifdef HAVE_ZSTD
+    if (compression == GNC_XML_COMPRESSION_ZSTD)
+    {
+        ZSTD_CCtx *cctx = ZSTD_createCCtx ();
+
+        if (!cctx)
+        {
+            g_warning ("Could not set up compression for '%s'", filename);
+            fclose (out);
+            return NULL;
+        }
+        return new ZstdCompressor (out, cctx, filename);
+    }
+#endif
+
+    return new GzipBlockCompressor (out, filename);
+}
+
+static GncXmlDecompressor *
+decompressor_new (const gchar *filename, GncXmlCompression compression)
+{
+#ifdef HAVE_ZSTD
+    if (compression == GNC_XML_COMPRESSION_ZSTD)
+    {
+        FILE *file = g_fopen (filename, "rb");
+        ZSTD_DCtx *dctx;
+
+        if (!file)
+            return NULL;
+        dctx = ZSTD_createDCtx ();
+        if (!dctx)
+        {
+            fclose (file);
+            return NULL;
+        }
+        return new ZstdDecompressor (file, dctx, filename);
+    }
+#endif
+
+    if (compression == GNC_XML_COMPRESSION_GZIP)
+    {
+        FILE *file = g_fopen (filename, "rb");
+
+        if (!file)
+            return NULL;
+        return new GzipDecompressor (file, filename);
+    }
+
+    g_warning ("Cannot read '%s': unsupported compression", filename);
+    return NULL;
+}
+
+typedef struct
+{
+    gint fd;
+    GncXmlCompressor *compressor;
+    GncXmlDecompressor *decompressor;
+} compress_thread_params_t;
+
+/* map the FILE* handed out to the thread at the other end of its pipe */
+static std::mutex threads_mutex;
+static std::unordered_map<FILE*, GThread*> threads;
+
+/* Moves data between the pipe and the (de)compressor.  Returns 1 on
+ * success or 0 otherwise, stuffed into a pointer type. */
+static gpointer
+compress_thread_func (compress_thread_params_t *params)
+{
+    std::vector<char> buffer (GNC_XML_BLOCK_SIZE);
+    gssize bytes;
+    gint success = 1;
+
+    if (params->compressor)
+    {
+        for (;;)
+        {
+            bytes = read (params->fd, buffer.data (), buffer.size ());
+            if (bytes > 0)
+            {
+                /* After a failure keep emptying the pipe, so that the
+                 * writer sees the error when it closes the file rather
+                 * than blocking. */
+                if (success && !params->compressor->write (buffer.data (), bytes))
+                    success = 0;
+            }
+            else if (bytes == 0)
+            {
+                break;
+            }
+            else if (errno != EINTR)
+            {
+                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                success = 0;
+                break;
+            }
+        }
+        if (!params->compressor->finish ())
+            success = 0;
+        delete params->compressor;
+    }
+    else
+    {
+        while ((bytes = params->decompressor->read (buffer.data (),
+                                                    buffer.size ())) > 0)
+        {
+            if (
+#if COMPILER(MSVC)
+                _write
+#else
+                write
+#endif
+                (params->fd, buffer.data (), bytes) < 0)
+            {
+                g_warning ("Could not write to pipe. The error is '%s' (%d)",
+                           g_strerror (errno) ? g_strerror (errno) : "", errno);
+                success = 0;
+                break;
+            }
+        }
+        if (bytes < 0)
+            success = 0;
+        delete params->decompressor;
+    }
+
+    close (params->fd);
+    g_free (params);
+
+    return GINT_TO_POINTER (success);
+}
+
+FILE *
+gnc_xml_compressed_open (const gchar *filename, const gchar *mode,
+                         GncXmlCompression compression)
+{
+    gboolean compress = mode[0] == 'w';
+    compress_thread_params_t *params;
+    int filedes[2];
+    GThread *thread;
+    GError *error = NULL;
+    FILE *file;
+
+    if (compression == GNC_XML_COMPRESSION_NONE)
+        return g_fopen (filename, mode);
+
+    params = g_new0 (compress_thread_params_t, 1);
+    if (compress)
+        params->compressor = compressor_new (filename, compression);
+    else
+        params->decompressor = decompressor_new (filename, compression);
+    if (!params->compressor && !params->decompressor)
+    {
+        g_free (params);
+        return NULL;
+    }
+
+#ifdef G_OS_WIN32
+    if (_pipe (filedes, GNC_XML_BLOCK_SIZE, _O_BINARY) < 0)
+#else
+    if (pipe (filedes) < 0)
+#endif
+    {
+        g_warning ("Pipe call failed: %s", g_strerror (errno));
+        delete params->compressor;
+        delete params->decompressor;
+        g_free (params);
+        return NULL;
+    }
+    params->fd = filedes[compress ? 0 : 1];
+
+#ifndef HAVE_GLIB_2_32
+    thread = g_thread_create ((GThreadFunc) compress_thread_func, params,
+                              TRUE, &error);
+#else
+    thread = g_thread_new ("xml_thread", (GThreadFunc) compress_thread_func,
+                           params);
+#endif
+    if (!thread)
+    {
+        g_warning ("Could not create thread for (de)compression: %s",
+                   error->message);
+        g_error_free (error);
+        delete params->compressor;
+        delete params->decompressor;
+        g_free (params);
+        close (filedes[0]);
+        close (filedes[1]);
+        return NULL;
+    }
+
+    if (compress)
+        file = fdopen (filedes[1], "w");
+    else
+        file = fdopen (filedes[0], "r");
+
+    std::lock_guard<std::mutex> lock (threads_mutex);
+    threads[file] = thread;
+
+    return file;
+}
+
+gboolean
+gnc_xml_compressed_close (FILE *file)
+{
+    gboolean retval;
+    GThread *thread = NULL;
+
+    {
+        std::lock_guard<std::mutex> lock (threads_mutex);
+        auto iter = threads.find (file);
+        if (iter != threads.end ())
+        {
+            thread = iter->second;
+            threads.erase (iter);
+        }
+    }
+
+    /* Closing our end of the pipe is what lets the thread finish. */
+    retval = fclose (file) == 0;
+    if (thread && !GPOINTER_TO_INT (g_thread_join (thread)))
+        retval = FALSE;
+
+    return retval;
+}
+
+gssize
+gnc_xml_compressed_peek (const gchar *filename, GncXmlCompression compression,
+                         gchar *buf, gsize len)
+{
+    GncXmlDecompressor *decompressor = decompressor_new (filename, compression);
+    gsize total = 0;
+
+    if (!decompressor)
+        return -1;
+
+    while (total < len)
+    {
+        gssize bytes = decompressor->read (buf + total, len - total);
+
+        if (bytes < 0)
+        {
+            delete decompressor;
+            return -1;
+        }
+        if (bytes == 0)
+            break;
+        total += bytes;
+    }
+    delete decompressor;
+
+    return total;
+}
+
+void
+gnc_xml_compressed_push_handler (xmlParserCtxtPtr xml_context, gpointer data)
+{
+    auto source = static_cast<gnc_xml_compressed_source*>(data);
+    GncXmlDecompressor *decompressor;
+    std::vector<char> buffer (GNC_XML_BLOCK_SIZE);
+    gssize bytes;
+    gboolean parse_ok = TRUE;
+
+    source->ok = FALSE;
+    decompressor = decompressor_new (source->filename, source->compression);
+    if (!decompressor)
+        return;
+
+    while ((bytes = decompressor->read (buffer.data (), buffer.size ())) > 0)
+    {
+        if (xmlParseChunk (xml_context, buffer.data (), bytes, 0) != 0)
+        {
+            parse_ok = FALSE;
+            break;
+        }
+    }
+    delete decompressor;
+
+    /* last chunk; a truncated file only fails here */
+    if (xmlParseChunk (xml_context, "", 0, 1) != 0)
+        parse_ok = FALSE;
+    source->ok = bytes >= 0 && parse_ok && xml_context->wellFormed;
+}
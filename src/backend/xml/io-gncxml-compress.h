@@ -0,0 +1,70 @@
+/********************************************************************
+ * io-gncxml-compress.h -- compressed reading and writing of files  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef IO_GNCXML_COMPRESS_H
+#define IO_GNCXML_COMPRESS_H
+
+extern "C"
+{
+#include <glib.h>
+#include <stdio.h>
+}
+
+#include "gnc-xml-helper.h"
+#include "io-gncxml-v2.h"
+
+/** Opens filename for reading ("r") or writing ("w") through a pipe,
+ * with a thread on the other end doing the (de)compression.
+ *
+ * Gzip output is cut into blocks that are deflated independently on a
+ * pool of threads and then written in order as a single gzip member, so
+ * any gunzip can read it.  Zstandard output uses libzstd's own workers.
+ * GNC_XML_COMPRESSION_NONE just opens the file.
+ *
+ * Close the file with gnc_xml_compressed_close().
+ */
+FILE *gnc_xml_compressed_open (const gchar *filename, const gchar *mode,
+                               GncXmlCompression compression);
+/** Closes a file from gnc_xml_compressed_open() and waits for its
+ * thread.  FALSE if anything failed along the way. */
+gboolean gnc_xml_compressed_close (FILE *file);
+
+/** Decompresses the start of filename into buf; returns the number of
+ * bytes read, or -1 on error. */
+gssize gnc_xml_compressed_peek (const gchar *filename,
+                                GncXmlCompression compression,
+                                gchar *buf, gsize len);
+
+typedef struct
+{
+    const gchar *filename;
+    GncXmlCompression compression;
+    gboolean ok;    /* set by the push handler */
+} gnc_xml_compressed_source;
+
+/** A sixtp_push_handler that decompresses the gnc_xml_compressed_source
+ * it gets as user data and feeds it straight to the parser.  Its ok is
+ * set only if the whole file was read and parsed as well-formed XML. */
+void gnc_xml_compressed_push_handler (xmlParserCtxtPtr xml_context,
+                                      gpointer source);
+
+#endif /* IO_GNCXML_COMPRESS_H */
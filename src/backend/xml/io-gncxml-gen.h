@@ -34,11 +34,16 @@ extern "C"
 typedef gboolean (*gxpf_callback)(const char *tag, gpointer parsedata,
                                   gpointer data);
 
+class GncXmlPipeline;
+
 struct gxpf_data_struct
 {
     gxpf_callback cb;
     gpointer parsedata;
     gpointer bookdata;
+    /* When set, parsers that support it hand their trees to the
+     * pipeline instead of converting them in line. */
+    GncXmlPipeline *pipeline;
 };
 
 typedef struct gxpf_data_struct gxpf_data;
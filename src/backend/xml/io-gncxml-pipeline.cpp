@@ -0,0 +1,137 @@
+/********************************************************************
+ * io-gncxml-pipeline.cpp -- convert loaded subtrees on workers     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include "config.h"
+
+#include <glib.h>
+#include "qof.h"
+}
+
+#include "io-gncxml-pipeline.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* How many trees each worker may be ahead of the commits; bounds the
+ * memory the pending trees take. */
+#define PIPELINE_PENDING_PER_THREAD 64
+
+GncXmlPipeline::GncXmlPipeline (guint n_threads)
+    : m_pool (NULL), m_max_pending (PIPELINE_PENDING_PER_THREAD * n_threads),
+      m_ok (TRUE)
+{
+    GError *error = NULL;
+
+    m_pool = g_thread_pool_new (run_job, this, n_threads, FALSE, &error);
+    if (!m_pool)
+    {
+        PWARN ("Could not create load threads, converting in line: %s",
+               error ? error->message : "(unknown)");
+        g_clear_error (&error);
+    }
+}
+
+GncXmlPipeline::~GncXmlPipeline ()
+{
+    /* Let the workers finish with the trees before freeing them. */
+    if (m_pool)
+        g_thread_pool_free (m_pool, FALSE, TRUE);
+
+    for (auto job : m_pending)
+    {
+        xmlFreeNode (job->node);
+        delete job;
+    }
+}
+
+void
+GncXmlPipeline::run_job (gpointer job_p, gpointer pipeline_p)
+{
+    auto job = static_cast<Job*>(job_p);
+    auto pipeline = static_cast<GncXmlPipeline*>(pipeline_p);
+
+    job->cache (job->node, job->values);
+
+    {
+        std::lock_guard<std::mutex> lock (pipeline->m_mutex);
+        job->done = true;
+    }
+    pipeline->m_job_done.notify_all ();
+}
+
+void
+GncXmlPipeline::push (xmlNodePtr node, CacheFunc cache, CommitFunc commit,
+                      gpointer data)
+{
+    auto job = new Job;
+
+    job->node = node;
+    job->cache = cache;
+    job->commit = commit;
+    job->data = data;
+    job->done = false;
+    m_pending.push_back (job);
+
+    if (m_pool)
+        g_thread_pool_push (m_pool, job, NULL);
+    else
+        run_job (job, this);
+
+    while (!m_pending.empty ()
+            && (m_pending.size () > m_max_pending || head_done ()))
+        commit_head ();
+}
+
+gboolean
+GncXmlPipeline::drain ()
+{
+    while (!m_pending.empty ())
+        commit_head ();
+    return m_ok;
+}
+
+bool
+GncXmlPipeline::head_done ()
+{
+    std::lock_guard<std::mutex> lock (m_mutex);
+    return m_pending.front ()->done;
+}
+
+void
+GncXmlPipeline::commit_head ()
+{
+    auto job = m_pending.front ();
+
+    {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_job_done.wait (lock, [job] { return job->done; });
+    }
+    m_pending.pop_front ();
+
+    /* Like the serial parse, keep going after a bad object so that
+     * everything it can report gets reported. */
+    if (!job->commit (job->node, job->data))
+        m_ok = FALSE;
+
+    xmlFreeNode (job->node);
+    delete job;
+}
@@ -0,0 +1,95 @@
+/********************************************************************
+ * io-gncxml-pipeline.h -- convert loaded subtrees on workers       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef IO_GNCXML_PIPELINE_H
+#define IO_GNCXML_PIPELINE_H
+
+extern "C"
+{
+#include <glib.h>
+}
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-parsers.h"
+
+/** Overlaps the conversion of top-level objects with the parse.
+ *
+ * The parsing thread pushes each finished object's DOM tree.  A pool of
+ * workers fills a DomTreeCache with the tree's GUIDs, dates, numbers
+ * and strings, which is most of the work that doesn't need the engine,
+ * and the parsing thread then commits the trees in file order: the
+ * commit function builds the engine object with the usual dom_tree_to_*
+ * code, which picks up the cached values. Since only the parsing thread
+ * touches the engine, the book comes out the same as without the
+ * pipeline.
+ *
+ * Anything that looks up an object committed through the pipeline must
+ * drain() it first.
+ */
+class GncXmlPipeline
+{
+public:
+    /** Runs on a worker thread: may only read the tree and fill the
+     * cache. */
+    typedef void (*CacheFunc) (xmlNodePtr node, DomTreeCache& cache);
+    /** Runs on the parsing thread; returns FALSE if node was bad. */
+    typedef gboolean (*CommitFunc) (xmlNodePtr node, gpointer data);
+
+    explicit GncXmlPipeline (guint n_threads);
+    /** Drops whatever hasn't been committed. */
+    ~GncXmlPipeline ();
+
+    /** Takes over node, which is freed once it's committed.  Commits
+     * whatever is ready, and waits when too much is pending. */
+    void push (xmlNodePtr node, CacheFunc cache, CommitFunc commit,
+               gpointer data);
+    /** Commits everything pushed so far.  FALSE if any commit failed. */
+    gboolean drain ();
+
+private:
+    struct Job
+    {
+        xmlNodePtr node;
+        CacheFunc cache;
+        CommitFunc commit;
+        gpointer data;
+        DomTreeCache values;
+        bool done;
+    };
+
+    static void run_job (gpointer job_p, gpointer pipeline_p);
+    bool head_done ();
+    void commit_head ();
+
+    GThreadPool *m_pool;
+    std::mutex m_mutex;
+    std::condition_variable m_job_done;
+    std::deque<Job*> m_pending;
+    size_t m_max_pending;
+    gboolean m_ok;
+};
+
+#endif /* IO_GNCXML_PIPELINE_H */
@@ -43,7 +43,6 @@ extern "C"
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
-#include <zlib.h>
 #include <errno.h>
 
 #include "gnc-engine.h"
@@ -74,29 +73,13 @@ extern "C"
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
+#include "io-gncxml-compress.h"
+#include "io-gncxml-pipeline.h"
 
-/* Do not treat -Wstrict-aliasing warnings as errors because of problems of the
- * G_LOCK* macros as declared by glib.  See
- * http://bugzilla.gnome.org/show_bug.cgi?id=316221 for additional information.
- */
-#if (__GNUC__ >= 4 && __GNUC_MINOR__ >= 2)
-#    pragma GCC diagnostic warning "-Wstrict-aliasing"
-#endif
+#include <thread>
 
 static QofLogModule log_module = GNC_MOD_IO;
 
-/* map pointers, e.g. of type FILE*, to GThreads */
-static GHashTable *threads = NULL;
-G_LOCK_DEFINE_STATIC(threads);
-
-typedef struct
-{
-    gint fd;
-    gchar *filename;
-    gchar *perms;
-    gboolean compress;
-} gz_thread_params_t;
-
 /* Callback structure */
 struct file_backend
 {
@@ -107,6 +90,7 @@ struct file_backend
     sixtp         * parser;
     FILE          * out;
     QofBook       * book;
+    GncXmlWriter  * writer;
 };
 
 #define GNC_V2_STRING "gnc-v2"
@@ -114,12 +98,6 @@ struct file_backend
 const gchar *gnc_v2_xml_version_string = GNC_V2_STRING;
 extern const gchar *gnc_v2_book_version_string;        /* see gnc-book-xml-v2 */
 
-/* Forward declarations */
-static FILE *try_gz_open (const char *filename, const char *perms, gboolean use_gzip,
-                          gboolean compress);
-static gboolean is_gzipped_file(const gchar *name);
-static gboolean wait_for_gzip(FILE *file);
-
 static void
 clear_up_account_commodity(
     gnc_commodity_table *tbl, Account *act,
@@ -613,6 +591,39 @@ book_callback(const char *tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+/* Later objects may refer to the ones still in the load pipeline, so
+ * commit those before parsing anything that isn't a transaction. */
+static gboolean
+pipeline_barrier_handler(gpointer data_for_children,
+                         GSList* data_from_children, GSList* sibling_data,
+                         gpointer parent_data, gpointer global_data,
+                         gpointer *result, const gchar *tag,
+                         const gchar *child_tag)
+{
+    gxpf_data *gdata = (gxpf_data*)global_data;
+
+    if (!gdata->pipeline || g_strcmp0(child_tag, TRANSACTION_TAG) == 0)
+        return TRUE;
+
+    return gdata->pipeline->drain();
+}
+
+/* How many threads convert transactions and prices while the file is
+ * parsed.  GNC_XML_LOAD_THREADS overrides it; 0 converts them on the
+ * parsing thread. */
+static guint
+gnc_xml_load_threads(void)
+{
+    const gchar *env = g_getenv("GNC_XML_LOAD_THREADS");
+    guint cores;
+
+    if (env)
+        return (guint) g_ascii_strtoull(env, NULL, 10);
+
+    cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 0;
+}
+
 static gboolean
 generic_callback(const char *tag, gpointer globaldata, gpointer data)
 {
@@ -709,6 +720,8 @@ qof_session_load_from_xml_file_v2_full(
     sixtp *main_parser;
     sixtp *book_parser;
     struct file_backend be_data;
+    gxpf_data gpdata;
+    guint n_threads;
     gboolean retval;
     char *v2type = NULL;
 
@@ -774,47 +787,77 @@ qof_session_load_from_xml_file_v2_full(
     if (be_data.ok == FALSE)
         goto bail;
 
+    sixtp_set_before_child(main_parser, pipeline_barrier_handler);
+    sixtp_set_before_child(book_parser, pipeline_barrier_handler);
+
     /* stop logging while we load */
     xaccLogDisable ();
     xaccDisableDataScrubbing();
 
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+    gpdata.pipeline = NULL;
+    n_threads = gnc_xml_load_threads();
+    if (n_threads > 0)
+        gpdata.pipeline = new GncXmlPipeline(n_threads);
+
     if (push_handler)
     {
         gpointer parse_result = NULL;
-        gxpf_data gpdata;
-
-        gpdata.cb = generic_callback;
-        gpdata.parsedata = gd;
-        gpdata.bookdata = book;
 
         retval = sixtp_parse_push(top_parser, push_handler, push_user_data,
                                   NULL, &gpdata, &parse_result);
     }
     else
     {
-	/* Even though libxml2 knows how to decompress zipped files, we
-	 * do it ourself since as of version 2.9.1 it has a bug that
-	 * causes it to fail to decompress certain files. See
-	 * https://bugzilla.gnome.org/show_bug.cgi?id=712528 for more
-	 * info.
-	 */
-	gchar *filename = fbe->fullpath;
-	FILE *file;
-	gboolean is_compressed = is_gzipped_file(filename);
-	file = try_gz_open(filename, "r", is_compressed, FALSE);
-	if (file == NULL)
-	{
-	    PWARN("Unable to open file %s", filename);
-	    retval = FALSE;
-	}
-	else
-	{
-	    retval = gnc_xml_parse_fd(top_parser, file,
-				      generic_callback, gd, book);
-	    fclose(file);
-	    if (is_compressed)
-		wait_for_gzip(file);
-	}
+        /* Even though libxml2 knows how to decompress zipped files, we
+         * do it ourself since as of version 2.9.1 it has a bug that
+         * causes it to fail to decompress certain files. See
+         * https://bugzilla.gnome.org/show_bug.cgi?id=712528 for more
+         * info.
+         */
+        gchar *filename = fbe->fullpath;
+        gpointer parse_result = NULL;
+        gnc_xml_compressed_source source;
+
+        source.filename = filename;
+        source.compression = gnc_xml_file_compression(filename);
+        if (source.compression != GNC_XML_COMPRESSION_NONE)
+        {
+            /* decompress straight into the parser */
+            retval = sixtp_parse_push(top_parser,
+                                      gnc_xml_compressed_push_handler, &source,
+                                      NULL, &gpdata, &parse_result);
+            if (!source.ok)
+            {
+                PWARN("Unable to read file %s", filename);
+                retval = FALSE;
+            }
+        }
+        else
+        {
+            FILE *file = g_fopen(filename, "r");
+            if (file == NULL)
+            {
+                PWARN("Unable to open file %s", filename);
+                retval = FALSE;
+            }
+            else
+            {
+                retval = sixtp_parse_fd(top_parser, file,
+                                        NULL, &gpdata, &parse_result);
+                fclose(file);
+            }
+        }
+    }
+
+    if (gpdata.pipeline)
+    {
+        /* the book may end with transactions still in the pipeline */
+        if (retval)
+            retval = gpdata.pipeline->drain();
+        delete gpdata.pipeline;
     }
 
     if (!retval)
@@ -1077,6 +1120,7 @@ write_commodities(FILE *out, QofBook *book, sixtp_gdv2 *gd)
     GList *namespaces;
     GList *lp;
     gboolean success = TRUE;
+    GncXmlWriter writer(out);
 
     tbl = gnc_commodity_table_get_table(book);
 
@@ -1089,25 +1133,21 @@ write_commodities(FILE *out, QofBook *book, sixtp_gdv2 *gd)
     for (lp = namespaces; success && lp; lp = lp->next)
     {
         GList *comms, *lp2;
-        xmlNodePtr comnode;
 
         comms = gnc_commodity_table_get_commodities(tbl, static_cast<const char*>(lp->data));
         comms = g_list_sort(comms, compare_commodity_ids);
 
         for (lp2 = comms; lp2; lp2 = lp2->next)
         {
-            comnode = gnc_commodity_dom_tree_create(static_cast<const gnc_commodity*>(lp2->data));
-            if (comnode == NULL)
+            if (!gnc_commodity_to_xml_stream(writer, static_cast<const gnc_commodity*>(lp2->data)))
                 continue;
 
-            xmlElemDump(out, NULL, comnode);
-            if (ferror(out) || fprintf(out, "\n") < 0)
+            if (writer.error())
             {
                 success = FALSE;
                 break;
             }
 
-            xmlFreeNode(comnode);
             gd->counter.commodities_loaded++;
             sixtp_run_callback(gd, "commodities");
         }
@@ -1123,71 +1163,19 @@ write_commodities(FILE *out, QofBook *book, sixtp_gdv2 *gd)
 static gboolean
 write_pricedb(FILE *out, QofBook *book, sixtp_gdv2 *gd)
 {
-    xmlNodePtr node;
-    xmlNodePtr parent;
-    xmlOutputBufferPtr outbuf;
-
-    parent = gnc_pricedb_dom_tree_create(gnc_pricedb_get_db(book));
+    GncXmlWriter writer(out);
 
-    if (!parent)
-    {
-        return TRUE;
-    }
-
-    /* Write out the parent pricedb tag then loop to write out each price.
-       We do it this way instead of just calling xmlElemDump so that we can
-       increment the progress bar as we go. */
-
-    if (fprintf( out, "<%s version=\"%s\">\n", parent->name,
-                 xmlGetProp(parent, BAD_CAST "version")) < 0)
-        return FALSE;
-
-    /* We create our own output buffer so we can call xmlNodeDumpOutput to get
-       the indendation correct. */
-    outbuf = xmlOutputBufferCreateFile(out, NULL);
-    if (outbuf == NULL)
-    {
-        xmlFreeNode(parent);
-        return FALSE;
-    }
-
-    for (node = parent->children; node; node = node->next)
-    {
-        /* Write two spaces since xmlNodeDumpOutput doesn't indent the first line */
-        xmlOutputBufferWrite(outbuf, 2, "  ");
-        xmlNodeDumpOutput(outbuf, NULL, node, 1, 1, NULL);
-        /* It also doesn't terminate the last line */
-        xmlOutputBufferWrite(outbuf, 1, "\n");
-        if (ferror(out))
-            break;
-        gd->counter.prices_loaded += 1;
-        sixtp_run_callback(gd, "prices");
-    }
-
-    xmlOutputBufferClose(outbuf);
-
-    if (ferror(out) || fprintf(out, "</%s>\n", parent->name) < 0)
-    {
-        xmlFreeNode(parent);
-        return FALSE;
-    }
-
-    xmlFreeNode(parent);
-    return TRUE;
+    gnc_pricedb_to_xml_stream(writer, gnc_pricedb_get_db(book), gd);
+    return !writer.error();
 }
 
 static int
 xml_add_trn_data(Transaction *t, gpointer data)
 {
     struct file_backend *be_data = static_cast<decltype(be_data)>(data);
-    xmlNodePtr node;
 
-    node = gnc_transaction_dom_tree_create(t);
-
-    xmlElemDump(be_data->out, NULL, node);
-    xmlFreeNode(node);
-
-    if (ferror(be_data->out) || fprintf(be_data->out, "\n") < 0)
+    gnc_transaction_to_xml_stream(*be_data->writer, t);
+    if (be_data->writer->error())
         return -1;
 
     be_data->gd->counter.transactions_loaded++;
@@ -1199,9 +1187,11 @@ static gboolean
 write_transactions(FILE *out, QofBook *book, sixtp_gdv2 *gd)
 {
     struct file_backend be_data;
+    GncXmlWriter writer(out);
 
     be_data.out = out;
     be_data.gd = gd;
+    be_data.writer = &writer;
     return 0 ==
            xaccAccountTreeForEachTransaction(gnc_book_get_root_account(book),
                    xml_add_trn_data,
@@ -1213,9 +1203,11 @@ write_template_transaction_data( FILE *out, QofBook *book, sixtp_gdv2 *gd )
 {
     Account *ra;
     struct file_backend be_data;
+    GncXmlWriter writer(out);
 
     be_data.out = out;
     be_data.gd = gd;
+    be_data.writer = &writer;
 
     ra = gnc_book_get_template_root(book);
     if ( gnc_account_n_descendants(ra) > 0 )
@@ -1405,232 +1397,20 @@ gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *book, FILE
     return success;
 }
 
-#define BUFLEN 4096
-
-/* Compress or decompress function that is to be run in a separate thread.
- * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
-static gpointer
-gz_thread_func(gz_thread_params_t *params)
-{
-    gchar buffer[BUFLEN];
-    gssize bytes;
-    gint gzval;
-    gzFile file;
-    gint success = 1;
-
-#ifdef G_OS_WIN32
-    {
-        gchar *conv_name = g_win32_locale_filename_from_utf8(params->filename);
-        gchar *perms;
-
-        if (!conv_name)
-        {
-            g_warning("Could not convert '%s' to system codepage",
-                      params->filename);
-            success = 0;
-            goto cleanup_gz_thread_func;
-        }
-
-        if (strchr(params->perms, 'b'))
-            perms = g_strdup(params->perms);
-        else
-            perms = g_strdup_printf("%cb%s", *params->perms, params->perms + 1);
-
-        file = gzopen(conv_name, perms);
-        g_free(perms);
-        g_free(conv_name);
-    }
-#else /* !G_OS_WIN32 */
-    file = gzopen(params->filename, params->perms);
-#endif /* G_OS_WIN32 */
-
-    if (file == NULL)
-    {
-        g_warning("Child threads gzopen failed");
-        success = 0;
-        goto cleanup_gz_thread_func;
-    }
-
-    if (params->compress)
-    {
-        while (success)
-        {
-            bytes = read(params->fd, buffer, BUFLEN);
-            if (bytes > 0)
-            {
-                if (gzwrite(file, buffer, bytes) <= 0)
-                {
-                    gint errnum;
-                    const gchar *error = gzerror(file, &errnum);
-                    g_warning("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                              params->filename, error, errnum);
-                    success = 0;
-                }
-            }
-            else if (bytes == 0)
-            {
-                break;
-            }
-            else
-            {
-                g_warning("Could not read from pipe. The error is '%s' (errno %d)",
-                          g_strerror(errno) ? g_strerror(errno) : "", errno);
-                success = 0;
-            }
-        }
-    }
-    else
-    {
-        while (success)
-        {
-            gzval = gzread(file, buffer, BUFLEN);
-            if (gzval > 0)
-            {
-                if (
-#if COMPILER(MSVC)
-                    _write
-#else
-                    write
-#endif
-                    (params->fd, buffer, gzval) < 0)
-                {
-                    g_warning("Could not write to pipe. The error is '%s' (%d)",
-                              g_strerror(errno) ? g_strerror(errno) : "", errno);
-                    success = 0;
-                }
-            }
-            else if (gzval == 0)
-            {
-                break;
-            }
-            else
-            {
-                gint errnum;
-                const gchar *error = gzerror(file, &errnum);
-                g_warning("Could not read from compressed file '%s'. The error is: '%s' (%d)",
-                          params->filename, error, errnum);
-                success = 0;
-            }
-        }
-    }
-
-    if ((gzval = gzclose(file)) != Z_OK)
-    {
-        g_warning("Could not close the compressed file '%s' (errnum %d)",
-                  params->filename, gzval);
-        success = 0;
-    }
-
-cleanup_gz_thread_func:
-    close(params->fd);
-    g_free(params->filename);
-    g_free(params->perms);
-    g_free(params);
-
-    return GINT_TO_POINTER(success);
-}
-
-static FILE *
-try_gz_open (const char *filename, const char *perms, gboolean use_gzip,
-             gboolean compress)
-{
-    if (strstr(filename, ".gz.") != NULL) /* its got a temp extension */
-        use_gzip = TRUE;
-
-    if (!use_gzip)
-        return g_fopen(filename, perms);
-
-    {
-        int filedes[2];
-        GThread *thread;
-        GError *error = NULL;
-        gz_thread_params_t *params;
-        FILE *file;
-
-#ifdef G_OS_WIN32
-        if (_pipe(filedes, 4096, _O_BINARY) < 0)
-        {
-#else
-        if (pipe(filedes) < 0)
-        {
-#endif
-            g_warning("Pipe call failed. Opening uncompressed file.");
-            return g_fopen(filename, perms);
-        }
-
-        params = g_new(gz_thread_params_t, 1);
-        params->fd = filedes[compress ? 0 : 1];
-        params->filename = g_strdup(filename);
-        params->perms = g_strdup(perms);
-        params->compress = compress;
-
-#ifndef HAVE_GLIB_2_32
-        thread = g_thread_create((GThreadFunc) gz_thread_func, params,
-				 TRUE, &error);
-#else
-        thread = g_thread_new("xml_thread", (GThreadFunc) gz_thread_func,
-			      params);
-#endif
-        if (!thread)
-        {
-            g_warning("Could not create thread for (de)compression: %s",
-                      error->message);
-            g_error_free(error);
-            g_free(params->filename);
-            g_free(params->perms);
-            g_free(params);
-            close(filedes[0]);
-            close(filedes[1]);
-
-            return g_fopen(filename, perms);
-        }
-
-        if (compress)
-            file = fdopen(filedes[1], "w");
-        else
-            file = fdopen(filedes[0], "r");
-
-        G_LOCK(threads);
-        if (!threads)
-            threads = g_hash_table_new(g_direct_hash, g_direct_equal);
-
-        g_hash_table_insert(threads, file, thread);
-        G_UNLOCK(threads);
-
-        return file;
-    }
-}
-
-static gboolean
-wait_for_gzip(FILE *file)
-{
-    gboolean retval = TRUE;
-
-    G_LOCK(threads);
-    if (threads)
-    {
-        GThread *thread = static_cast<decltype(thread)>(g_hash_table_lookup(threads, file));
-        if (thread)
-        {
-            g_hash_table_remove(threads, file);
-            retval = GPOINTER_TO_INT(g_thread_join(thread));
-        }
-    }
-    G_UNLOCK(threads);
-
-    return retval;
-}
-
 gboolean
 gnc_book_write_to_xml_file_v2(
     QofBook *book,
     const char *filename,
-    gboolean compress)
+    GncXmlCompression compression)
 {
     FILE *out;
     gboolean success = TRUE;
 
-    out = try_gz_open(filename, "w", compress, TRUE);
+    if (strstr(filename, ".gz.") != NULL) /* its got a temp extension */
+        if (compression == GNC_XML_COMPRESSION_NONE)
+            compression = GNC_XML_COMPRESSION_GZIP;
+
+    out = gnc_xml_compressed_open(filename, "w", compression);
 
     /* Try to write as much as possible */
     if (!out
@@ -1638,15 +1418,10 @@ gnc_book_write_to_xml_file_v2(
             || !write_emacs_trailer(out))
         success = FALSE;
 
-    /* Close the output stream */
-    if (out && fclose(out))
+    /* Close the output stream, waiting for the compression */
+    if (out && !gnc_xml_compressed_close(out))
         success = FALSE;
 
-    /* Optionally wait for parallel compression threads */
-    if (out && compress)
-        if (!wait_for_gzip(out))
-            success = FALSE;
-
     return success;
 }
 
@@ -1687,63 +1462,51 @@ gnc_book_write_accounts_to_xml_file_v2(
 }
 
 /***********************************************************************/
-static gboolean
-is_gzipped_file(const gchar *name)
+GncXmlCompression
+gnc_xml_file_compression(const gchar *name)
 {
-    unsigned char buf[2];
+    unsigned char buf[4];
     int fd = g_open(name, O_RDONLY, 0);
+    gssize num_read;
 
     if (fd == -1)
     {
-        return FALSE;
+        return GNC_XML_COMPRESSION_NONE;
     }
 
-    if (read(fd, buf, 2) != 2)
-    {
-        close(fd);
-        return FALSE;
-    }
+    num_read = read(fd, buf, sizeof(buf));
     close(fd);
 
-    if (buf[0] == 037 && buf[1] == 0213)
+    if (num_read >= 2 && buf[0] == 037 && buf[1] == 0213)
     {
-        return TRUE;
+        return GNC_XML_COMPRESSION_GZIP;
+    }
+#ifdef HAVE_ZSTD
+    if (num_read == 4 && buf[0] == 0x28 && buf[1] == 0xb5
+            && buf[2] == 0x2f && buf[3] == 0xfd)
+    {
+        return GNC_XML_COMPRESSION_ZSTD;
     }
+#endif
 
-    return FALSE;
+    return GNC_XML_COMPRESSION_NONE;
 }
 
 QofBookFileType
 gnc_is_xml_data_file_v2(const gchar *name, gboolean *with_encoding)
 {
-    if (is_gzipped_file(name))
+    GncXmlCompression compression = gnc_xml_file_compression(name);
+
+    if (compression != GNC_XML_COMPRESSION_NONE)
     {
-        gzFile file = NULL;
         char first_chunk[256];
-        int num_read;
-
-#ifdef G_OS_WIN32
-        {
-            gchar *conv_name = g_win32_locale_filename_from_utf8(name);
-            if (!conv_name)
-                g_warning("Could not convert '%s' to system codepage", name);
-            else
-            {
-                file = gzopen(conv_name, "rb");
-                g_free(conv_name);
-            }
-        }
-#else
-        file = gzopen(name, "r");
-#endif
-        if (file == NULL)
-            return GNC_BOOK_NOT_OURS;
-
-        num_read = gzread(file, first_chunk, sizeof(first_chunk) - 1);
-        gzclose(file);
+        gssize num_read;
 
+        num_read = gnc_xml_compressed_peek(name, compression, first_chunk,
+                                           sizeof(first_chunk) - 1);
         if (num_read < 1)
             return GNC_BOOK_NOT_OURS;
+        first_chunk[num_read] = '\0';
 
         return gnc_is_our_first_xml_chunk(first_chunk, with_encoding);
     }
@@ -1842,11 +1605,10 @@ gnc_xml2_find_ambiguous(const gchar *filename, GList *encodings,
     GHashTable *processed = NULL;
     gint n_impossible = 0;
     GError *error = NULL;
-    gboolean is_compressed;
     gboolean clean_return = FALSE;
 
-    is_compressed = is_gzipped_file(filename);
-    file = try_gz_open(filename, "r", is_compressed, FALSE);
+    file = gnc_xml_compressed_open(filename, "r",
+                                   gnc_xml_file_compression(filename));
     if (file == NULL)
     {
         PWARN("Unable to open file %s", filename);
@@ -2027,9 +1789,7 @@ cleanup_find_ambs:
         g_free(ascii);
     if (file)
     {
-        fclose(file);
-        if (is_compressed)
-            wait_for_gzip(file);
+        gnc_xml_compressed_close(file);
     }
 
     return (clean_return) ? n_impossible : -1;
@@ -2050,11 +1810,10 @@ parse_with_subst_push_handler (xmlParserCtxtPtr xml_context,
     GIConv ascii = (GIConv) - 1;
     GString *output = NULL;
     GError *error = NULL;
-    gboolean is_compressed;
 
     filename = push_data->filename;
-    is_compressed = is_gzipped_file(filename);
-    file = try_gz_open(filename, "r", is_compressed, FALSE);
+    file = gnc_xml_compressed_open(filename, "r",
+                                   gnc_xml_file_compression(filename));
     if (file == NULL)
     {
         PWARN("Unable to open file %s", filename);
@@ -2166,9 +1925,7 @@ cleanup_push_handler:
         g_iconv_close(ascii);
     if (file)
     {
-        fclose(file);
-        if (is_compressed)
-            wait_for_gzip(file);
+        gnc_xml_compressed_close(file);
     }
 }
 
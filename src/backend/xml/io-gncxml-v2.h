@@ -80,12 +80,21 @@ typedef struct
     QofBook *book;
 } gnc_template_xaction_data;
 
+/** How a data file is compressed. */
+typedef enum
+{
+    GNC_XML_COMPRESSION_NONE,
+    GNC_XML_COMPRESSION_GZIP,
+    GNC_XML_COMPRESSION_ZSTD,
+} GncXmlCompression;
+
 /** read in an account group from a file */
 gboolean qof_session_load_from_xml_file_v2(FileBackend *, QofBook *, QofBookFileType);
 
 /* write all book info to a file */
 gboolean gnc_book_write_to_xml_filehandle_v2(QofBook *book, FILE *fh);
-gboolean gnc_book_write_to_xml_file_v2(QofBook *book, const char *filename, gboolean compress);
+gboolean gnc_book_write_to_xml_file_v2(QofBook *book, const char *filename,
+                                       GncXmlCompression compression);
 
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2(QofBackend *be, QofBook *book, FILE *fh);
@@ -97,6 +106,11 @@ gboolean gnc_book_write_accounts_to_xml_file_v2(QofBackend * be, QofBook *book,
  */
 QofBookFileType gnc_is_xml_data_file_v2(const gchar *name, gboolean *with_encoding);
 
+/** Which compression the file uses, going by its magic number.  Zstandard
+ * is only recognized when it's built in.
+ */
+GncXmlCompression gnc_xml_file_compression(const gchar *name);
+
 /** Write a name-space declaration for the provided namespace data type
  * within the GNC XML namespace at http://www.gnucash.org/XML.
  */
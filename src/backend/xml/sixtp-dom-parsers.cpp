@@ -37,9 +37,20 @@ extern "C"
 
 static QofLogModule log_module = GNC_MOD_IO;
 
+static inline const DomTreeCache::Value*
+dom_tree_cached_value(xmlNodePtr node, DomTreeValueType type)
+{
+    auto value = static_cast<const DomTreeCache::Value*>(node->_private);
+    return value && value->type == type ? value : NULL;
+}
+
 GncGUID*
 dom_tree_to_guid(xmlNodePtr node)
 {
+    auto cached = dom_tree_cached_value(node, DOM_TREE_GUID);
+    if (cached)
+        return guid_copy(&cached->guid);
+
     if (!node->properties)
     {
         return NULL;
@@ -493,6 +504,10 @@ dom_tree_to_text(xmlNodePtr tree)
 
     g_return_val_if_fail(tree, NULL);
 
+    auto cached = dom_tree_cached_value(tree, DOM_TREE_TEXT);
+    if (cached)
+        return g_strdup(cached->text.c_str());
+
     /* no nodes means it's an empty string text */
     if (!tree->xmlChildrenNode)
     {
@@ -516,6 +531,14 @@ dom_tree_to_text(xmlNodePtr tree)
 gnc_numeric*
 dom_tree_to_gnc_numeric(xmlNodePtr node)
 {
+    auto cached = dom_tree_cached_value(node, DOM_TREE_NUMERIC);
+    if (cached)
+    {
+        gnc_numeric *ret = g_new(gnc_numeric, 1);
+        *ret = cached->numeric;
+        return ret;
+    }
+
     gchar *content = dom_tree_to_text(node);
     gnc_numeric *ret;
     if (!content)
@@ -564,6 +587,9 @@ dom_tree_to_timespec(xmlNodePtr node)
     gboolean seen_ns = FALSE;
     xmlNodePtr n;
 
+    auto cached = dom_tree_cached_value(node, DOM_TREE_TIMESPEC);
+    if (cached)
+        return cached->ts;
 
     ret.tv_sec = 0;
     ret.tv_nsec = 0;
@@ -914,3 +940,137 @@ dom_tree_valid_timespec (Timespec *ts, const xmlChar *name)
               "with a date of 1969-12-31 or 1970-01-01.", name);
     return FALSE;
 }
+
+/***********************************************************************/
+/* ahead-of-time conversion */
+
+/* These mirror the dom_tree_to_* converters above without logging,
+ * which isn't thread-safe, and give up wherever those would complain. */
+static gboolean
+cache_text(xmlNodePtr node, std::string& text)
+{
+    if (!node->xmlChildrenNode)
+    {
+        text.clear();
+        return TRUE;
+    }
+
+    auto temp = (char*)xmlNodeListGetString (NULL, node->xmlChildrenNode, TRUE);
+    if (!temp)
+        return FALSE;
+
+    text = temp;
+    xmlFree (temp);
+    return TRUE;
+}
+
+static gboolean
+cache_guid(xmlNodePtr node, GncGUID *guid)
+{
+    gboolean ok = FALSE;
+
+    if (!node->properties ||
+            strcmp((char*) node->properties->name, "type") != 0)
+        return FALSE;
+
+    auto type = (char*)xmlNodeGetContent (node->properties->xmlAttrPropertyValue);
+    if ((g_strcmp0("guid", type) == 0) || (g_strcmp0("new", type) == 0))
+    {
+        auto guid_str = (char*)xmlNodeGetContent (node->xmlChildrenNode);
+        ok = string_to_guid(guid_str, guid);
+        xmlFree (guid_str);
+    }
+    xmlFree (type);
+    return ok;
+}
+
+static gboolean
+cache_timespec(xmlNodePtr node, Timespec *ts)
+{
+    gboolean seen_s = FALSE;
+    gboolean seen_ns = FALSE;
+    std::string content;
+
+    ts->tv_sec = 0;
+    ts->tv_nsec = 0;
+    for (auto n = node->xmlChildrenNode; n; n = n->next)
+    {
+        switch (n->type)
+        {
+        case XML_COMMENT_NODE:
+        case XML_TEXT_NODE:
+            break;
+        case XML_ELEMENT_NODE:
+            if (g_strcmp0("ts:date", (char*)n->name) == 0)
+            {
+                if (seen_s || !cache_text(n, content) ||
+                        !string_to_timespec_secs(content.c_str(), ts))
+                    return FALSE;
+                seen_s = TRUE;
+            }
+            else if (g_strcmp0("ts:ns", (char*)n->name) == 0)
+            {
+                if (seen_ns || !cache_text(n, content) ||
+                        !string_to_timespec_nsecs(content.c_str(), ts))
+                    return FALSE;
+                seen_ns = TRUE;
+            }
+            break;
+        default:
+            return FALSE;
+        }
+    }
+    return seen_s;
+}
+
+void
+DomTreeCache::add (xmlNodePtr node, DomTreeValueType type)
+{
+    Value value;
+    gboolean ok = FALSE;
+
+    value.type = type;
+    switch (type)
+    {
+    case DOM_TREE_GUID:
+        ok = cache_guid(node, &value.guid);
+        break;
+    case DOM_TREE_TEXT:
+        ok = cache_text(node, value.text);
+        break;
+    case DOM_TREE_NUMERIC:
+        ok = cache_text(node, value.text) &&
+             string_to_gnc_numeric(value.text.c_str(), &value.numeric);
+        value.text.clear();
+        break;
+    case DOM_TREE_TIMESPEC:
+        ok = cache_timespec(node, &value.ts);
+        break;
+    }
+
+    if (!ok)
+        return;
+
+    m_values.push_back(std::move(value));
+    node->_private = &m_values.back();
+}
+
+void
+DomTreeCache::add_children (xmlNodePtr node,
+                            const struct dom_tree_cache_tag *tags)
+{
+    for (auto child = node->xmlChildrenNode; child; child = child->next)
+    {
+        if (child->type != XML_ELEMENT_NODE)
+            continue;
+
+        for (auto tag = tags; tag->tag; tag++)
+        {
+            if (g_strcmp0(tag->tag, (char*)child->name) == 0)
+            {
+                add(child, tag->type);
+                break;
+            }
+        }
+    }
+}
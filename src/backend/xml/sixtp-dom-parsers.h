@@ -34,6 +34,9 @@ extern "C"
 
 #include "gnc-xml-helper.h"
 
+#include <deque>
+#include <string>
+
 GncGUID* dom_tree_to_guid(xmlNodePtr node);
 
 gnc_commodity* dom_tree_to_commodity_ref(xmlNodePtr node, QofBook *book);
@@ -76,4 +79,50 @@ gboolean dom_tree_generic_parse(xmlNodePtr node,
                                 struct dom_tree_handler *handlers,
                                 gpointer data);
 
+typedef enum
+{
+    DOM_TREE_GUID,
+    DOM_TREE_TEXT,
+    DOM_TREE_NUMERIC,
+    DOM_TREE_TIMESPEC,
+} DomTreeValueType;
+
+struct dom_tree_cache_tag
+{
+    const char *tag;
+    DomTreeValueType type;
+};
+
+/** Node contents converted ahead of the handlers that use them, so that
+ * the text parsing can run on a thread that mustn't touch the engine.
+ *
+ * add() hangs the converted value off the node's _private field, and
+ * dom_tree_to_guid(), dom_tree_to_text(), dom_tree_to_gnc_numeric() and
+ * dom_tree_to_timespec() then return it instead of parsing the node
+ * again.  Nodes that don't convert cleanly are left alone, so that the
+ * converter reports them as usual.  The cache must outlive the tree.
+ */
+class DomTreeCache
+{
+public:
+    struct Value
+    {
+        DomTreeValueType type;
+        GncGUID guid;
+        gnc_numeric numeric;
+        Timespec ts;
+        std::string text;
+    };
+
+    /** Doesn't log or use the engine, so it's safe on any thread that
+     * owns the tree. */
+    void add (xmlNodePtr node, DomTreeValueType type);
+    /** Adds each child element of node whose name is in the
+     * NULL-terminated tags. */
+    void add_children (xmlNodePtr node, const struct dom_tree_cache_tag *tags);
+
+private:
+    std::deque<Value> m_values;
+};
+
 #endif /* _SIXTP_DOM_PARSERS_H_ */
@@ -0,0 +1,489 @@
+/********************************************************************
+ * sixtp-stream-generators.cpp                                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include "config.h"
+#include <string.h>
+#include <glib.h>
+
+#include <gnc-date.h>
+}
+
+#include "gnc-xml-helper.h"
+#include "sixtp-dom-generators.h"
+#include "sixtp-stream-generators.h"
+#include "sixtp-utils.h"
+
+#include <kvp_frame.hpp>
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* libxml2 indents two spaces a level, up to 60 spaces. */
+#define INDENT_SIZE 2
+#define INDENT_MAX_LEVEL 30
+
+GncXmlWriter::GncXmlWriter (FILE *out) :
+    m_out (out), m_start_tag_open (FALSE), m_error (FALSE)
+{
+}
+
+GncXmlWriter::~GncXmlWriter ()
+{
+    g_warn_if_fail (m_open.empty ());
+}
+
+void
+GncXmlWriter::indent (size_t level)
+{
+    m_buf.append (INDENT_SIZE * MIN (level, INDENT_MAX_LEVEL), ' ');
+}
+
+void
+GncXmlWriter::close_start_tag ()
+{
+    if (m_start_tag_open)
+    {
+        m_buf += '>';
+        m_start_tag_open = FALSE;
+    }
+}
+
+void
+GncXmlWriter::start_element (const char *tag)
+{
+    if (!m_open.empty ())
+    {
+        Element& parent = m_open.back ();
+        g_return_if_fail (!parent.has_text);
+        if (m_start_tag_open)
+        {
+            close_start_tag ();
+            m_buf += '\n';
+        }
+        parent.has_elements = TRUE;
+        indent (m_open.size ());
+    }
+    m_buf += '<';
+    m_buf += tag;
+    m_open.push_back ({tag, FALSE, FALSE});
+    m_start_tag_open = TRUE;
+}
+
+void
+GncXmlWriter::add_attribute (const char *name, const char *value)
+{
+    const char *p;
+
+    g_return_if_fail (m_start_tag_open);
+
+    m_buf += ' ';
+    m_buf += name;
+    m_buf += "=\"";
+    /* As xmlAttrSerializeTxtContent escapes it for a document without an
+     * encoding. */
+    for (p = value; *p; ++p)
+    {
+        switch (*p)
+        {
+        case '\n': m_buf += "&#10;"; break;
+        case '\r': m_buf += "&#13;"; break;
+        case '\t': m_buf += "&#9;"; break;
+        case '"': m_buf += "&quot;"; break;
+        case '<': m_buf += "&lt;"; break;
+        case '>': m_buf += "&gt;"; break;
+        case '&': m_buf += "&amp;"; break;
+        default:
+            if (static_cast<guchar>(*p) < 0x80)
+                m_buf += *p;
+            else
+            {
+                gunichar c = g_utf8_get_char_validated (p, -1);
+                char ref[16];
+                if (c == static_cast<gunichar>(-1) ||
+                        c == static_cast<gunichar>(-2))
+                    c = static_cast<guchar>(*p);
+                else
+                    p = g_utf8_next_char (p) - 1;
+                g_snprintf (ref, sizeof (ref), "&#x%X;", c);
+                m_buf += ref;
+            }
+        }
+    }
+    m_buf += '"';
+}
+
+void
+GncXmlWriter::append_escaped_text (const char *text, size_t len)
+{
+    const char *end = text + len, *run = text, *p;
+
+    /* As xmlEscapeContent escapes text nodes. */
+    for (p = text; p < end; ++p)
+    {
+        const char *ent;
+        switch (*p)
+        {
+        case '<': ent = "&lt;"; break;
+        case '>': ent = "&gt;"; break;
+        case '&': ent = "&amp;"; break;
+        case '\r': ent = "&#13;"; break;
+        default: continue;
+        }
+        m_buf.append (run, p - run);
+        m_buf += ent;
+        run = p + 1;
+    }
+    m_buf.append (run, end - run);
+}
+
+void
+GncXmlWriter::add_text (const char *text, gboolean check)
+{
+    size_t len = strlen (text);
+    const gchar *p;
+
+    g_return_if_fail (!m_open.empty ());
+    g_return_if_fail (!m_open.back ().has_elements);
+
+    close_start_tag ();
+    m_open.back ().has_text = TRUE;
+    if (!check)
+    {
+        append_escaped_text (text, len);
+        return;
+    }
+
+    for (p = text; *p; ++p)
+        if (*p > 0 && *p < 0x20 && *p != 0x09 && *p != 0x0a && *p != 0x0d)
+            break;
+    if (*p || !g_utf8_validate (text, len, NULL))
+    {
+        gchar *copy = g_strdup (text);
+        append_escaped_text (reinterpret_cast<char*>(checked_char_cast (copy)),
+                             len);
+        g_free (copy);
+    }
+    else
+        append_escaped_text (text, len);
+}
+
+void
+GncXmlWriter::end_element ()
+{
+    g_return_if_fail (!m_open.empty ());
+
+    Element& elem = m_open.back ();
+    if (m_start_tag_open)
+    {
+        m_buf += "/>";
+        m_start_tag_open = FALSE;
+    }
+    else
+    {
+        /* Text content isn't indented, so only child elements are
+         * followed by a newline and the end tag indented. */
+        if (elem.has_elements)
+            indent (m_open.size () - 1);
+        m_buf += "</";
+        m_buf += elem.tag;
+        m_buf += '>';
+    }
+    m_open.pop_back ();
+    m_buf += '\n';
+    if (m_open.empty ())
+        flush ();
+}
+
+void
+GncXmlWriter::discard ()
+{
+    m_buf.clear ();
+    m_open.clear ();
+    m_start_tag_open = FALSE;
+}
+
+void
+GncXmlWriter::flush ()
+{
+    if (!m_error && !m_buf.empty () &&
+            fwrite (m_buf.data (), 1, m_buf.size (), m_out) != m_buf.size ())
+        m_error = TRUE;
+    m_buf.clear ();
+}
+
+gboolean
+GncXmlWriter::error () const
+{
+    return m_error || ferror (m_out);
+}
+
+/***********************************************************************/
+
+gboolean
+text_to_xml_stream (GncXmlWriter& writer, const char *tag, const char *str)
+{
+    g_return_val_if_fail (tag, FALSE);
+    g_return_val_if_fail (str, FALSE);
+    writer.start_element (tag);
+    /* xmlNodeAddContent ignores empty text. */
+    if (*str)
+        writer.add_text (str);
+    writer.end_element ();
+    return TRUE;
+}
+
+void
+text_child_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                          const char *str)
+{
+    writer.start_element (tag);
+    if (str)
+        writer.add_text (str);
+    writer.end_element ();
+}
+
+void
+int_to_xml_stream (GncXmlWriter& writer, const char *tag, gint64 val)
+{
+    gchar text[32];
+
+    g_snprintf (text, sizeof (text), "%" G_GINT64_FORMAT, val);
+    text_to_xml_stream (writer, tag, text);
+}
+
+void
+empty_to_xml_stream (GncXmlWriter& writer, const char *tag)
+{
+    writer.start_element (tag);
+    writer.end_element ();
+}
+
+gboolean
+guid_to_xml_stream (GncXmlWriter& writer, const char *tag, const GncGUID* gid)
+{
+    char guid_str[GUID_ENCODING_LENGTH + 1];
+
+    if (!guid_to_string_buff (gid, guid_str))
+    {
+        PERR ("guid_to_string_buff failed\n");
+        return FALSE;
+    }
+
+    writer.start_element (tag);
+    writer.add_attribute ("type", "guid");
+    writer.add_text (guid_str, FALSE);
+    writer.end_element ();
+    return TRUE;
+}
+
+gboolean
+commodity_ref_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                             const gnc_commodity *c)
+{
+    g_return_val_if_fail (c, FALSE);
+
+    if (!gnc_commodity_get_namespace (c) || !gnc_commodity_get_mnemonic (c))
+        return FALSE;
+
+    writer.start_element (tag);
+    text_child_to_xml_stream (writer, "cmdty:space",
+                              gnc_commodity_get_namespace_compat (c));
+    text_child_to_xml_stream (writer, "cmdty:id",
+                              gnc_commodity_get_mnemonic (c));
+    writer.end_element ();
+    return TRUE;
+}
+
+gboolean
+timespec_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                        const Timespec *spec, const char *type)
+{
+    gchar *date_str;
+
+    g_return_val_if_fail (spec, FALSE);
+
+    date_str = timespec_sec_to_string (spec);
+    if (!date_str)
+        return FALSE;
+
+    writer.start_element (tag);
+    if (type)
+        writer.add_attribute ("type", type);
+    text_child_to_xml_stream (writer, "ts:date", date_str);
+    if (spec->tv_nsec > 0)
+    {
+        gchar *ns_str = timespec_nsec_to_string (spec);
+        if (ns_str)
+            text_child_to_xml_stream (writer, "ts:ns", ns_str);
+        g_free (ns_str);
+    }
+    writer.end_element ();
+
+    g_free (date_str);
+    return TRUE;
+}
+
+void
+gdate_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                     const GDate *date, const char *type)
+{
+    gchar date_str[512];
+
+    g_return_if_fail (date);
+
+    g_date_strftime (date_str, sizeof (date_str), "%Y-%m-%d", date);
+    writer.start_element (tag);
+    if (type)
+        writer.add_attribute ("type", type);
+    text_child_to_xml_stream (writer, "gdate", date_str);
+    writer.end_element ();
+}
+
+void
+gnc_numeric_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                           const gnc_numeric *num)
+{
+    gchar *numstr;
+
+    g_return_if_fail (num);
+
+    numstr = gnc_numeric_to_string (*num);
+    g_return_if_fail (numstr);
+    text_to_xml_stream (writer, tag, numstr);
+    g_free (numstr);
+}
+
+/* A typed value, which add_kvp_value_node sets with xmlNodeSetContent. */
+static void
+add_typed_value (GncXmlWriter& writer, const char *tag, const char *type,
+                 const char *val)
+{
+    writer.start_element (tag);
+    writer.add_attribute ("type", type);
+    if (*val)
+        writer.add_text (val);
+    writer.end_element ();
+}
+
+static void add_kvp_slot (const char *key, KvpValue *value, void *data);
+
+static void
+add_kvp_value (GncXmlWriter& writer, const char *tag, KvpValue *val)
+{
+    switch (val->get_type ())
+    {
+    case KvpValue::Type::INT64:
+    {
+        gchar text[32];
+        g_snprintf (text, sizeof (text), "%" G_GINT64_FORMAT,
+                    val->get<int64_t>());
+        add_typed_value (writer, tag, "integer", text);
+        break;
+    }
+    case KvpValue::Type::DOUBLE:
+    {
+        gchar *text = double_to_string (val->get<double>());
+        add_typed_value (writer, tag, "double", text);
+        g_free (text);
+        break;
+    }
+    case KvpValue::Type::NUMERIC:
+    {
+        gchar *text = gnc_numeric_to_string (val->get<gnc_numeric>());
+        add_typed_value (writer, tag, "numeric", text);
+        g_free (text);
+        break;
+    }
+    case KvpValue::Type::STRING:
+        writer.start_element (tag);
+        writer.add_attribute ("type", "string");
+        if (val->get<const char*>())
+            writer.add_text (val->get<const char*>());
+        writer.end_element ();
+        break;
+    case KvpValue::Type::GUID:
+    {
+        gchar guidstr[GUID_ENCODING_LENGTH + 1];
+        guid_to_string_buff (val->get<GncGUID*>(), guidstr);
+        add_typed_value (writer, tag, "guid", guidstr);
+        break;
+    }
+    case KvpValue::Type::TIMESPEC:
+    {
+        auto ts = val->get<Timespec>();
+        timespec_to_xml_stream (writer, tag, &ts, "timespec");
+        break;
+    }
+    case KvpValue::Type::GDATE:
+    {
+        auto d = val->get<GDate>();
+        gdate_to_xml_stream (writer, tag, &d, "gdate");
+        break;
+    }
+    case KvpValue::Type::GLIST:
+        writer.start_element (tag);
+        writer.add_attribute ("type", "list");
+        for (auto cursor = val->get<GList*>(); cursor; cursor = cursor->next)
+            add_kvp_value (writer, "slot:value",
+                           static_cast<KvpValue*>(cursor->data));
+        writer.end_element ();
+        break;
+    case KvpValue::Type::FRAME:
+    {
+        auto frame = val->get<KvpFrame*>();
+        writer.start_element (tag);
+        writer.add_attribute ("type", "frame");
+        if (frame)
+            frame->for_each_slot (add_kvp_slot, &writer);
+        writer.end_element ();
+        break;
+    }
+    default:
+        empty_to_xml_stream (writer, tag);
+        break;
+    }
+}
+
+static void
+add_kvp_slot (const char *key, KvpValue *value, void *data)
+{
+    auto& writer = *static_cast<GncXmlWriter*>(data);
+
+    writer.start_element ("slot");
+    text_child_to_xml_stream (writer, "slot:key", key);
+    add_kvp_value (writer, "slot:value", value);
+    writer.end_element ();
+}
+
+gboolean
+qof_instance_slots_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                                  const QofInstance *inst)
+{
+    KvpFrame *frame = qof_instance_get_slots (inst);
+    if (!frame)
+        return FALSE;
+
+    writer.start_element (tag);
+    frame->for_each_slot (add_kvp_slot, &writer);
+    writer.end_element ();
+    return TRUE;
+}
@@ -0,0 +1,111 @@
+/********************************************************************
+ * sixtp-stream-generators.h                                        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+#ifndef SIXTP_STREAM_GENERATORS_H
+#define SIXTP_STREAM_GENERATORS_H
+
+extern "C"
+{
+#include <stdio.h>
+#include <glib.h>
+
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include <string>
+#include <vector>
+
+/** Writes elements straight to a file, laid out byte for byte as
+ * xmlElemDump() lays out the DOM tree the matching *_dom_tree_create
+ * function builds, so that large objects can be saved without building
+ * one.
+ *
+ * An element's content is either text or child elements, never both.
+ * Each top-level element is buffered until it's closed, then written
+ * with a newline after it. Tags and attribute names aren't copied and
+ * must outlive the element.
+ */
+class GncXmlWriter
+{
+public:
+    explicit GncXmlWriter (FILE *out);
+    ~GncXmlWriter ();
+
+    void start_element (const char *tag);
+    /** Must be called before the element's content is added. */
+    void add_attribute (const char *name, const char *value);
+    /** Adds a text node. An empty one still counts as content, as with
+     * xmlNewTextChild(), so the element is closed with an end tag. The
+     * text gets the same cleanup as checked_char_cast() unless check is
+     * FALSE. */
+    void add_text (const char *text, gboolean check = TRUE);
+    void end_element ();
+    /** Drops the top-level element being written and everything in it. */
+    void discard ();
+    /** TRUE if writing to the file has failed. */
+    gboolean error () const;
+
+private:
+    struct Element
+    {
+        const char *tag;
+        gboolean has_text;
+        gboolean has_elements;
+    };
+
+    void close_start_tag ();
+    void indent (size_t level);
+    void append_escaped_text (const char *text, size_t len);
+    void flush ();
+
+    FILE *m_out;
+    std::string m_buf;
+    std::vector<Element> m_open;
+    gboolean m_start_tag_open;
+    gboolean m_error;
+};
+
+/* Counterparts of the generators in sixtp-dom-generators.h; where those
+ * return NULL, these write nothing and return FALSE. */
+gboolean text_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                             const char *str);
+void text_child_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                               const char *str);
+void int_to_xml_stream (GncXmlWriter& writer, const char *tag, gint64 val);
+void empty_to_xml_stream (GncXmlWriter& writer, const char *tag);
+gboolean guid_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                             const GncGUID *gid);
+gboolean commodity_ref_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                                      const gnc_commodity *c);
+gboolean timespec_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                                 const Timespec *spec,
+                                 const char *type = NULL);
+void gdate_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                          const GDate *date, const char *type = NULL);
+void gnc_numeric_to_xml_stream (GncXmlWriter& writer, const char *tag,
+                                const gnc_numeric *num);
+gboolean qof_instance_slots_to_xml_stream (GncXmlWriter& writer,
+                                           const char *tag,
+                                           const QofInstance *inst);
+
+#endif /* SIXTP_STREAM_GENERATORS_H */
@@ -105,6 +105,45 @@ write_dom_node_to_file(xmlNodePtr node, int fd)
     fclose(out);
 }
 
+static gchar*
+file_contents(FILE *file)
+{
+    GString *str = g_string_new(NULL);
+    char buf[4096];
+    size_t len;
+
+    rewind(file);
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+        g_string_append_len(str, buf, len);
+    return g_string_free(str, FALSE);
+}
+
+gboolean
+written_matches_dom_node(xmlNodePtr node,
+                         void (*write)(FILE *out, gpointer data),
+                         gpointer data)
+{
+    FILE *dumped = tmpfile();
+    FILE *written = tmpfile();
+    gchar *dumped_str, *written_str;
+    gboolean retval;
+
+    xmlElemDump(dumped, NULL, node);
+    fprintf(dumped, "\n");
+    write(written, data);
+    dumped_str = file_contents(dumped);
+    written_str = file_contents(written);
+    retval = g_strcmp0(dumped_str, written_str) == 0;
+    if (!retval)
+        printf("Expected:\n%s\nWritten:\n%s\n", dumped_str, written_str);
+
+    g_free(dumped_str);
+    g_free(written_str);
+    fclose(dumped);
+    fclose(written);
+    return retval;
+}
+
 gboolean
 print_dom_tree(gpointer data_for_children, GSList* data_from_children,
                GSList* sibling_data, gpointer parent_data,
@@ -42,6 +42,12 @@ typedef struct KvpFrameImpl KvpFrame;
 
 void write_dom_node_to_file(xmlNodePtr node, int fd);
 
+/* Whether write writes exactly what xmlElemDump writes for node, with a
+ * newline after it as the file writers add. */
+gboolean written_matches_dom_node(xmlNodePtr node,
+                                  void (*write)(FILE *out, gpointer data),
+                                  gpointer data);
+
 int files_compare(const gchar* f1, const gchar* f2);
 
 gboolean print_dom_tree(gpointer data_for_children, GSList* data_from_children,
@@ -37,6 +37,7 @@ extern "C"
 #include <glib.h>
 #include <glib-object.h>
 #include <glib/gstdio.h>
+#include <zlib.h>
 
 #include <cashobjects.h>
 #include <TransLog.h>
@@ -77,6 +78,34 @@ remove_locks(const char *filename)
     remove_files_pattern(filename, ".LCK");
 }
 
+/* The same file loaded with transactions and prices converted on the
+ * parsing thread must give an identical book. */
+static void
+test_serial_load_matches(const char *filename, QofBook *book)
+{
+    QofSession *session;
+    QofBook *serial_book;
+
+    g_setenv("GNC_XML_LOAD_THREADS", "0", TRUE);
+    session = qof_session_new();
+    qof_session_begin(session, filename, TRUE, FALSE, TRUE);
+    qof_session_load(session, NULL);
+    serial_book = qof_session_get_book (session);
+
+    do_test_args(xaccAccountEqual(gnc_book_get_root_account(serial_book),
+                                  gnc_book_get_root_account(book), TRUE),
+                 "threaded load accounts", __FILE__, __LINE__,
+                 "accounts and transactions differ for file [%s]", filename);
+    do_test_args(gnc_pricedb_equal(gnc_pricedb_get_db(serial_book),
+                                   gnc_pricedb_get_db(book)),
+                 "threaded load prices", __FILE__, __LINE__,
+                 "prices differ for file [%s]", filename);
+
+    qof_session_end(session);
+    qof_session_destroy(session);
+    g_unsetenv("GNC_XML_LOAD_THREADS");
+}
+
 static void
 test_load_file(const char *filename)
 {
@@ -98,6 +127,7 @@ test_load_file(const char *filename)
 /*    gnc_prefs_set_file_save_compressed(FALSE); */
     qof_session_begin(session, filename, ignore_lock, FALSE, TRUE);
 
+    g_setenv("GNC_XML_LOAD_THREADS", "4", TRUE);
     qof_session_load(session, NULL);
     book = qof_session_get_book (session);
 
@@ -109,11 +139,80 @@ test_load_file(const char *filename)
                  "session load xml2", __FILE__, __LINE__,
                  "qof error=%d for file [%s]",
                  qof_session_get_error(session), filename);
+    test_serial_load_matches(filename, book);
     /* Uncomment the line below to generate corrected files */
 /*    qof_session_save( session, NULL ); */
     qof_session_end(session);
 }
 
+/* A gzipped book cut off halfway must fail to load instead of giving
+ * whatever was parsed up to the cut. */
+static void
+test_load_truncated(const char *filename)
+{
+    QofSession *session;
+    gchar *contents = NULL, *truncated;
+    gsize length;
+    gint fd;
+    gzFile gz;
+    QofBackendError err;
+    const char *logdomain = "gnc.io";
+    GLogLevelFlags loglevel = static_cast<decltype(loglevel)>(G_LOG_LEVEL_WARNING);
+    guint hdlr;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL))
+    {
+        failure_args("truncated load", __FILE__, __LINE__,
+                     "unable to read file [%s]", filename);
+        return;
+    }
+
+    truncated = g_strdup("test-load-xml2-truncated-XXXXXX");
+    fd = g_mkstemp(truncated);
+    if (fd == -1)
+    {
+        failure("unable to create temporary file");
+        g_free(contents);
+        g_free(truncated);
+        return;
+    }
+    close(fd);
+
+    if (length >= 2 && (guchar)contents[0] == 037
+            && (guchar)contents[1] == 0213)
+    {
+        g_file_set_contents(truncated, contents, length / 2, NULL);
+    }
+    else
+    {
+        gz = gzopen(truncated, "wb");
+        gzwrite(gz, contents, length);
+        gzclose(gz);
+        g_free(contents);
+        g_file_get_contents(truncated, &contents, &length, NULL);
+        g_file_set_contents(truncated, contents, length / 2, NULL);
+    }
+    g_free(contents);
+
+    hdlr = g_log_set_handler (logdomain, loglevel,
+                              (GLogFunc)test_null_handler, NULL);
+    session = qof_session_new();
+    qof_session_begin(session, truncated, TRUE, FALSE, TRUE);
+    qof_session_load(session, NULL);
+    err = qof_session_get_error(session);
+    g_log_remove_handler (logdomain, hdlr);
+
+    do_test_args(err != ERR_BACKEND_NO_ERR,
+                 "truncated load", __FILE__, __LINE__,
+                 "no error loading truncated copy of [%s]", filename);
+
+    qof_session_end(session);
+    qof_session_destroy(session);
+    remove_locks(truncated);
+    g_unlink(truncated);
+    g_free(truncated);
+}
+
 int
 main (int argc, char ** argv)
 {
@@ -149,6 +248,8 @@ main (int argc, char ** argv)
                 if (!g_file_test(to_open, G_FILE_TEST_IS_DIR))
                 {
                     test_load_file(to_open);
+                    if (files_tested == 0)
+                        test_load_truncated(to_open);
                     files_tested++;
                 }
                 g_free(to_open);
@@ -237,6 +237,13 @@ test_add_account(const char *tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+static void
+stream_account(FILE *out, gpointer act)
+{
+    GncXmlWriter writer(out);
+    gnc_account_to_xml_stream(writer, static_cast<Account*>(act), FALSE, TRUE);
+}
+
 static void
 test_account(int i, Account *test_act)
 {
@@ -268,6 +275,8 @@ test_account(int i, Account *test_act)
     {
         success("account_xml");
     }
+    do_test(written_matches_dom_node(test_node, stream_account, test_act),
+            "gnc_account_to_xml_stream");
 
     filename1 = g_strdup_printf("test_file_XXXXXX");
 
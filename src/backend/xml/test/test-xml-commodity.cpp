@@ -169,6 +169,13 @@ test_add_commodity(const char *tag, gpointer globaldata, gpointer data)
 
 }
 
+static void
+stream_commodity(FILE *out, gpointer com)
+{
+    GncXmlWriter writer(out);
+    gnc_commodity_to_xml_stream(writer, static_cast<gnc_commodity*>(com));
+}
+
 static void
 test_generation(void)
 {
@@ -204,6 +211,10 @@ test_generation(void)
         {
             success_args("commodity_xml", __FILE__, __LINE__, "%d", i);
         }
+        do_test_args(written_matches_dom_node(test_node, stream_commodity,
+                                              ran_com),
+                     "gnc_commodity_to_xml_stream", __FILE__, __LINE__,
+                     "%d", i);
 
         filename1 = g_strdup_printf("test_file_XXXXXX");
 
@@ -63,6 +63,13 @@ test_add_pricedb (const char *tag, gpointer globaldata, gpointer data)
     return TRUE;
 }
 
+static void
+stream_pricedb (FILE *out, gpointer db)
+{
+    GncXmlWriter writer (out);
+    gnc_pricedb_to_xml_stream (writer, static_cast<GNCPriceDB*>(db), NULL);
+}
+
 static void
 test_db (GNCPriceDB *db)
 {
@@ -83,6 +90,9 @@ test_db (GNCPriceDB *db)
     if (!db)
         return;
 
+    do_test_args (written_matches_dom_node (test_node, stream_pricedb, db),
+                  "gnc_pricedb_to_xml_stream", __FILE__, __LINE__, "%d", iter);
+
     filename1 = g_strdup_printf ("test_file_XXXXXX");
 
     fd = g_mkstemp (filename1);
@@ -339,6 +339,13 @@ really_get_rid_of_transaction(Transaction *trn)
     xaccTransCommitEdit(trn);
 }
 
+static void
+stream_transaction(FILE *out, gpointer trn)
+{
+    GncXmlWriter writer(out);
+    gnc_transaction_to_xml_stream(writer, static_cast<Transaction*>(trn));
+}
+
 struct tran_data_struct
 {
     Transaction *trn;
@@ -440,6 +447,10 @@ test_transaction(void)
         {
             success_args("transaction_xml", __FILE__, __LINE__, "%d", i );
         }
+        do_test_args(written_matches_dom_node(test_node, stream_transaction,
+                                              ran_trn),
+                     "gnc_transaction_to_xml_stream", __FILE__, __LINE__,
+                     "%d", i);
 
         filename1 = g_strdup_printf("test_file_XXXXXX");
 
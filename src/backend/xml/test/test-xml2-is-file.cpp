@@ -22,16 +22,65 @@ extern "C"
 #include "config.h"
 #include <stdlib.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#include <glib/gstdio.h>
 
 #include "test-stuff.h"
 #include "test-engine-stuff.h"
 }
 
 #include "io-gncxml-v2.h"
+#include "io-gncxml-compress.h"
 #include "test-file-stuff.h"
 
 #define FILENAME "Money95bank_fr.gml2"
 
+static void
+test_compressed_copy(const char *filename, GncXmlCompression compression)
+{
+    gchar *contents, *copy_contents;
+    gsize length, copy_length;
+    gchar *copy_name = g_strdup("test-xml2-is-file-XXXXXX");
+    int fd = g_mkstemp(copy_name);
+    FILE *out;
+    gboolean ok;
+
+    close(fd);
+    g_file_get_contents(filename, &contents, &length, NULL);
+
+    /* several blocks' worth, so the parallel compressor has work */
+    out = gnc_xml_compressed_open(copy_name, "w", compression);
+    ok = out != NULL;
+    for (int i = 0; ok && i < 8; i++)
+        ok = fwrite(contents, 1, length, out) == length;
+    if (out && !gnc_xml_compressed_close(out))
+        ok = FALSE;
+    do_test(ok, "write compressed copy");
+    do_test(gnc_xml_file_compression(copy_name) == compression,
+            "gnc_xml_file_compression");
+    do_test(gnc_is_xml_data_file_v2(copy_name, NULL),
+            "gnc_is_xml_data_file_v2 compressed");
+
+    out = gnc_xml_compressed_open(copy_name, "r", compression);
+    copy_contents = static_cast<gchar*>(g_malloc(length));
+    ok = out != NULL;
+    for (int i = 0; ok && i < 8; i++)
+        ok = (fread(copy_contents, 1, length, out) == length
+              && memcmp(contents, copy_contents, length) == 0);
+    if (ok)
+        ok = fread(copy_contents, 1, 1, out) == 0;
+    if (out && !gnc_xml_compressed_close(out))
+        ok = FALSE;
+    do_test(ok, "read compressed copy");
+
+    g_unlink(copy_name);
+    g_free(copy_contents);
+    g_free(contents);
+    g_free(copy_name);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -45,6 +94,12 @@ main(int argc, char **argv)
     char *filename = static_cast<decltype(filename)>(malloc(strlen(directory) + 1 + strlen(FILENAME) + 1));
     sprintf(filename, "%s/%s", directory, FILENAME);
     do_test(gnc_is_xml_data_file_v2(filename, NULL), "gnc_is_xml_data_file_v2");
+    do_test(gnc_xml_file_compression(filename) == GNC_XML_COMPRESSION_NONE,
+            "gnc_xml_file_compression uncompressed");
+    test_compressed_copy(filename, GNC_XML_COMPRESSION_GZIP);
+#ifdef HAVE_ZSTD
+    test_compressed_copy(filename, GNC_XML_COMPRESSION_ZSTD);
+#endif
 
     print_test_results();
     exit(get_rv());
@@ -34,6 +34,7 @@ static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
+static gboolean sql_load_on_demand = FALSE; // This is also the default in the prefs backend
 
 PrefsBackend *prefsbackend = NULL;
 
@@ -116,6 +117,18 @@ gnc_prefs_set_file_retention_days(gint days)
     file_retention_days = days;
 }
 
+gboolean
+gnc_prefs_get_sql_load_on_demand(void)
+{
+    return sql_load_on_demand;
+}
+
+void
+gnc_prefs_set_sql_load_on_demand(gboolean on_demand)
+{
+    sql_load_on_demand = on_demand;
+}
+
 guint
 gnc_prefs_get_long_version()
 {
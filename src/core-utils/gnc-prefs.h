@@ -113,6 +113,12 @@ void gnc_prefs_set_file_retention_policy(gint policy);
 gint gnc_prefs_get_file_retention_days(void);
 void gnc_prefs_set_file_retention_days(gint days);
 
+/** Whether the SQL backend should load transactions only when an
+ *  account register or a query needs them, instead of all at once
+ *  when the book is opened.  Only read when a book is opened. */
+gboolean gnc_prefs_get_sql_load_on_demand(void);
+void gnc_prefs_set_sql_load_on_demand(gboolean on_demand);
+
 guint gnc_prefs_get_long_version( void );
 
 /** @} */
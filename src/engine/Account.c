@@ -40,6 +40,7 @@
 #include "gnc-lot.h"
 #include "gnc-pricedb.h"
 #include "qofinstance-p.h"
+#include "Query.h"
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
 
@@ -117,6 +118,8 @@ enum
 \********************************************************************/
 
 static void xaccAccountBringUpToDate (Account *acc);
+static void account_split_index_clear (AccountPrivate *priv);
+static void account_balance_dirty_from (AccountPrivate *priv, gint pos);
 
 
 /********************************************************************\
@@ -270,10 +273,16 @@ gnc_account_init(Account* acc)
     priv->starting_balance = gnc_numeric_zero();
     priv->starting_cleared_balance = gnc_numeric_zero();
     priv->starting_reconciled_balance = gnc_numeric_zero();
+    priv->splits_loaded_from = G_MININT64;
+    priv->loading_splits = FALSE;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_pos = 0;
 
     priv->splits = NULL;
     priv->sort_dirty = FALSE;
+    priv->split_index = g_sequence_new (NULL);
+    priv->split_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+    priv->splits_changed = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -285,6 +294,17 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    g_list_free (priv->splits);
+    priv->splits = NULL;
+    g_sequence_free (priv->split_index);
+    priv->split_index = NULL;
+    g_hash_table_destroy (priv->split_map);
+    priv->split_map = NULL;
+    g_hash_table_destroy (priv->splits_changed);
+    priv->splits_changed = NULL;
+
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -343,7 +363,8 @@ gnc_account_get_property (GObject         *object,
         g_value_set_boolean(value, priv->non_standard_scu);
         break;
     case PROP_SORT_DIRTY:
-        g_value_set_boolean(value, priv->sort_dirty);
+        g_value_set_boolean(value, priv->sort_dirty ||
+                            g_hash_table_size(priv->splits_changed) > 0);
         break;
     case PROP_BALANCE_DIRTY:
         g_value_set_boolean(value, priv->balance_dirty);
@@ -1358,8 +1379,7 @@ xaccAccountCommitEdit (Account *acc)
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            account_split_index_clear (priv);
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1710,9 +1730,324 @@ gnc_account_set_balance_dirty (Account *acc)
         return;
 
     priv = GET_PRIVATE(acc);
+    account_balance_dirty_from (priv, 0);
+}
+
+/* Mark the running balances dirty from position pos of the split list
+ * onwards, keeping the earliest such position. */
+static void
+account_balance_dirty_from (AccountPrivate *priv, gint pos)
+{
+    if (!priv->balance_dirty || pos < priv->balance_dirty_pos)
+        priv->balance_dirty_pos = pos;
     priv->balance_dirty = TRUE;
 }
 
+void
+gnc_account_split_changed (Account *acc, Split *split)
+{
+    AccountPrivate *priv;
+    GSequenceIter *iter;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    iter = g_hash_table_lookup (priv->split_map, split);
+    /* A split that isn't in the list yet can't affect the running
+     * balances, and gets put in place when it is inserted; it stays in
+     * the set only so that sort-dirty reports the pending change. */
+    if (iter)
+        account_balance_dirty_from (priv, g_sequence_iter_get_position (iter));
+    else
+        account_balance_dirty_from (priv,
+                                    g_sequence_get_length (priv->split_index));
+    if (!priv->sort_dirty)
+        g_hash_table_insert (priv->splits_changed, split, split);
+}
+
+/********************************************************************\
+ * Split index                                                      *
+ *   The account's split list is kept in step with a GSequence of   *
+ *   its GList nodes.  The sequence finds the sorted position of a  *
+ *   new split in O(log n); the node is then linked into the list   *
+ *   next to its neighbour, so the list handed out by               *
+ *   xaccAccountGetSplitList() is never rebuilt or copied.          *
+\********************************************************************/
+
+static gint
+split_node_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    return xaccSplitOrder (((const GList*)a)->data, ((const GList*)b)->data);
+}
+
+/* Link node, which iter holds, into the split list between the nodes
+ * of its neighbours in the index. */
+static void
+account_split_index_link (AccountPrivate *priv, GList *node,
+                          GSequenceIter *iter)
+{
+    GSequenceIter *next = g_sequence_iter_next (iter);
+
+    if (!g_sequence_iter_is_end (next))
+    {
+        GList *next_node = g_sequence_get (next);
+        node->next = next_node;
+        node->prev = next_node->prev;
+        if (next_node->prev)
+            next_node->prev->next = node;
+        else
+            priv->splits = node;
+        next_node->prev = node;
+    }
+    else if (!g_sequence_iter_is_begin (iter))
+    {
+        GList *prev_node = g_sequence_get (g_sequence_iter_prev (iter));
+        prev_node->next = node;
+        node->prev = prev_node;
+    }
+    else
+    {
+        priv->splits = node;
+    }
+}
+
+static GSequenceIter *
+account_split_index_insert (AccountPrivate *priv, Split *s, gboolean sorted)
+{
+    GList *node = g_list_alloc ();
+    GSequenceIter *iter;
+
+    node->data = s;
+    if (sorted)
+        iter = g_sequence_insert_sorted (priv->split_index, node,
+                                         split_node_order, NULL);
+    else
+        iter = g_sequence_prepend (priv->split_index, node);
+    g_hash_table_insert (priv->split_map, s, iter);
+    account_split_index_link (priv, node, iter);
+    return iter;
+}
+
+static gboolean
+account_split_index_remove (AccountPrivate *priv, Split *s)
+{
+    GSequenceIter *iter = g_hash_table_lookup (priv->split_map, s);
+    GList *node;
+
+    if (!iter)
+        return FALSE;
+
+    account_balance_dirty_from (priv, g_sequence_iter_get_position (iter));
+    g_hash_table_remove (priv->splits_changed, s);
+    node = g_sequence_get (iter);
+    g_sequence_remove (iter);
+    g_hash_table_remove (priv->split_map, s);
+    priv->splits = g_list_delete_link (priv->splits, node);
+    return TRUE;
+}
+
+/* Re-sort the index and relink the list nodes in the new order.  No
+ * node is allocated or freed, so the iterators in split_map stay
+ * valid. */
+static void
+account_split_index_sort (AccountPrivate *priv)
+{
+    GSequenceIter *iter;
+    GList *prev = NULL;
+
+    g_sequence_sort (priv->split_index, split_node_order, NULL);
+    priv->splits = NULL;
+    for (iter = g_sequence_get_begin_iter (priv->split_index);
+            !g_sequence_iter_is_end (iter);
+            iter = g_sequence_iter_next (iter))
+    {
+        GList *node = g_sequence_get (iter);
+        node->prev = prev;
+        node->next = NULL;
+        if (prev)
+            prev->next = node;
+        else
+            priv->splits = node;
+        prev = node;
+    }
+}
+
+/* Move just the splits in splits_changed to their new places.  They
+ * are all taken out first so that the remaining index is sorted
+ * again, then put back one at a time. */
+static void
+account_split_index_reposition (AccountPrivate *priv)
+{
+    GPtrArray *moved = g_ptr_array_new ();
+    GHashTableIter hiter;
+    gpointer key;
+    guint i;
+
+    g_hash_table_iter_init (&hiter, priv->splits_changed);
+    while (g_hash_table_iter_next (&hiter, &key, NULL))
+    {
+        GSequenceIter *iter = g_hash_table_lookup (priv->split_map, key);
+        GList *node;
+
+        if (!iter)
+            continue;
+        account_balance_dirty_from (priv,
+                                    g_sequence_iter_get_position (iter));
+        node = g_sequence_get (iter);
+        g_sequence_remove (iter);
+        priv->splits = g_list_remove_link (priv->splits, node);
+        g_ptr_array_add (moved, node);
+    }
+    g_hash_table_remove_all (priv->splits_changed);
+
+    for (i = 0; i < moved->len; i++)
+    {
+        GList *node = g_ptr_array_index (moved, i);
+        GSequenceIter *iter = g_sequence_insert_sorted (priv->split_index,
+                                                        node,
+                                                        split_node_order,
+                                                        NULL);
+        g_hash_table_insert (priv->split_map, node->data, iter);
+        account_split_index_link (priv, node, iter);
+        account_balance_dirty_from (priv,
+                                    g_sequence_iter_get_position (iter));
+    }
+    g_ptr_array_free (moved, TRUE);
+}
+
+static void
+account_split_index_clear (AccountPrivate *priv)
+{
+    g_sequence_remove_range (g_sequence_get_begin_iter (priv->split_index),
+                             g_sequence_get_end_iter (priv->split_index));
+    g_hash_table_remove_all (priv->split_map);
+    g_hash_table_remove_all (priv->splits_changed);
+    g_list_free (priv->splits);
+    priv->splits = NULL;
+}
+
+static gint
+split_node_date_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    /* One of a and b is the probe, whose node holds no split.  It sorts
+     * after every split posted before *date and before every split
+     * posted at or after it. */
+    const Split *sa = ((const GList*)a)->data;
+    const Split *sb = ((const GList*)b)->data;
+    time64 date = *(const time64*)user_data;
+
+    if (!sa)
+        return xaccTransGetDate (xaccSplitGetParent (sb)) < date ? 1 : -1;
+    return xaccTransGetDate (xaccSplitGetParent (sa)) < date ? -1 : 1;
+}
+
+/* Binary search for the first split posted at or after date.  Returns
+ * the end iterator if there is none.  The index must be sorted. */
+static GSequenceIter *
+account_split_index_search_date (const AccountPrivate *priv, time64 date)
+{
+    GList probe = { NULL, NULL, NULL };
+
+    return g_sequence_search (priv->split_index, &probe,
+                              split_node_date_order, &date);
+}
+
+/* The balance between the adjacent splits prev and next, either of
+ * which may be NULL.  The running balance of prev only counts the splits
+ * after it if they are all loaded, so if it was posted before
+ * splits_loaded_from the balance is worked back from next instead, which
+ * the caller must have loaded. */
+static gnc_numeric
+account_balance_between (const AccountPrivate *priv, const Split *prev,
+                         const Split *next)
+{
+    /* Before any entries the account has the balance it started with,
+     * which is zero unless the backend left some splits unloaded. */
+    if (!prev)
+        return priv->starting_balance;
+    if (xaccTransGetDate (xaccSplitGetParent (prev)) >= priv->splits_loaded_from)
+        return xaccSplitGetBalance (prev);
+    if (!next)
+        return priv->balance;
+    return gnc_numeric_sub (xaccSplitGetBalance (next), xaccSplitGetAmount (next),
+                            GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+}
+
+/* The balance before the first split posted at or after date; the
+ * splits must be sorted, the running balances up to date and the splits
+ * from date on loaded. */
+static gnc_numeric
+account_balance_before_date (const AccountPrivate *priv, time64 date)
+{
+    GSequenceIter *iter = account_split_index_search_date (priv, date);
+    GList *prev = NULL, *next = NULL;
+
+    if (!g_sequence_iter_is_begin (iter))
+        prev = g_sequence_get (g_sequence_iter_prev (iter));
+    if (!g_sequence_iter_is_end (iter))
+        next = g_sequence_get (iter);
+    return account_balance_between (priv, prev ? prev->data : NULL,
+                                    next ? next->data : NULL);
+}
+
+/* The balance as of the given date, with the same requirements. */
+static gnc_numeric
+account_balance_as_of_date (const AccountPrivate *priv, time64 date)
+{
+    /* If no split was posted at or after the given date, the latest
+     * account balance is good enough. */
+    if (g_sequence_iter_is_end (account_split_index_search_date (priv, date)))
+        return priv->balance;
+
+    return account_balance_before_date (priv, date);
+}
+
+/* Has the backend loaded every split of the account from date on?  If
+ * not, ask it for them with a split query, which goes through its query
+ * hooks like any other.  The loading may send events whose handlers ask
+ * for balances again, so it isn't started twice for the same account;
+ * other accounts still load what they need. */
+static void
+account_load_splits_from (Account *acc, time64 date)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    QofQuery *query;
+
+    if (date >= priv->splits_loaded_from || priv->loading_splits)
+        return;
+
+    priv->loading_splits = TRUE;
+    query = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (query, gnc_account_get_book (acc));
+    xaccQueryAddSingleAccountMatch (query, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (query, TRUE, date, FALSE, 0, QOF_QUERY_AND);
+    qof_query_run (query);
+    qof_query_destroy (query);
+    priv->loading_splits = FALSE;
+}
+
+void
+gnc_account_set_splits_loaded_from (Account *acc, time64 date)
+{
+    g_return_if_fail (GNC_IS_ACCOUNT(acc));
+
+    GET_PRIVATE(acc)->splits_loaded_from = date;
+}
+
+/* The last node of the split list, without walking it. */
+static GList *
+account_split_index_last (const AccountPrivate *priv)
+{
+    GSequenceIter *end = g_sequence_get_end_iter (priv->split_index);
+
+    if (g_sequence_iter_is_begin (end))
+        return NULL;
+    return g_sequence_get (g_sequence_iter_prev (end));
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -1720,33 +2055,33 @@ gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    GSequenceIter *iter;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    if (g_hash_table_lookup (priv->split_map, s))
         return FALSE;
 
     if (qof_instance_get_editlevel(acc) == 0)
     {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
+        iter = account_split_index_insert (priv, s, TRUE);
     }
     else
     {
-        priv->splits = g_list_prepend(priv->splits, s);
+        iter = account_split_index_insert (priv, s, FALSE);
         priv->sort_dirty = TRUE;
     }
+    g_hash_table_remove (priv->splits_changed, s);
+    priv->split_list_generation++;
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
     /* Also send an event based on the account */
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
-    priv->balance_dirty = TRUE;
+    account_balance_dirty_from (priv, g_sequence_iter_get_position (iter));
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1756,23 +2091,20 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    if (!account_split_index_remove (priv, s))
         return FALSE;
+    priv->split_list_generation++;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
-    priv->balance_dirty = TRUE;
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1785,11 +2117,19 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
 
     priv = GET_PRIVATE(acc);
-    if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
+    if (!force && qof_instance_get_editlevel(acc) > 0)
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
-    priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
+    if (priv->sort_dirty)
+    {
+        account_split_index_sort (priv);
+        g_hash_table_remove_all (priv->splits_changed);
+        priv->sort_dirty = FALSE;
+        account_balance_dirty_from (priv, 0);
+    }
+    else if (g_hash_table_size (priv->splits_changed) > 0)
+    {
+        account_split_index_reposition (priv);
+    }
 }
 
 static void
@@ -2061,7 +2401,8 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
+    GList *lp = NULL;
+    gint pos, nsplits;
 
     if (NULL == acc) return;
 
@@ -2071,13 +2412,33 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* The splits before balance_dirty_pos still hold good running
+     * balances, so pick up the accumulation from the last of them. */
+    nsplits = g_sequence_get_length (priv->split_index);
+    pos = MIN (priv->balance_dirty_pos, nsplits);
+    if (pos > 0)
+    {
+        GList *prev = g_sequence_get (g_sequence_get_iter_at_pos (priv->split_index,
+                                      pos - 1));
+        Split *split = (Split *) prev->data;
+
+        balance            = split->balance;
+        cleared_balance    = split->cleared_balance;
+        reconciled_balance = split->reconciled_balance;
+        lp = prev->next;
+    }
+    else
+    {
+        balance            = priv->starting_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+        lp = priv->splits;
+    }
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    PINFO ("acct=%s split %d of %d, starting baln=%" G_GINT64_FORMAT "/%"
+           G_GINT64_FORMAT, priv->accountName, pos, nsplits,
+           balance.num, balance.denom);
+    for (; lp; lp = lp->next)
     {
         Split *split = (Split *) lp->data;
         gnc_numeric amt = xaccSplitGetAmount (split);
@@ -2106,6 +2467,7 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->balance_dirty_pos = 0;
 }
 
 /********************************************************************\
@@ -2220,7 +2582,7 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
 
     xaccAccountBeginEdit(acc);
     priv->type = tip;
-    priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    account_balance_dirty_from (priv, 0); /* new type may affect balance computation */
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2396,7 +2758,7 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     }
 
     priv->sort_dirty = TRUE;  /* Not needed. */
-    priv->balance_dirty = TRUE;
+    account_balance_dirty_from (priv, 0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -3174,7 +3536,7 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
 
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3187,7 +3549,7 @@ gnc_account_set_start_cleared_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_balance_dirty_from (priv, 0);
 }
 
 void
@@ -3200,7 +3562,7 @@ gnc_account_set_start_reconciled_balance (Account *acc,
 
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
-    priv->balance_dirty = TRUE;
+    account_balance_dirty_from (priv, 0);
 }
 
 gnc_numeric
@@ -3237,7 +3599,7 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (node = account_split_index_last(priv); node; node = node->prev)
     {
         Split *split = node->data;
 
@@ -3265,82 +3627,24 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
-    AccountPrivate *priv;
-    GList   *lp;
-    Timespec ts, trans_ts;
-    gboolean found = FALSE;
-    gnc_numeric balance;
-
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
+    account_load_splits_from (acc, date);
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
-    priv = GET_PRIVATE(acc);
-    balance = priv->balance;
-
-    /* Since transaction post times are stored as a Timespec,
-     * convert date into a Timespec as well rather than converting
-     * each transaction's Timespec into a time64.
-     *
-     * FIXME: CAS: I think this comment is a bogus justification for
-     * using xaccTransGetDatePostedTS.  There's no benefit to using
-     * Timespec when the input argument is time64, and it's hard to
-     * imagine that casting long long to long and comparing two longs is
-     * worse than comparing two long longs every time.  IMO,
-     * xaccAccountGetPresentBalance gets this right, and its algorithm
-     * should be used here.
-     */
-    ts.tv_sec = date;
-    ts.tv_nsec = 0;
-
-    lp = priv->splits;
-    while ( lp && !found )
-    {
-        xaccTransGetDatePostedTS( xaccSplitGetParent( (Split *)lp->data ),
-                                  &trans_ts );
-        if ( timespec_cmp( &trans_ts, &ts ) >= 0 )
-            found = TRUE;
-        else
-            lp = lp->next;
-    }
-
-    if ( lp )
-    {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
-        }
-    }
-
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
-
-    return( balance );
+    return account_balance_as_of_date (GET_PRIVATE(acc), date);
 }
 
 /*
  * Originally gsr_account_present_balance in gnc-split-reg.c
  *
- * How does this routine compare to xaccAccountGetBalanceAsOfDate just
- * above?  These two routines should eventually be collapsed into one.
- * Perhaps the startup logic from that one, and the logic from this
- * one that walks from the tail of the split list.
+ * The balance of the last split posted up to the end of today, found
+ * by the same binary search as xaccAccountGetBalanceAsOfDate.  The
+ * account is const here and can't be sorted, so while inserts or date
+ * changes are still pending the list is walked back from the tail as
+ * it used to be.  If the backend still has to load splits posted
+ * after today, loading them changes the account all the same.
  */
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
@@ -3353,15 +3657,25 @@ xaccAccountGetPresentBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    if (today + 1 < priv->splits_loaded_from)
+    {
+        account_load_splits_from ((Account*)acc, today + 1);
+        xaccAccountSortSplits ((Account*)acc, TRUE);
+        xaccAccountRecomputeBalance ((Account*)acc);
+    }
+    if (!priv->sort_dirty && g_hash_table_size (priv->splits_changed) == 0)
+        return account_balance_before_date (priv, today + 1);
+
+    for (node = account_split_index_last (priv); node; node = node->prev)
     {
         Split *split = node->data;
 
         if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
-            return xaccSplitGetBalance (split);
+            return account_balance_between (priv, split,
+                                            node->next ? node->next->data : NULL);
     }
 
-    return gnc_numeric_zero ();
+    return priv->starting_balance;
 }
 
 
@@ -3676,6 +3990,103 @@ xaccAccountGetBalanceChangeForPeriod (Account *acc, time64 t1, time64 t2,
     return gnc_numeric_sub(b2, b1, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
 }
 
+gnc_numeric *
+xaccAccountGetBalancesAsOfDatesInCurrency (Account *acc, const time64 *dates,
+                                           guint n_dates,
+                                           gnc_commodity *report_commodity,
+                                           gboolean include_children,
+                                           GList **accounts)
+{
+    GList *rows, *node;
+    GHashTable *conversions;
+    GNCPriceDB *pdb;
+    gnc_numeric *balances;
+    guint n_rows, row, col;
+    time64 earliest = G_MAXINT64;
+    int fraction;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    g_return_val_if_fail(dates != NULL || n_dates == 0, NULL);
+
+    if (!report_commodity)
+        report_commodity = xaccAccountGetCommodity (acc);
+
+    rows = g_list_prepend (gnc_account_get_descendants (acc), acc);
+    n_rows = g_list_length (rows);
+    balances = g_new (gnc_numeric, (gsize) n_rows * n_dates);
+
+    for (col = 0; col < n_dates; col++)
+        earliest = MIN (earliest, dates[col]);
+    for (node = rows; node; node = node->next)
+    {
+        account_load_splits_from (node->data, earliest);
+        xaccAccountSortSplits (node->data, TRUE);
+        xaccAccountRecomputeBalance (node->data);
+    }
+
+    /* Fill the matrix one date at a time, so that every commodity only
+     * needs its prices looked up once per date. */
+    pdb = gnc_pricedb_get_db (gnc_account_get_book (acc));
+    conversions = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                         (GDestroyNotify) gnc_price_conversion_destroy);
+    for (col = 0; col < n_dates; col++)
+    {
+        Timespec ts = { dates[col], 0 };
+
+        for (node = rows, row = 0; node; node = node->next, row++)
+        {
+            AccountPrivate *priv = GET_PRIVATE(node->data);
+            gnc_numeric balance = gnc_numeric_zero ();
+            GNCPriceConversion *conv;
+
+            if (report_commodity && priv->commodity)
+                balance = account_balance_as_of_date (priv, dates[col]);
+            if (!gnc_numeric_zero_p (balance) &&
+                !gnc_commodity_equiv (priv->commodity, report_commodity))
+            {
+                conv = g_hash_table_lookup (conversions, priv->commodity);
+                if (!conv)
+                {
+                    conv = gnc_price_conversion_new (pdb, priv->commodity,
+                                                     report_commodity, ts);
+                    g_hash_table_insert (conversions, priv->commodity, conv);
+                }
+                balance = gnc_price_conversion_convert (conv, balance);
+            }
+            balances[row * n_dates + col] = balance;
+        }
+        g_hash_table_remove_all (conversions);
+    }
+    g_hash_table_destroy (conversions);
+
+    /* The rows are in depth-first order, so each account's descendants
+     * follow it directly.  Sum them up front to back, which is the order
+     * gnc_account_foreach_descendant visits them in, and each row only
+     * reads rows that haven't been summed yet. */
+    if (include_children && report_commodity)
+    {
+        fraction = gnc_commodity_get_fraction (report_commodity);
+        for (node = rows, row = 0; node; node = node->next, row++)
+        {
+            guint last = row + gnc_account_n_descendants (node->data);
+            guint sub;
+
+            for (sub = row + 1; sub <= last; sub++)
+                for (col = 0; col < n_dates; col++)
+                    balances[row * n_dates + col] =
+                        gnc_numeric_add (balances[row * n_dates + col],
+                                         balances[sub * n_dates + col],
+                                         fraction, GNC_HOW_RND_ROUND_HALF_UP);
+        }
+    }
+
+    if (accounts)
+        *accounts = rows;
+    else
+        g_list_free (rows);
+    return balances;
+}
+
 
 /********************************************************************\
 \********************************************************************/
@@ -3699,6 +4110,66 @@ xaccAccountGetSplitList (const Account *acc)
     return GET_PRIVATE(acc)->splits;
 }
 
+SplitList *
+xaccAccountFindSplitsInDateRange (Account *acc, time64 start, time64 end,
+                                  gint64 *n_splits)
+{
+    AccountPrivate *priv;
+    GSequenceIter *first, *last;
+
+    if (n_splits)
+        *n_splits = 0;
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
+    if (start > end)
+        return NULL;
+
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+
+    priv = GET_PRIVATE(acc);
+    first = account_split_index_search_date (priv, start);
+    if (end == G_MAXINT64)
+        last = g_sequence_get_end_iter (priv->split_index);
+    else
+        last = account_split_index_search_date (priv, end + 1);
+
+    if (n_splits)
+        *n_splits = g_sequence_iter_get_position (last) -
+                    g_sequence_iter_get_position (first);
+    if (first == last)
+        return NULL;
+    return g_sequence_get (first);
+}
+
+gint64
+xaccAccountCountSplitsInDateRange (const Account *acc, time64 start, time64 end)
+{
+    const AccountPrivate *priv;
+    GSequenceIter *first, *last;
+
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+    if (start > end)
+        return 0;
+
+    priv = GET_PRIVATE(acc);
+    if (priv->sort_dirty || g_hash_table_size (priv->splits_changed) > 0)
+        return g_sequence_get_length (priv->split_index);
+
+    first = account_split_index_search_date (priv, start);
+    if (end == G_MAXINT64)
+        last = g_sequence_get_end_iter (priv->split_index);
+    else
+        last = account_split_index_search_date (priv, end + 1);
+    return g_sequence_iter_get_position (last) -
+           g_sequence_iter_get_position (first);
+}
+
+guint
+xaccAccountGetSplitListGeneration (const Account *acc)
+{
+    g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
+    return GET_PRIVATE(acc)->split_list_generation;
+}
+
 gint64
 xaccAccountCountSplits (const Account *acc, gboolean include_children)
 {
@@ -4337,14 +4808,33 @@ xaccAccountSetReconcileLastInterval (Account *acc, int months, int days)
 /********************************************************************\
 \********************************************************************/
 
+typedef enum
+{
+    POSTPONE_DATE,
+    POSTPONE_BALANCE,
+    POSTPONE_NUM_PATHS
+} PostponePath;
+
+/* The paths of the postponed reconciliation, parsed on first use. */
+static const KvpPath *
+reconcile_postpone_path (PostponePath which)
+{
+    static const KvpPath *paths[POSTPONE_NUM_PATHS];
+    if (paths[which] == NULL)
+        paths[which] = qof_kvp_path_intern (which == POSTPONE_DATE ?
+                                            "reconcile-info/postpone/date" :
+                                            "reconcile-info/postpone/balance");
+    return paths[which];
+}
+
 gboolean
 xaccAccountGetReconcilePostponeDate (const Account *acc, time64 *postpone_date)
 {
     gint64 date = 0;
     GValue v = G_VALUE_INIT;
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_kvp (QOF_INSTANCE(acc),
-                          "reconcile-info/postpone/date", &v);
+    qof_instance_get_kvp_path (QOF_INSTANCE(acc),
+                               reconcile_postpone_path (POSTPONE_DATE), &v);
     if (G_VALUE_HOLDS_INT64 (&v))
         date = g_value_get_int64 (&v);
 
@@ -4369,8 +4859,8 @@ xaccAccountSetReconcilePostponeDate (Account *acc, time64 postpone_date)
     g_value_init (&v, G_TYPE_INT64);
     g_value_set_int64 (&v, postpone_date);
     xaccAccountBeginEdit (acc);
-    qof_instance_set_kvp (QOF_INSTANCE (acc),
-                          "/reconcile-info/postpone/date", &v);
+    qof_instance_set_kvp_path (QOF_INSTANCE (acc),
+                               reconcile_postpone_path (POSTPONE_DATE), &v);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
 }
@@ -4385,8 +4875,8 @@ xaccAccountGetReconcilePostponeBalance (const Account *acc,
     gnc_numeric bal = gnc_numeric_zero ();
     GValue v = G_VALUE_INIT;
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_kvp (QOF_INSTANCE(acc),
-                          "reconcile-info/postpone/balance", &v);
+    qof_instance_get_kvp_path (QOF_INSTANCE(acc),
+                               reconcile_postpone_path (POSTPONE_BALANCE), &v);
     if (G_VALUE_HOLDS_INT64 (&v))
         bal = *(gnc_numeric*)g_value_get_boxed (&v);
 
@@ -4411,8 +4901,8 @@ xaccAccountSetReconcilePostponeBalance (Account *acc, gnc_numeric balance)
     g_value_init (&v, GNC_TYPE_NUMERIC);
     g_value_set_boxed (&v, &balance);
     xaccAccountBeginEdit (acc);
-    qof_instance_set_kvp (QOF_INSTANCE (acc),
-                          "/reconcile-info/postpone/balance", &v);
+    qof_instance_set_kvp_path (QOF_INSTANCE (acc),
+                               reconcile_postpone_path (POSTPONE_BALANCE), &v);
     mark_account (acc);
     xaccAccountCommitEdit (acc);
 }
@@ -4714,7 +5204,7 @@ finder_help_function(const Account *acc, const char *description,
      * list is in date order, and the most recent matches should be
      * returned!?  */
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    for (slp = account_split_index_last(priv); slp; slp = slp->prev)
     {
         Split *lsplit = slp->data;
         Transaction *ltrans = xaccSplitGetParent(lsplit);
@@ -597,6 +597,35 @@ gnc_numeric xaccAccountGetBalanceAsOfDateInCurrency(
 gnc_numeric xaccAccountGetBalanceChangeForPeriod (
     Account *acc, time64 date1, time64 date2, gboolean recurse);
 
+/** Get the balances of an account and all of its descendants at
+ *  several dates at once, converted to report_commodity with the price
+ *  nearest to each date.  This is much cheaper than asking for each
+ *  balance separately: every account is searched once per date and
+ *  the pricedb is consulted at most once per commodity and date.
+ *
+ *  @param account The account at the top of the subtree.
+ *
+ *  @param dates The dates to get the balances at.
+ *
+ *  @param n_dates The number of dates.
+ *
+ *  @param report_commodity The commodity to report in, or NULL for the
+ *  commodity of account.
+ *
+ *  @param include_children If TRUE, each balance includes the balances
+ *  of that account's descendants.
+ *
+ *  @param accounts If not NULL, set to a newly allocated list of the
+ *  accounts the rows belong to: account first, then its descendants in
+ *  depth-first order.  Free it with g_list_free().
+ *
+ *  @return A newly allocated matrix with one row per account and one
+ *  column per date, row after row.  Free it with g_free(). */
+gnc_numeric *xaccAccountGetBalancesAsOfDatesInCurrency (
+    Account *account, const time64 *dates, guint n_dates,
+    gnc_commodity *report_commodity, gboolean include_children,
+    GList **accounts);
+
 /** @} */
 
 /** @name Account Children and Parents.
@@ -990,6 +1019,33 @@ gboolean xaccAccountIsEquityType(GNCAccountType t);
  */
 SplitList* xaccAccountGetSplitList (const Account *account);
 
+/** The xaccAccountFindSplitsInDateRange() routine finds the splits of
+ *    the account whose transactions were posted from @a start to @a end,
+ *    both included, by a binary search of the sorted split list.
+ * @return The node of the account's split list (see
+ *    xaccAccountGetSplitList()) holding the earliest of them, or NULL if
+ *    there are none.  The following nodes hold the rest.
+ * @param n_splits If not NULL, set to the number of splits in the range.
+ */
+SplitList* xaccAccountFindSplitsInDateRange (Account *account, time64 start,
+                                             time64 end, gint64 *n_splits);
+
+/** The xaccAccountCountSplitsInDateRange() routine counts the splits
+ *    xaccAccountFindSplitsInDateRange() would find, without sorting the
+ *    split list.  While the list is waiting to be sorted it counts every
+ *    split of the account instead, so the count may be too high but is
+ *    never too low.
+ */
+gint64 xaccAccountCountSplitsInDateRange (const Account *account,
+                                          time64 start, time64 end);
+
+
+/** The xaccAccountGetSplitListGeneration() routine returns a number
+ *    which changes whenever a split is inserted into or removed from
+ *    the account, whether or not events are suspended.  Anything built
+ *    from the split list can keep it to tell whether it's still current.
+ */
+guint xaccAccountGetSplitListGeneration (const Account *account);
 
 /** The xaccAccountCountSplits() routine returns the number of all
  *    the splits in the account.
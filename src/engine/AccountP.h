@@ -102,6 +102,14 @@ typedef struct AccountPrivate
     gnc_numeric starting_balance;
     gnc_numeric starting_cleared_balance;
     gnc_numeric starting_reconciled_balance;
+    /* Every split posted on or after this date is in memory.  Backends
+     * which leave older transactions in storage until they are needed
+     * raise it; the starting balances then include the splits not yet
+     * loaded, and the running balances of splits before this date
+     * don't count the unloaded splits after them. */
+    time64 splits_loaded_from;
+    /* Is a query for the splits before splits_loaded_from running? */
+    gboolean loading_splits;
 
     /* cached parameters */
     gnc_numeric balance;
@@ -109,10 +117,33 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    /* Position in the split list of the first split whose running
+     * balances are incorrect; the splits before it are still good, so
+     * xaccAccountRecomputeBalance only has to accumulate from here.
+     * Only meaningful while balance_dirty is set. */
+    gint balance_dirty_pos;
 
     GList *splits;              /* list of split pointers */
     gboolean sort_dirty;        /* sort order of splits is bad */
 
+    /* The split list above is only the view handed out by
+     * xaccAccountGetSplitList(); the order is maintained by
+     * split_index, a balanced tree of the GList nodes sorted with
+     * xaccSplitOrder, so that finding the insertion point costs
+     * O(log n) instead of a walk down the list.  split_map maps each
+     * Split to its GSequenceIter for constant-time membership tests
+     * and removal, even while the sort keys are stale (sort_dirty). */
+    GSequence *split_index;
+    GHashTable *split_map;
+    /* Splits whose sort keys may have changed since the last sort.
+     * Unless sort_dirty is set, only these are re-positioned by
+     * xaccAccountSortSplits(). */
+    GHashTable *splits_changed;
+    /* Incremented whenever a split is inserted or removed, so caches
+     * built from the split list can tell whether they missed a change,
+     * e.g. while events were suspended. */
+    guint split_list_generation;
+
     LotList   *lots;		/* list of lot pointers */
     GNCPolicy *policy;		/* Cached pointer to policy method */
 
@@ -132,6 +163,19 @@ struct account_s
  * call this on an existing account! */
 void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 
+/* Record that the sort keys, amount or reconcile state of split, which
+ * is in acc, may have changed.  The next xaccAccountSortSplits() moves
+ * just that split to its new place, and the running balances are
+ * recomputed from the earlier of its old and new positions only. */
+void gnc_account_split_changed (Account *acc, Split *split);
+
+/* Set by backends which load transactions on demand: every split of acc
+ * posted on or after date has been loaded.  G_MAXINT64 means none of
+ * them have, G_MININT64 that all of them have, which is the default.
+ * Balances by date first ask the backend for the missing splits with a
+ * split query on the account. */
+void gnc_account_set_splits_loaded_from (Account *acc, time64 date);
+
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
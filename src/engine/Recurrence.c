@@ -164,6 +164,55 @@ nth_weekday_compare(const GDate *start, const GDate *next, PeriodType pt)
 }
 
 
+/* align_day_in_month() moves 'date' to the occurrence of 'r' in
+   date's month, in one of the three possible ways, and then off the
+   weekend if r asks for that. */
+static void
+align_day_in_month(const Recurrence *r, GDate *date)
+{
+    const GDate *start = &r->start;
+    PeriodType pt = r->ptype;
+    guint dim;
+
+    dim = g_date_get_days_in_month(g_date_get_month(date),
+                                   g_date_get_year(date));
+    if (pt == PERIOD_LAST_WEEKDAY || pt == PERIOD_NTH_WEEKDAY)
+    {
+        gint wdresult = nth_weekday_compare(start, date, pt);
+        if (wdresult < 0)
+        {
+            wdresult = -wdresult;
+            g_date_subtract_days(date, wdresult);
+        }
+        else
+            g_date_add_days(date, wdresult);
+    }
+    else if (pt == PERIOD_END_OF_MONTH || g_date_get_day(start) >= dim)
+        g_date_set_day(date, dim);  /* last day in the month */
+    else
+        g_date_set_day(date, g_date_get_day(start)); /*same day as start*/
+
+    /* Adjust for dates on the weekend. */
+    if (pt == PERIOD_YEAR || pt == PERIOD_MONTH || pt == PERIOD_END_OF_MONTH)
+    {
+        if (g_date_get_weekday(date) == G_DATE_SATURDAY || g_date_get_weekday(date) == G_DATE_SUNDAY)
+        {
+            switch (r->wadj)
+            {
+            case WEEKEND_ADJ_BACK:
+                g_date_subtract_days(date, g_date_get_weekday(date) == G_DATE_SATURDAY ? 1 : 2);
+                break;
+            case WEEKEND_ADJ_FORWARD:
+                g_date_add_days(date, g_date_get_weekday(date) == G_DATE_SATURDAY ? 2 : 1);
+                break;
+            case WEEKEND_ADJ_NONE:
+            default:
+                break;
+            }
+        }
+    }
+}
+
 /* This is the only real algorithm related to recurrences.  It goes:
    Step 1) Go forward one period from the reference date.
    Step 2) Back up to align to the phase of the start date.
@@ -174,7 +223,6 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     PeriodType pt;
     const GDate *start;
     guint mult;
-    WeekendAdjust wadj;
 
     g_return_if_fail(r);
     g_return_if_fail(ref);
@@ -194,7 +242,6 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     /* Step 1: move FORWARD one period, passing exactly one occurrence. */
     mult = r->mult;
     pt = r->ptype;
-    wadj = r->wadj;
     switch (pt)
     {
     case PERIOD_YEAR:
@@ -305,52 +352,15 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     case PERIOD_LAST_WEEKDAY:
     case PERIOD_END_OF_MONTH:
     {
-        guint dim, n_months;
+        guint n_months;
 
         n_months = 12 * (g_date_get_year(next) - g_date_get_year(start)) +
                    (g_date_get_month(next) - g_date_get_month(start));
         g_date_subtract_months(next, n_months % mult);
 
         /* Ok, now we're in the right month, so we just have to align
-           the day in one of the three possible ways. */
-        dim = g_date_get_days_in_month(g_date_get_month(next),
-                                       g_date_get_year(next));
-        if (pt == PERIOD_LAST_WEEKDAY || pt == PERIOD_NTH_WEEKDAY)
-        {
-            gint wdresult = nth_weekday_compare(start, next, pt);
-            if (wdresult < 0)
-            {
-                wdresult = -wdresult;
-                g_date_subtract_days(next, wdresult);
-            }
-            else
-                g_date_add_days(next, wdresult);
-        }
-        else if (pt == PERIOD_END_OF_MONTH || g_date_get_day(start) >= dim)
-            g_date_set_day(next, dim);  /* last day in the month */
-        else
-            g_date_set_day(next, g_date_get_day(start)); /*same day as start*/
-
-        /* Adjust for dates on the weekend. */
-        if (pt == PERIOD_YEAR || pt == PERIOD_MONTH || pt == PERIOD_END_OF_MONTH)
-        {
-            if (g_date_get_weekday(next) == G_DATE_SATURDAY || g_date_get_weekday(next) == G_DATE_SUNDAY)
-            {
-                switch (wadj)
-                {
-                case WEEKEND_ADJ_BACK:
-                    g_date_subtract_days(next, g_date_get_weekday(next) == G_DATE_SATURDAY ? 1 : 2);
-                    break;
-                case WEEKEND_ADJ_FORWARD:
-                    g_date_add_days(next, g_date_get_weekday(next) == G_DATE_SATURDAY ? 2 : 1);
-                    break;
-                case WEEKEND_ADJ_NONE:
-                default:
-                    break;
-                }
-            }
-        }
-
+           the day. */
+        align_day_in_month(r, next);
     }
     break;
     case PERIOD_WEEK:
@@ -363,18 +373,112 @@ recurrenceNextInstance(const Recurrence *r, const GDate *ref, GDate *next)
     }
 }
 
-/* Zero-based index */
-void
-recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
+/* The occurrences after the start date are simply the start date plus
+   n periods, aligned to the phase, so they can be computed directly.
+   Stepping from one occurrence to the next with
+   recurrenceNextInstance() gives the same dates. */
+static void
+nth_instance(const Recurrence *r, guint n, GDate *date)
 {
-    GDate ref;
-    guint i;
+    guint mult = r->mult;
 
-    for (*date = ref = r->start, i = 0; i < n; i++)
+    g_date_set_julian(date, g_date_get_julian(&r->start));
+    if (n == 0)
+        return;
+
+    switch (r->ptype)
     {
-        recurrenceNextInstance(r, &ref, date);
-        ref = *date;
+    case PERIOD_WEEK:
+        mult *= 7;
+        /* fall through */
+    case PERIOD_DAY:
+        g_date_add_days(date, n * mult);
+        break;
+    case PERIOD_YEAR:
+        mult *= 12;
+        /* fall through */
+    case PERIOD_MONTH:
+    case PERIOD_NTH_WEEKDAY:
+    case PERIOD_LAST_WEEKDAY:
+    case PERIOD_END_OF_MONTH:
+        g_date_set_day(date, 1);
+        g_date_add_months(date, n * mult);
+        align_day_in_month(r, date);
+        break;
+    case PERIOD_ONCE:
+        g_date_clear(date, 1);
+        break;
+    default:
+        PERR("Invalid period type");
+        g_date_clear(date, 1);
+        break;
+    }
+}
+
+/* Finds n such that 'date' is the nth instance of 'r'.  A weekend
+   adjustment can move an occurrence into the neighbouring month, so
+   the month count is only a first guess. */
+static gboolean
+instance_index(const Recurrence *r, const GDate *date, guint *n)
+{
+    const GDate *start = &r->start;
+    guint mult = r->mult;
+    gint months, guess, i;
+    GDate tmp;
+
+    if (g_date_compare(date, start) == 0)
+    {
+        *n = 0;
+        return TRUE;
+    }
+    if (g_date_compare(date, start) < 0)
+        return FALSE;
+
+    switch (r->ptype)
+    {
+    case PERIOD_WEEK:
+        mult *= 7;
+        /* fall through */
+    case PERIOD_DAY:
+    {
+        gint days = g_date_days_between(start, date);
+        if (days % mult != 0)
+            return FALSE;
+        *n = days / mult;
+        return TRUE;
     }
+    case PERIOD_YEAR:
+        mult *= 12;
+        /* fall through */
+    case PERIOD_MONTH:
+    case PERIOD_NTH_WEEKDAY:
+    case PERIOD_LAST_WEEKDAY:
+    case PERIOD_END_OF_MONTH:
+        months = 12 * (g_date_get_year(date) - g_date_get_year(start)) +
+                 (g_date_get_month(date) - g_date_get_month(start));
+        guess = months / mult;
+        for (i = guess - 1; i <= guess + 1; i++)
+        {
+            if (i < 1)
+                continue;
+            nth_instance(r, i, &tmp);
+            if (g_date_compare(&tmp, date) == 0)
+            {
+                *n = i;
+                return TRUE;
+            }
+        }
+        return FALSE;
+    default:
+        return FALSE;
+    }
+}
+
+/* Zero-based index */
+void
+recurrenceNthInstance(const Recurrence *r, guint n, GDate *date)
+{
+    nth_instance(r, n, date);
 }
 
 time64
@@ -435,6 +539,131 @@ recurrenceListNextInstance(const GList *rlist, const GDate *ref, GDate *next)
     }
 }
 
+typedef struct
+{
+    const Recurrence *r;
+    GDate date;      /* the next date of r to hand out */
+    gboolean indexed;
+    guint n;         /* date is the nth instance of r, if indexed */
+} InstanceCursor;
+
+static void
+instance_cursor_advance(InstanceCursor *c)
+{
+    if (c->indexed)
+    {
+        nth_instance(c->r, ++c->n, &c->date);
+    }
+    else
+    {
+        /* Not on the regular sequence, so step the slow way. */
+        GDate ref = c->date;
+        recurrenceNextInstance(c->r, &ref, &c->date);
+    }
+}
+
+/* A weekend adjusted recurrence in a list of several can't be merged
+   by period number: stepping the list from a date of one recurrence
+   that falls between a weekend and the adjusted date of another skips
+   the latter, and recurrenceListNextInstance() is what the scheduler
+   steps with. */
+static gboolean
+list_needs_stepping(const GList *rlist)
+{
+    const GList *iter;
+
+    if (rlist == NULL || rlist->next == NULL)
+        return FALSE;
+    for (iter = rlist; iter; iter = iter->next)
+    {
+        const Recurrence *r = iter->data;
+        if (r->wadj != WEEKEND_ADJ_NONE &&
+                (r->ptype == PERIOD_YEAR || r->ptype == PERIOD_MONTH ||
+                 r->ptype == PERIOD_END_OF_MONTH))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+void
+recurrenceListInstances(const GList *rlist, const GDate *ref,
+                        const GDate *end, guint max, GArray *dates)
+{
+    InstanceCursor *cursors;
+    const GList *iter;
+    guint n_cursors = 0;
+    guint count = 0;
+    guint i;
+
+    g_return_if_fail(ref && end && dates && g_date_valid(ref));
+
+    if (rlist == NULL || !g_date_valid(end))
+        return;
+
+    if (list_needs_stepping(rlist))
+    {
+        GDate next = *ref;
+
+        while (max == 0 || count < max)
+        {
+            GDate cur = next;
+            recurrenceListNextInstance(rlist, &cur, &next);
+            if (!g_date_valid(&next) || g_date_compare(&next, end) > 0)
+                break;
+            g_array_append_val(dates, next);
+            count++;
+        }
+        return;
+    }
+
+    cursors = g_new0(InstanceCursor, g_list_length((GList *) rlist));
+    for (iter = rlist; iter; iter = iter->next)
+    {
+        InstanceCursor *c = &cursors[n_cursors];
+
+        c->r = iter->data;
+        /* The first date is whatever recurrenceNextInstance says, as a
+           ref date between an occurrence and its weekend adjustment
+           skips that occurrence.  From there on the sequence is
+           regular. */
+        recurrenceNextInstance(c->r, ref, &c->date);
+        if (!g_date_valid(&c->date))
+            continue;
+        c->indexed = instance_index(c->r, &c->date, &c->n);
+        n_cursors++;
+    }
+
+    while (max == 0 || count < max)
+    {
+        GDate *earliest = NULL;
+
+        for (i = 0; i < n_cursors; i++)
+        {
+            if (!g_date_valid(&cursors[i].date))
+                continue;
+            if (!earliest || g_date_compare(&cursors[i].date, earliest) < 0)
+                earliest = &cursors[i].date;
+        }
+        if (!earliest || g_date_compare(earliest, end) > 0)
+            break;
+
+        g_array_append_val(dates, *earliest);
+        count++;
+
+        /* Step every recurrence that falls on this date, so a date
+           shared by two of them is only returned once. */
+        for (i = 0; i < n_cursors; i++)
+        {
+            GDate last = g_array_index(dates, GDate, dates->len - 1);
+            if (g_date_valid(&cursors[i].date) &&
+                    g_date_compare(&cursors[i].date, &last) == 0)
+                instance_cursor_advance(&cursors[i]);
+        }
+    }
+
+    g_free(cursors);
+}
+
 /* Caller owns the returned memory */
 gchar *
 recurrenceToString(const Recurrence *r)
@@ -148,6 +148,16 @@ gnc_numeric recurrenceGetAccountPeriodValue(const Recurrence *r,
 void recurrenceListNextInstance(const GList *r, const GDate *refDate,
                                 GDate *nextDate);
 
+/** Appends to 'dates', a GArray of GDate, the occurrences of the
+ * composite recurrence after 'refDate' and on or before 'endDate', but
+ * no more than 'max' of them unless 'max' is 0.  These are the dates
+ * repeated calls to recurrenceListNextInstance() would give.  They are
+ * computed directly from the period number, except for lists of
+ * several recurrences where one of them is weekend adjusted; those are
+ * stepped from one date to the next. **/
+void recurrenceListInstances(const GList *r, const GDate *refDate,
+                             const GDate *endDate, guint max, GArray *dates);
+
 /* These four functions are only for xml storage, not user presentation. */
 gchar *recurrencePeriodTypeToString(PeriodType pt);
 PeriodType recurrencePeriodTypeFromString(const gchar *str);
@@ -913,6 +913,45 @@ xaccSchedXactionGetNextInstance (const SchedXaction *sx, SXTmpStateData *tsd)
     return next_occur;
 }
 
+void
+gnc_sx_get_instance_dates (const SchedXaction *sx, const SXTmpStateData *tsd,
+                           const GDate *end_date, GArray *dates)
+{
+    GDate prev_occur, end;
+    guint max = 0;
+
+    g_return_if_fail (sx && tsd && end_date && dates);
+
+    /* Same starting point as xaccSchedXactionGetNextInstance(). */
+    prev_occur = tsd->last_date;
+    if (! g_date_valid( &prev_occur ) && g_date_valid(&sx->start_date))
+    {
+        prev_occur = sx->start_date;
+        g_date_subtract_days( &prev_occur, 1 );
+    }
+    if (! g_date_valid( &prev_occur ))
+        return;
+
+    end = *end_date;
+    if ( xaccSchedXactionHasEndDate( sx ) )
+    {
+        const GDate *sx_end = xaccSchedXactionGetEndDate( sx );
+        if ( g_date_compare( sx_end, &end ) < 0 )
+            end = *sx_end;
+    }
+    else if ( xaccSchedXactionHasOccurDef( sx ) )
+    {
+        /* Each instance takes one off the remaining count, and there are
+         * none once it reaches zero. */
+        if (tsd->num_occur_rem == 0)
+            return;
+        if (tsd->num_occur_rem > 0)
+            max = tsd->num_occur_rem;
+    }
+
+    recurrenceListInstances(sx->schedule, &prev_occur, &end, max, dates);
+}
+
 gint
 gnc_sx_get_instance_count( const SchedXaction *sx, SXTmpStateData *stateData )
 {
@@ -1060,6 +1099,19 @@ gnc_sx_incr_temporal_state(const SchedXaction *sx, SXTmpStateData *tsd )
     ++tsd->num_inst;
 }
 
+void
+gnc_sx_incr_temporal_state_to(const SchedXaction *sx, SXTmpStateData *tsd,
+                              const GDate *next_date)
+{
+    g_return_if_fail(tsd != NULL && next_date != NULL);
+    tsd->last_date = *next_date;
+    if (xaccSchedXactionHasOccurDef (sx))
+    {
+        --tsd->num_occur_rem;
+    }
+    ++tsd->num_inst;
+}
+
 void
 gnc_sx_destroy_temporal_state (SXTmpStateData *tsd)
 {
@@ -246,6 +246,12 @@ SXTmpStateData *gnc_sx_create_temporal_state(const SchedXaction *sx );
  * occurence in the remporalStateDate. The SX is unchanged. */
 void gnc_sx_incr_temporal_state(const SchedXaction *sx, SXTmpStateData *stateData );
 
+/** Like gnc_sx_incr_temporal_state(), when the date of the next
+ * occurrence is already known, e.g. from gnc_sx_get_instance_dates(). */
+void gnc_sx_incr_temporal_state_to(const SchedXaction *sx,
+                                   SXTmpStateData *stateData,
+                                   const GDate *next_date);
+
 /** Frees the given stateDate object. */
 void gnc_sx_destroy_temporal_state( SXTmpStateData *stateData );
 
@@ -272,6 +278,18 @@ SXTmpStateData *gnc_sx_clone_temporal_state( SXTmpStateData *stateData );
 GDate xaccSchedXactionGetNextInstance(const SchedXaction *sx,
                                       SXTmpStateData *stateData);
 
+/** \brief Appends the dates of the occurrences following stateData.
+ *
+ * Appends to dates, a GArray of GDate, the dates that alternately calling
+ * xaccSchedXactionGetNextInstance() and gnc_sx_incr_temporal_state()
+ * would give, up to and including end_date.  The SX's end date and
+ * remaining occurrences are respected.  See recurrenceListInstances()
+ * for how the dates are computed.
+ */
+void gnc_sx_get_instance_dates(const SchedXaction *sx,
+                               const SXTmpStateData *stateData,
+                               const GDate *end_date, GArray *dates);
+
 /** \brief Set the schedxaction's template transaction.
 
 t_t_list is a glist of TTInfo's as defined in SX-ttinfo.h.
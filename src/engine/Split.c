@@ -56,6 +56,8 @@
 #include "gnc-lot.h"
 #include "gnc-event.h"
 #include "qofinstance-p.h"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
 
 const char *void_former_amt_str = "void-former-amount";
 const char *void_former_val_str = "void-former-value";
@@ -65,6 +67,11 @@ const char *void_former_val_str = "void-former-value";
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_ENGINE;
 
+/* Splits which have been given an account that doesn't hold them yet,
+ * because their transaction hasn't been committed.  The query index
+ * can't find these through the accounts' split lists. */
+static GHashTable *account_pending_splits = NULL;
+
 /* KVP key values used for SX info stored Split's slots. */
 #define GNC_SX_ID                    "sched-xaction"
 #define GNC_SX_ACCOUNT               "account"
@@ -702,6 +709,24 @@ xaccSplitDump (const Split *split, const char *tag)
 /********************************************************************\
 \********************************************************************/
 
+/* A split belongs in account_pending_splits while its account differs
+ * from the one it was last inserted into. */
+static void
+split_update_account_pending (Split *s)
+{
+    if (s->acc && s->acc != s->orig_acc)
+    {
+        if (!account_pending_splits)
+            account_pending_splits = g_hash_table_new (g_direct_hash,
+                                                       g_direct_equal);
+        g_hash_table_insert (account_pending_splits, s, s);
+    }
+    else if (account_pending_splits)
+    {
+        g_hash_table_remove (account_pending_splits, s);
+    }
+}
+
 void
 xaccFreeSplit (Split *split)
 {
@@ -726,6 +751,7 @@ xaccFreeSplit (Split *split)
     split->lot         = NULL;
     split->acc         = NULL;
     split->orig_acc    = NULL;
+    split_update_account_pending (split);
 
     split->date_reconciled.tv_sec = 0;
     split->date_reconciled.tv_nsec = 0;
@@ -739,9 +765,7 @@ xaccFreeSplit (Split *split)
 void mark_split (Split *s)
 {
     if (s->acc)
-    {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
-    }
+        gnc_account_split_changed (s->acc, s);
 
     /* set dirty flag on lot too. */
     if (s->lot) gnc_lot_set_closed_unknown(s->lot);
@@ -920,6 +944,41 @@ xaccSplitListGetUniqueTransactions(const GList *splits)
 }
 /*################## Added for Reg2 #################*/
 
+/********************************************************************
+ * xaccSplitListSumAmounts
+ ********************************************************************/
+
+#define SUM_BATCH 256
+
+void
+xaccSplitListSumAmounts (SplitList *splits, gnc_numeric *balance,
+                         gnc_numeric *cleared, gnc_numeric *reconciled)
+{
+    gnc_numeric amounts[SUM_BATCH];
+    guint8 masks[SUM_BATCH];
+    gnc_numeric sums[3];
+    SplitList *node = splits;
+    gsize n;
+
+    sums[0] = sums[1] = sums[2] = gnc_numeric_zero ();
+    while (node)
+    {
+        for (n = 0; node && n < SUM_BATCH; node = node->next, n++)
+        {
+            Split *split = node->data;
+            char rec = split->reconciled;
+            amounts[n] = split->amount;
+            masks[n] = 1 | (rec != NREC ? 2 : 0) |
+                       (rec == YREC || rec == FREC ? 4 : 0);
+        }
+        gnc_numeric_sum_fixed (amounts, masks, n, 3, sums);
+    }
+
+    if (balance) *balance = sums[0];
+    if (cleared) *cleared = sums[1];
+    if (reconciled) *reconciled = sums[2];
+}
+
 
 /********************************************************************
  * Account funcs
@@ -944,6 +1003,7 @@ xaccSplitSetAccount (Split *s, Account *acc)
         xaccTransBeginEdit(trans);
 
     s->acc = acc;
+    split_update_account_pending (s);
     qof_instance_set_dirty(QOF_INSTANCE(s));
 
     if (trans)
@@ -1021,13 +1081,14 @@ xaccSplitCommitEdit(Split *s)
        original and new transactions, for the _next_ begin/commit cycle. */
     s->orig_acc = s->acc;
     s->orig_parent = s->parent;
+    split_update_account_pending (s);
     if (!qof_commit_edit_part2(QOF_INSTANCE(s), commit_err, NULL,
                                (void (*) (QofInstance *)) xaccFreeSplit))
         return;
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        gnc_account_split_changed (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1042,6 +1103,7 @@ xaccSplitRollbackEdit(Split *s)
        the final commit. */
     if (s->acc != s->orig_acc)
         s->acc = s->orig_acc;
+    split_update_account_pending (s);
 
     /* Undestroy if needed */
     if (qof_instance_get_destroying(s) && s->parent)
@@ -2248,6 +2310,193 @@ no_op (gpointer obj, const QofParam *p)
     return obj;
 }
 
+/********************************************************************\
+ * Query index                                                      *
+ *   Queries for the splits of some accounts, maybe posted within a *
+ *   range of dates, are answered from the accounts' sorted split   *
+ *   lists instead of by checking every split in the book.          *
+\********************************************************************/
+
+typedef struct
+{
+    GList *guids;               /* of the accounts */
+    time64 start;
+    time64 end;
+} SplitIndexRange;
+
+static gboolean
+split_index_path_is (const GSList *path, const char *first, const char *second)
+{
+    if (!path || g_strcmp0 (path->data, first))
+        return FALSE;
+    path = path->next;
+    if (!second)
+        return path == NULL;
+    return path && !g_strcmp0 (path->data, second) && !path->next;
+}
+
+/* Pick out the terms the index can answer: a match of the split's
+ * account against a list of GUIDs, and bounds on the date posted.
+ * Returns FALSE if there is no account match. */
+static gboolean
+split_index_range (const GList *and_terms, SplitIndexRange *range)
+{
+    gboolean have_accounts = FALSE;
+    const GList *node;
+
+    range->guids = NULL;
+    range->start = G_MININT64;
+    range->end = G_MAXINT64;
+
+    for (node = and_terms; node; node = node->next)
+    {
+        const QofQueryTerm *qt = node->data;
+        const GSList *path = qof_query_term_get_param_path (qt);
+        const QofQueryPredData *pd = qof_query_term_get_pred_data (qt);
+
+        if (qof_query_term_is_inverted (qt))
+            continue;
+
+        if ((split_index_path_is (path, SPLIT_ACCOUNT, QOF_PARAM_GUID) ||
+             split_index_path_is (path, SPLIT_ACCOUNT_GUID, NULL)) &&
+            !g_strcmp0 (pd->type_name, QOF_TYPE_GUID))
+        {
+            const query_guid_def *gdata = (const query_guid_def*)pd;
+
+            /* A split without an account has the null GUID. */
+            if (gdata->options != QOF_GUID_MATCH_ANY ||
+                g_list_find_custom (gdata->guids, guid_null (),
+                                    (GCompareFunc)guid_compare))
+                continue;
+            if (!have_accounts ||
+                g_list_length (gdata->guids) < g_list_length (range->guids))
+                range->guids = gdata->guids;
+            have_accounts = TRUE;
+        }
+        else if (split_index_path_is (path, SPLIT_TRANS, TRANS_DATE_POSTED) &&
+                 !g_strcmp0 (pd->type_name, QOF_TYPE_DATE))
+        {
+            const query_date_def *ddata = (const query_date_def*)pd;
+            time64 t = ddata->date.tv_sec;
+
+            /* The bounds are whole seconds and include t; the term
+             * itself takes care of the nanoseconds. */
+            if (ddata->options != QOF_DATE_MATCH_NORMAL)
+                continue;
+            if (pd->how == QOF_COMPARE_GT || pd->how == QOF_COMPARE_GTE ||
+                pd->how == QOF_COMPARE_EQUAL)
+                range->start = MAX (range->start, t);
+            if (pd->how == QOF_COMPARE_LT || pd->how == QOF_COMPARE_LTE ||
+                pd->how == QOF_COMPARE_EQUAL)
+                range->end = MIN (range->end, t);
+        }
+    }
+    return have_accounts;
+}
+
+static gint64
+split_index_estimate (QofBook *book, const GList *and_terms)
+{
+    SplitIndexRange range;
+    GHashTable *seen;
+    gint64 total = 0;
+    GList *node;
+
+    if (!split_index_range (and_terms, &range))
+        return -1;
+
+    /* Counts what split_index_foreach visits, but leaves the accounts
+     * unsorted, as printing the query plan estimates too. */
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = range.guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+
+        if (!acc || g_hash_table_lookup (seen, acc))
+            continue;
+        g_hash_table_insert (seen, acc, acc);
+        total += xaccAccountCountSplitsInDateRange (acc, range.start,
+                                                    range.end);
+    }
+
+    if (account_pending_splits)
+    {
+        GHashTableIter iter;
+        gpointer key;
+
+        g_hash_table_iter_init (&iter, account_pending_splits);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+            Split *s = key;
+            if (qof_instance_get_book (s) == book &&
+                g_hash_table_lookup (seen, s->acc))
+                total++;
+        }
+    }
+    g_hash_table_destroy (seen);
+    return total;
+}
+
+static void
+split_index_foreach (QofBook *book, const GList *and_terms,
+                     QofInstanceForeachCB cb, gpointer user_data)
+{
+    SplitIndexRange range;
+    GHashTable *seen;
+    GList *node;
+
+    if (!split_index_range (and_terms, &range))
+        return;
+
+    /* The GUID list may name an account more than once. */
+    seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = range.guids; node; node = node->next)
+    {
+        Account *acc = xaccAccountLookup (node->data, book);
+        SplitList *splits;
+        gint64 n_splits;
+
+        if (!acc || g_hash_table_lookup (seen, acc))
+            continue;
+        g_hash_table_insert (seen, acc, acc);
+
+        splits = xaccAccountFindSplitsInDateRange (acc, range.start, range.end,
+                                                   &n_splits);
+        for (; splits && n_splits > 0; splits = splits->next, n_splits--)
+        {
+            Split *s = splits->data;
+            /* A split moving to another account is visited below. */
+            if (s->acc == acc)
+                cb (QOF_INSTANCE (s), user_data);
+        }
+    }
+
+    /* Splits of uncommitted transactions aren't in their new account's
+     * list yet, nor in any account's list if they are new. */
+    if (account_pending_splits)
+    {
+        GHashTableIter iter;
+        gpointer key;
+
+        g_hash_table_iter_init (&iter, account_pending_splits);
+        while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+            Split *s = key;
+            if (qof_instance_get_book (s) == book &&
+                g_hash_table_lookup (seen, s->acc))
+                cb (QOF_INSTANCE (s), user_data);
+        }
+    }
+    g_hash_table_destroy (seen);
+}
+
+static const QofQueryIndex split_query_index =
+{
+    "account splits by date posted",
+    split_index_estimate,
+    split_index_foreach,
+};
+
 static void
 qofSplitSetParentTrans(Split *s, QofInstance *ent)
 {
@@ -2365,6 +2614,7 @@ gboolean xaccSplitRegister (void)
                         NULL);
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, NULL);
+    qof_query_register_index (GNC_ID_SPLIT, &split_query_index);
 
     return qof_object_register (&split_object_def);
 }
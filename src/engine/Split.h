@@ -356,6 +356,17 @@ Split      * xaccSplitLookup (const GncGUID *guid, QofBook *book);
 /* Get a GList of unique transactions containing the given list of Splits. */
 GList *xaccSplitListGetUniqueTransactions(const GList *splits);
 /*################## Added for Reg2 #################*/
+
+/** Adds up the amounts of a list of splits, together with the amounts
+ * of those that are cleared or reconciled and of those that are
+ * reconciled or frozen, as xaccAccountRecomputeBalance() classifies
+ * them. The sums start at zero and are added with
+ * gnc_numeric_add_fixed(), so a sum is an error value if the splits'
+ * amounts don't share a denominator. Any of the results may be NULL.
+ */
+void xaccSplitListSumAmounts (SplitList *splits, gnc_numeric *balance,
+                              gnc_numeric *cleared, gnc_numeric *reconciled);
+
 /** Add a peer split to this split's lot-split list.
  * @param other_split: The split whose guid to add
  * @param timestamp: The time to be recorded for the split.
@@ -27,12 +27,20 @@
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+# include <io.h>
+#endif
 
 #include "Account.h"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "Scrub.h"
 #include "qof.h"
+#include "qofinstance-p.h"
 #ifdef _MSC_VER
 # define g_fopen fopen
 #endif
@@ -79,13 +87,97 @@ static QofLogModule log_module = "gnc.translog";
  * (-) hack alert -- something better than just the account name
  *     is needed for identifying the account.
  */
+
+/*
+ * The binary format trades (2) for speed: each change becomes one
+ * length-prefixed record of fixed-size little-endian fields followed by
+ * the strings, so nothing has to be formatted while the user waits.
+ * Records are copied into a ring buffer and a writer thread writes out
+ * whatever has piled up in one go, syncing according to the policy set
+ * with xaccLogSetSync().  xaccLogBinaryToText() turns such a file back
+ * into the text format, which is what the log replay reads.
+ *
+ *   file:   "GNCJRNL1" record*
+ *   record: u32 length, u8 flag, 3 reserved, u32 n_splits,
+ *           i64 time_now, i64 date_entered, i64 date_posted,
+ *           trans guid, u32 length of num, description and notes
+ *           (64 bytes), then n_splits times
+ *           split guid, account guid, i64 amount num and denom,
+ *           i64 value num and denom, i64 date_reconciled,
+ *           u8 reconciled, u8 has account, 2 reserved,
+ *           u32 length of account name, memo and action
+ *           (88 bytes), then the strings in that order, unterminated.
+ */
 /* ------------------------------------------------------------------ */
 
+#define JOURNAL_MAGIC "GNCJRNL1"
+#define JOURNAL_MAGIC_LEN 8
+#define JOURNAL_TRANS_SIZE 64
+#define JOURNAL_SPLIT_SIZE 88
+/* Must be a power of two */
+#define JOURNAL_RING_SIZE (1 << 20)
+
+typedef struct
+{
+    GncGUID guid;
+    gboolean has_account;
+    GncGUID acc_guid;
+    const char *acc_name;
+    const char *memo;
+    const char *action;
+    char reconciled;
+    gnc_numeric amount;
+    gnc_numeric value;
+    time64 date_reconciled;
+} LogSplit;
+
+/* One transaction as it goes into either format */
+typedef struct
+{
+    char flag;
+    time64 now;
+    time64 date_entered;
+    time64 date_posted;
+    GncGUID guid;
+    const char *num;
+    const char *description;
+    const char *notes;
+    guint n_splits;
+    LogSplit *splits;
+} LogTrans;
+
+typedef struct
+{
+    FILE *file;
+    gchar *ring;
+    /* Running byte counts, compared modulo 2^32.  Only xaccTransWriteLog
+     * moves head and only the writer thread moves tail. */
+    volatile gint head;
+    volatile gint tail;
+    /* Set while the writer sleeps, so that producers only touch the
+     * mutex when there is someone to wake. */
+    volatile gint writer_waiting;
+
+    GMutex *mutex;
+    GCond *wake;        /* the writer waits on this */
+    GCond *done;        /* producers wait on this for space or a sync */
+    /* Protected by mutex */
+    guint synced;
+    guint sync_wanted;
+    gboolean stop;
+    gboolean failed;
+
+    GThread *thread;
+} Journal;
 
 static int gen_logs = 1;
 static FILE * trans_log = NULL; /**< current log file handle */
+static Journal * journal = NULL; /**< or the binary one */
 static char * trans_log_name = NULL; /**< current log file name */
 static char * log_base_name = NULL;
+static XaccLogFormat log_format = XACC_LOG_TEXT;
+static volatile gint log_sync = XACC_LOG_SYNC_INTERVAL;
+static volatile gint log_sync_secs = 5;
 
 /********************************************************************\
 \********************************************************************/
@@ -105,7 +197,7 @@ void xaccLogEnable  (void)
 void
 xaccReopenLog (void)
 {
-    if (trans_log)
+    if (trans_log || journal)
     {
         xaccCloseLog();
         xaccOpenLog();
@@ -116,12 +208,17 @@ xaccReopenLog (void)
 void
 xaccLogSetBaseName (const char *basepath)
 {
-    if (!basepath) return;
+    if (!basepath)
+    {
+        /* The book is going away, get what's been logged to disk. */
+        xaccCloseLog();
+        return;
+    }
 
     g_free (log_base_name);
     log_base_name = g_strdup (basepath);
 
-    if (trans_log)
+    if (trans_log || journal)
     {
         xaccCloseLog();
         xaccOpenLog();
@@ -129,6 +226,15 @@ xaccLogSetBaseName (const char *basepath)
 }
 
 
+void
+xaccLogSetFormat (XaccLogFormat format)
+{
+    if (format == log_format) return;
+    log_format = format;
+    xaccReopenLog();
+}
+
+
 /*
  * See if the provided file name is that of the current log file.
  * Since the filename is generated with a time-stamp we can ignore the
@@ -150,6 +256,798 @@ xaccFileIsCurrentLog (const gchar *name)
     return result;
 }
 
+/********************************************************************\
+ * The text format
+\********************************************************************/
+
+#define LOG_TEXT_HEADER "mod\ttrans_guid\tsplit_guid\ttime_now\t" \
+                        "date_entered\tdate_posted\t" \
+                        "acc_guid\tacc_name\tnum\tdescription\t" \
+                        "notes\tmemo\taction\treconciled\t" \
+                        "amount\tvalue\tdate_reconciled"
+
+static void
+log_write_text_header (FILE *out)
+{
+    fprintf (out, "%s\n", LOG_TEXT_HEADER);
+    fprintf (out, "-----------------\n");
+}
+
+static void
+log_time_to_string (time64 t, char *buff)
+{
+    Timespec ts;
+
+    timespecFromTime64(&ts, t);
+    gnc_timespec_to_iso8601_buff (ts, buff);
+}
+
+static void
+log_write_text (FILE *out, const LogTrans *lt)
+{
+    char trans_guid_str[GUID_ENCODING_LENGTH + 1];
+    char split_guid_str[GUID_ENCODING_LENGTH + 1];
+    char dnow[100], dent[100], dpost[100], drecn[100];
+    guint i;
+
+    log_time_to_string (lt->now, dnow);
+    log_time_to_string (lt->date_entered, dent);
+    log_time_to_string (lt->date_posted, dpost);
+
+    guid_to_string_buff (&lt->guid, trans_guid_str);
+    fprintf (out, "===== START\n");
+
+    for (i = 0; i < lt->n_splits; i++)
+    {
+        const LogSplit *ls = &lt->splits[i];
+        char acc_guid_str[GUID_ENCODING_LENGTH + 1];
+
+        if (ls->has_account)
+            guid_to_string_buff (&ls->acc_guid, acc_guid_str);
+        else
+            acc_guid_str[0] = '\0';
+
+        log_time_to_string (ls->date_reconciled, drecn);
+
+        guid_to_string_buff (&ls->guid, split_guid_str);
+
+        /* use tab-separated fields */
+        fprintf (out,
+                 "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
+                 "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
+                 lt->flag,
+                 trans_guid_str, split_guid_str,  /* trans+split make up unique id */
+                 /* Note that the next three strings always exist,
+                 		* so we don't need to test them. */
+                 dnow,
+                 dent,
+                 dpost,
+                 acc_guid_str,
+                 ls->acc_name,
+                 lt->num,
+                 lt->description,
+                 lt->notes,
+                 ls->memo,
+                 ls->action,
+                 ls->reconciled,
+                 gnc_numeric_num(ls->amount),
+                 gnc_numeric_denom(ls->amount),
+                 gnc_numeric_num(ls->value),
+                 gnc_numeric_denom(ls->value),
+                 /* The next string always exists. No need to test it. */
+                 drecn);
+    }
+
+    fprintf (out, "===== END\n");
+}
+
+/* Takes a snapshot of trans; free lt->splits when done.  The strings
+ * are the transaction's own. */
+static void
+log_trans_capture (LogTrans *lt, Transaction *trans, char flag)
+{
+    GList *node;
+    guint i = 0;
+
+    lt->flag = flag;
+    lt->now = gnc_time (NULL);
+    lt->date_entered = trans->date_entered.tv_sec;
+    lt->date_posted = trans->date_posted.tv_sec;
+    lt->guid = *xaccTransGetGUID (trans);
+    lt->num = trans->num ? trans->num : "";
+    lt->description = trans->description ? trans->description : "";
+    lt->notes = xaccTransGetNotes (trans);
+    if (!lt->notes) lt->notes = "";
+
+    lt->n_splits = g_list_length (trans->splits);
+    lt->splits = g_new (LogSplit, lt->n_splits);
+    for (node = trans->splits; node; node = node->next, i++)
+    {
+        Split *split = node->data;
+        Account *acc = xaccSplitGetAccount (split);
+        LogSplit *ls = &lt->splits[i];
+
+        ls->guid = *xaccSplitGetGUID (split);
+        ls->has_account = (acc != NULL);
+        ls->acc_guid = acc ? *xaccAccountGetGUID (acc) : *guid_null ();
+        ls->acc_name = acc ? xaccAccountGetName (acc) : NULL;
+        if (!ls->acc_name) ls->acc_name = "";
+        ls->memo = split->memo ? split->memo : "";
+        ls->action = split->action ? split->action : "";
+        ls->reconciled = split->reconciled;
+        ls->amount = xaccSplitGetAmount (split);
+        ls->value = xaccSplitGetValue (split);
+        ls->date_reconciled = split->date_reconciled.tv_sec;
+    }
+}
+
+/********************************************************************\
+ * The binary format
+\********************************************************************/
+
+static void
+put_u32 (guchar *p, guint32 v)
+{
+    v = GUINT32_TO_LE (v);
+    memcpy (p, &v, sizeof v);
+}
+
+static void
+put_i64 (guchar *p, gint64 v)
+{
+    guint64 u = GUINT64_TO_LE ((guint64) v);
+    memcpy (p, &u, sizeof u);
+}
+
+static guint32
+get_u32 (const guchar *p)
+{
+    guint32 v;
+    memcpy (&v, p, sizeof v);
+    return GUINT32_FROM_LE (v);
+}
+
+static gint64
+get_i64 (const guchar *p)
+{
+    guint64 u;
+    memcpy (&u, p, sizeof u);
+    return (gint64) GUINT64_FROM_LE (u);
+}
+
+static gboolean
+journal_sync_file (FILE *file)
+{
+#ifdef G_OS_WIN32
+    return _commit (_fileno (file)) == 0;
+#else
+    return fsync (fileno (file)) == 0;
+#endif
+}
+
+static gpointer
+journal_thread (gpointer data)
+{
+    Journal *j = data;
+    gint64 last_sync = g_get_monotonic_time ();
+    gboolean ok = TRUE;
+
+    g_mutex_lock (j->mutex);
+    while (TRUE)
+    {
+        XaccLogSync sync = g_atomic_int_get (&log_sync);
+        gint64 interval = (gint64) g_atomic_int_get (&log_sync_secs) * G_USEC_PER_SEC;
+        guint tail = (guint) g_atomic_int_get (&j->tail);
+        guint head = (guint) g_atomic_int_get (&j->head);
+        gboolean sync_now;
+
+        sync_now = (j->synced != head &&
+                    (j->stop || sync == XACC_LOG_SYNC_COMMIT ||
+                     (gint) (j->sync_wanted - j->synced) > 0 ||
+                     (sync == XACC_LOG_SYNC_INTERVAL &&
+                      g_get_monotonic_time () - last_sync >= interval)));
+
+        if (head == tail && !sync_now)
+        {
+            if (j->stop) break;
+
+            /* The exchange is a full barrier, so either the producer
+             * sees the flag or we see its new head. */
+            g_atomic_int_compare_and_exchange (&j->writer_waiting, 0, 1);
+            if ((guint) g_atomic_int_get (&j->head) == head)
+            {
+                if (sync == XACC_LOG_SYNC_INTERVAL && j->synced != head)
+                {
+#ifndef HAVE_GLIB_2_32
+                    GTimeVal until;
+                    g_get_current_time (&until);
+                    g_time_val_add (&until, last_sync + interval -
+                                    g_get_monotonic_time ());
+                    g_cond_timed_wait (j->wake, j->mutex, &until);
+#else
+                    g_cond_wait_until (j->wake, j->mutex, last_sync + interval);
+#endif
+                }
+                else
+                    g_cond_wait (j->wake, j->mutex);
+            }
+            g_atomic_int_set (&j->writer_waiting, 0);
+            continue;
+        }
+        g_mutex_unlock (j->mutex);
+
+        /* Write out everything queued, in two pieces if it wraps */
+        if (ok && head != tail)
+        {
+            guint at = tail & (JOURNAL_RING_SIZE - 1);
+            guint len = head - tail;
+            guint first = MIN (len, JOURNAL_RING_SIZE - at);
+
+            ok = (fwrite (j->ring + at, 1, first, j->file) == first &&
+                  fwrite (j->ring, 1, len - first, j->file) == len - first &&
+                  fflush (j->file) == 0);
+        }
+        if (ok && sync_now)
+        {
+            ok = journal_sync_file (j->file);
+            last_sync = g_get_monotonic_time ();
+        }
+        g_atomic_int_add (&j->tail, (gint) (head - tail));
+
+        g_mutex_lock (j->mutex);
+        if (!ok && !j->failed)
+        {
+            PERR ("Error writing transaction log: %s", g_strerror (errno));
+            j->failed = TRUE;
+        }
+        if (sync_now)
+            j->synced = head;
+        g_cond_broadcast (j->done);
+    }
+    g_mutex_unlock (j->mutex);
+    return NULL;
+}
+
+static void
+journal_free (Journal *j)
+{
+#ifndef HAVE_GLIB_2_32
+    g_mutex_free (j->mutex);
+    g_cond_free (j->wake);
+    g_cond_free (j->done);
+#else
+    g_mutex_clear (j->mutex);
+    g_cond_clear (j->wake);
+    g_cond_clear (j->done);
+    g_free (j->mutex);
+    g_free (j->wake);
+    g_free (j->done);
+#endif
+    g_free (j->ring);
+    g_free (j);
+}
+
+static Journal *
+journal_open (const char *filename)
+{
+    Journal *j;
+    FILE *file = g_fopen (filename, "ab");
+
+    if (!file) return NULL;
+
+    fseek (file, 0, SEEK_END);
+    if (ftell (file) == 0)
+        fwrite (JOURNAL_MAGIC, 1, JOURNAL_MAGIC_LEN, file);
+
+    j = g_new0 (Journal, 1);
+    j->file = file;
+    j->ring = g_malloc (JOURNAL_RING_SIZE);
+#ifndef HAVE_GLIB_2_32
+    j->mutex = g_mutex_new ();
+    j->wake = g_cond_new ();
+    j->done = g_cond_new ();
+    j->thread = g_thread_create (journal_thread, j, TRUE, NULL);
+#else
+    j->mutex = g_new0 (GMutex, 1);
+    j->wake = g_new0 (GCond, 1);
+    j->done = g_new0 (GCond, 1);
+    g_mutex_init (j->mutex);
+    g_cond_init (j->wake);
+    g_cond_init (j->done);
+    j->thread = g_thread_try_new ("translog", journal_thread, j, NULL);
+#endif
+    if (!j->thread)
+    {
+        fclose (file);
+        journal_free (j);
+        return NULL;
+    }
+    return j;
+}
+
+/* Writes and syncs everything, then stops the writer */
+static void
+journal_close (Journal *j)
+{
+    g_mutex_lock (j->mutex);
+    j->stop = TRUE;
+    g_cond_signal (j->wake);
+    g_mutex_unlock (j->mutex);
+
+    g_thread_join (j->thread);
+    fclose (j->file);
+    journal_free (j);
+}
+
+static void
+journal_wake (Journal *j)
+{
+    if (g_atomic_int_get (&j->writer_waiting))
+    {
+        g_mutex_lock (j->mutex);
+        g_cond_signal (j->wake);
+        g_mutex_unlock (j->mutex);
+    }
+}
+
+/* Waits until the writer has taken (or, with sync, synced) everything
+ * before pos. */
+static void
+journal_wait (Journal *j, guint pos, gboolean sync)
+{
+    g_mutex_lock (j->mutex);
+    if (sync && (gint) (pos - j->sync_wanted) > 0)
+        j->sync_wanted = pos;
+    g_cond_signal (j->wake);
+    while (!j->failed &&
+            (gint) ((sync ? j->synced : (guint) g_atomic_int_get (&j->tail))
+                    - pos) < 0)
+        g_cond_wait (j->done, j->mutex);
+    g_mutex_unlock (j->mutex);
+}
+
+static void
+journal_put (Journal *j, const void *data, guint len)
+{
+    const gchar *p = data;
+
+    while (len > 0)
+    {
+        guint head = (guint) g_atomic_int_get (&j->head);
+        guint space = JOURNAL_RING_SIZE - (head - (guint) g_atomic_int_get (&j->tail));
+        guint n, at, first;
+
+        if (space == 0)
+        {
+            journal_wait (j, head - JOURNAL_RING_SIZE + 1, FALSE);
+            continue;
+        }
+        n = MIN (len, space);
+        at = head & (JOURNAL_RING_SIZE - 1);
+        first = MIN (n, JOURNAL_RING_SIZE - at);
+        memcpy (j->ring + at, p, first);
+        memcpy (j->ring, p + first, n - first);
+        /* Publishes the bytes to the writer */
+        g_atomic_int_add (&j->head, (gint) n);
+        p += n;
+        len -= n;
+    }
+}
+
+static void
+journal_write (Journal *j, const LogTrans *lt)
+{
+    guchar fixed[JOURNAL_SPLIT_SIZE];
+    guint32 num_len = strlen (lt->num);
+    guint32 desc_len = strlen (lt->description);
+    guint32 notes_len = strlen (lt->notes);
+    guint32 len;
+    guint i;
+
+    len = JOURNAL_TRANS_SIZE + lt->n_splits * JOURNAL_SPLIT_SIZE +
+          num_len + desc_len + notes_len;
+    for (i = 0; i < lt->n_splits; i++)
+        len += strlen (lt->splits[i].acc_name) + strlen (lt->splits[i].memo) +
+               strlen (lt->splits[i].action);
+
+    memset (fixed, 0, JOURNAL_TRANS_SIZE);
+    put_u32 (fixed, len);
+    fixed[4] = lt->flag;
+    put_u32 (fixed + 8, lt->n_splits);
+    put_i64 (fixed + 12, lt->now);
+    put_i64 (fixed + 20, lt->date_entered);
+    put_i64 (fixed + 28, lt->date_posted);
+    memcpy (fixed + 36, lt->guid.reserved, GUID_DATA_SIZE);
+    put_u32 (fixed + 52, num_len);
+    put_u32 (fixed + 56, desc_len);
+    put_u32 (fixed + 60, notes_len);
+    journal_put (j, fixed, JOURNAL_TRANS_SIZE);
+
+    for (i = 0; i < lt->n_splits; i++)
+    {
+        const LogSplit *ls = &lt->splits[i];
+
+        memset (fixed, 0, JOURNAL_SPLIT_SIZE);
+        memcpy (fixed, ls->guid.reserved, GUID_DATA_SIZE);
+        memcpy (fixed + 16, ls->acc_guid.reserved, GUID_DATA_SIZE);
+        put_i64 (fixed + 32, gnc_numeric_num (ls->amount));
+        put_i64 (fixed + 40, gnc_numeric_denom (ls->amount));
+        put_i64 (fixed + 48, gnc_numeric_num (ls->value));
+        put_i64 (fixed + 56, gnc_numeric_denom (ls->value));
+        put_i64 (fixed + 64, ls->date_reconciled);
+        fixed[72] = ls->reconciled;
+        fixed[73] = ls->has_account ? 1 : 0;
+        put_u32 (fixed + 76, strlen (ls->acc_name));
+        put_u32 (fixed + 80, strlen (ls->memo));
+        put_u32 (fixed + 84, strlen (ls->action));
+        journal_put (j, fixed, JOURNAL_SPLIT_SIZE);
+    }
+
+    journal_put (j, lt->num, num_len);
+    journal_put (j, lt->description, desc_len);
+    journal_put (j, lt->notes, notes_len);
+    for (i = 0; i < lt->n_splits; i++)
+    {
+        const LogSplit *ls = &lt->splits[i];
+        journal_put (j, ls->acc_name, strlen (ls->acc_name));
+        journal_put (j, ls->memo, strlen (ls->memo));
+        journal_put (j, ls->action, strlen (ls->action));
+    }
+
+    /* A begin edit is always followed by something that ends it, which
+     * can take the begin edit out with it. */
+    if (lt->flag == 'B')
+        return;
+    if (g_atomic_int_get (&log_sync) == XACC_LOG_SYNC_COMMIT)
+        journal_wait (j, (guint) g_atomic_int_get (&j->head), TRUE);
+    else
+        journal_wake (j);
+}
+
+void
+xaccLogSetSync (XaccLogSync sync, guint interval_secs)
+{
+    g_atomic_int_set (&log_sync, sync);
+    g_atomic_int_set (&log_sync_secs, MAX (interval_secs, 1));
+    if (journal)
+        journal_wake (journal);
+}
+
+static const char *
+take_string (const guchar **src, gchar **dst, guint32 len)
+{
+    gchar *str = *dst;
+
+    memcpy (str, *src, len);
+    str[len] = '\0';
+    *src += len;
+    *dst += len + 1;
+    return str;
+}
+
+/* Fills lt from the record rec of length len, pointing its strings
+ * into *strings; free both lt->splits and *strings. */
+static gboolean
+journal_decode (const guchar *rec, guint32 len, LogTrans *lt, gchar **strings)
+{
+    const guchar *src;
+    gchar *dst;
+    guint64 str_len;
+    guint i;
+
+    lt->n_splits = get_u32 (rec + 8);
+    if (lt->n_splits > (len - JOURNAL_TRANS_SIZE) / JOURNAL_SPLIT_SIZE)
+        return FALSE;
+
+    src = rec + JOURNAL_TRANS_SIZE;
+    str_len = (guint64) get_u32 (rec + 52) + get_u32 (rec + 56) + get_u32 (rec + 60);
+    for (i = 0; i < lt->n_splits; i++, src += JOURNAL_SPLIT_SIZE)
+        str_len += (guint64) get_u32 (src + 76) + get_u32 (src + 80) +
+                   get_u32 (src + 84);
+    if (str_len != len - JOURNAL_TRANS_SIZE - lt->n_splits * JOURNAL_SPLIT_SIZE)
+        return FALSE;
+
+    lt->flag = rec[4];
+    lt->now = get_i64 (rec + 12);
+    lt->date_entered = get_i64 (rec + 20);
+    lt->date_posted = get_i64 (rec + 28);
+    memcpy (lt->guid.reserved, rec + 36, GUID_DATA_SIZE);
+
+    /* src is now at the strings */
+    dst = *strings = g_malloc (str_len + 3 * (lt->n_splits + 1));
+    lt->num = take_string (&src, &dst, get_u32 (rec + 52));
+    lt->description = take_string (&src, &dst, get_u32 (rec + 56));
+    lt->notes = take_string (&src, &dst, get_u32 (rec + 60));
+
+    lt->splits = g_new (LogSplit, lt->n_splits);
+    for (i = 0; i < lt->n_splits; i++)
+    {
+        const guchar *fixed = rec + JOURNAL_TRANS_SIZE + i * JOURNAL_SPLIT_SIZE;
+        LogSplit *ls = &lt->splits[i];
+
+        memcpy (ls->guid.reserved, fixed, GUID_DATA_SIZE);
+        memcpy (ls->acc_guid.reserved, fixed + 16, GUID_DATA_SIZE);
+        ls->amount = gnc_numeric_create (get_i64 (fixed + 32), get_i64 (fixed + 40));
+        ls->value = gnc_numeric_create (get_i64 (fixed + 48), get_i64 (fixed + 56));
+        ls->date_reconciled = get_i64 (fixed + 64);
+        ls->reconciled = fixed[72];
+        ls->has_account = fixed[73] != 0;
+        ls->acc_name = take_string (&src, &dst, get_u32 (fixed + 76));
+        ls->memo = take_string (&src, &dst, get_u32 (fixed + 80));
+        ls->action = take_string (&src, &dst, get_u32 (fixed + 84));
+    }
+    return TRUE;
+}
+
+/********************************************************************\
+ * Reading logs back
+\********************************************************************/
+
+typedef struct
+{
+    FILE *file;
+    const gchar *filename;
+    gboolean binary;
+    long size;
+    long pos;
+    LogTrans lt;
+    /* What lt points into */
+    guchar *rec;
+    gchar *strings;
+    GPtrArray *lines;
+    GArray *splits;
+} LogReader;
+
+/* Reads a line of any length, without its line end */
+static gchar *
+log_read_line (FILE *in)
+{
+    GString *line = g_string_new (NULL);
+    char buf[1024];
+
+    while (fgets (buf, sizeof buf, in))
+    {
+        g_string_append (line, buf);
+        if (line->str[line->len - 1] == '\n')
+            break;
+    }
+    if (line->len == 0)
+    {
+        g_string_free (line, TRUE);
+        return NULL;
+    }
+    while (line->len > 0 && (line->str[line->len - 1] == '\n' ||
+                             line->str[line->len - 1] == '\r'))
+        g_string_truncate (line, line->len - 1);
+    return g_string_free (line, FALSE);
+}
+
+static LogReader *
+log_reader_open (const gchar *filename)
+{
+    char magic[JOURNAL_MAGIC_LEN];
+    LogReader *r;
+    FILE *in = g_fopen (filename, "rb");
+
+    if (!in) return NULL;
+
+    r = g_new0 (LogReader, 1);
+    r->file = in;
+    r->filename = filename;
+    if (fread (magic, 1, JOURNAL_MAGIC_LEN, in) == JOURNAL_MAGIC_LEN &&
+            memcmp (magic, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN) == 0)
+    {
+        r->binary = TRUE;
+        fseek (in, 0, SEEK_END);
+        r->size = ftell (in);
+        r->pos = JOURNAL_MAGIC_LEN;
+        fseek (in, r->pos, SEEK_SET);
+    }
+    else
+    {
+        gchar *header;
+
+        rewind (in);
+        header = log_read_line (in);
+        if (!header || strcmp (header, LOG_TEXT_HEADER) != 0)
+        {
+            g_free (header);
+            fclose (in);
+            g_free (r);
+            return NULL;
+        }
+        g_free (header);
+        r->lines = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+        r->splits = g_array_new (FALSE, FALSE, sizeof (LogSplit));
+    }
+    return r;
+}
+
+/* Frees what the current record points into */
+static void
+log_reader_release (LogReader *r)
+{
+    if (r->binary)
+    {
+        g_free (r->lt.splits);
+        g_free (r->strings);
+        g_free (r->rec);
+        r->strings = NULL;
+        r->rec = NULL;
+    }
+    else
+    {
+        g_ptr_array_set_size (r->lines, 0);
+        g_array_set_size (r->splits, 0);
+    }
+    r->lt.splits = NULL;
+    r->lt.n_splits = 0;
+}
+
+static void
+log_reader_close (LogReader *r)
+{
+    log_reader_release (r);
+    if (!r->binary)
+    {
+        g_ptr_array_free (r->lines, TRUE);
+        g_array_free (r->splits, TRUE);
+    }
+    fclose (r->file);
+    g_free (r);
+}
+
+static gboolean
+log_reader_next_binary (LogReader *r)
+{
+    guint32 len;
+
+    if (r->pos >= r->size)
+        return FALSE;
+    if (r->size - r->pos < JOURNAL_TRANS_SIZE)
+    {
+        PWARN ("%s ends with a partial record", r->filename);
+        return FALSE;
+    }
+    r->rec = g_malloc (JOURNAL_TRANS_SIZE);
+    if (fread (r->rec, 1, JOURNAL_TRANS_SIZE, r->file) != JOURNAL_TRANS_SIZE)
+        return FALSE;
+    len = get_u32 (r->rec);
+    if (len < JOURNAL_TRANS_SIZE || len > r->size - r->pos)
+    {
+        PWARN ("%s ends with a partial record", r->filename);
+        return FALSE;
+    }
+    r->rec = g_realloc (r->rec, len);
+    if (fread (r->rec + JOURNAL_TRANS_SIZE, 1, len - JOURNAL_TRANS_SIZE, r->file)
+            != len - JOURNAL_TRANS_SIZE ||
+            !journal_decode (r->rec, len, &r->lt, &r->strings))
+    {
+        PWARN ("%s has a bad record at offset %ld", r->filename, r->pos);
+        return FALSE;
+    }
+    r->pos += len;
+    return TRUE;
+}
+
+static time64
+log_time_from_string (const char *str)
+{
+    return gnc_iso8601_to_timespec_gmt (str).tv_sec;
+}
+
+/* Adds one split line of a text record to r->lt */
+static gboolean
+log_reader_parse_line (LogReader *r, gchar *line)
+{
+    gchar **fields = g_strsplit (line, "\t", 0);
+    LogSplit ls;
+
+    if (g_strv_length (fields) != 17 || fields[0][0] == '\0' ||
+            !string_to_guid (fields[1], &r->lt.guid) ||
+            !string_to_guid (fields[2], &ls.guid) ||
+            !string_to_gnc_numeric (fields[14], &ls.amount) ||
+            !string_to_gnc_numeric (fields[15], &ls.value))
+    {
+        g_strfreev (fields);
+        return FALSE;
+    }
+
+    r->lt.flag = fields[0][0];
+    r->lt.now = log_time_from_string (fields[3]);
+    r->lt.date_entered = log_time_from_string (fields[4]);
+    r->lt.date_posted = log_time_from_string (fields[5]);
+    r->lt.num = fields[8];
+    r->lt.description = fields[9];
+    r->lt.notes = fields[10];
+
+    ls.has_account = (fields[6][0] != '\0' &&
+                      string_to_guid (fields[6], &ls.acc_guid));
+    if (!ls.has_account)
+        ls.acc_guid = *guid_null ();
+    ls.acc_name = fields[7];
+    ls.memo = fields[11];
+    ls.action = fields[12];
+    ls.reconciled = fields[13][0] ? fields[13][0] : NREC;
+    ls.date_reconciled = log_time_from_string (fields[16]);
+
+    g_ptr_array_add (r->lines, fields);
+    g_array_append_val (r->splits, ls);
+    return TRUE;
+}
+
+static gboolean
+log_reader_next_text (LogReader *r)
+{
+    gboolean started = FALSE;
+    gchar *line;
+
+    while ((line = log_read_line (r->file)))
+    {
+        if (!started)
+        {
+            started = g_str_has_prefix (line, "===== START");
+        }
+        else if (g_str_has_prefix (line, "===== END"))
+        {
+            if (r->splits->len > 0)
+            {
+                g_free (line);
+                r->lt.n_splits = r->splits->len;
+                r->lt.splits = (LogSplit *) r->splits->data;
+                return TRUE;
+            }
+            /* A transaction without splits says nothing */
+            started = FALSE;
+        }
+        else if (!log_reader_parse_line (r, line))
+        {
+            PWARN ("%s has a bad line: %s", r->filename, line);
+        }
+        g_free (line);
+    }
+    if (started)
+        PWARN ("%s ends with a partial record", r->filename);
+    return FALSE;
+}
+
+/* Moves on to the next record, which is left in r->lt */
+static gboolean
+log_reader_next (LogReader *r)
+{
+    log_reader_release (r);
+    return r->binary ? log_reader_next_binary (r) : log_reader_next_text (r);
+}
+
+gboolean
+xaccLogFileIsBinary (const gchar *filename)
+{
+    LogReader *r = log_reader_open (filename);
+    gboolean binary = (r && r->binary);
+
+    if (r) log_reader_close (r);
+    return binary;
+}
+
+gboolean
+xaccLogBinaryToText (const gchar *filename, FILE *out)
+{
+    LogReader *r = log_reader_open (filename);
+
+    if (!r) return FALSE;
+    if (!r->binary)
+    {
+        log_reader_close (r);
+        return FALSE;
+    }
+
+    log_write_text_header (out);
+    while (log_reader_next (r))
+        log_write_text (out, &r->lt);
+    log_reader_close (r);
+    return TRUE;
+}
+
 /********************************************************************\
 \********************************************************************/
 
@@ -164,7 +1062,7 @@ xaccOpenLog (void)
 	 PINFO ("Attempt to open disabled transaction log");
 	 return;
     }
-    if (trans_log) return;
+    if (trans_log || journal) return;
 
     if (!log_base_name) log_base_name = g_strdup ("translog");
 
@@ -173,16 +1071,25 @@ xaccOpenLog (void)
 
     filename = g_strconcat (log_base_name, ".", timestamp, ".log", NULL);
 
-    trans_log = g_fopen (filename, "a");
-    if (!trans_log)
+    if (log_format == XACC_LOG_BINARY)
+    {
+        journal = journal_open (filename);
+        if (!journal)
+            PWARN ("Cannot start binary log %s, writing text instead", filename);
+    }
+    if (!journal)
     {
-        int norr = errno;
-        printf ("Error: xaccOpenLog(): cannot open journal \n"
-                "\t %d %s\n", norr, g_strerror (norr) ? g_strerror (norr) : "");
+        trans_log = g_fopen (filename, "a");
+        if (!trans_log)
+        {
+            int norr = errno;
+            printf ("Error: xaccOpenLog(): cannot open journal \n"
+                    "\t %d %s\n", norr, g_strerror (norr) ? g_strerror (norr) : "");
 
-        g_free (filename);
-        g_free (timestamp);
-        return;
+            g_free (filename);
+            g_free (timestamp);
+            return;
+        }
     }
 
     /* Save the log file name */
@@ -193,13 +1100,8 @@ xaccOpenLog (void)
     g_free (filename);
     g_free (timestamp);
 
-    /*  Note: this must match src/import-export/log-replay/gnc-log-replay.c */
-    fprintf (trans_log, "mod\ttrans_guid\tsplit_guid\ttime_now\t"
-             "date_entered\tdate_posted\t"
-             "acc_guid\tacc_name\tnum\tdescription\t"
-             "notes\tmemo\taction\treconciled\t"
-             "amount\tvalue\tdate_reconciled\n");
-    fprintf (trans_log, "-----------------\n");
+    if (trans_log)
+        log_write_text_header (trans_log);
 }
 
 /********************************************************************\
@@ -208,6 +1110,15 @@ xaccOpenLog (void)
 void
 xaccCloseLog (void)
 {
+    /* Nothing is being written to it any more */
+    g_free (trans_log_name);
+    trans_log_name = NULL;
+
+    if (journal)
+    {
+        journal_close (journal);
+        journal = NULL;
+    }
     if (!trans_log) return;
     fflush (trans_log);
     fclose (trans_log);
@@ -220,89 +1131,333 @@ xaccCloseLog (void)
 void
 xaccTransWriteLog (Transaction *trans, char flag)
 {
-    GList *node;
-    char trans_guid_str[GUID_ENCODING_LENGTH + 1];
-    char split_guid_str[GUID_ENCODING_LENGTH + 1];
-    const char *trans_notes;
-    char dnow[100], dent[100], dpost[100], drecn[100];
-    Timespec ts;
+    LogTrans lt;
 
     if (!gen_logs)
     {
 	 PINFO ("Attempt to write disabled transaction log");
 	 return;
     }
-    if (!trans_log) return;
+    if (!trans_log && !journal) return;
+
+    log_trans_capture (&lt, trans, flag);
+    if (journal)
+    {
+        journal_write (journal, &lt);
+    }
+    else
+    {
+        log_write_text (trans_log, &lt);
+        /* get data out to the disk */
+        fflush (trans_log);
+    }
+    g_free (lt.splits);
+}
 
-    timespecFromTime64(&ts, gnc_time (NULL));
-    gnc_timespec_to_iso8601_buff (ts, dnow);
+/********************************************************************\
+ * Replaying a log into a book
+\********************************************************************/
 
-    timespecFromTime64(&ts, trans->date_entered.tv_sec);
-    gnc_timespec_to_iso8601_buff (ts, dent);
+static gboolean
+log_str_equal (const char *a, const char *b)
+{
+    return strcmp (a ? a : "", b ? b : "") == 0;
+}
 
-    timespecFromTime64(&ts, trans->date_posted.tv_sec);
-    gnc_timespec_to_iso8601_buff (ts, dpost);
+/* TRUE if trans already looks the way lt says it does */
+static gboolean
+log_trans_matches (Transaction *trans, const LogTrans *lt)
+{
+    QofBook *book = qof_instance_get_book (trans);
+    guint i;
 
-    guid_to_string_buff (xaccTransGetGUID(trans), trans_guid_str);
-    trans_notes = xaccTransGetNotes(trans);
-    fprintf (trans_log, "===== START\n");
+    if (trans->date_entered.tv_sec != lt->date_entered ||
+            trans->date_posted.tv_sec != lt->date_posted ||
+            !log_str_equal (trans->num, lt->num) ||
+            !log_str_equal (trans->description, lt->description) ||
+            !log_str_equal (xaccTransGetNotes (trans), lt->notes) ||
+            xaccTransCountSplits (trans) != (int) lt->n_splits)
+        return FALSE;
 
-    for (node = trans->splits; node; node = node->next)
+    for (i = 0; i < lt->n_splits; i++)
     {
-        Split *split = node->data;
-        const char * accname = "";
-        char acc_guid_str[GUID_ENCODING_LENGTH + 1];
-        gnc_numeric amt, val;
+        const LogSplit *ls = &lt->splits[i];
+        Split *split = xaccSplitLookup (&ls->guid, book);
+        Account *acc;
+
+        if (!split || xaccSplitGetParent (split) != trans)
+            return FALSE;
+        acc = xaccSplitGetAccount (split);
+        if (ls->has_account ?
+                (!acc || !guid_equal (xaccAccountGetGUID (acc), &ls->acc_guid)) :
+                acc != NULL)
+            return FALSE;
+        if (!log_str_equal (split->memo, ls->memo) ||
+                !log_str_equal (split->action, ls->action) ||
+                split->reconciled != ls->reconciled ||
+                split->date_reconciled.tv_sec != ls->date_reconciled ||
+                !gnc_numeric_equal (xaccSplitGetAmount (split), ls->amount) ||
+                !gnc_numeric_equal (xaccSplitGetValue (split), ls->value))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* The accounts stay open for the whole replay, so that their splits
+ * are sorted and their balances computed once at the end instead of
+ * after every transaction. */
+static void
+log_replay_open_account (GHashTable *accounts, Account *acc)
+{
+    if (acc && !g_hash_table_lookup (accounts, acc))
+    {
+        xaccAccountBeginEdit (acc);
+        g_hash_table_insert (accounts, acc, acc);
+    }
+}
+
+static void
+log_replay_close_account (gpointer key, gpointer value, gpointer data)
+{
+    xaccAccountCommitEdit (key);
+}
+
+static gboolean
+log_trans_has_split (const LogTrans *lt, Split *split)
+{
+    guint i;
+
+    for (i = 0; i < lt->n_splits; i++)
+        if (guid_equal (&lt->splits[i].guid, xaccSplitGetGUID (split)))
+            return TRUE;
+    return FALSE;
+}
+
+static void
+log_replay_commit (QofBook *book, Transaction *trans, const LogTrans *lt,
+                   GHashTable *accounts)
+{
+    Timespec ts = {0, 0};
+    gchar *read_only = NULL;
+    GList *node, *stale = NULL;
+    guint i;
 
-        if (xaccSplitGetAccount(split))
+    if (trans)
+    {
+        xaccTransBeginEdit (trans);
+        read_only = g_strdup (xaccTransGetReadOnly (trans));
+        if (read_only)
+        {
+            PWARN ("Replaying a read only transaction.");
+            xaccTransClearReadOnly (trans);
+        }
+        for (node = xaccTransGetSplitList (trans); node; node = node->next)
         {
-            accname = xaccAccountGetName (xaccSplitGetAccount(split));
-            guid_to_string_buff(xaccAccountGetGUID(xaccSplitGetAccount(split)),
-                                acc_guid_str);
+            log_replay_open_account (accounts, xaccSplitGetAccount (node->data));
+            if (!log_trans_has_split (lt, node->data))
+                stale = g_list_prepend (stale, node->data);
+        }
+        for (node = stale; node; node = node->next)
+            xaccSplitDestroy (node->data);
+        g_list_free (stale);
+    }
+    else
+    {
+        trans = xaccMallocTransaction (book);
+        xaccTransBeginEdit (trans);
+        xaccTransSetGUID (trans, &lt->guid);
+    }
+
+    ts.tv_sec = lt->date_entered;
+    xaccTransSetDateEnteredTS (trans, &ts);
+    ts.tv_sec = lt->date_posted;
+    xaccTransSetDatePostedTS (trans, &ts);
+    xaccTransSetNum (trans, lt->num);
+    xaccTransSetDescription (trans, lt->description);
+    /* Notes live in a slot, don't create an empty one */
+    if (!log_str_equal (xaccTransGetNotes (trans), lt->notes))
+        xaccTransSetNotes (trans, lt->notes);
+
+    /* The log doesn't record the currency; a new transaction gets it
+     * from its accounts, so that values are rounded correctly. */
+    for (i = 0; i < lt->n_splits && !xaccTransGetCurrency (trans); i++)
+    {
+        Account *acc = lt->splits[i].has_account ?
+                       xaccAccountLookup (&lt->splits[i].acc_guid, book) : NULL;
+        if (acc && gnc_commodity_is_currency (xaccAccountGetCommodity (acc)))
+            xaccTransSetCurrency (trans, xaccAccountGetCommodity (acc));
+    }
+
+    for (i = 0; i < lt->n_splits; i++)
+    {
+        const LogSplit *ls = &lt->splits[i];
+        Split *split = xaccSplitLookup (&ls->guid, book);
+        Account *acc = NULL;
+
+        if (ls->has_account)
+        {
+            acc = xaccAccountLookup (&ls->acc_guid, book);
+            if (!acc)
+                PWARN ("Account %s of a replayed split was not found", ls->acc_name);
+        }
+        if (!split)
+        {
+            split = xaccMallocSplit (book);
+            xaccSplitSetGUID (split, &ls->guid);
         }
         else
         {
-            acc_guid_str[0] = '\0';
+            log_replay_open_account (accounts, xaccSplitGetAccount (split));
         }
+        if (acc)
+        {
+            log_replay_open_account (accounts, acc);
+            xaccSplitSetAccount (split, acc);
+        }
+        if (xaccSplitGetParent (split) != trans)
+            xaccSplitSetParent (split, trans);
 
-        timespecFromTime64(&ts, split->date_reconciled.tv_sec);
-        gnc_timespec_to_iso8601_buff (ts, drecn);
+        xaccSplitSetMemo (split, ls->memo);
+        xaccSplitSetAction (split, ls->action);
+        ts.tv_sec = ls->date_reconciled;
+        xaccSplitSetDateReconciledTS (split, &ts);
+        xaccSplitSetReconcile (split, ls->reconciled);
+        xaccSplitSetAmount (split, ls->amount);
+        xaccSplitSetValue (split, ls->value);
+    }
 
-        guid_to_string_buff (xaccSplitGetGUID(split), split_guid_str);
-        amt = xaccSplitGetAmount (split);
-        val = xaccSplitGetValue (split);
+    xaccTransScrubCurrency (trans);
+    xaccTransSetReadOnly (trans, read_only);
+    xaccTransCommitEdit (trans);
+    g_free (read_only);
+}
 
-        /* use tab-separated fields */
-        fprintf (trans_log,
-                 "%c\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t"
-                 "%s\t%s\t%s\t%s\t%c\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\t%s\n",
-                 flag,
-                 trans_guid_str, split_guid_str,  /* trans+split make up unique id */
-                 /* Note that the next three strings always exist,
-                 		* so we don't need to test them. */
-                 dnow,
-                 dent,
-                 dpost,
-                 acc_guid_str,
-                 accname ? accname : "",
-                 trans->num ? trans->num : "",
-                 trans->description ? trans->description : "",
-                 trans_notes ? trans_notes : "",
-                 split->memo ? split->memo : "",
-                 split->action ? split->action : "",
-                 split->reconciled,
-                 gnc_numeric_num(amt),
-                 gnc_numeric_denom(amt),
-                 gnc_numeric_num(val),
-                 gnc_numeric_denom(val),
-                 /* The next string always exists. No need to test it. */
-                 drecn);
+static void
+log_replay_delete (Transaction *trans, GHashTable *accounts)
+{
+    GList *node;
+
+    for (node = xaccTransGetSplitList (trans); node; node = node->next)
+        log_replay_open_account (accounts, xaccSplitGetAccount (node->data));
+
+    if (xaccTransGetReadOnly (trans))
+    {
+        PWARN ("Destroying a read only transaction.");
+        xaccTransClearReadOnly (trans);
     }
+    xaccTransBeginEdit (trans);
+    xaccTransDestroy (trans);
+    xaccTransCommitEdit (trans);
+}
 
-    fprintf (trans_log, "===== END\n");
+/* Maps the GUID of every transaction in the log to the number of its
+ * last commit or delete, counting from 1. */
+static GHashTable *
+log_replay_last_records (LogReader *r)
+{
+    GHashTable *last = g_hash_table_new_full (guid_hash_to_guint,
+                                              guid_g_hash_table_equal,
+                                              (GDestroyNotify) guid_free, NULL);
+    guint n = 0;
 
-    /* get data out to the disk */
-    fflush (trans_log);
+    while (log_reader_next (r))
+    {
+        GncGUID *guid;
+
+        n++;
+        if (r->lt.flag != 'C' && r->lt.flag != 'D')
+            continue;
+        guid = guid_malloc ();
+        *guid = r->lt.guid;
+        g_hash_table_replace (last, guid, GUINT_TO_POINTER (n));
+    }
+    return last;
+}
+
+gboolean
+xaccLogReplay (QofBook *book, const gchar *filename, XaccLogReplayStats *stats)
+{
+    XaccLogReplayStats count = {0, 0, 0, 0};
+    GHashTable *accounts, *last;
+    LogReader *r;
+    guint n = 0;
+
+    g_return_val_if_fail (book && filename, FALSE);
+
+    if (xaccFileIsCurrentLog (filename))
+    {
+        PWARN ("Cannot replay the current log file %s", filename);
+        return FALSE;
+    }
+    r = log_reader_open (filename);
+    if (!r)
+        return FALSE;
+
+    /* Only the last state of each transaction matters, so find that
+     * first and then go through the log again applying just those. */
+    last = log_replay_last_records (r);
+    log_reader_close (r);
+    r = log_reader_open (filename);
+    if (!r)
+    {
+        g_hash_table_destroy (last);
+        return FALSE;
+    }
+
+    accounts = g_hash_table_new (g_direct_hash, g_direct_equal);
+    qof_event_suspend ();
+    while (log_reader_next (r))
+    {
+        const LogTrans *lt = &r->lt;
+        Transaction *trans;
+
+        n++;
+        if (lt->flag != 'C' && lt->flag != 'D')
+        {
+            /* Begin edits and rollbacks leave the book as it was */
+            count.ignored++;
+            continue;
+        }
+        if (GPOINTER_TO_UINT (g_hash_table_lookup (last, &lt->guid)) != n)
+        {
+            count.superseded++;
+            continue;
+        }
+
+        trans = xaccTransLookup (&lt->guid, book);
+        if (lt->flag == 'C')
+        {
+            if (trans && log_trans_matches (trans, lt))
+                count.skipped++;
+            else
+            {
+                log_replay_commit (book, trans, lt, accounts);
+                count.applied++;
+            }
+        }
+        else
+        {
+            if (!trans)
+                count.skipped++;
+            else
+            {
+                log_replay_delete (trans, accounts);
+                count.applied++;
+            }
+        }
+    }
+    g_hash_table_foreach (accounts, log_replay_close_account, NULL);
+    g_hash_table_destroy (accounts);
+    g_hash_table_destroy (last);
+    qof_event_resume ();
+    log_reader_close (r);
+
+    PINFO ("Replayed %s: %u applied, %u already there, %u superseded, %u ignored",
+           filename, count.applied, count.skipped, count.superseded,
+           count.ignored);
+    if (stats)
+        *stats = count;
+    return TRUE;
 }
 
 /************************ END OF ************************************\
@@ -43,9 +43,33 @@
 #ifndef XACC_TRANS_LOG_H
 #define XACC_TRANS_LOG_H
 
+#include <stdio.h>
+
 #include "Account.h"
 #include "Transaction.h"
 
+/** How the log is written. */
+typedef enum
+{
+    XACC_LOG_TEXT,      /**< Tab separated lines, written and flushed
+                             before xaccTransWriteLog() returns. */
+    XACC_LOG_BINARY     /**< Compact binary records, queued for a writer
+                             thread that writes them out in batches. */
+} XaccLogFormat;
+
+/** When a binary log makes sure its records have reached the disk.
+ *  Text logs are only ever flushed to the operating system. */
+typedef enum
+{
+    XACC_LOG_SYNC_COMMIT,   /**< Before each commit, delete or rollback
+                                 returns; a begin edit and its commit
+                                 share one sync. */
+    XACC_LOG_SYNC_INTERVAL, /**< At most every few seconds while there
+                                 are changes.  The default. */
+    XACC_LOG_SYNC_SAVE      /**< Only when the log is closed, which
+                                 happens after each save. */
+} XaccLogSync;
+
 void    xaccOpenLog (void);
 void    xaccCloseLog (void);
 void    xaccReopenLog (void);
@@ -81,6 +105,50 @@ void    xaccLogSetBaseName (const char *);
 /** Test a filename to see if it is the name of the current logfile */
 gboolean xaccFileIsCurrentLog (const gchar *name);
 
+/** Selects the format of log files.  An open log is reopened as a new
+ *    file if the format changes.  The default is XACC_LOG_TEXT.
+ */
+void    xaccLogSetFormat (XaccLogFormat format);
+
+/** Sets when binary logs are synced to disk; interval_secs is only used
+ *    by XACC_LOG_SYNC_INTERVAL.  Takes effect immediately.
+ */
+void    xaccLogSetSync (XaccLogSync sync, guint interval_secs);
+
+/** TRUE if filename is a log written in the binary format. */
+gboolean xaccLogFileIsBinary (const gchar *filename);
+
+/** Writes the records of the binary log filename to out in the text
+ *    format, header included.  A record cut short by a crash ends the
+ *    conversion.  FALSE if filename can't be read or isn't a binary log.
+ */
+gboolean xaccLogBinaryToText (const gchar *filename, FILE *out);
+
+/** What xaccLogReplay() did with the records of a log. */
+typedef struct
+{
+    guint applied;      /**< commits and deletes made to the book */
+    guint skipped;      /**< commits and deletes the book already had */
+    guint superseded;   /**< records followed by a later commit or
+                             delete of the same transaction */
+    guint ignored;      /**< begin edits and rollbacks */
+} XaccLogReplayStats;
+
+/** Applies the commits and deletes recorded in the log filename, text
+ *    or binary, straight to book.  Only the last record of each
+ *    transaction is applied, and skipped if the book already has it,
+ *    so replaying a log twice changes nothing.
+ *
+ *    Events are suspended and the accounts involved are kept open until
+ *    the end, so callers should refresh whatever displays the book.
+ *    Changes are logged like any other unless logging is disabled.
+ *
+ * @param stats If not NULL, filled in with what was done.
+ * @return FALSE if filename isn't a log or is the current one.
+ */
+gboolean xaccLogReplay (QofBook *book, const gchar *filename,
+                        XaccLogReplayStats *stats);
+
 #endif /* XACC_TRANS_LOG_H */
 /** @} */
 /** @} */
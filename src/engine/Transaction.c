@@ -2088,6 +2088,7 @@ xaccTransSetDescription (Transaction *trans, const char *desc)
 
     CACHE_REPLACE(trans->description, desc);
     qof_instance_set_dirty(QOF_INSTANCE(trans));
+    mark_trans(trans);  /* The description is a sort key for the splits */
     xaccTransCommitEdit(trans);
 }
 
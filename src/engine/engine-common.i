@@ -34,6 +34,7 @@ static const GncGUID * gncAccountGetGUID(Account *x)
 %typemap(newfree) LotList * "g_list_free($1);"
 %typemap(newfree) CommodityList * "g_list_free($1);"
 
+%ignore xaccSplitListSumAmounts;
 %include <Split.h>
 
 AccountList * gnc_account_get_children (const Account *account);
@@ -44,6 +45,8 @@ AccountList * gnc_account_get_descendants_sorted (const Account *account);
 %ignore gnc_account_get_children_sorted;
 %ignore gnc_account_get_descendants;
 %ignore gnc_account_get_descendants_sorted;
+%ignore xaccAccountGetBalancesAsOfDatesInCurrency;
+%ignore xaccAccountFindSplitsInDateRange;
 %include <Account.h>
 
 %include <Transaction.h>
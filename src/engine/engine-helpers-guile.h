@@ -59,4 +59,12 @@ gnc_commodity * gnc_scm_to_commodity(SCM scm);
 SCM gnc_commodity_to_scm (const gnc_commodity *commodity);
 SCM gnc_book_to_scm (const QofBook *book);
 
+/* Returns the balances of account and its descendants at each of the
+ * dates in dates_scm (a list of times or timepairs), as a list with
+ * one (account balance ...) entry per account.  See
+ * xaccAccountGetBalancesAsOfDatesInCurrency. */
+SCM gnc_account_get_balances_as_of_dates (Account *account, SCM dates_scm,
+                                          gnc_commodity *report_commodity,
+                                          gboolean include_children);
+
 #endif
@@ -2141,3 +2141,48 @@ gnc_book_to_scm (const QofBook *book)
 {
     return gnc_generic_to_scm(book, "_p_QofBook");
 }
+
+SCM
+gnc_account_get_balances_as_of_dates (Account *account, SCM dates_scm,
+                                      gnc_commodity *report_commodity,
+                                      gboolean include_children)
+{
+    GList *accounts, *node;
+    gnc_numeric *balances;
+    time64 *dates;
+    guint n_dates, row, col;
+    SCM result = SCM_EOL;
+
+    if (!account || !scm_is_true (scm_list_p (dates_scm)))
+        return SCM_BOOL_F;
+
+    n_dates = scm_to_uint (scm_length (dates_scm));
+    dates = g_new (time64, n_dates);
+    for (col = 0; col < n_dates; col++, dates_scm = SCM_CDR (dates_scm))
+    {
+        SCM date_scm = SCM_CAR (dates_scm);
+        if (gnc_timepair_p (date_scm))
+            dates[col] = gnc_timepair2timespec (date_scm).tv_sec;
+        else
+            dates[col] = scm_to_int64 (date_scm);
+    }
+
+    balances = xaccAccountGetBalancesAsOfDatesInCurrency (account, dates,
+               n_dates, report_commodity, include_children, &accounts);
+    g_free (dates);
+
+    for (node = accounts, row = 0; node; node = node->next, row++)
+    {
+        SCM row_scm = SCM_EOL;
+        for (col = n_dates; col > 0; col--)
+            row_scm = scm_cons (gnc_numeric_to_scm (
+                                    balances[row * n_dates + col - 1]),
+                                row_scm);
+        result = scm_cons (scm_cons (gnc_generic_to_scm (node->data,
+                                     "_p_Account"), row_scm), result);
+    }
+    g_list_free (accounts);
+    g_free (balances);
+
+    return scm_reverse (result);
+}
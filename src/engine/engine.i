@@ -198,6 +198,7 @@ SplitList * qof_query_run_subquery (QofQuery *q, const QofQuery *q);
 %ignore GNC_ERROR_OVERFLOW;
 %ignore GNC_ERROR_DENOM_DIFF;
 %ignore GNC_ERROR_REMAINDER;
+%ignore gnc_numeric_sum_fixed;
 %include <gnc-numeric.h>
 
 Timespec timespecCanonicalDayTime(Timespec t);
@@ -485,7 +485,6 @@ gnc_numeric
 gnc_lot_get_balance (GNCLot *lot)
 {
     LotPrivate* priv;
-    GList *node;
     gnc_numeric zero = gnc_numeric_zero();
     gnc_numeric baln = zero;
     if (!lot) return zero;
@@ -500,13 +499,8 @@ gnc_lot_get_balance (GNCLot *lot)
     /* Sum over splits; because they all belong to same account
      * they will have same denominator.
      */
-    for (node = priv->splits; node; node = node->next)
-    {
-        Split *s = node->data;
-        gnc_numeric amt = xaccSplitGetAmount (s);
-        baln = gnc_numeric_add_fixed (baln, amt);
-        g_assert (gnc_numeric_check (baln) == GNC_ERROR_OK);
-    }
+    xaccSplitListSumAmounts (priv->splits, &baln, NULL, NULL);
+    g_assert (gnc_numeric_check (baln) == GNC_ERROR_OK);
 
     /* cache a zero balance as a closed lot */
     if (gnc_numeric_equal (baln, zero))
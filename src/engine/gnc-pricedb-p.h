@@ -57,6 +57,14 @@ struct gnc_price_db_s
     QofInstance inst;              /* globally unique object identifier */
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
+
+    /* Recently used nearest price conversions, most recent first, and
+     * an index of them by commodities and time.  See
+     * gnc_pricedb_convert_balance_nearest_price. */
+    GQueue *conversion_lru;
+    GHashTable *conversion_cache;
+    guint64 conversion_hits;
+    guint64 conversion_misses;
 };
 
 struct _GncPriceDBClass
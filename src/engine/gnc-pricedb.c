@@ -37,10 +37,15 @@ static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         Timespec t, gboolean sameday);
+static void pricedb_conversion_cache_invalidate(GNCPriceDB *db, GNCPrice *p);
+static void pricedb_conversion_cache_destroy(GNCPriceDB *db);
+static GNCPriceConversion *
+pricedb_cached_conversion(GNCPriceDB *db, const gnc_commodity *from,
+                          const gnc_commodity *to, Timespec t);
 static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
-                            gpointer user_data);
+pricedb_series_traversal(GNCPriceDB *db,
+                         gboolean (*f)(GPtrArray *series, gpointer user_data),
+                         gpointer user_data);
 
 enum
 {
@@ -818,15 +823,157 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* price series
+
+   The prices of one commodity in one currency are kept in a GPtrArray
+   holding a reference to each of them, sorted like a PriceList with the
+   latest price first.  Looking prices up by time is a binary search,
+   and loading a book, which lists the prices in that order, only
+   appends to the arrays.
+ */
+
+static GPtrArray *
+price_series_new (void)
+{
+    return g_ptr_array_new_with_free_func ((GDestroyNotify) gnc_price_unref);
+}
+
+/* The index of the latest price not later than t or, without
+ * inclusive, of the latest price earlier than t.  All the prices
+ * before that index are later. */
+static guint
+price_series_search (const GPtrArray *series, Timespec t, gboolean inclusive)
+{
+    guint lo = 0, hi = series->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec price_t = gnc_price_get_time (g_ptr_array_index (series, mid));
+        gint cmp = timespec_cmp (&price_t, &t);
+
+        if (cmp > 0 || (cmp == 0 && !inclusive))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* The index p has, or would have, in series. */
+static guint
+price_series_position (const GPtrArray *series, const GNCPrice *p)
+{
+    guint lo = 0, hi = series->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+
+        if (compare_prices_by_date (g_ptr_array_index (series, mid), p) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static gboolean
+price_series_has_duplicate (const GPtrArray *series, guint pos, GNCPrice *p)
+{
+    PriceListIsDuplStruct dupl = { p, FALSE };
+    Timespec day = timespecCanonicalDayTime (gnc_price_get_time (p));
+    guint i;
+
+    /* Only prices on the same day can be duplicates, and they are all
+     * next to where p would go. */
+    for (i = pos; i > 0 && !dupl.isDupl; i--)
+    {
+        GNCPrice *other = g_ptr_array_index (series, i - 1);
+        Timespec other_day = timespecCanonicalDayTime (gnc_price_get_time (other));
+        if (!timespec_equal (&other_day, &day))
+            break;
+        price_list_is_duplicate (other, &dupl);
+    }
+    for (i = pos; i < series->len && !dupl.isDupl; i++)
+    {
+        GNCPrice *other = g_ptr_array_index (series, i);
+        Timespec other_day = timespecCanonicalDayTime (gnc_price_get_time (other));
+        if (!timespec_equal (&other_day, &day))
+            break;
+        price_list_is_duplicate (other, &dupl);
+    }
+    return dupl.isDupl;
+}
+
+static void
+price_series_insert (GPtrArray *series, GNCPrice *p, gboolean check_dupl)
+{
+    guint pos = price_series_position (series, p);
+
+    if (check_dupl && price_series_has_duplicate (series, pos, p))
+        return;
+
+    gnc_price_ref (p);
+    g_ptr_array_add (series, p);
+    if (pos < series->len - 1)
+    {
+        memmove (&series->pdata[pos + 1], &series->pdata[pos],
+                 (series->len - 1 - pos) * sizeof (gpointer));
+        series->pdata[pos] = p;
+    }
+}
+
+static void
+price_series_remove (GPtrArray *series, GNCPrice *p)
+{
+    guint pos = price_series_position (series, p);
+
+    if (pos < series->len && g_ptr_array_index (series, pos) == p)
+        g_ptr_array_remove_index (series, pos);
+    else
+        g_ptr_array_remove (series, p);
+}
+
+/* The prices of series as a PriceList, without taking references. */
+static PriceList *
+price_series_to_list (const GPtrArray *series)
+{
+    PriceList *prices = NULL;
+    guint i;
+
+    for (i = series->len; i > 0; i--)
+        prices = g_list_prepend (prices, g_ptr_array_index (series, i - 1));
+    return prices;
+}
+
+/* Whichever of two prices comes first in a PriceList, i.e. the later. */
+static GNCPrice *
+price_later (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? a : b;
+}
+
+/* Whichever of two prices comes last in a PriceList, i.e. the earlier. */
+static GNCPrice *
+price_earlier (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) >= 0 ? a : b;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to price series (see above).  The top-level key
+   is the commodity you want the prices for, and the second level key
+   is the commodity that the value is expressed in terms of.
  */
 
 /* GObject Initialization */
@@ -885,18 +1032,18 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
+    GPtrArray *series = (GPtrArray *) data;
     GNCPrice *p;
+    guint i;
 
-    for (node = price_list; node; node = node->next)
+    for (i = 0; i < series->len; i++)
     {
-        p = node->data;
+        p = g_ptr_array_index (series, i);
 
         p->db = NULL;
     }
 
-    gnc_price_list_destroy(price_list);
+    g_ptr_array_free (series, TRUE);
 }
 
 static void
@@ -924,6 +1071,7 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    pricedb_conversion_cache_destroy (db);
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -1006,7 +1154,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_series_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1016,6 +1164,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1077,7 +1226,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1127,20 +1276,15 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
-    {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
-    }
-    if (!price_list)
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        LEAVE (" no price list");
-        return FALSE;
+        series = price_series_new ();
+        g_hash_table_insert(currency_hash, currency, series);
     }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    price_series_insert (series, p, !db->bulk_update);
     p->db = db;
+    pricedb_conversion_cache_invalidate (db, p);
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
 
     LEAVE ("db=%p, pr=%p dirty=%d dextroying=%d commodity=%s/%s currency_hash=%p",
@@ -1189,7 +1333,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1225,24 +1369,19 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
+    series = g_hash_table_lookup(currency_hash, currency);
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (series)
+        price_series_remove (series, p);
+    pricedb_conversion_cache_invalidate (db, p);
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price series is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!series || series->len == 0)
     {
         g_hash_table_remove(currency_hash, currency);
+        if (series)
+            g_ptr_array_free (series, TRUE);
 
         if (cleanup)
         {
@@ -1337,18 +1476,19 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
+    guint i = 0;
     remove_info *data = (remove_info *) user_data;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* The most recent price is the first in the list */
+    /* The most recent price is the first in the series */
     if (!data->delete_last)
-        node = g_list_next(node);
+        i++;
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each item in the series */
+    for (; i < series->len; i++)
+        check_one_price_date (g_ptr_array_index (series, i), data);
 
     LEAVE(" ");
 }
@@ -1418,30 +1558,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *prices = price_series_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, prices);
         g_list_free (*l);
+        g_list_free (prices);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = prices;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    GPtrArray *series;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        series = g_hash_table_lookup(hash, currency);
+        if (!series)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_series_to_list (series);
     }
     else
     {
@@ -1530,44 +1673,49 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     return forward_list;
 }
 
+/* Fill series with the prices of c in currency and of currency in c,
+ * both of which the lookups between two commodities consider, and
+ * return how many of them there are. */
+static guint
+pricedb_get_series (GNCPriceDB *db, const gnc_commodity *c,
+                    const gnc_commodity *currency, GPtrArray *series[2])
+{
+    GHashTable *currency_hash;
+    GPtrArray *found;
+    guint n = 0;
+
+    currency_hash = g_hash_table_lookup (db->commodity_hash, c);
+    if (currency_hash &&
+        (found = g_hash_table_lookup (currency_hash, currency)) != NULL)
+        series[n++] = found;
+    currency_hash = g_hash_table_lookup (db->commodity_hash, currency);
+    if (currency_hash &&
+        (found = g_hash_table_lookup (currency_hash, c)) != NULL)
+        series[n++] = found;
+    return n;
+}
+
 GNCPrice *
 gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
-    GNCPrice *result;
-    GHashTable *currency_hash;
+    GPtrArray *series[2];
+    GNCPrice *result = NULL;
+    guint n, i;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    n = pricedb_get_series (db, commodity, currency, series);
+    /* The latest price is the first of each series. */
+    for (i = 0; i < n; i++)
+        result = price_later (result, g_ptr_array_index (series[i], 0));
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE(" ");
     return result;
 }
 
-
-static void
-lookup_latest(gpointer key, gpointer val, gpointer user_data)
-{
-    //gnc_commodity *currency = (gnc_commodity *)key;
-    GList *price_list = (GList *)val;
-    GList **return_list = (GList **)user_data;
-
-    if (!price_list) return;
-
-    /* the latest price is the first in list */
-    gnc_price_list_insert(return_list, price_list->data, FALSE);
-}
-
 typedef struct
 {
     GList **list;
@@ -1575,65 +1723,58 @@ typedef struct
     Timespec t;
 } UsesCommodity;
 
-/* price_list_scan_any_currency is the helper function used with
- * pricedb_pricelist_traversal by the "any_currency" price lookup functions. It 
- * builds a list of prices that are either to or from the commodity "com".  
- * The resulting list will include the last price newer than "t" and the first 
- * price older than "t".  All other prices will be ignored.  Since in the most 
- * common cases we will be looking for recent prices which are at the front of 
- * the various price lists, this is considerably faster than concatenating all 
- * the relevant price lists and sorting the result.  
+/* price_series_scan_any_currency is the helper function used with
+ * pricedb_series_traversal by the "any_currency" price lookup functions. It
+ * builds a list of prices that are either to or from the commodity "com".
+ * The resulting list will include the last price newer than "t" and the first
+ * price older than "t".  All other prices will be ignored, and finding
+ * those two in each series is a binary search, so this is considerably
+ * faster than concatenating all the relevant price lists and sorting the
+ * result.
 */
- 
+
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_series_scan_any_currency(GPtrArray *series, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *price;
     gnc_commodity *com;
     gnc_commodity *cur;
-    
-    if (!price_list)
+    guint pos;
+
+    if (series->len == 0)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
-    
-    /* if this price list isn't for the commodity we are interested in,
+    price = g_ptr_array_index (series, 0);
+    com = gnc_price_get_commodity(price);
+    cur = gnc_price_get_currency(price);
+
+    /* if this price series isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
-    
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+
+    /* Find the first price that is older than the requested time. */
+    pos = price_series_search (series, helper->t, FALSE);
+    if (pos == series->len)
     {
-        GNCPrice *price = node->data;
-        Timespec price_t = gnc_price_get_time(price);
-        if (timespec_cmp(&price_t, &helper->t) < 0)
-        {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
-        {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-        }
-        node = node->next;
+        /* The last price is later than given time, add it */
+        price = g_ptr_array_index (series, pos - 1);
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
+        return TRUE;
+    }
+    /* If there is a previous price add it to the results. */
+    if (pos > 0)
+    {
+        price = g_ptr_array_index (series, pos - 1);
+        gnc_price_ref(price);
+        *helper->list = g_list_prepend(*helper->list, price);
     }
+    /* Add the first price before the desired time */
+    price = g_ptr_array_index (series, pos);
+    gnc_price_ref(price);
+    *helper->list = g_list_prepend(*helper->list, price);
 
     return TRUE;
 }
@@ -1799,8 +1940,8 @@ gnc_pricedb_lookup_nearest_in_time_any_currency(GNCPriceDB *db,
     if (!db || !commodity) return NULL;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency,
-                                       &helper);
+    pricedb_series_traversal(db, price_series_scan_any_currency,
+                             &helper);
     prices = g_list_sort(prices, compare_prices_by_date);
     result = nearest_to(prices, commodity, t);
     gnc_price_list_destroy(prices);
@@ -1820,8 +1961,8 @@ gnc_pricedb_lookup_latest_before_any_currency(GNCPriceDB *db,
     if (!db || !commodity) return NULL;
     ENTER ("db=%p commodity=%p", db, commodity);
 
-    pricedb_pricelist_traversal(db, price_list_scan_any_currency,
-                                       &helper);
+    pricedb_series_traversal(db, price_series_scan_any_currency,
+                             &helper);
     prices = g_list_sort(prices, compare_prices_by_date);
     result = latest_before(prices, commodity, t);
     gnc_price_list_destroy(prices);
@@ -1838,7 +1979,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    GPtrArray *series;
     GHashTable *currency_hash;
     gint size;
 
@@ -1853,8 +1994,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (series)
         {
             LEAVE("yes");
             return TRUE;
@@ -1898,9 +2039,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
-    
-    *result += g_list_length(price_list);
+    GPtrArray *series = value;
+
+    *result += series->len;
 }
 
 int
@@ -1949,60 +2090,66 @@ gnc_pricedb_nth_price (GNCPriceDB *db,
             g_hash_table_iter_init(&iter, currency_hash);
             if (g_hash_table_iter_next(&iter, &key, &value))
             {
-                PriceList *prices = value;
-                result = g_list_nth_data(prices, n);
+                GPtrArray *series = value;
+                if ((guint) n < series->len)
+                    result = g_ptr_array_index (series, n);
             }
         }
         else if (num_currencies > 1)
         {
             /* Prices for multiple currencies, must find the nth entry in the
                merged currency list. */
-            GList **price_array = (GList **)g_new(gpointer, num_currencies);
-            GList **next_list;
-            int i, j;
+            GPtrArray **series = g_new(GPtrArray *, num_currencies);
+            guint *next_index = g_new(guint, num_currencies);
+            int i, j, next;
             GHashTableIter iter;
             gpointer key, value;
-            
-            /* Build an array of all the currencies this commodity has prices for */
+
+            /* Build an array of all the currencies this commodity has prices
+               for, and of the next price to look at in each */
             for (i = 0, g_hash_table_iter_init(&iter, currency_hash);
                  g_hash_table_iter_next(&iter, &key, &value) && i < num_currencies;
                  i++)
             {
-                price_array[i] = value;
+                series[i] = value;
+                next_index[i] = 0;
             }
-            
+
             /* Iterate n times to get the nth price, each time finding the currency
                with the latest price */
             for (i = 0; i <= n; i++)
             {
-                next_list = NULL;
+                next = -1;
                 for (j = 0; j < num_currencies; j++)
                 {
                     /* Save this entry if it's the first one or later than
                        the saved one. */
-                    if (price_array[j] != NULL &&
-                        (next_list == NULL || *next_list == NULL ||
-                        compare_prices_by_date((*next_list)->data, (price_array[j])->data) > 0))
+                    if (next_index[j] < series[j]->len &&
+                        (next < 0 ||
+                         compare_prices_by_date(
+                             g_ptr_array_index (series[next], next_index[next]),
+                             g_ptr_array_index (series[j], next_index[j])) > 0))
                     {
-                        next_list = &price_array[j];
+                        next = j;
                     }
                 }
-                /* next_list points to the list with the latest price unless all
-                   the lists are empty */
-                if (next_list && *next_list)
+                /* next is the currency with the latest price unless all
+                   the series are used up */
+                if (next >= 0)
                 {
-                    result = (*next_list)->data;
-                    *next_list = (*next_list)->next;
+                    result = g_ptr_array_index (series[next], next_index[next]);
+                    next_index[next]++;
                 }
                 else
                 {
-                    /* all the lists are empty, "n" is greater than the number
-                       of prices for this commodity. */
+                    /* all the series are used up, "n" is greater than the
+                       number of prices for this commodity. */
                     result = NULL;
                     break;
                 }
             }
-            g_free(price_array);
+            g_free(next_index);
+            g_free(series);
         }
     }
 
@@ -2025,29 +2172,29 @@ gnc_pricedb_lookup_at_time(GNCPriceDB *db,
                            const gnc_commodity *currency,
                            Timespec t)
 {
-    GList *price_list;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    GPtrArray *series[2];
+    GNCPrice *result = NULL;
+    guint n, i;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    n = pricedb_get_series (db, c, currency, series);
+    for (i = 0; i < n; i++)
     {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
+        guint pos = price_series_search (series[i], t, TRUE);
+        GNCPrice *p;
+        Timespec price_time;
+
+        if (pos == series[i]->len)
+            continue;
+        p = g_ptr_array_index (series[i], pos);
+        price_time = gnc_price_get_time(p);
         if (timespec_equal(&price_time, &t))
-        {
-            gnc_price_ref(p);
-            g_list_free (price_list);
-            return p;
-        }
-        item = item->next;
+            result = price_later (result, p);
     }
-    g_list_free (price_list);
+    gnc_price_ref(result);
     LEAVE (" ");
-    return NULL;
+    return result;
 }
 
 static GNCPrice *
@@ -2057,36 +2204,32 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        Timespec t,
                        gboolean sameday)
 {
-    GList *price_list;
+    GPtrArray *series[2];
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
-    GHashTable *currency_hash;
+    guint n, i;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
+    n = pricedb_get_series (db, c, currency, series);
+    if (!n) return NULL;
 
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
+    /* current_price is the earliest price after the one we want and
+       next_price the latest one not after it. */
+    for (i = 0; i < n; i++)
     {
-        GNCPrice *p = item->data;
-        Timespec price_time = gnc_price_get_time(p);
-        if (timespec_cmp(&price_time, &t) <= 0)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
+        guint pos = price_series_search (series[i], t, TRUE);
+        if (pos < series[i]->len)
+            next_price = price_later (next_price,
+                                      g_ptr_array_index (series[i], pos));
+        if (pos > 0)
+            current_price = price_earlier (current_price,
+                                           g_ptr_array_index (series[i], pos - 1));
     }
+    /* default answer */
+    if (!current_price)
+        current_price = next_price;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2158,7 +2301,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2178,33 +2320,38 @@ gnc_pricedb_lookup_latest_before (GNCPriceDB *db,
                                   gnc_commodity *currency,
                                   Timespec t)
 {
-    GList *price_list;
+    GPtrArray *series[2];
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    GHashTable *currency_hash;
-    Timespec price_time;
+    guint n, i;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
+    n = pricedb_get_series (db, c, currency, series);
+    for (i = 0; i < n; i++)
     {
-        price_time = gnc_price_get_time (item->data);
-        if (timespec_cmp(&price_time, &t) <= 0)
-            current_price = item->data;
-        item = item->next;
+        guint pos = price_series_search (series[i], t, TRUE);
+        if (pos < series[i]->len)
+            current_price = price_later (current_price,
+                                         g_ptr_array_index (series[i], pos));
     }
-    while (timespec_cmp(&price_time, &t) > 0 && item);
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
 
+static gnc_numeric
+convert_balance_direct (gnc_numeric bal, const gnc_commodity *from,
+                        const gnc_commodity *to, GNCPrice *price)
+{
+    if (gnc_price_get_commodity(price) == from)
+        return gnc_numeric_mul (bal, gnc_price_get_value (price),
+                                gnc_commodity_get_fraction (to),
+                                GNC_HOW_RND_ROUND);
+    return gnc_numeric_div (bal, gnc_price_get_value (price),
+                            gnc_commodity_get_fraction (to),
+                            GNC_HOW_RND_ROUND);
+}
+
 static gnc_numeric
 direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
                            const gnc_commodity *from, const gnc_commodity *to,
@@ -2222,14 +2369,7 @@ direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
         price = gnc_pricedb_lookup_latest(db, from, to);
     if (price == NULL)
         return retval;
-    if (gnc_price_get_commodity(price) == from)
-        retval = gnc_numeric_mul (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
-    else
-        retval = gnc_numeric_div (bal, gnc_price_get_value (price),
-                                  gnc_commodity_get_fraction (to),
-                                  GNC_HOW_RND_ROUND);
+    retval = convert_balance_direct (bal, from, to, price);
     gnc_price_unref (price);
     return retval;
 
@@ -2310,18 +2450,12 @@ convert_balance(gnc_numeric bal, const gnc_commodity *from,
                            fraction, GNC_HOW_RND_ROUND);
 
 }
-static gnc_numeric
-indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
-                             const gnc_commodity *from, const gnc_commodity *to,
-                             Timespec *t )
+static PriceTuple
+lookup_common_prices (GNCPriceDB *db, const gnc_commodity *from,
+                      const gnc_commodity *to, Timespec *t)
 {
     GList *from_prices = NULL, *to_prices = NULL;
-    PriceTuple tuple;
-    gnc_numeric zero = gnc_numeric_zero();
-    if (from == NULL || to == NULL)
-        return zero;
-    if (gnc_numeric_zero_p(bal))
-        return zero;
+    PriceTuple tuple = {NULL, NULL};
     if (t == NULL)
     {
         from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
@@ -2338,13 +2472,32 @@ indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
             to_prices = gnc_pricedb_lookup_nearest_in_time_any_currency(db,
                                                                     to, *t);
     }
-    if (from_prices == NULL || to_prices == NULL)
-        return zero;
-    tuple = extract_common_prices(from_prices, to_prices);
+    if (from_prices != NULL && to_prices != NULL)
+        tuple = extract_common_prices(from_prices, to_prices);
     gnc_price_list_destroy(from_prices);
     gnc_price_list_destroy(to_prices);
+    return tuple;
+}
+
+static gnc_numeric
+indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
+                             const gnc_commodity *from, const gnc_commodity *to,
+                             Timespec *t )
+{
+    PriceTuple tuple;
+    gnc_numeric zero = gnc_numeric_zero();
+    if (from == NULL || to == NULL)
+        return zero;
+    if (gnc_numeric_zero_p(bal))
+        return zero;
+    tuple = lookup_common_prices (db, from, to, t);
     if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
+    {
+        gnc_numeric retval = convert_balance(bal, from, to, tuple);
+        gnc_price_unref (tuple.from);
+        gnc_price_unref (tuple.to);
+        return retval;
+    }
     return zero;
 }
 
@@ -2384,25 +2537,243 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
         const gnc_commodity *balance_currency,
         const gnc_commodity *new_currency,
         Timespec t)
+{
+    if (gnc_numeric_zero_p (balance) ||
+        gnc_commodity_equiv (balance_currency, new_currency))
+        return balance;
+    if (!pdb || !balance_currency || !new_currency)
+        return gnc_numeric_zero ();
+
+    /* Look for a direct price and, if there's none, try if we find a
+     * price in another currency and convert in two stages.  Reports
+     * ask for the same conversion over and over, so remember which
+     * prices these are. */
+    return gnc_price_conversion_convert (
+               pricedb_cached_conversion (pdb, balance_currency, new_currency, t),
+               balance);
+}
+
+struct gnc_price_conversion_s
+{
+    GNCPriceDB *db;
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    Timespec t;
+    gboolean direct_looked_up;
+    GNCPrice *direct;
+    gboolean indirect_looked_up;
+    PriceTuple indirect;
+};
+
+GNCPriceConversion *
+gnc_price_conversion_new (GNCPriceDB *pdb,
+                          const gnc_commodity *balance_currency,
+                          const gnc_commodity *new_currency,
+                          Timespec t)
+{
+    GNCPriceConversion *conv;
+
+    g_return_val_if_fail (pdb && balance_currency && new_currency, NULL);
+
+    conv = g_new0 (GNCPriceConversion, 1);
+    conv->db = pdb;
+    conv->from = balance_currency;
+    conv->to = new_currency;
+    conv->t = t;
+    return conv;
+}
+
+void
+gnc_price_conversion_destroy (GNCPriceConversion *conv)
+{
+    if (!conv) return;
+    if (conv->direct)
+        gnc_price_unref (conv->direct);
+    if (conv->indirect.from)
+    {
+        gnc_price_unref (conv->indirect.from);
+        gnc_price_unref (conv->indirect.to);
+    }
+    g_free (conv);
+}
+
+/* Same steps as gnc_pricedb_convert_balance_nearest_price, except that
+ * the prices are only looked up the first time they are needed. */
+gnc_numeric
+gnc_price_conversion_convert (GNCPriceConversion *conv, gnc_numeric balance)
 {
     gnc_numeric new_value;
 
+    g_return_val_if_fail (conv, gnc_numeric_zero ());
+
     if (gnc_numeric_zero_p (balance) ||
-        gnc_commodity_equiv (balance_currency, new_currency))
+        gnc_commodity_equiv (conv->from, conv->to))
         return balance;
 
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, &t);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
+    if (!conv->direct_looked_up)
+    {
+        conv->direct = gnc_pricedb_lookup_nearest_in_time (conv->db, conv->from,
+                                                           conv->to, conv->t);
+        conv->direct_looked_up = TRUE;
+    }
+    if (conv->direct)
+    {
+        new_value = convert_balance_direct (balance, conv->from, conv->to,
+                                            conv->direct);
+        if (!gnc_numeric_zero_p (new_value))
+            return new_value;
+    }
 
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, &t);
+    if (!conv->indirect_looked_up)
+    {
+        conv->indirect = lookup_common_prices (conv->db, conv->from, conv->to,
+                                               &conv->t);
+        conv->indirect_looked_up = TRUE;
+    }
+    if (conv->indirect.from)
+        return convert_balance (balance, conv->from, conv->to, conv->indirect);
+    return gnc_numeric_zero ();
+}
+
+/* The conversion cache.  The entries are keyed on the exact time
+ * rather than on its day, because the nearest price can change within
+ * a day.  A conversion only depends on the prices of its two
+ * commodities, so adding or removing a price drops just the entries
+ * involving the price's commodity or currency. */
+#define PRICEDB_CONVERSION_CACHE_SIZE 1024
+
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    Timespec t;
+    GNCPriceConversion *conv;
+} ConversionCacheEntry;
+
+static guint
+conversion_cache_entry_hash (gconstpointer key)
+{
+    const ConversionCacheEntry *entry = key;
+    return g_direct_hash (entry->from) ^ (g_direct_hash (entry->to) * 31) ^
+           (guint) entry->t.tv_sec ^ (guint) (entry->t.tv_sec >> 32) ^
+           (guint) entry->t.tv_nsec;
+}
+
+static gboolean
+conversion_cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+    const ConversionCacheEntry *entry_a = a, *entry_b = b;
+    return entry_a->from == entry_b->from && entry_a->to == entry_b->to &&
+           timespec_equal (&entry_a->t, &entry_b->t);
+}
+
+static void
+conversion_cache_drop (GNCPriceDB *db, GList *link)
+{
+    ConversionCacheEntry *entry = link->data;
+
+    g_hash_table_remove (db->conversion_cache, entry);
+    g_queue_delete_link (db->conversion_lru, link);
+    gnc_price_conversion_destroy (entry->conv);
+    g_free (entry);
+}
+
+static GNCPriceConversion *
+pricedb_cached_conversion (GNCPriceDB *db, const gnc_commodity *from,
+                           const gnc_commodity *to, Timespec t)
+{
+    ConversionCacheEntry probe = { from, to, t, NULL };
+    ConversionCacheEntry *entry;
+    GList *link;
+
+    if (!db->conversion_cache)
+    {
+        db->conversion_cache = g_hash_table_new (conversion_cache_entry_hash,
+                                                 conversion_cache_entry_equal);
+        db->conversion_lru = g_queue_new ();
+    }
+
+    link = g_hash_table_lookup (db->conversion_cache, &probe);
+    if (link)
+    {
+        db->conversion_hits++;
+        g_queue_unlink (db->conversion_lru, link);
+        g_queue_push_head_link (db->conversion_lru, link);
+        entry = link->data;
+        return entry->conv;
+    }
+
+    db->conversion_misses++;
+    if (g_queue_get_length (db->conversion_lru) >= PRICEDB_CONVERSION_CACHE_SIZE)
+        conversion_cache_drop (db, g_queue_peek_tail_link (db->conversion_lru));
+
+    entry = g_new (ConversionCacheEntry, 1);
+    *entry = probe;
+    entry->conv = gnc_price_conversion_new (db, from, to, t);
+    g_queue_push_head (db->conversion_lru, entry);
+    g_hash_table_insert (db->conversion_cache, entry,
+                         g_queue_peek_head_link (db->conversion_lru));
+    return entry->conv;
+}
+
+static void
+pricedb_conversion_cache_invalidate (GNCPriceDB *db, GNCPrice *p)
+{
+    const gnc_commodity *commodity = gnc_price_get_commodity (p);
+    const gnc_commodity *currency = gnc_price_get_currency (p);
+    GList *link, *next;
+
+    if (!db->conversion_lru)
+        return;
+
+    for (link = db->conversion_lru->head; link; link = next)
+    {
+        ConversionCacheEntry *entry = link->data;
+        next = link->next;
+        if (entry->from == commodity || entry->from == currency ||
+            entry->to == commodity || entry->to == currency)
+            conversion_cache_drop (db, link);
+    }
+}
+
+static void
+pricedb_conversion_cache_destroy (GNCPriceDB *db)
+{
+    if (!db->conversion_lru)
+        return;
+
+    PINFO ("conversion cache: %" G_GUINT64_FORMAT " hits, %"
+           G_GUINT64_FORMAT " misses", db->conversion_hits,
+           db->conversion_misses);
+    while (!g_queue_is_empty (db->conversion_lru))
+        conversion_cache_drop (db, g_queue_peek_head_link (db->conversion_lru));
+    g_queue_free (db->conversion_lru);
+    g_hash_table_destroy (db->conversion_cache);
+    db->conversion_lru = NULL;
+    db->conversion_cache = NULL;
+}
+
+guint64
+gnc_pricedb_get_conversion_cache_hits (GNCPriceDB *db)
+{
+    return db ? db->conversion_hits : 0;
+}
+
+guint64
+gnc_pricedb_get_conversion_cache_misses (GNCPriceDB *db)
+{
+    return db ? db->conversion_misses : 0;
+}
+
+void
+gnc_pricedb_reset_conversion_cache_stats (GNCPriceDB *db)
+{
+    if (!db) return;
+    PINFO ("conversion cache: %" G_GUINT64_FORMAT " hits, %"
+           G_GUINT64_FORMAT " misses", db->conversion_hits,
+           db->conversion_misses);
+    db->conversion_hits = 0;
+    db->conversion_misses = 0;
 }
 
 
@@ -2420,16 +2791,15 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
+    guint i;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
 
     /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    for (i = 0; foreach_data->ok && i < series->len; i++)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index (series, i);
         foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2462,38 +2832,38 @@ unstable_price_traversal(GNCPriceDB *db,
     return foreach_data.ok;
 }
 
-/* foreach_pricelist */
+/* foreach_series */
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(GPtrArray *series, gpointer user_data);
     gpointer user_data;
-} GNCPriceListForeachData;
+} GNCPriceSeriesForeachData;
 
 static void
-pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
+pricedb_series_foreach_series(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
+    GPtrArray *series = (GPtrArray *) val;
+    GNCPriceSeriesForeachData *foreach_data = (GNCPriceSeriesForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(series, foreach_data->user_data);
     }
 }
 
 static void
-pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
+pricedb_series_foreach_currencies_hash(gpointer key, gpointer val, gpointer user_data)
 {
     GHashTable *currencies_hash = (GHashTable *) val;
-    g_hash_table_foreach(currencies_hash, pricedb_pricelist_foreach_pricelist, user_data);
+    g_hash_table_foreach(currencies_hash, pricedb_series_foreach_series, user_data);
 }
 
 static gboolean
-pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+pricedb_series_traversal(GNCPriceDB *db,
+                         gboolean (*f)(GPtrArray *series, gpointer user_data),
                          gpointer user_data)
 {
-    GNCPriceListForeachData foreach_data;
+    GNCPriceSeriesForeachData foreach_data;
 
     if (!db || !f) return FALSE;
     foreach_data.ok = TRUE;
@@ -2504,7 +2874,7 @@ pricedb_pricelist_traversal(GNCPriceDB *db,
         return FALSE;
     }
     g_hash_table_foreach(db->commodity_hash,
-                         pricedb_pricelist_foreach_currencies_hash,
+                         pricedb_series_foreach_currencies_hash,
                          &foreach_data);
 
     return foreach_data.ok;
@@ -2562,12 +2932,12 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
+            GPtrArray *series = (GPtrArray *) pricelist_entry->value;
+            guint k;
 
-            for (node = (GList *) price_list; node; node = node->next)
+            for (k = 0; k < series->len; k++)
             {
-                GNCPrice *price = (GNCPrice *) node->data;
+                GNCPrice *price = (GNCPrice *) g_ptr_array_index (series, k);
 
                 /* stop traversal when f returns FALSE */
                 if (FALSE == ok) break;
@@ -2787,15 +3157,14 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
+    guint i;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
 
-    while (node)
+    for (i = 0; i < series->len; i++)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index (series, i);
         foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
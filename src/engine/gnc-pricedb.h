@@ -566,6 +566,51 @@ gnc_pricedb_convert_balance_nearest_price(GNCPriceDB *pdb,
                                           const gnc_commodity *new_currency,
                                           Timespec t);
 
+/** A reusable conversion between two commodities at a fixed time.  It
+ * converts balances exactly as gnc_pricedb_convert_balance_nearest_price()
+ * does, but looks the prices up only once, on first use, so that callers
+ * converting many balances at the same date don't query the pricedb for
+ * each of them.  The conversion must not outlive the pricedb and doesn't
+ * see prices added after its first use.
+ */
+typedef struct gnc_price_conversion_s GNCPriceConversion;
+
+/** @brief Create a conversion from balance_currency to new_currency using
+ * the prices nearest to t.
+ * @return A new conversion, to be freed with gnc_price_conversion_destroy().
+ */
+GNCPriceConversion *
+gnc_price_conversion_new (GNCPriceDB *pdb,
+                          const gnc_commodity *balance_currency,
+                          const gnc_commodity *new_currency,
+                          Timespec t);
+
+/** @brief Free a conversion and release the prices it holds. */
+void gnc_price_conversion_destroy (GNCPriceConversion *conv);
+
+/** @brief Convert a balance with a conversion.
+ * @return The same value gnc_pricedb_convert_balance_nearest_price() would
+ * return for the conversion's commodities and time.
+ */
+gnc_numeric
+gnc_price_conversion_convert (GNCPriceConversion *conv, gnc_numeric balance);
+
+/** @brief The number of gnc_pricedb_convert_balance_nearest_price()
+ * calls that found the prices to use in the pricedb's conversion cache.
+ *
+ * The cache remembers the prices used for the most recent conversions
+ * between two commodities at a given time, and forgets them when a
+ * price for either commodity is added or removed.
+ */
+guint64 gnc_pricedb_get_conversion_cache_hits (GNCPriceDB *db);
+
+/** @brief The number of gnc_pricedb_convert_balance_nearest_price()
+ * calls that had to look their prices up. */
+guint64 gnc_pricedb_get_conversion_cache_misses (GNCPriceDB *db);
+
+/** @brief Log the conversion cache counters and set them back to zero. */
+void gnc_pricedb_reset_conversion_cache_stats (GNCPriceDB *db);
+
 typedef gboolean (*GncPriceForeachFunc)(GNCPrice *p, gpointer user_data);
 
 /** @brief Call a GncPriceForeachFunction once for each price in db, until the
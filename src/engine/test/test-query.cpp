@@ -67,12 +67,98 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+/* The splits of an account posted within a range of dates come from
+ * the account's split index; check them against a walk of the split
+ * list. */
+static void
+test_account_date_query (Account *acc, QofBook *book)
+{
+    GList *splits = xaccAccountGetSplitList (acc);
+    guint n_splits = g_list_length (splits);
+    time64 start, end;
+    GList *node, *list;
+    guint expected = 0;
+    QofQuery *q;
+
+    if (n_splits == 0)
+        return;
+    start = xaccTransGetDate (xaccSplitGetParent (
+                                  static_cast<Split*>(g_list_nth_data (splits, n_splits / 3))));
+    end = xaccTransGetDate (xaccSplitGetParent (
+                                static_cast<Split*>(g_list_nth_data (splits, 2 * n_splits / 3))));
+    for (node = splits; node; node = node->next)
+    {
+        time64 date = xaccTransGetDate (xaccSplitGetParent (static_cast<Split*>(node->data)));
+        if (date >= start && date <= end)
+            expected++;
+    }
+    /* The list is sorted, so the count the planner uses is exact. */
+    do_test (xaccAccountCountSplitsInDateRange (acc, start, end) == expected,
+             "split count in date range");
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    xaccQueryAddDateMatchTT (q, TRUE, start, TRUE, end, QOF_QUERY_AND);
+    list = qof_query_run (q);
+    if (g_list_length (list) != expected)
+    {
+        failure_args ("account date query", __FILE__, __LINE__,
+                      "number of matching splits %d not %d",
+                      g_list_length (list), expected);
+        qof_query_destroy (q);
+        return;
+    }
+    for (node = list; node; node = node->next)
+    {
+        if (xaccSplitGetAccount (static_cast<Split*>(node->data)) != acc)
+        {
+            failure ("split from the wrong account");
+            break;
+        }
+    }
+    qof_query_destroy (q);
+}
+
+/* A split in an open transaction isn't in its account's split list
+ * yet; the query must find it all the same. */
+static void
+test_uncommitted_split_query (Account *acc, QofBook *book)
+{
+    Transaction *trans;
+    Split *split;
+    QofQuery *q;
+    GList *list;
+
+    trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (acc));
+    xaccTransSetDatePostedSecs (trans, gnc_time (NULL));
+    split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+    list = qof_query_run (q);
+    if (!g_list_find (list, split))
+        failure ("uncommitted split not found");
+    else
+        success ("found uncommitted split");
+    qof_query_destroy (q);
+
+    xaccTransDestroy (trans);
+    xaccTransCommitEdit (trans);
+}
+
 static void
 run_test (void)
 {
     QofSession *session;
     Account *root;
     QofBook *book;
+    GList *accounts, *node;
 
     session = get_random_session ();
     book = qof_session_get_book (session);
@@ -82,6 +168,13 @@ run_test (void)
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
 
+    accounts = gnc_account_get_descendants (root);
+    for (node = accounts; node; node = node->next)
+        test_account_date_query (static_cast<Account*>(node->data), book);
+    if (accounts)
+        test_uncommitted_split_query (static_cast<Account*>(accounts->data), book);
+    g_list_free (accounts);
+
     qof_session_end (session);
 }
 
@@ -325,6 +325,61 @@ static void test_some()
     test_specific(PERIOD_DAY, 7,    4, 1, 2000,    4, 8, 2000,  4, 15, 2000);
 }
 
+/* recurrenceListInstances() has to give the same dates as stepping
+   through them with recurrenceListNextInstance(). */
+static void test_list_instances()
+{
+    Recurrence r1, r2;
+    GList *rlist;
+    GDate start, ref, end, next;
+    GArray *dates;
+    PeriodType pt;
+    WeekendAdjust wadj;
+    guint16 mult;
+    gint i, j;
+
+    dates = g_array_new(FALSE, FALSE, sizeof(GDate));
+    for (i = 0; i < 2000; i++)
+    {
+        pt = get_random_int_in_range(PERIOD_ONCE, NUM_PERIOD_TYPES - 1);
+        wadj = get_random_int_in_range(WEEKEND_ADJ_NONE, NUM_WEEKEND_ADJS - 1);
+        mult = get_random_int_in_range(1, NUM_MULT_TO_TEST);
+        g_date_set_julian(&start, get_random_int_in_range(JULIAN_START, JULIAN_START + 3650));
+        recurrenceSet(&r1, mult, pt, &start, wadj);
+        rlist = g_list_append(NULL, &r1);
+        if (i % 2)
+        {
+            g_date_add_days(&start, get_random_int_in_range(1, 40));
+            recurrenceSet(&r2, 1, PERIOD_MONTH, &start,
+                          get_random_int_in_range(WEEKEND_ADJ_NONE, NUM_WEEKEND_ADJS - 1));
+            rlist = g_list_append(rlist, &r2);
+        }
+
+        g_date_set_julian(&ref, get_random_int_in_range(JULIAN_START - 100, JULIAN_START + 3650));
+        end = ref;
+        g_date_add_days(&end, get_random_int_in_range(0, 3650));
+
+        g_array_set_size(dates, 0);
+        recurrenceListInstances(rlist, &ref, &end, 0, dates);
+
+        next = ref;
+        for (j = 0; ; j++)
+        {
+            GDate cur = next;
+            recurrenceListNextInstance(rlist, &cur, &next);
+            if (!g_date_valid(&next) || g_date_compare(&next, &end) > 0)
+                break;
+            if (!do_test(j < (gint)dates->len, "too few instances"))
+                break;
+            if (!test_equal(&next, &g_array_index(dates, GDate, j)))
+                break;
+        }
+        do_test(j == (gint)dates->len, "instance count");
+        g_list_free(rlist);
+    }
+    g_array_free(dates, TRUE);
+}
+
 static void test_use()
 {
     Recurrence *r;
@@ -343,6 +398,8 @@ static void test_main()
 
     test_some();
 
+    test_list_instances();
+
     test_all();
 
     qof_book_destroy (book);
@@ -0,0 +1,373 @@
+/********************************************************************\
+ * test-translog.c -- check the binary transaction log against the  *
+ *                    text one, and replaying both                  *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "TransLog.h"
+#include "qofinstance-p.h"
+#include "test-stuff.h"
+
+/* Returns the one file in dir whose name starts with prefix */
+static gchar *
+find_log (const gchar *dir, const gchar *prefix)
+{
+    GDir *d = g_dir_open (dir, 0, NULL);
+    const gchar *name;
+    gchar *found = NULL;
+
+    while (d && (name = g_dir_read_name (d)))
+        if (g_str_has_prefix (name, prefix))
+            found = g_build_filename (dir, name, NULL);
+    if (d) g_dir_close (d);
+    return found;
+}
+
+/* Reads file, blanking out the time_now column, which depends on when
+ * each log was written. */
+static gchar *
+read_log (FILE *file)
+{
+    GString *out = g_string_new (NULL);
+    char buf[1024];
+
+    rewind (file);
+    while (fgets (buf, sizeof buf, file))
+    {
+        gchar **fields = g_strsplit (buf, "\t", -1);
+        gchar *line;
+
+        if (g_strv_length (fields) > 4 && strcmp (fields[0], "mod") != 0)
+        {
+            g_free (fields[3]);
+            fields[3] = g_strdup ("");
+        }
+        line = g_strjoinv ("\t", fields);
+        g_string_append (out, line);
+        g_free (line);
+        g_strfreev (fields);
+    }
+    return g_string_free (out, FALSE);
+}
+
+static gint
+count_records (const gchar *log)
+{
+    gint n = 0;
+    const gchar *p = log;
+
+    while ((p = strstr (p, "===== END\n")))
+    {
+        n++;
+        p++;
+    }
+    return n;
+}
+
+static void
+write_logs (Transaction *trans, const gchar *base, XaccLogFormat format)
+{
+    xaccLogSetFormat (format);
+    xaccLogSetBaseName (base);
+    xaccLogEnable ();
+    xaccOpenLog ();
+    xaccTransWriteLog (trans, 'B');
+    xaccTransWriteLog (trans, 'C');
+    xaccCloseLog ();
+    xaccLogDisable ();
+}
+
+static void
+test_binary_log (QofBook *book, const gchar *dir)
+{
+    Account *acc;
+    Transaction *trans;
+    Split *split;
+    gchar *base, *text_name, *bin_name, *text, *converted, *truncated;
+    gchar *contents;
+    gsize length;
+    FILE *file;
+
+    acc = xaccMallocAccount (book);
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, "Checking");
+    xaccAccountCommitEdit (acc);
+
+    trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetNum (trans, "1001");
+    xaccTransSetDescription (trans, "Groceries");
+    xaccTransSetNotes (trans, "Weekly shopping");
+    xaccTransSetDatePostedSecs (trans, 1000000000);
+
+    split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetMemo (split, "Milk");
+    xaccSplitSetAction (split, "Buy");
+    xaccSplitSetAmount (split, gnc_numeric_create (-1234, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (-1234, 100));
+
+    /* No account and empty strings */
+    split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAmount (split, gnc_numeric_create (1234, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (1234, 100));
+
+    base = g_build_filename (dir, "text", NULL);
+    write_logs (trans, base, XACC_LOG_TEXT);
+    g_free (base);
+    base = g_build_filename (dir, "binary", NULL);
+    write_logs (trans, base, XACC_LOG_BINARY);
+    g_free (base);
+
+    text_name = find_log (dir, "text.");
+    bin_name = find_log (dir, "binary.");
+    do_test (text_name != NULL && bin_name != NULL, "both logs written");
+    if (!text_name || !bin_name)
+        return;
+
+    do_test (!xaccLogFileIsBinary (text_name), "text log isn't binary");
+    do_test (xaccLogFileIsBinary (bin_name), "binary log is binary");
+
+    file = g_fopen (text_name, "r");
+    text = read_log (file);
+    fclose (file);
+
+    file = tmpfile ();
+    do_test (xaccLogBinaryToText (bin_name, file), "binary log converts");
+    converted = read_log (file);
+    fclose (file);
+
+    do_test (count_records (text) == 2, "text log has both records");
+    do_test (strcmp (text, converted) == 0, "converted log matches text log");
+
+    /* A crash in the middle of the second record loses just that one */
+    g_file_get_contents (bin_name, &contents, &length, NULL);
+    g_file_set_contents (bin_name, contents, length - 10, NULL);
+    file = tmpfile ();
+    xaccLogBinaryToText (bin_name, file);
+    truncated = read_log (file);
+    fclose (file);
+    do_test (count_records (truncated) == 1, "truncated log keeps first record");
+
+    g_remove (text_name);
+    g_remove (bin_name);
+    g_free (contents);
+    g_free (truncated);
+    g_free (converted);
+    g_free (text);
+    g_free (bin_name);
+    g_free (text_name);
+
+    xaccTransDestroy (trans);
+    xaccTransCommitEdit (trans);
+}
+
+static gnc_commodity *
+make_usd (QofBook *book)
+{
+    gnc_commodity *usd = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                            "USD", "840", 100);
+    return gnc_commodity_table_insert (gnc_commodity_table_get_table (book), usd);
+}
+
+static Account *
+make_account (QofBook *book, const char *name, const GncGUID *guid)
+{
+    Account *acc = xaccMallocAccount (book);
+
+    xaccAccountBeginEdit (acc);
+    if (guid)
+        qof_instance_set_guid (acc, guid);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetCommodity (acc, make_usd (book));
+    gnc_account_append_child (gnc_book_get_root_account (book), acc);
+    xaccAccountCommitEdit (acc);
+    return acc;
+}
+
+static Transaction *
+make_trans (Account *from, Account *to, const char *description, gint64 cents)
+{
+    QofBook *book = qof_instance_get_book (from);
+    Transaction *trans = xaccMallocTransaction (book);
+    Split *split;
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (from));
+    xaccTransSetDescription (trans, description);
+    xaccTransSetDatePostedSecs (trans, 1000000000);
+
+    split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, from);
+    xaccSplitSetAmount (split, gnc_numeric_create (-cents, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (-cents, 100));
+
+    split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, to);
+    xaccSplitSetAmount (split, gnc_numeric_create (cents, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (cents, 100));
+
+    xaccTransCommitEdit (trans);
+    return trans;
+}
+
+typedef struct
+{
+    QofBook *other;
+    gint differ;
+} CompareData;
+
+static void
+compare_trans (QofInstance *inst, gpointer data)
+{
+    CompareData *cd = data;
+    Transaction *other = xaccTransLookup (qof_instance_get_guid (inst), cd->other);
+
+    if (!xaccTransEqual (GNC_TRANSACTION (inst), other, TRUE, TRUE, FALSE, FALSE))
+        cd->differ++;
+}
+
+/* The book saved before the edits is stood in for by a second book with
+ * the same accounts; replaying the log of the edits into it must give
+ * the book as it was when the edits were done. */
+static void
+test_replay (const gchar *dir, XaccLogFormat format)
+{
+    QofBook *live = qof_book_new ();
+    QofBook *saved = qof_book_new ();
+    Account *checking, *groceries, *saved_checking;
+    Transaction *t1, *t2;
+    XaccLogReplayStats stats;
+    CompareData cd = { saved, 0 };
+    const gchar *prefix = format == XACC_LOG_BINARY ? "replay-bin." : "replay-text.";
+    gchar *base, *log_name;
+    GList *node;
+
+    checking = make_account (live, "Checking", NULL);
+    groceries = make_account (live, "Groceries", NULL);
+    saved_checking = make_account (saved, "Checking", xaccAccountGetGUID (checking));
+    make_account (saved, "Groceries", xaccAccountGetGUID (groceries));
+
+    base = g_build_filename (dir, prefix, NULL);
+    base[strlen (base) - 1] = '\0';
+    xaccLogSetFormat (format);
+    xaccLogSetBaseName (base);
+    g_free (base);
+    xaccLogEnable ();
+
+    t1 = make_trans (checking, groceries, "Groceries", 2500);
+    t2 = make_trans (checking, groceries, "Refunded", 1000);
+    make_trans (groceries, checking, "Refund", 500);
+
+    xaccTransBeginEdit (t1);
+    xaccTransSetDescription (t1, "Groceries and milk");
+    for (node = xaccTransGetSplitList (t1); node; node = node->next)
+    {
+        Split *split = node->data;
+        xaccSplitSetAmount (split, gnc_numeric_add (xaccSplitGetAmount (split),
+                            xaccSplitGetAmount (split), 100, GNC_HOW_RND_NEVER));
+        xaccSplitSetValue (split, xaccSplitGetAmount (split));
+        xaccSplitSetReconcile (split, CREC);
+    }
+    xaccTransCommitEdit (t1);
+
+    xaccTransBeginEdit (t2);
+    xaccTransDestroy (t2);
+    xaccTransCommitEdit (t2);
+
+    xaccCloseLog ();
+    xaccLogDisable ();
+
+    log_name = find_log (dir, prefix);
+    do_test (log_name != NULL, "replay log written");
+    if (!log_name)
+        return;
+    do_test (xaccLogFileIsBinary (log_name) == (format == XACC_LOG_BINARY),
+             "replay log has the right format");
+
+    do_test (xaccLogReplay (saved, log_name, &stats), "log replays");
+    do_test (stats.applied == 2, "last state of each transaction applied");
+    do_test (stats.skipped == 1, "delete of a transaction never saved skipped");
+    do_test (stats.superseded == 2, "earlier states superseded");
+
+    qof_collection_foreach (qof_book_get_collection (live, GNC_ID_TRANS),
+                            compare_trans, &cd);
+    do_test (cd.differ == 0, "replayed transactions match");
+    do_test (qof_collection_count (qof_book_get_collection (saved, GNC_ID_TRANS))
+             == qof_collection_count (qof_book_get_collection (live, GNC_ID_TRANS)),
+             "replay leaves no extra transactions");
+    do_test (gnc_numeric_equal (xaccAccountGetBalance (checking),
+                                xaccAccountGetBalance (saved_checking)),
+             "replayed balance matches");
+
+    do_test (xaccLogReplay (saved, log_name, &stats), "log replays again");
+    do_test (stats.applied == 0, "second replay changes nothing");
+
+    g_remove (log_name);
+    g_free (log_name);
+    qof_book_destroy (saved);
+    qof_book_destroy (live);
+}
+
+int
+main (int argc, char **argv)
+{
+    QofBook *book;
+    gchar *dir;
+
+    qof_init ();
+    if (!cashobjects_register ())
+        return 1;
+
+    xaccLogDisable ();
+    book = qof_book_new ();
+    dir = g_build_filename (g_get_tmp_dir (), "test-translog-XXXXXX", NULL);
+    if (g_mkdtemp (dir))
+    {
+        test_binary_log (book, dir);
+        test_replay (dir, XACC_LOG_TEXT);
+        test_replay (dir, XACC_LOG_BINARY);
+        g_rmdir (dir);
+    }
+    else
+        do_test (FALSE, "temporary directory");
+
+    g_free (dir);
+    qof_book_destroy (book);
+    qof_close ();
+    print_test_results ();
+    return get_rv ();
+}
@@ -32,8 +32,10 @@ extern "C"
 #include "../Account.h"
 #include "../AccountP.h"
 #include "../Split.h"
+#include "../SplitP.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
+#include "../gnc-pricedb.h"
 
 #ifdef HAVE_GLIB_2_38
 #define _Q "'"
@@ -1196,6 +1198,122 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     test_signal_free (sig3);
     test_signal_free (sig1);
 }
+static Split*
+make_dated_split (QofBook *book, time64 date)
+{
+    auto txn = xaccMallocTransaction (book);
+    auto split = xaccMallocSplit (book);
+    xaccTransBeginEdit (txn);
+    xaccTransSetDatePostedSecs (txn, date);
+    xaccSplitSetParent (split, txn);
+    /* xaccTransCommitEdit () does a bunch of scrubbing that we don't need */
+    qof_commit_edit (QOF_INSTANCE (txn));
+    return split;
+}
+
+static void
+shuffle_splits (GPtrArray *splits)
+{
+    for (guint i = splits->len; i > 1; --i)
+    {
+        guint j = g_random_int_range (0, i);
+        gpointer tmp = g_ptr_array_index (splits, i - 1);
+        g_ptr_array_index (splits, i - 1) = g_ptr_array_index (splits, j);
+        g_ptr_array_index (splits, j) = tmp;
+    }
+}
+
+static void
+check_split_list_sorted (AccountPrivate *priv, guint expected)
+{
+    GList *node, *prev = NULL;
+    guint count = 0;
+
+    g_assert_cmpint (g_sequence_get_length (priv->split_index), ==, expected);
+    g_assert_cmpuint (g_hash_table_size (priv->split_map), ==, expected);
+    for (node = priv->splits; node; prev = node, node = node->next, ++count)
+    {
+        g_assert (node->prev == prev);
+        g_assert (g_hash_table_lookup (priv->split_map, node->data));
+        if (prev)
+            g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(prev->data),
+                                             static_cast<Split*>(node->data)),
+                             <, 0);
+    }
+    g_assert_cmpuint (count, ==, expected);
+}
+
+/* The split list must stay sorted and in step with the split index
+ * whichever order splits are inserted and removed in, and also after
+ * a deferred sort. */
+static void
+test_gnc_account_split_index (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    GPtrArray *splits = g_ptr_array_new ();
+    const guint nsplits = 200;
+    time64 now = gnc_time (NULL);
+
+    for (guint i = 0; i < nsplits; ++i)
+        g_ptr_array_add (splits,
+                         make_dated_split (book, now - g_random_int_range (0, 30) * 86400));
+
+    for (guint i = 0; i < nsplits; ++i)
+        g_assert (gnc_account_insert_split (fixture->acct, static_cast<Split*>(g_ptr_array_index (splits, i))));
+    check_split_list_sorted (priv, nsplits);
+
+    shuffle_splits (splits);
+    for (guint i = 0; i < nsplits / 2; ++i)
+        g_assert (gnc_account_remove_split (fixture->acct, static_cast<Split*>(g_ptr_array_index (splits, i))));
+    check_split_list_sorted (priv, nsplits - nsplits / 2);
+
+    qof_instance_increase_editlevel (fixture->acct);
+    for (guint i = 0; i < nsplits / 2; ++i)
+        g_assert (gnc_account_insert_split (fixture->acct, static_cast<Split*>(g_ptr_array_index (splits, i))));
+    qof_instance_decrease_editlevel (fixture->acct);
+    g_assert (priv->sort_dirty);
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    g_assert (!priv->sort_dirty);
+    check_split_list_sorted (priv, nsplits);
+
+    g_ptr_array_free (splits, TRUE);
+}
+
+/* Performance test, only run with -m perf: insert a million splits
+ * in random date order and remove them again in random order. */
+static void
+test_gnc_account_insert_remove_split_perf (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    GPtrArray *splits = g_ptr_array_new ();
+    const guint nsplits = 1000000;
+    time64 now = gnc_time (NULL);
+    gdouble elapsed;
+
+    for (guint i = 0; i < nsplits; ++i)
+        g_ptr_array_add (splits,
+                         make_dated_split (book, now - g_random_int_range (0, 3650) * 86400));
+
+    qof_event_suspend ();
+    g_test_timer_start ();
+    for (guint i = 0; i < nsplits; ++i)
+        gnc_account_insert_split (fixture->acct, static_cast<Split*>(g_ptr_array_index (splits, i)));
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "inserted %u splits in %6.3f s",
+                             nsplits, elapsed);
+
+    shuffle_splits (splits);
+    g_test_timer_start ();
+    for (guint i = 0; i < nsplits; ++i)
+        gnc_account_remove_split (fixture->acct, static_cast<Split*>(g_ptr_array_index (splits, i)));
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "removed %u splits in %6.3f s",
+                             nsplits, elapsed);
+    qof_event_resume ();
+
+    g_ptr_array_free (splits, TRUE);
+}
 /* xaccAccountSortSplits
 void
 xaccAccountSortSplits (Account *acc, gboolean force)// C: 4 in 2
@@ -1350,6 +1468,165 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
 }
 
+/* Finish a split's edit the way xaccTransCommitEdit would, without
+ * the scrubbing that these bare test transactions don't need. */
+static void
+commit_split (Split *split)
+{
+    auto txn = xaccSplitGetParent (split);
+    xaccSplitCommitEdit (split);
+    qof_commit_edit (QOF_INSTANCE (txn));
+}
+
+static Split*
+add_dated_split (Account *acct, time64 date, gnc_numeric amount)
+{
+    auto book = gnc_account_get_book (acct);
+    auto txn = xaccMallocTransaction (book);
+    auto split = xaccMallocSplit (book);
+    qof_begin_edit (QOF_INSTANCE (txn));
+    xaccTransSetDatePostedSecs (txn, date);
+    xaccSplitSetParent (split, txn);
+    xaccSplitSetAccount (split, acct);
+    xaccSplitSetAmount (split, amount);
+    xaccSplitSetReconcile (split, g_random_boolean () ? CREC : NREC);
+    commit_split (split);
+    return split;
+}
+
+static Account*
+make_balance_test_account (QofBook *book)
+{
+    auto acct = xaccMallocAccount (book);
+    auto commodity = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                        "USD", "0", 100);
+    xaccAccountBeginEdit (acct);
+    xaccAccountSetCommodity (acct, commodity);
+    xaccAccountCommitEdit (acct);
+    return acct;
+}
+
+static void
+check_running_balances (AccountPrivate *priv)
+{
+    gnc_numeric bal = priv->starting_balance;
+    gnc_numeric clr_bal = priv->starting_cleared_balance;
+
+    g_assert (!priv->balance_dirty);
+    for (auto node = priv->splits; node; node = node->next)
+    {
+        auto split = static_cast<Split*>(node->data);
+        bal = gnc_numeric_add_fixed (bal, split->amount);
+        if (split->reconciled != NREC)
+            clr_bal = gnc_numeric_add_fixed (clr_bal, split->amount);
+        g_assert (gnc_numeric_eq (split->balance, bal));
+        g_assert (gnc_numeric_eq (split->cleared_balance, clr_bal));
+    }
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+}
+
+/* Editing, moving, adding and removing single splits only recomputes
+ * the running balances from the first affected split, and must leave
+ * the same balances as a full recompute would. */
+static void
+test_xaccAccountRecomputeBalance_incremental (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Account *acct = make_balance_test_account (book);
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    GPtrArray *splits = g_ptr_array_new ();
+    time64 now = gnc_time (NULL);
+
+    for (guint i = 0; i < 300; ++i)
+        g_ptr_array_add (splits, add_dated_split (acct, now - g_random_int_range (0, 365) * 86400,
+                                                  gnc_numeric_create (g_random_int_range (-10000, 10000), 100)));
+    xaccAccountSortSplits (acct, FALSE);
+    xaccAccountRecomputeBalance (acct);
+    check_running_balances (priv);
+
+    for (guint i = 0; i < 100; ++i)
+    {
+        auto split = static_cast<Split*>(g_ptr_array_index (splits, g_random_int_range (0, splits->len)));
+        auto txn = xaccSplitGetParent (split);
+        switch (g_random_int_range (0, 4))
+        {
+        case 0:
+            qof_begin_edit (QOF_INSTANCE (txn));
+            xaccSplitSetAmount (split, gnc_numeric_create (g_random_int_range (-10000, 10000), 100));
+            commit_split (split);
+            break;
+        case 1:
+            qof_begin_edit (QOF_INSTANCE (txn));
+            xaccTransSetDatePostedSecs (txn, now - g_random_int_range (0, 365) * 86400);
+            commit_split (split);
+            break;
+        case 2:
+            qof_begin_edit (QOF_INSTANCE (txn));
+            xaccSplitSetReconcile (split, split->reconciled == NREC ? CREC : NREC);
+            commit_split (split);
+            break;
+        case 3:
+            g_ptr_array_remove (splits, split);
+            g_assert (gnc_account_remove_split (acct, split));
+            g_ptr_array_add (splits, add_dated_split (acct, now - g_random_int_range (0, 365) * 86400,
+                                                      gnc_numeric_create (g_random_int_range (-10000, 10000), 100)));
+            break;
+        }
+        g_assert (!priv->sort_dirty);
+        xaccAccountSortSplits (acct, FALSE);
+        check_split_list_sorted (priv, splits->len);
+        xaccAccountRecomputeBalance (acct);
+        check_running_balances (priv);
+    }
+    g_ptr_array_free (splits, TRUE);
+}
+
+/* Performance test, only run with -m perf: compare a full recompute of
+ * a 500,000 split account with the work done after editing a single
+ * split in the middle of it. */
+static void
+test_xaccAccountRecomputeBalance_perf (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Account *acct = make_balance_test_account (book);
+    GPtrArray *splits = g_ptr_array_new ();
+    const guint nsplits = 500000;
+    time64 start = gnc_time (NULL) - nsplits * 600;
+    gdouble elapsed;
+
+    qof_event_suspend ();
+    for (guint i = 0; i < nsplits; ++i)
+        g_ptr_array_add (splits, add_dated_split (acct, start + i * 600,
+                                                  gnc_numeric_create (g_random_int_range (-10000, 10000), 100)));
+    xaccAccountSortSplits (acct, FALSE);
+    xaccAccountRecomputeBalance (acct);
+
+    g_test_timer_start ();
+    gnc_account_set_balance_dirty (acct);
+    xaccAccountRecomputeBalance (acct);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "full recompute of %u splits: %8.6f s",
+                             nsplits, elapsed);
+
+    for (guint pos = nsplits / 2; pos < nsplits; pos += nsplits / 4)
+    {
+        auto split = static_cast<Split*>(g_ptr_array_index (splits, pos));
+        g_test_timer_start ();
+        qof_begin_edit (QOF_INSTANCE (xaccSplitGetParent (split)));
+        xaccSplitSetAmount (split, gnc_numeric_create (12345, 100));
+        commit_split (split);
+        xaccAccountSortSplits (acct, FALSE);
+        xaccAccountRecomputeBalance (acct);
+        elapsed = g_test_timer_elapsed ();
+        g_test_minimized_result (elapsed, "edit of split %u of %u: %8.6f s",
+                                 pos, nsplits, elapsed);
+    }
+    qof_event_resume ();
+    check_running_balances (fixture->func->get_private (acct));
+    g_ptr_array_free (splits, TRUE);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -1953,6 +2230,241 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* The binary search must agree with a walk from the head of the split
+ * list, including on dates shared by several splits and on dates
+ * before and after all of them. */
+static void
+test_xaccAccountGetBalanceAsOfDate_search (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Account *acct = make_balance_test_account (book);
+    AccountPrivate *priv = fixture->func->get_private (acct);
+    time64 start = gnc_time (NULL) - 100 * 86400;
+
+    for (guint i = 0; i < 200; ++i)
+        add_dated_split (acct, start + g_random_int_range (0, 100) * 86400,
+                         gnc_numeric_create (g_random_int_range (-10000, 10000), 100));
+    xaccAccountSortSplits (acct, FALSE);
+    xaccAccountRecomputeBalance (acct);
+
+    for (time64 date = start - 86400; date < start + 102 * 86400; date += 43200)
+    {
+        gnc_numeric expected = gnc_numeric_zero ();
+        GList *node;
+        for (node = priv->splits; node; node = node->next)
+        {
+            auto split = static_cast<Split*>(node->data);
+            if (xaccTransGetDate (xaccSplitGetParent (split)) >= date)
+                break;
+            expected = split->balance;
+        }
+        if (!node)
+            expected = priv->balance;
+        g_assert (gnc_numeric_eq (xaccAccountGetBalanceAsOfDate (acct, date),
+                                  expected));
+    }
+}
+
+static void
+add_test_price (QofBook *book, gnc_commodity *com, gnc_commodity *cur,
+                time64 date, gnc_numeric value)
+{
+    Timespec ts = { date, 0 };
+    auto price = gnc_price_create (book);
+    gnc_price_begin_edit (price);
+    gnc_price_set_commodity (price, com);
+    gnc_price_set_currency (price, cur);
+    gnc_price_set_time (price, ts);
+    gnc_price_set_source (price, PRICE_SOURCE_USER_PRICE);
+    gnc_price_set_value (price, value);
+    gnc_price_commit_edit (price);
+    gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+    gnc_price_unref (price);
+}
+
+static Account*
+add_balance_test_child (Account *parent, gnc_commodity *commodity)
+{
+    auto acct = xaccMallocAccount (gnc_account_get_book (parent));
+    xaccAccountBeginEdit (acct);
+    xaccAccountSetCommodity (acct, commodity);
+    xaccAccountCommitEdit (acct);
+    gnc_account_append_child (parent, acct);
+    return acct;
+}
+
+/* What the batch call is meant to replace: one as-of-date lookup and
+ * conversion per account and date, summed over the subtree. */
+static gnc_numeric
+balance_as_of_date_in_currency (Account *acct, time64 date,
+                                gnc_commodity *report_commodity,
+                                gboolean include_children)
+{
+    auto balance = xaccAccountConvertBalanceToCurrencyAsOfDate (
+                       acct, xaccAccountGetBalanceAsOfDate (acct, date),
+                       xaccAccountGetCommodity (acct), report_commodity, date);
+    if (!include_children)
+        return balance;
+    auto descendants = gnc_account_get_descendants (acct);
+    for (auto node = descendants; node; node = node->next)
+        balance = gnc_numeric_add (balance,
+                                   balance_as_of_date_in_currency (
+                                       static_cast<Account*>(node->data),
+                                       date, report_commodity, FALSE),
+                                   gnc_commodity_get_fraction (report_commodity),
+                                   GNC_HOW_RND_ROUND_HALF_UP);
+    g_list_free (descendants);
+    return balance;
+}
+
+/* xaccAccountGetBalancesAsOfDatesInCurrency
+ * A tree with accounts in the report currency, in another currency
+ * priced directly against it and in a stock priced only in the other
+ * currency, so that both direct and indirect conversions happen. */
+static void
+test_xaccAccountGetBalancesAsOfDatesInCurrency (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    auto usd = gnc_commodity_new (book, "US Dollar", "CURRENCY", "USD", "840", 100);
+    auto eur = gnc_commodity_new (book, "Euro", "CURRENCY", "EUR", "978", 100);
+    auto acme = gnc_commodity_new (book, "Acme Corp", "NYSE", "ACME", "", 1000);
+    auto top = add_balance_test_child (fixture->acct, usd);
+    auto euro = add_balance_test_child (top, eur);
+    Account *leaves[] = { add_balance_test_child (euro, acme),
+                          add_balance_test_child (euro, eur),
+                          add_balance_test_child (top, usd) };
+    time64 start = gnc_time (NULL) - 100 * 86400;
+    time64 dates[12];
+    GList *accounts = NULL;
+
+    for (auto acct : leaves)
+        for (guint i = 0; i < 50; ++i)
+            add_dated_split (acct, start + g_random_int_range (0, 100) * 86400,
+                             gnc_numeric_create (g_random_int_range (-100000, 100000),
+                                                 gnc_commodity_get_fraction (xaccAccountGetCommodity (acct))));
+    for (guint i = 0; i < 10; ++i)
+    {
+        add_test_price (book, eur, usd, start + i * 10 * 86400,
+                        gnc_numeric_create (g_random_int_range (90, 130), 100));
+        add_test_price (book, acme, eur, start + i * 10 * 86400 + 3600,
+                        gnc_numeric_create (g_random_int_range (1000, 5000), 100));
+    }
+    for (guint i = 0; i < G_N_ELEMENTS (dates); ++i)
+        dates[i] = start + ((gint) i - 1) * 9 * 86400;
+
+    for (gboolean children : { FALSE, TRUE })
+    {
+        auto balances = xaccAccountGetBalancesAsOfDatesInCurrency (
+                            top, dates, G_N_ELEMENTS (dates), usd, children,
+                            &accounts);
+        g_assert_cmpint (g_list_length (accounts), ==, 5);
+        g_assert (accounts->data == top);
+        guint row = 0;
+        for (auto node = accounts; node; node = node->next, ++row)
+            for (guint col = 0; col < G_N_ELEMENTS (dates); ++col)
+            {
+                auto expected = balance_as_of_date_in_currency (
+                                    static_cast<Account*>(node->data),
+                                    dates[col], usd, children);
+                auto got = balances[row * G_N_ELEMENTS (dates) + col];
+                g_assert_cmpint (got.num, ==, expected.num);
+                g_assert_cmpint (got.denom, ==, expected.denom);
+            }
+        g_list_free (accounts);
+        g_free (balances);
+    }
+}
+
+/* Ten years of month ends over a tree of 60 accounts in four
+ * commodities, against the per-account, per-date path. */
+static void
+test_xaccAccountGetBalancesAsOfDatesInCurrency_perf (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    gnc_commodity *commodities[] =
+    {
+        gnc_commodity_new (book, "US Dollar", "CURRENCY", "USD", "840", 100),
+        gnc_commodity_new (book, "Euro", "CURRENCY", "EUR", "978", 100),
+        gnc_commodity_new (book, "Pound Sterling", "CURRENCY", "GBP", "826", 100),
+        gnc_commodity_new (book, "Acme Corp", "NYSE", "ACME", "", 1000),
+    };
+    const guint naccounts = 60, nsplits = 10000, ndates = 120;
+    auto top = add_balance_test_child (fixture->acct, commodities[0]);
+    time64 start = gnc_time (NULL) - 3650 * 86400;
+    auto dates = g_new (time64, ndates);
+    gdouble elapsed;
+
+    qof_event_suspend ();
+    for (guint i = 0; i < naccounts; ++i)
+    {
+        auto acct = add_balance_test_child (top, commodities[i % 4]);
+        for (guint j = 0; j < nsplits; ++j)
+            add_dated_split (acct, start + g_random_int_range (0, 3650) * 86400,
+                             gnc_numeric_create (g_random_int_range (-10000, 10000), 100));
+    }
+    for (guint day = 0; day < 3650; ++day)
+        for (guint i = 1; i < 4; ++i)
+            add_test_price (book, commodities[i], commodities[i == 3 ? 1 : 0],
+                            start + day * 86400,
+                            gnc_numeric_create (g_random_int_range (50, 200), 100));
+    for (guint i = 0; i < ndates; ++i)
+        dates[i] = start + (i + 1) * 30 * 86400;
+    auto descendants = gnc_account_get_descendants (top);
+    for (auto node = descendants; node; node = node->next)
+        xaccAccountGetBalanceAsOfDate (static_cast<Account*>(node->data),
+                                       start); /* sort and recompute */
+    g_list_free (descendants);
+
+    g_test_timer_start ();
+    for (guint i = 0; i < ndates; ++i)
+    {
+        descendants = gnc_account_get_descendants (top);
+        balance_as_of_date_in_currency (top, dates[i], commodities[0], TRUE);
+        for (auto node = descendants; node; node = node->next)
+            balance_as_of_date_in_currency (static_cast<Account*>(node->data),
+                                            dates[i], commodities[0], FALSE);
+        g_list_free (descendants);
+    }
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "per-call balances of %u accounts at %u dates: %8.6f s",
+                             naccounts + 1, ndates, elapsed);
+
+    g_test_timer_start ();
+    auto balances = xaccAccountGetBalancesAsOfDatesInCurrency (
+                        top, dates, ndates, commodities[0], TRUE, NULL);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "batch balances of %u accounts at %u dates: %8.6f s",
+                             naccounts + 1, ndates, elapsed);
+    qof_event_resume ();
+    g_free (balances);
+    g_free (dates);
+}
+/* A split inserted while the account is being edited sits unsorted at
+ * the head of the index; the present balance mustn't depend on it. */
+static void
+test_xaccAccountGetPresentBalance_unsorted (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Account *acct = make_balance_test_account (book);
+    time64 start = gnc_time (NULL) - 100 * 86400;
+    gnc_numeric present;
+
+    for (guint i = 0; i < 50; ++i)
+        add_dated_split (acct, start + g_random_int_range (0, 90) * 86400,
+                         gnc_numeric_create (g_random_int_range (-10000, 10000), 100));
+    xaccAccountSortSplits (acct, FALSE);
+    xaccAccountRecomputeBalance (acct);
+    present = xaccAccountGetPresentBalance (acct);
+    g_assert (gnc_numeric_eq (present, xaccAccountGetBalance (acct)));
+
+    xaccAccountBeginEdit (acct);
+    add_dated_split (acct, gnc_time (NULL) + 30 * 86400,
+                     gnc_numeric_create (12345, 100));
+    g_assert (gnc_numeric_eq (xaccAccountGetPresentBalance (acct), present));
+    xaccAccountCommitEdit (acct);
+    xaccAccountRecomputeBalance (acct);
+    g_assert (gnc_numeric_eq (xaccAccountGetPresentBalance (acct), present));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -2551,8 +3063,14 @@ test_suite_account (void)
 // GNC_TEST_ADD (suitename, "xaccAcctChildrenEqual", Fixture, NULL, setup, test_xaccAcctChildrenEqual,  teardown );
 // GNC_TEST_ADD (suitename, "xaccAccountEqual", Fixture, NULL, setup, test_xaccAccountEqual,  teardown );
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
+    GNC_TEST_ADD (suitename, "gnc account split index", Fixture, NULL, setup, test_gnc_account_split_index,  teardown );
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "gnc account insert & remove split perf", Fixture, NULL, setup, test_gnc_account_insert_remove_split_perf,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance incremental", Fixture, NULL, setup, test_xaccAccountRecomputeBalance_incremental,  teardown );
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance perf", Fixture, NULL, setup, test_xaccAccountRecomputeBalance_perf,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2571,7 +3089,12 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate search", Fixture, NULL, setup, test_xaccAccountGetBalanceAsOfDate_search,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalancesAsOfDatesInCurrency", Fixture, NULL, setup, test_xaccAccountGetBalancesAsOfDatesInCurrency,  teardown );
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "xaccAccountGetBalancesAsOfDatesInCurrency perf", Fixture, NULL, setup, test_xaccAccountGetBalancesAsOfDatesInCurrency_perf,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance unsorted", Fixture, NULL, setup, test_xaccAccountGetPresentBalance_unsorted,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
 
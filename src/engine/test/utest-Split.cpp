@@ -1870,6 +1870,58 @@ test_xaccSplitVoid (Fixture *fixture, gconstpointer pData)
     g_assert (gnc_numeric_zero_p (xaccSplitVoidFormerValue (fixture->split)));
     g_assert_cmpint (fixture->split->reconciled, ==, NREC);
 }
+/* xaccSplitListSumAmounts
+void
+xaccSplitListSumAmounts (SplitList *splits, gnc_numeric *balance,
+                         gnc_numeric *cleared, gnc_numeric *reconciled)
+*/
+static void
+test_xaccSplitListSumAmounts (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = xaccSplitGetBook (fixture->split);
+    const char recn[] = { NREC, CREC, YREC, FREC, VREC };
+    gnc_numeric zero = gnc_numeric_zero ();
+    gnc_numeric balance = zero, cleared = zero, reconciled = zero;
+    gnc_numeric bal_sum, clr_sum, rec_sum;
+    SplitList *splits = NULL, *node;
+    int i;
+
+    /* More splits than are summed in one batch. */
+    for (i = 0; i < 600; i++)
+    {
+        Split *split = xaccMallocSplit (book);
+        split->amount = gnc_numeric_create (i % 7 ? 1000 - 3 * i : 0, 1000);
+        split->reconciled = recn[i % 5];
+        splits = g_list_prepend (splits, split);
+        balance = gnc_numeric_add_fixed (balance, split->amount);
+        if (split->reconciled != NREC)
+            cleared = gnc_numeric_add_fixed (cleared, split->amount);
+        if (split->reconciled == YREC || split->reconciled == FREC)
+            reconciled = gnc_numeric_add_fixed (reconciled, split->amount);
+    }
+
+    xaccSplitListSumAmounts (NULL, &bal_sum, &clr_sum, &rec_sum);
+    g_assert (gnc_numeric_equal (bal_sum, zero));
+    g_assert (gnc_numeric_equal (rec_sum, zero));
+    xaccSplitListSumAmounts (splits, &bal_sum, &clr_sum, &rec_sum);
+    g_assert_cmpint (bal_sum.num, ==, balance.num);
+    g_assert_cmpint (bal_sum.denom, ==, balance.denom);
+    g_assert_cmpint (clr_sum.num, ==, cleared.num);
+    g_assert_cmpint (clr_sum.denom, ==, cleared.denom);
+    g_assert_cmpint (rec_sum.num, ==, reconciled.num);
+    g_assert_cmpint (rec_sum.denom, ==, reconciled.denom);
+    xaccSplitListSumAmounts (splits, NULL, &clr_sum, NULL);
+    g_assert (gnc_numeric_equal (clr_sum, cleared));
+
+    /* An amount in a different denomination is an error. */
+    static_cast<Split*>(splits->next->data)->amount = gnc_numeric_create (1, 100);
+    xaccSplitListSumAmounts (splits, &bal_sum, NULL, NULL);
+    g_assert_cmpint (gnc_numeric_check (bal_sum), !=, GNC_ERROR_OK);
+
+    for (node = splits; node; node = node->next)
+        test_destroy (node->data);
+    g_list_free (splits);
+}
 
 /* The rest of these are simple setters and getters unworthy of testing:
  * qofSplitSetMemo // Not Used
@@ -1901,6 +1953,100 @@ test_xaccSplitVoid (Fixture *fixture, gconstpointer pData)
  * xaccSplitRegister // C: 1  Local: 1:0:0
  */
 
+/* Queries for the splits with the largest values.  With max_results set
+ * the matches are kept in a bounded heap instead of being sorted and
+ * cropped; the results must be the same, including the order of splits
+ * with equal values. */
+static GPtrArray *
+make_valued_splits (QofBook *book, guint nsplits, gint nvalues)
+{
+    GPtrArray *splits = g_ptr_array_sized_new (nsplits);
+
+    for (guint i = 0; i < nsplits; ++i)
+    {
+        Split *split = xaccMallocSplit (book);
+        split->value = gnc_numeric_create (g_random_int_range (0, nvalues), 100);
+        g_ptr_array_add (splits, split);
+    }
+    return splits;
+}
+
+static GList *
+run_value_query (QofBook *book, gint max_results)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *results;
+
+    qof_query_set_book (q, book);
+    qof_query_set_sort_order (q, qof_query_build_param_list (SPLIT_VALUE, NULL),
+                              NULL, NULL);
+    qof_query_set_max_results (q, max_results);
+    results = g_list_copy (qof_query_run (q));
+    qof_query_destroy (q);
+    return results;
+}
+
+static void
+check_last_results (GList *all, GList *top, gint max_results)
+{
+    guint len = g_list_length (all);
+    GList *node = g_list_nth (all, len > (guint) max_results ?
+                              len - max_results : 0);
+
+    g_assert_cmpint (g_list_length (top), ==, MIN (len, (guint) max_results));
+    for (; node; node = node->next, top = top->next)
+        g_assert (node->data == top->data);
+}
+
+static void
+test_query_max_results (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = xaccSplitGetBook (fixture->split);
+    GPtrArray *splits = make_valued_splits (book, 1000, 10);
+    const gint max_results[] = { 0, 1, 7, 100, 999, 1002, 5000 };
+    GList *all = run_value_query (book, -1);
+
+    g_assert_cmpint (g_list_length (all), ==, 1002);
+    for (guint i = 0; i < G_N_ELEMENTS (max_results); ++i)
+    {
+        GList *top = run_value_query (book, max_results[i]);
+        check_last_results (all, top, max_results[i]);
+        g_list_free (top);
+    }
+    g_list_free (all);
+    g_ptr_array_free (splits, TRUE);
+}
+
+/* Performance test, only run with -m perf: the last 100 of a million
+ * splits by value, from the bounded heap and from sorting them all. */
+static void
+test_query_max_results_perf (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = xaccSplitGetBook (fixture->split);
+    const guint nsplits = 1000000;
+    const gint max_results = 100;
+    GPtrArray *splits = make_valued_splits (book, nsplits, 1000000);
+    GList *top, *all;
+    gdouble elapsed;
+
+    g_test_timer_start ();
+    top = run_value_query (book, max_results);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "last %d of %u splits, bounded heap: %6.3f s",
+                             max_results, nsplits, elapsed);
+
+    g_test_timer_start ();
+    all = run_value_query (book, -1);
+    elapsed = g_test_timer_elapsed ();
+    g_test_minimized_result (elapsed, "last %d of %u splits, full sort: %6.3f s",
+                             max_results, nsplits, elapsed);
+
+    check_last_results (all, top, max_results);
+    g_list_free (top);
+    g_list_free (all);
+    g_ptr_array_free (splits, TRUE);
+}
+
 
 void
 test_suite_split (void)
@@ -1942,5 +2088,9 @@ test_suite_split (void)
     GNC_TEST_ADD (suitename, "xaccSplitMakeStockSplit", Fixture, NULL, setup, test_xaccSplitMakeStockSplit, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitGetOtherSplit", Fixture, NULL, setup, test_xaccSplitGetOtherSplit, teardown);
     GNC_TEST_ADD (suitename, "xaccSplitVoid", Fixture, NULL, setup, test_xaccSplitVoid, teardown);
+    GNC_TEST_ADD (suitename, "xaccSplitListSumAmounts", Fixture, NULL, setup, test_xaccSplitListSumAmounts, teardown);
+    GNC_TEST_ADD (suitename, "query max results", Fixture, NULL, setup, test_query_max_results, teardown);
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "query max results perf", Fixture, NULL, setup, test_query_max_results_perf, teardown);
 
 }
@@ -1017,11 +1017,184 @@ test_gnc_pricedb_lookup_nearest_in_time (PriceDBFixture *fixture, gconstpointer
     g_assert_cmpstr(GET_CUR_NAME(price), ==, "AUD");
     g_assert_cmpstr(GET_COM_NAME(price), ==, "USD");
 }
-// Not Used
 /* gnc_pricedb_lookup_latest_before
 GNCPrice *
 gnc_pricedb_lookup_latest_before (GNCPriceDB *db,// Local: 0:0:0
 */
+/* The lookups binary search the price series of both directions; check
+ * them against walking the merged, latest first, price list the way
+ * they used to. */
+static gint
+compare_latest_first (gconstpointer a, gconstpointer b)
+{
+    Timespec time_a = gnc_price_get_time((GNCPrice*)a);
+    Timespec time_b = gnc_price_get_time((GNCPrice*)b);
+    gint result = -timespec_cmp(&time_a, &time_b);
+    if (result) return result;
+    return guid_compare (gnc_price_get_guid((GNCPrice*)a),
+                         gnc_price_get_guid((GNCPrice*)b));
+}
+
+static GNCPrice *
+walk_nearest_in_time (GList *prices, Timespec t)
+{
+    GNCPrice *current = prices->data, *next = NULL;
+    GList *node;
+    for (node = prices; node; node = node->next)
+    {
+        Timespec price_t = gnc_price_get_time(node->data);
+        if (timespec_cmp(&price_t, &t) <= 0)
+        {
+            next = node->data;
+            break;
+        }
+        current = node->data;
+    }
+    if (next)
+    {
+        Timespec current_t = gnc_price_get_time(current);
+        Timespec next_t = gnc_price_get_time(next);
+        Timespec diff_current = timespec_diff(&current_t, &t);
+        Timespec diff_next = timespec_diff(&next_t, &t);
+        Timespec abs_current = timespec_abs(&diff_current);
+        Timespec abs_next = timespec_abs(&diff_next);
+        if (timespec_cmp(&abs_current, &abs_next) >= 0)
+            return next;
+    }
+    return current;
+}
+
+static GNCPrice *
+walk_latest_before (GList *prices, Timespec t, gboolean exact)
+{
+    GList *node;
+    for (node = prices; node; node = node->next)
+    {
+        Timespec price_t = gnc_price_get_time(node->data);
+        if (exact ? timespec_equal(&price_t, &t)
+            : timespec_cmp(&price_t, &t) <= 0)
+            return node->data;
+    }
+    return NULL;
+}
+
+static void
+test_gnc_pricedb_lookup_latest_before (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    gnc_commodity *usd = fixture->com->usd, *bgn = fixture->com->bgn;
+    Timespec start = gnc_dmy2timespec(1, 1, 2010);
+    GList *prices, *node;
+    int i;
+
+    for (i = 0; i < 300; i++)
+    {
+        /* Several prices a day need the later ones to be from a better
+         * source, or they replace each other. */
+        Timespec t = {start.tv_sec + g_random_int_range(0, 200) * 86400 +
+                      g_random_int_range(0, 4) * 3600, 0};
+        gboolean reverse = g_random_boolean();
+        GNCPrice *price = construct_price(book, reverse ? bgn : usd,
+                                          reverse ? usd : bgn, t,
+                                          g_random_int_range(0, 3),
+                                          gnc_numeric_create(g_random_int_range(1, 100000), 1000));
+        gnc_pricedb_add_price(db, price);
+        gnc_price_unref(price);
+    }
+    prices = gnc_pricedb_get_prices(db, usd, bgn);
+    prices = g_list_concat(prices, gnc_pricedb_get_prices(db, bgn, usd));
+    g_assert (prices != NULL);
+    /* Take some out again, the lookups must see that too. */
+    for (node = prices; node; node = node->next)
+        if (g_random_int_range(0, 10) == 0)
+            gnc_pricedb_remove_price(db, node->data);
+    gnc_price_list_destroy(prices);
+    prices = gnc_pricedb_get_prices(db, usd, bgn);
+    prices = g_list_concat(prices, gnc_pricedb_get_prices(db, bgn, usd));
+    prices = g_list_sort(prices, compare_latest_first);
+
+    g_assert (gnc_pricedb_lookup_latest(db, usd, bgn) == prices->data);
+    gnc_price_unref(prices->data);
+    for (i = -2; i < 204 * 24; i++)
+    {
+        Timespec t = {start.tv_sec + i * 3600, 0};
+        GNCPrice *price = gnc_pricedb_lookup_nearest_in_time(db, usd, bgn, t);
+        g_assert (price == walk_nearest_in_time(prices, t));
+        gnc_price_unref(price);
+        price = gnc_pricedb_lookup_latest_before(db, bgn, usd, t);
+        g_assert (price == walk_latest_before(prices, t, FALSE));
+        gnc_price_unref(price);
+        price = gnc_pricedb_lookup_at_time(db, usd, bgn, t);
+        g_assert (price == walk_latest_before(prices, t, TRUE));
+        gnc_price_unref(price);
+    }
+    gnc_price_list_destroy(prices);
+}
+
+/* Ten years of daily quotes for a thousand commodities. */
+static void
+test_gnc_pricedb_lookup_perf (PriceDBFixture *fixture, gconstpointer pData)
+{
+    const int ncommodities = 1000, ndays = 3650, nlookups = 1000000;
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    gnc_commodity **commodities = g_new(gnc_commodity *, ncommodities);
+    Timespec start = gnc_dmy2timespec(1, 1, 2005);
+    gdouble elapsed;
+    int i, day;
+
+    for (i = 0; i < ncommodities; i++)
+    {
+        gchar *mnemonic = g_strdup_printf("C%04d", i);
+        commodities[i] = gnc_commodity_new(book, mnemonic, "NASDAQ",
+                                           mnemonic, "", 1);
+        g_free(mnemonic);
+    }
+
+    g_test_timer_start();
+    for (day = 0; day < ndays; day++)
+        for (i = 0; i < ncommodities; i++)
+        {
+            Timespec t = {start.tv_sec + day * 86400, 0};
+            GNCPrice *price = construct_price(book, commodities[i],
+                                              fixture->com->usd, t,
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(g_random_int_range(100, 100000), 100));
+            gnc_pricedb_add_price(db, price);
+            gnc_price_unref(price);
+        }
+    elapsed = g_test_timer_elapsed();
+    g_test_minimized_result(elapsed, "adding %d prices: %8.6f s",
+                            ncommodities * ndays, elapsed);
+
+    g_test_timer_start();
+    for (i = 0; i < nlookups; i++)
+    {
+        Timespec t = {start.tv_sec + g_random_int_range(0, ndays * 24) * 3600, 0};
+        GNCPrice *price = gnc_pricedb_lookup_nearest_in_time(
+            db, commodities[g_random_int_range(0, ncommodities)],
+            fixture->com->usd, t);
+        gnc_price_unref(price);
+    }
+    elapsed = g_test_timer_elapsed();
+    g_test_minimized_result(elapsed, "%d nearest in time lookups: %8.6f s",
+                            nlookups, elapsed);
+
+    g_test_timer_start();
+    for (i = 0; i < nlookups; i++)
+    {
+        Timespec t = {start.tv_sec + g_random_int_range(0, ndays * 24) * 3600, 0};
+        GNCPrice *price = gnc_pricedb_lookup_latest_before(
+            db, commodities[g_random_int_range(0, ncommodities)],
+            fixture->com->usd, t);
+        gnc_price_unref(price);
+    }
+    elapsed = g_test_timer_elapsed();
+    g_test_minimized_result(elapsed, "%d latest before lookups: %8.6f s",
+                            nlookups, elapsed);
+    g_free(commodities);
+}
 /* direct_balance_conversion
 static gnc_numeric
 direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,// Local: 2:0:0
@@ -1128,6 +1301,60 @@ test_gnc_pricedb_convert_balance_nearest_price (PriceDBFixture *fixture, gconstp
     g_assert_cmpint(result.denom, ==, 100);
 
 }
+
+/* Repeated conversions are served from the cache; only adding or removing
+ * a price for one of the two commodities makes them look prices up again.
+ */
+static void
+test_gnc_pricedb_conversion_cache (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceDB *db = fixture->pricedb;
+    QofBook *book = qof_instance_get_book(QOF_INSTANCE(db));
+    Commodities *c = fixture->com;
+    Timespec t = gnc_dmy2timespec(15, 8, 2011);
+    gnc_numeric from = gnc_numeric_create(10000, 100);
+    gnc_numeric result;
+    GNCPrice *price;
+
+    gnc_pricedb_reset_conversion_cache_stats(db);
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->usd,
+                                                       c->gbp, t);
+    g_assert_cmpint(result.num, ==, 6186);
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->usd,
+                                                       c->gbp, t);
+    g_assert_cmpint(result.num, ==, 6186);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_hits(db), ==, 1);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_misses(db), ==, 1);
+
+    gnc_pricedb_add_price(db, construct_price(book, c->dkk, c->eur, t,
+                                              PRICE_SOURCE_FQ,
+                                              gnc_numeric_create(13, 100)));
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->usd,
+                                                       c->gbp, t);
+    g_assert_cmpint(result.num, ==, 6186);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_hits(db), ==, 2);
+
+    price = construct_price(book, c->gbp, c->usd, t, PRICE_SOURCE_EDIT_DLG,
+                            gnc_numeric_create(2, 1));
+    gnc_pricedb_add_price(db, price);
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->usd,
+                                                       c->gbp, t);
+    g_assert_cmpint(result.num, ==, 5000);
+    g_assert_cmpint(result.denom, ==, 100);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_misses(db), ==, 2);
+
+    gnc_pricedb_remove_price(db, price);
+    gnc_price_unref(price);
+    result = gnc_pricedb_convert_balance_nearest_price(db, from, c->usd,
+                                                       c->gbp, t);
+    g_assert_cmpint(result.num, ==, 6186);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_hits(db), ==, 2);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_misses(db), ==, 3);
+
+    gnc_pricedb_reset_conversion_cache_stats(db);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_hits(db), ==, 0);
+    g_assert_cmpint(gnc_pricedb_get_conversion_cache_misses(db), ==, 0);
+}
 /* pricedb_foreach_pricelist
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)// Local: 0:1:0
@@ -1378,12 +1605,16 @@ test_suite_gnc_pricedb (void)
     GNC_TEST_ADD (suitename, "gnc pricedb lookup day", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_day, teardown);
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb lookup latest before", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_latest_before, teardown);
+    if (g_test_perf ())
+        GNC_TEST_ADD (suitename, "gnc pricedb lookup perf", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_perf, teardown);
 // GNC_TEST_ADD (suitename, "direct balance conversion", Fixture, NULL, setup, test_direct_balance_conversion, teardown);
 // GNC_TEST_ADD (suitename, "extract common prices", Fixture, NULL, setup, test_extract_common_prices, teardown);
 // GNC_TEST_ADD (suitename, "convert balance", Fixture, NULL, setup, test_convert_balance, teardown);
 // GNC_TEST_ADD (suitename, "indirect balance conversion", Fixture, NULL, setup, test_indirect_balance_conversion, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_nearest_price, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb conversion cache", PriceDBFixture, NULL, setup, test_gnc_pricedb_conversion_cache, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);
@@ -168,7 +168,10 @@ gnc_account_sel_init (GNCAccountSel *gas)
     gas_populate_list( gas );
 
     gas->eventHandlerId =
-        qof_event_register_handler( gnc_account_sel_event_cb, gas );
+        qof_event_register_handler_filtered( gnc_account_sel_event_cb, gas,
+                                             GNC_ID_ACCOUNT,
+                                             QOF_EVENT_CREATE | QOF_EVENT_MODIFY
+                                             | QOF_EVENT_DESTROY );
 
     gas->initDone = TRUE;
 }
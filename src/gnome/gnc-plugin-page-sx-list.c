@@ -304,12 +304,22 @@ gnc_plugin_page_sx_list_finalize (GObject *object)
 }
 
 
+/* The upcoming instances shown are those of the year from today. */
+static void
+gppsl_range_end(GDate *end)
+{
+    g_date_clear(end, 1);
+    gnc_gdate_set_today (end);
+    g_date_add_years(end, 1);
+}
+
 /* Virtual Functions */
 static void
 gnc_plugin_page_sx_list_refresh_cb (GHashTable *changes, gpointer user_data)
 {
     GncPluginPageSxList *page = user_data;
     GncPluginPageSxListPrivate *priv;
+    GDate end;
 
     g_return_if_fail(GNC_IS_PLUGIN_PAGE_SX_LIST(page));
 
@@ -318,6 +328,9 @@ gnc_plugin_page_sx_list_refresh_cb (GHashTable *changes, gpointer user_data)
         return;
 
     priv = GNC_PLUGIN_PAGE_SX_LIST_GET_PRIVATE(page);
+    /* The page may have been open since before today. */
+    gppsl_range_end(&end);
+    gnc_sx_instance_model_set_range_end(priv->instances, &end);
     gtk_widget_queue_draw(priv->widget);
 }
 
@@ -403,9 +416,7 @@ gnc_plugin_page_sx_list_create_widget (GncPluginPage *plugin_page)
 
     {
         GDate end;
-        g_date_clear(&end, 1);
-        gnc_gdate_set_today (&end);
-        g_date_add_years(&end, 1);
+        gppsl_range_end(&end);
         priv->instances = GNC_SX_INSTANCE_MODEL(gnc_sx_get_instances(&end, TRUE));
     }
 
@@ -435,6 +435,7 @@ csv_fixed_trans_import (CsvFTImportInfo *info)
     progress = GTK_PROGRESS_BAR(info->progressbar);
 
     gnc_suspend_gui_refresh ();
+    qof_event_begin_batch ();
 
     while (valid)
     {
@@ -689,6 +690,7 @@ csv_fixed_trans_import (CsvFTImportInfo *info)
     }
     g_free (void_reason);
 
+    qof_event_end_batch ();
     gnc_resume_gui_refresh ();
 
     LEAVE("");
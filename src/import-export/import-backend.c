@@ -40,6 +40,7 @@
 #include "Account.h"
 #include "Query.h"
 #include "gnc-engine.h"
+#include "gnc-event.h"
 #include "engine-helpers.h"
 #include "gnc-prefs.h"
 #include "gnc-ui-util.h"
@@ -813,55 +814,132 @@ void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
                                    double fuzzy_amount_difference,
                                    gint match_date_hardlimit)
 {
-    GList * list_element;
-    Query *query = qof_query_create_for(GNC_ID_SPLIT);
+    GList trans_info_list = { NULL, NULL, NULL };
     g_assert (trans_info);
 
-    /* Get list of splits of the originating account. */
+    trans_info_list.data = trans_info;
+    gnc_import_find_split_matches_list (&trans_info_list, process_threshold,
+                                        fuzzy_amount_difference,
+                                        match_date_hardlimit);
+}
+
+/* The imported transactions of one account, and the range of their
+   dates. */
+typedef struct
+{
+    GList *trans_infos;
+    time64 first;
+    time64 last;
+} ImportAccountBatch;
+
+static void
+import_account_batch_free (gpointer data)
+{
+    ImportAccountBatch *batch = data;
+    g_list_free (batch->trans_infos);
+    g_free (batch);
+}
+
+/* Index of the first candidate posted at or after the given time. */
+static guint
+candidates_search_date (GPtrArray *candidates, const Timespec *ts)
+{
+    guint lo = 0, hi = candidates->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        Timespec posted = xaccTransRetDatePostedTS
+                          (xaccSplitGetParent (g_ptr_array_index (candidates, mid)));
+        if (timespec_cmp (&posted, ts) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/** /brief Find the matching splits of a list of imported transactions.
+   Rather than one query per transaction, this runs one query per import
+   account over the whole date range of its transactions.  The query
+   returns the splits in split order, which is by date posted, so each
+   transaction then only looks at the splits within match_date_hardlimit
+   days of it, in the order its own query would have returned them. */
+void gnc_import_find_split_matches_list (GList *trans_info_list,
+                                         gint process_threshold,
+                                         double fuzzy_amount_difference,
+                                         gint match_date_hardlimit)
+{
+    GHashTable *batches;
+    GHashTableIter hiter;
+    gpointer key, value;
+    GList *node;
+    time64 window = (time64) match_date_hardlimit * 86400;
+
+    batches = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                     import_account_batch_free);
+    for (node = trans_info_list; node; node = node->next)
     {
-        /* We used to traverse *all* splits of the account by using
-           xaccAccountGetSplitList, which is a bad idea because 90% of these
-           splits are outside the date range that is interesting. We should
-           rather use a query according to the date region, which is
-           implemented here.
-        */
+        GNCImportTransInfo *trans_info = node->data;
         Account *importaccount =
             xaccSplitGetAccount (gnc_import_TransInfo_get_fsplit (trans_info));
         time64 download_time = xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
+        ImportAccountBatch *batch = g_hash_table_lookup (batches, importaccount);
+
+        if (batch == NULL)
+        {
+            batch = g_new0 (ImportAccountBatch, 1);
+            batch->first = batch->last = download_time;
+            g_hash_table_insert (batches, importaccount, batch);
+        }
+        batch->trans_infos = g_list_prepend (batch->trans_infos, trans_info);
+        batch->first = MIN (batch->first, download_time);
+        batch->last = MAX (batch->last, download_time);
+    }
+
+    g_hash_table_iter_init (&hiter, batches);
+    while (g_hash_table_iter_next (&hiter, &key, &value))
+    {
+        Account *importaccount = key;
+        ImportAccountBatch *batch = value;
+        Query *query = qof_query_create_for(GNC_ID_SPLIT);
+        GPtrArray *candidates = g_ptr_array_new ();
 
         qof_query_set_book (query, gnc_get_current_book());
         xaccQueryAddSingleAccountMatch (query, importaccount,
                                         QOF_QUERY_AND);
         xaccQueryAddDateMatchTT (query,
-                                 TRUE, download_time - match_date_hardlimit * 86400,
-                                 TRUE, download_time + match_date_hardlimit * 86400,
+                                 TRUE, batch->first - window,
+                                 TRUE, batch->last + window,
                                  QOF_QUERY_AND);
-        list_element = qof_query_run (query);
-        /* Sigh. Doesnt help too much. We still create and run one query
-           for each imported transaction. Maybe it would improve
-           performance further if there is one single (master-)query at
-           the beginning, matching the full date range and all accounts in
-           question. However, this doesnt quite work because this function
-           here is called from each gnc_gen_trans_list_add_trans(), which
-           is called one at a time. Therefore the whole importer would
-           have to change its behaviour: Accept the imported txns via
-           gnc_gen_trans_list_add_trans(), and only when
-           gnc_gen_trans_list_run() is called, then calculate all the
-           different match candidates. That's too much work for now.
-        */
-    }
+        for (node = qof_query_run (query); node; node = node->next)
+            g_ptr_array_add (candidates, node->data);
 
-    /* Traverse that list, calling split_find_match on each one. Note
-       that xaccAccountForEachSplit is declared in Account.h but
-       implemented nowhere :-( */
-    while (list_element != NULL)
-    {
-        split_find_match (trans_info, list_element->data,
-                          process_threshold, fuzzy_amount_difference);
-        list_element = g_list_next (list_element);
-    }
+        for (node = batch->trans_infos; node; node = node->next)
+        {
+            GNCImportTransInfo *trans_info = node->data;
+            time64 download_time = xaccTransGetDate (gnc_import_TransInfo_get_trans (trans_info));
+            Timespec start = { download_time - window, 0 };
+            Timespec end = { download_time + window, 0 };
+            guint i;
+
+            for (i = candidates_search_date (candidates, &start);
+                    i < candidates->len; i++)
+            {
+                Split *split = g_ptr_array_index (candidates, i);
+                Timespec posted = xaccTransRetDatePostedTS (xaccSplitGetParent (split));
 
-    qof_query_destroy (query);
+                if (timespec_cmp (&posted, &end) > 0)
+                    break;
+                split_find_match (trans_info, split,
+                                  process_threshold, fuzzy_amount_difference);
+            }
+        }
+
+        g_ptr_array_free (candidates, TRUE);
+        qof_query_destroy (query);
+    }
+    g_hash_table_destroy (batches);
 }
 
 
@@ -1083,46 +1161,275 @@ gnc_import_process_trans_item (GncImportMatchMap *matchmap,
 }
 
 /********************************************************************\
- * check_trans_online_id() Callback function used by
- * gnc_import_exists_online_id.  Takes pointers to transaction and split,
- * returns 0 if their online_ids  do NOT match, or if the split
- * belongs to the transaction
+ * Online ID index
+ *   For each account that has been searched, a hash of the online_ids
+ *   of its splits.  A split's online_id is its own, or else its
+ *   transaction's.  The index is built on the first lookup in the
+ *   account and kept current through engine events: splits that are
+ *   added to the account or modified are read again before the next
+ *   lookup, when their online_ids have been set.  Splits inserted or
+ *   removed while events are suspended, as by the SQL backend's loads
+ *   or a log replay, send no events; the account's split list
+ *   generation then differs from the one the index has seen and the
+ *   account is indexed again.
 \********************************************************************/
-static gint check_trans_online_id(Transaction *trans1, void *user_data)
+
+#define ONLINE_ID_INDEX "import-online-id-index"
+
+typedef struct
 {
-    Account *account;
-    Split *split1;
-    Split *split2 = user_data;
-    const gchar *online_id1;
-    const gchar *online_id2;
-
-    account = xaccSplitGetAccount(split2);
-    split1 = xaccTransFindSplitByAccount(trans1, account);
-    if (split1 == split2)
-        return 0;
+    GHashTable *ids;            /* online_id -> GList of Split */
+    GHashTable *split_ids;      /* Split -> its online_id in ids */
+    GHashTable *pending;        /* Splits to read again */
+    guint generation;           /* of the split list, as last seen */
+} AccountOnlineIds;
 
-    /* hack - we really want to iterate over the _splits_ of the account
-       instead of the transactions */
-    g_assert(split1 != NULL);
+typedef struct
+{
+    GHashTable *accounts;       /* Account -> AccountOnlineIds */
+    gint listener;
+} OnlineIdIndex;
 
-    if (gnc_import_split_has_online_id(split1))
-        online_id1 = gnc_import_get_split_online_id(split1);
-    else
-        online_id1 = gnc_import_get_trans_online_id(trans1);
+static gchar *
+split_online_id (Split *split)
+{
+    Transaction *trans;
+    gchar *id = NULL;
+
+    qof_instance_get (QOF_INSTANCE (split), "online-id", &id, NULL);
+    if (id != NULL && *id != '\0')
+        return id;
+    g_free (id);
+    id = NULL;
+
+    trans = xaccSplitGetParent (split);
+    if (trans)
+        qof_instance_get (QOF_INSTANCE (trans), "online-id", &id, NULL);
+    return id;
+}
 
-    online_id2 = gnc_import_get_split_online_id(split2);
+static void
+account_online_ids_free (gpointer data)
+{
+    AccountOnlineIds *acc_ids = data;
+    GHashTableIter iter;
+    gpointer key, value;
 
-    if ((online_id1 == NULL) ||
-            (online_id2 == NULL) ||
-            (strcmp(online_id1, online_id2) != 0))
+    g_hash_table_iter_init (&iter, acc_ids->ids);
+    while (g_hash_table_iter_next (&iter, &key, &value))
     {
-        return 0;
+        g_free (key);
+        g_list_free (value);
+    }
+    g_hash_table_destroy (acc_ids->ids);
+    g_hash_table_destroy (acc_ids->split_ids);
+    g_hash_table_destroy (acc_ids->pending);
+    g_free (acc_ids);
+}
+
+static void
+account_online_ids_remove (AccountOnlineIds *acc_ids, Split *split)
+{
+    gpointer id, list;
+
+    if (!g_hash_table_lookup_extended (acc_ids->split_ids, split, NULL, &id))
+        return;
+    if (g_hash_table_lookup_extended (acc_ids->ids, id, &id, &list))
+    {
+        /* Keep the key, which the remaining splits share. */
+        g_hash_table_steal (acc_ids->ids, id);
+        list = g_list_remove (list, split);
+        if (list)
+            g_hash_table_insert (acc_ids->ids, id, list);
+        else
+            g_free (id);
+    }
+    g_hash_table_remove (acc_ids->split_ids, split);
+}
+
+static void
+account_online_ids_read (AccountOnlineIds *acc_ids, Account *account,
+                         Split *split)
+{
+    gpointer key, list;
+    gchar *id;
+
+    account_online_ids_remove (acc_ids, split);
+    if (xaccSplitGetAccount (split) != account)
+        return;
+    id = split_online_id (split);
+    if (id == NULL)
+        return;
+
+    if (g_hash_table_lookup_extended (acc_ids->ids, id, &key, &list))
+    {
+        g_hash_table_steal (acc_ids->ids, key);
+        g_free (id);
+        id = key;
     }
     else
+        list = NULL;
+    g_hash_table_insert (acc_ids->ids, id, g_list_prepend (list, split));
+    g_hash_table_insert (acc_ids->split_ids, split, id);
+}
+
+static void
+online_id_index_event_handler (QofInstance *entity, QofEventId event_type,
+                               gpointer handler_data, gpointer event_data)
+{
+    OnlineIdIndex *index = handler_data;
+    AccountOnlineIds *acc_ids;
+
+    if (GNC_IS_ACCOUNT (entity))
+    {
+        acc_ids = g_hash_table_lookup (index->accounts, entity);
+        if (acc_ids == NULL)
+            return;
+        if (event_type & QOF_EVENT_DESTROY)
+        {
+            g_hash_table_remove (index->accounts, entity);
+        }
+        else if (event_type & (GNC_EVENT_ITEM_ADDED | GNC_EVENT_ITEM_REMOVED))
+        {
+            if (event_type & GNC_EVENT_ITEM_ADDED)
+                g_hash_table_insert (acc_ids->pending, event_data, event_data);
+            else
+            {
+                g_hash_table_remove (acc_ids->pending, event_data);
+                account_online_ids_remove (acc_ids, event_data);
+            }
+            /* Each insert or removal comes right after its own
+               increment, so a gap means changes were missed. */
+            if (acc_ids->generation + 1 ==
+                    xaccAccountGetSplitListGeneration (GNC_ACCOUNT (entity)))
+                acc_ids->generation++;
+        }
+    }
+    else if (GNC_IS_SPLIT (entity))
+    {
+        Split *split = GNC_SPLIT (entity);
+        GHashTableIter iter;
+        gpointer value;
+
+        if (event_type & QOF_EVENT_DESTROY)
+        {
+            /* The split may already have left its account. */
+            g_hash_table_iter_init (&iter, index->accounts);
+            while (g_hash_table_iter_next (&iter, NULL, &value))
+            {
+                acc_ids = value;
+                g_hash_table_remove (acc_ids->pending, split);
+                account_online_ids_remove (acc_ids, split);
+            }
+        }
+        else if (event_type & QOF_EVENT_MODIFY)
+        {
+            acc_ids = g_hash_table_lookup (index->accounts,
+                                           xaccSplitGetAccount (split));
+            if (acc_ids)
+                g_hash_table_insert (acc_ids->pending, split, split);
+        }
+    }
+    else if (GNC_IS_TRANSACTION (entity) && (event_type & QOF_EVENT_MODIFY))
+    {
+        GList *node;
+
+        for (node = xaccTransGetSplitList (GNC_TRANSACTION (entity)); node;
+                node = node->next)
+        {
+            acc_ids = g_hash_table_lookup (index->accounts,
+                                           xaccSplitGetAccount (node->data));
+            if (acc_ids)
+                g_hash_table_insert (acc_ids->pending, node->data, node->data);
+        }
+    }
+}
+
+static void
+online_id_index_destroy (QofBook *book, gpointer key, gpointer user_data)
+{
+    OnlineIdIndex *index = user_data;
+
+    qof_event_unregister_handler (index->listener);
+    g_hash_table_destroy (index->accounts);
+    g_free (index);
+}
+
+/* The online_ids of the account, indexing it on first use. */
+static AccountOnlineIds *
+online_id_index_get_account (Account *account)
+{
+    QofBook *book = gnc_account_get_book (account);
+    OnlineIdIndex *index = qof_book_get_data (book, ONLINE_ID_INDEX);
+    AccountOnlineIds *acc_ids;
+    GHashTableIter iter;
+    gpointer split;
+    GList *node;
+
+    if (index == NULL)
+    {
+        index = g_new0 (OnlineIdIndex, 1);
+        index->accounts = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                          NULL, account_online_ids_free);
+        index->listener =
+            qof_event_register_handler (online_id_index_event_handler, index);
+        qof_book_set_data_fin (book, ONLINE_ID_INDEX, index,
+                               online_id_index_destroy);
+    }
+
+    acc_ids = g_hash_table_lookup (index->accounts, account);
+    if (acc_ids != NULL &&
+            acc_ids->generation != xaccAccountGetSplitListGeneration (account))
+    {
+        g_hash_table_remove (index->accounts, account);
+        acc_ids = NULL;
+    }
+    if (acc_ids == NULL)
     {
-        /*printf("test_trans_online_id(): Duplicate found\n");*/
-        return 1;
+        acc_ids = g_new0 (AccountOnlineIds, 1);
+        acc_ids->generation = xaccAccountGetSplitListGeneration (account);
+        acc_ids->ids = g_hash_table_new (g_str_hash, g_str_equal);
+        acc_ids->split_ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+        acc_ids->pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+        for (node = xaccAccountGetSplitList (account); node; node = node->next)
+            account_online_ids_read (acc_ids, account, node->data);
+        g_hash_table_insert (index->accounts, account, acc_ids);
     }
+
+    g_hash_table_iter_init (&iter, acc_ids->pending);
+    while (g_hash_table_iter_next (&iter, &split, NULL))
+        account_online_ids_read (acc_ids, account, split);
+    g_hash_table_remove_all (acc_ids->pending);
+
+    return acc_ids;
+}
+
+Split *
+gnc_import_find_split_by_online_id (Account *account, const gchar *online_id,
+                                    Split *exclude)
+{
+    AccountOnlineIds *acc_ids;
+    GList *node;
+
+    g_return_val_if_fail (account != NULL, NULL);
+    if (online_id == NULL)
+        return NULL;
+
+    acc_ids = online_id_index_get_account (account);
+    for (node = g_hash_table_lookup (acc_ids->ids, online_id); node;
+            node = node->next)
+    {
+        Split *split = node->data;
+
+        /* Each transaction counts once, by its first split in the
+           account. */
+        if (split == exclude ||
+                xaccTransFindSplitByAccount (xaccSplitGetParent (split),
+                                             account) != split)
+            continue;
+        return split;
+    }
+    return NULL;
 }
 
 /** Checks whether the given transaction's online_id already exists in
@@ -1132,6 +1439,7 @@ gboolean gnc_import_exists_online_id (Transaction *trans)
     gboolean online_id_exists = FALSE;
     Account *dest_acct;
     Split *source_split;
+    gchar *online_id = NULL;
 
     /* Look for an online_id in the first split */
     source_split = xaccTransGetSplit(trans, 0);
@@ -1139,9 +1447,12 @@ gboolean gnc_import_exists_online_id (Transaction *trans)
 
     /* DEBUG("%s%d%s","Checking split ",i," for duplicates"); */
     dest_acct = xaccSplitGetAccount(source_split);
-    online_id_exists = xaccAccountForEachTransaction(dest_acct,
-                       check_trans_online_id,
-                       source_split);
+    qof_instance_get (QOF_INSTANCE (source_split), "online-id", &online_id, NULL);
+    if (dest_acct != NULL && online_id != NULL)
+        online_id_exists =
+            gnc_import_find_split_by_online_id (dest_acct, online_id,
+                                                source_split) != NULL;
+    g_free (online_id);
 
     /* If it does, abort the process for this transaction, since it is
        already in the system. */
@@ -1183,6 +1494,9 @@ gnc_import_TransInfo_new (Transaction *trans, GncImportMatchMap *matchmap)
 }
 
 
+static void trans_info_select_match (GNCImportTransInfo *trans_info,
+                                     GNCImportSettings *settings);
+
 /** compare_probability() is used by g_list_sort to sort by probability */
 static gint compare_probability (gconstpointer a,
                                  gconstpointer b)
@@ -1199,15 +1513,37 @@ void
 gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
                                    GNCImportSettings *settings)
 {
-    GNCImportMatchInfo * best_match = NULL;
     g_assert (trans_info);
 
-
     /* Find all split matches in originating account. */
     gnc_import_find_split_matches(trans_info,
                                   gnc_import_Settings_get_display_threshold (settings),
                                   gnc_import_Settings_get_fuzzy_amount (settings),
                                   gnc_import_Settings_get_match_date_hardlimit (settings));
+    trans_info_select_match (trans_info, settings);
+}
+
+void
+gnc_import_TransInfo_init_matches_list (GList *trans_info_list,
+                                        GNCImportSettings *settings)
+{
+    GList *node;
+
+    gnc_import_find_split_matches_list (trans_info_list,
+                                        gnc_import_Settings_get_display_threshold (settings),
+                                        gnc_import_Settings_get_fuzzy_amount (settings),
+                                        gnc_import_Settings_get_match_date_hardlimit (settings));
+    for (node = trans_info_list; node; node = node->next)
+        trans_info_select_match (node->data, settings);
+}
+
+/* Sort the match list of trans_info and set its selected_match and
+   action fields. */
+static void
+trans_info_select_match (GNCImportTransInfo *trans_info,
+                         GNCImportSettings *settings)
+{
+    GNCImportMatchInfo * best_match = NULL;
 
     if (trans_info->match_list != NULL)
     {
@@ -58,6 +58,26 @@ typedef enum _action
  * online_id. */
 gboolean gnc_import_exists_online_id (Transaction *trans);
 
+/** Look up a split of the given account by online_id.  The online_id
+ * of a split is its own, or else that of its transaction.  The
+ * account's online_ids are indexed on the first lookup and the index
+ * is kept current through engine events, so each lookup takes
+ * constant time.  If the account's splits changed without events the
+ * account is indexed again.
+ *
+ * @param account The account to search.
+ *
+ * @param online_id The online_id to look for.
+ *
+ * @param exclude A split to ignore, usually the one being imported,
+ * or NULL.
+ *
+ * @return A split of a transaction in the account with that
+ * online_id, or NULL if there is none. */
+Split *gnc_import_find_split_by_online_id (Account *account,
+        const gchar *online_id,
+        Split *exclude);
+
 /** Iterate through all splits of the originating account of the given
  * transaction, find all matching splits there, and store them in the
  * GNCImportTransInfo structure.
@@ -87,6 +107,20 @@ void gnc_import_find_split_matches(GNCImportTransInfo *trans_info,
                                    double fuzzy_amount_difference,
                                    gint match_date_hardlimit);
 
+/** Like gnc_import_find_split_matches(), for each of a list of
+ * GNCImportTransInfo.  The match lists are the same, but the splits
+ * of each import account are looked up once for the whole list
+ * instead of once per transaction.
+ *
+ * @param trans_info_list A list of GNCImportTransInfo.
+ *
+ * The other parameters are those of gnc_import_find_split_matches().
+ */
+void gnc_import_find_split_matches_list (GList *trans_info_list,
+                                         gint process_threshold,
+                                         double fuzzy_amount_difference,
+                                         gint match_date_hardlimit);
+
 /** Iterates through all splits of the originating account of
  * trans_info. Sorts the resulting list and sets the selected_match
  * and action fields in the trans_info.
@@ -100,6 +134,18 @@ void
 gnc_import_TransInfo_init_matches (GNCImportTransInfo *trans_info,
                                    GNCImportSettings *settings);
 
+/** Like gnc_import_TransInfo_init_matches(), for each of a list of
+ * GNCImportTransInfo, finding the matches with
+ * gnc_import_find_split_matches_list().
+ *
+ * @param trans_info_list A list of GNCImportTransInfo.
+ *
+ * @param settings The structure that holds all the user preferences.
+ */
+void
+gnc_import_TransInfo_init_matches_list (GList *trans_info_list,
+                                        GNCImportSettings *settings);
+
 /** This function is intended to be called when the importer dialog is
  * finished. It should be called once for each imported transaction
  * and processes each ImportTransInfo according to its selected action:
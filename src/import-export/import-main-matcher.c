@@ -63,6 +63,10 @@ struct _main_matcher_info
     int selected_row;
     GNCTransactionProcessedCB transaction_processed_cb;
     gpointer user_data;
+    /* Transactions added since the last flush; their matches are
+       looked up together and they get their rows then. */
+    GList *pending_trans;
+    guint pending_idle_id;
 };
 
 enum downloaded_cols
@@ -102,16 +106,36 @@ automatch_store_transactions(GNCImportMainMatcher *info,
 static void
 refresh_model_row(GNCImportMainMatcher *gui, GtkTreeModel *model,
                   GtkTreeIter *iter, GNCImportTransInfo *info);
+static void
+flush_pending_trans (GNCImportMainMatcher *gui);
+static gboolean
+flush_pending_trans_idle (gpointer user_data);
 
 void gnc_gen_trans_list_delete (GNCImportMainMatcher *info)
 {
     GtkTreeModel *model;
     GtkTreeIter iter;
     GNCImportTransInfo *trans_info;
+    GList *node;
 
     if (info == NULL)
         return;
 
+    if (info->pending_idle_id)
+        g_source_remove (info->pending_idle_id);
+    for (node = info->pending_trans; node; node = node->next)
+    {
+        if (info->transaction_processed_cb)
+        {
+            info->transaction_processed_cb(node->data,
+                                           FALSE,
+                                           info->user_data);
+        }
+
+        gnc_import_TransInfo_delete(node->data);
+    }
+    g_list_free (info->pending_trans);
+
     model = gtk_tree_view_get_model(info->view);
     if (gtk_tree_model_get_iter_first(model, &iter))
     {
@@ -157,13 +181,16 @@ on_matcher_ok_clicked (GtkButton *button,
 
     /*   DEBUG ("Begin") */
 
+    flush_pending_trans (info);
     model = gtk_tree_view_get_model(info->view);
     if (!gtk_tree_model_get_iter_first(model, &iter))
         return;
 
     /* Don't run any queries and/or split sorts while processing the matcher
-    results. */
+    results.  Each transaction touches the same few accounts over and
+    over, so hold their events back and deliver them once at the end. */
     gnc_suspend_gui_refresh();
+    qof_event_begin_batch();
 
     do
     {
@@ -184,6 +211,7 @@ on_matcher_ok_clicked (GtkButton *button,
     while (gtk_tree_model_iter_next (model, &iter));
 
     /* Allow GUI refresh again. */
+    qof_event_end_batch();
     gnc_resume_gui_refresh();
 
     gnc_gen_trans_list_delete (info);
@@ -659,6 +687,7 @@ gboolean gnc_gen_trans_list_run (GNCImportMainMatcher *info)
     gboolean result;
 
     /* DEBUG("Begin"); */
+    flush_pending_trans (info);
     result = gtk_dialog_run (GTK_DIALOG (info->dialog));
     /* DEBUG("Result was %d", result); */
 
@@ -890,8 +919,6 @@ void gnc_gen_trans_list_add_trans(GNCImportMainMatcher *gui, Transaction *trans)
 void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transaction *trans, guint32 ref_id)
 {
     GNCImportTransInfo * transaction_info = NULL;
-    GtkTreeModel *model;
-    GtkTreeIter iter;
     g_assert (gui);
     g_assert (trans);
 
@@ -903,16 +930,58 @@ void gnc_gen_trans_list_add_trans_with_ref_id(GNCImportMainMatcher *gui, Transac
         transaction_info = gnc_import_TransInfo_new(trans, NULL);
         gnc_import_TransInfo_set_ref_id(transaction_info, ref_id);
 
-        gnc_import_TransInfo_init_matches(transaction_info,
-                                          gui->user_settings);
-
-        model = gtk_tree_view_get_model(gui->view);
-        gtk_list_store_append(GTK_LIST_STORE(model), &iter);
-        refresh_model_row (gui, model, &iter, transaction_info);
+        /* The importers add their transactions one after the other;
+           finding the matches of all of them at once is much cheaper,
+           so that waits until they're done and the main loop is idle,
+           or until the list is run. */
+        gui->pending_trans = g_list_prepend (gui->pending_trans,
+                                             transaction_info);
+        if (!gui->pending_idle_id)
+            gui->pending_idle_id = g_idle_add (flush_pending_trans_idle, gui);
     }
     return;
 }/* end gnc_import_add_trans_with_ref_id() */
 
+/* Find the matches of the pending transactions and add their rows. */
+static void
+flush_pending_trans (GNCImportMainMatcher *gui)
+{
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    GList *node;
+
+    if (gui->pending_idle_id)
+    {
+        g_source_remove (gui->pending_idle_id);
+        gui->pending_idle_id = 0;
+    }
+    if (gui->pending_trans == NULL)
+        return;
+
+    gui->pending_trans = g_list_reverse (gui->pending_trans);
+    gnc_import_TransInfo_init_matches_list (gui->pending_trans,
+                                            gui->user_settings);
+
+    model = gtk_tree_view_get_model(gui->view);
+    for (node = gui->pending_trans; node; node = node->next)
+    {
+        gtk_list_store_append(GTK_LIST_STORE(model), &iter);
+        refresh_model_row (gui, model, &iter, node->data);
+    }
+    g_list_free (gui->pending_trans);
+    gui->pending_trans = NULL;
+}
+
+static gboolean
+flush_pending_trans_idle (gpointer user_data)
+{
+    GNCImportMainMatcher *gui = user_data;
+
+    gui->pending_idle_id = 0;
+    flush_pending_trans (gui);
+    return FALSE;
+}
+
 /* Iterate through the rows of the clist and try to automatch each of them */
 static void
 automatch_store_transactions (GNCImportMainMatcher *info,
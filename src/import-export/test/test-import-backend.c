@@ -0,0 +1,276 @@
+/********************************************************************
+ * test-import-backend.c: Test the transaction matching of the      *
+ * generic importer.                                                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#include "config.h"
+#include <glib.h>
+
+#include "qof.h"
+#include "cashobjects.h"
+#include "Account.h"
+#include "Transaction.h"
+#include "gnc-commodity.h"
+#include "gnc-ui-util.h"
+#include "import-backend.h"
+#include "import-utilities.h"
+
+#include "test-stuff.h"
+
+#define DAY 86400
+#define N_BOOK_TRANS 60
+#define N_IMPORT_TRANS 20
+#define MATCH_DATE_HARDLIMIT 14
+
+static const char *descriptions[] = { "Grocer", "Grocery store", "Rent",
+                                      "Salary", "ATM", ""
+                                    };
+static const gint64 amounts[] = { 1000, 1025, 2000, -1000, -50000, 99 };
+
+static time64 start_time;
+static gnc_commodity *usd;
+
+static Account *
+make_account (QofBook *book, Account *parent, const char *name)
+{
+    Account *acc = xaccMallocAccount (book);
+
+    xaccAccountBeginEdit (acc);
+    xaccAccountSetName (acc, name);
+    xaccAccountSetType (acc, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (acc, usd);
+    xaccAccountCommitEdit (acc);
+    gnc_account_append_child (parent, acc);
+    return acc;
+}
+
+/* A transaction of amount between acc and other.  Without other it's
+ * an imported one, which is left open as the importer does. */
+static Transaction *
+make_trans (QofBook *book, Account *acc, Account *other, time64 date,
+            const char *desc, gint64 amount, const char *online_id)
+{
+    Transaction *trans = xaccMallocTransaction (book);
+    Split *split = xaccMallocSplit (book);
+    gnc_numeric value = gnc_numeric_create (amount, 100);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (acc));
+    xaccTransSetDatePostedSecs (trans, date);
+    xaccTransSetDescription (trans, desc);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, acc);
+    xaccSplitSetValue (split, value);
+    xaccSplitSetAmount (split, value);
+    if (online_id)
+        gnc_import_set_split_online_id (split, online_id);
+    if (other)
+    {
+        Split *other_split = xaccMallocSplit (book);
+        xaccSplitSetParent (other_split, trans);
+        xaccSplitSetAccount (other_split, other);
+        xaccSplitSetValue (other_split, gnc_numeric_neg (value));
+        xaccSplitSetAmount (other_split, gnc_numeric_neg (value));
+        xaccTransCommitEdit (trans);
+    }
+    return trans;
+}
+
+static gboolean
+match_lists_equal (GList *a, GList *b)
+{
+    for (; a && b; a = a->next, b = b->next)
+    {
+        if (gnc_import_MatchInfo_get_split (a->data) !=
+                gnc_import_MatchInfo_get_split (b->data) ||
+                gnc_import_MatchInfo_get_probability (a->data) !=
+                gnc_import_MatchInfo_get_probability (b->data))
+            return FALSE;
+    }
+    return a == NULL && b == NULL;
+}
+
+/* The matches found for a list of imported transactions at once must
+ * be those found for each of them on its own. */
+static void
+test_find_split_matches_list (QofBook *book, Account *bank, Account *cash,
+                              Account *other)
+{
+    GList *batch = NULL, *singles = NULL, *a, *b;
+    gboolean any_matches = FALSE;
+    int i;
+
+    for (i = 0; i < N_BOOK_TRANS; i++)
+        make_trans (book, i % 3 ? bank : cash, other,
+                    start_time + get_random_int_in_range (0, 120) * DAY,
+                    descriptions[i % G_N_ELEMENTS (descriptions)],
+                    amounts[get_random_int_in_range (0, G_N_ELEMENTS (amounts) - 1)],
+                    NULL);
+
+    /* Each imported transaction twice: once for the list and once to
+     * be matched on its own. */
+    for (i = 0; i < N_IMPORT_TRANS; i++)
+    {
+        Account *acc = i % 4 ? bank : cash;
+        time64 date = start_time + get_random_int_in_range (-20, 140) * DAY;
+        const char *desc = descriptions[get_random_int_in_range (0, G_N_ELEMENTS (descriptions) - 1)];
+        gint64 amount = amounts[get_random_int_in_range (0, G_N_ELEMENTS (amounts) - 1)];
+
+        batch = g_list_prepend (batch, gnc_import_TransInfo_new (
+                                    make_trans (book, acc, NULL, date, desc, amount, NULL), NULL));
+        singles = g_list_prepend (singles, gnc_import_TransInfo_new (
+                                      make_trans (book, acc, NULL, date, desc, amount, NULL), NULL));
+    }
+
+    gnc_import_find_split_matches_list (batch, 1, 1.0, MATCH_DATE_HARDLIMIT);
+    for (b = singles; b; b = b->next)
+        gnc_import_find_split_matches (b->data, 1, 1.0, MATCH_DATE_HARDLIMIT);
+
+    for (a = batch, b = singles; a && b; a = a->next, b = b->next)
+    {
+        GList *batch_matches = gnc_import_TransInfo_get_match_list (a->data);
+        GList *single_matches = gnc_import_TransInfo_get_match_list (b->data);
+
+        any_matches = any_matches || batch_matches != NULL;
+        do_test (match_lists_equal (batch_matches, single_matches),
+                 "batch and single match lists differ");
+    }
+    do_test (any_matches, "no matches found at all");
+
+    g_list_free_full (batch, (GDestroyNotify)gnc_import_TransInfo_delete);
+    g_list_free_full (singles, (GDestroyNotify)gnc_import_TransInfo_delete);
+}
+
+/* The split of acc with the online_id, found by walking the split list. */
+static Split *
+scan_for_online_id (Account *acc, const char *online_id)
+{
+    GList *node;
+
+    for (node = xaccAccountGetSplitList (acc); node; node = node->next)
+    {
+        Split *split = node->data;
+        gchar *id = NULL;
+        gboolean found;
+
+        qof_instance_get (QOF_INSTANCE (split), "online-id", &id, NULL);
+        if (id == NULL || *id == '\0')
+        {
+            g_free (id);
+            id = NULL;
+            qof_instance_get (QOF_INSTANCE (xaccSplitGetParent (split)),
+                              "online-id", &id, NULL);
+        }
+        found = g_strcmp0 (id, online_id) == 0;
+        g_free (id);
+        if (found)
+            return split;
+    }
+    return NULL;
+}
+
+static void
+check_online_ids (Account *acc, int n_ids, const char *msg)
+{
+    int i;
+
+    for (i = 0; i < n_ids; i++)
+    {
+        gchar *id = g_strdup_printf ("online-%d", i);
+        do_test (gnc_import_find_split_by_online_id (acc, id, NULL) ==
+                 scan_for_online_id (acc, id), msg);
+        g_free (id);
+    }
+}
+
+static Transaction *
+make_online_trans (QofBook *book, Account *acc, Account *other, int n)
+{
+    gchar *id = g_strdup_printf ("online-%d", n);
+    Transaction *trans = make_trans (book, acc, other, start_time + n * DAY,
+                                     "Online", 1000 + n, id);
+    g_free (id);
+    return trans;
+}
+
+/* The online_id index must agree with a walk of the split list, also
+ * after splits were added or removed while events were suspended. */
+static void
+test_online_id_index (QofBook *book, Account *acc, Account *other)
+{
+    Transaction *trans, *doomed = NULL;
+    int i;
+
+    for (i = 0; i < 30; i++)
+    {
+        trans = make_online_trans (book, acc, other, i);
+        if (i == 3)
+            doomed = trans;
+    }
+    check_online_ids (acc, 40, "index and scan differ");
+
+    make_online_trans (book, acc, other, 30);
+    do_test (gnc_import_find_split_by_online_id (acc, "online-30", NULL) != NULL,
+             "split added with events not found");
+
+    qof_event_suspend ();
+    make_online_trans (book, acc, other, 31);
+    xaccTransBeginEdit (doomed);
+    xaccTransDestroy (doomed);
+    xaccTransCommitEdit (doomed);
+    qof_event_resume ();
+
+    do_test (gnc_import_find_split_by_online_id (acc, "online-31", NULL) != NULL,
+             "split added while events were suspended not found");
+    do_test (gnc_import_find_split_by_online_id (acc, "online-3", NULL) == NULL,
+             "split removed while events were suspended found");
+    check_online_ids (acc, 40, "index and scan differ after suspended events");
+}
+
+int
+main (int argc, char **argv)
+{
+    QofBook *book;
+    Account *root, *bank, *cash, *other;
+
+    qof_init ();
+    if (!cashobjects_register ())
+    {
+        failure ("can't register cashobjects");
+        return get_rv ();
+    }
+
+    /* Always start from the same random seed so we fail consistently */
+    srand (0);
+    start_time = gnc_time (NULL) - 100 * DAY;
+
+    book = gnc_get_current_book ();
+    usd = gnc_commodity_new (book, "US Dollar", "CURRENCY", "USD", "0", 100);
+    root = gnc_book_get_root_account (book);
+    bank = make_account (book, root, "Bank");
+    cash = make_account (book, root, "Cash");
+    other = make_account (book, root, "Other");
+
+    test_find_split_matches_list (book, bank, cash, other);
+    test_online_id_index (book, cash, other);
+
+    print_test_results ();
+    return get_rv ();
+}
@@ -62,6 +62,58 @@ powten (int exp)
 }
 
 
+/* Checked 64-bit arithmetic for the fast paths below. Results are kept
+ * within +/-INT64_MAX, the range GncInt128 converts back to gint64, and
+ * the functions return FALSE if they would leave it. */
+static inline gboolean
+checked_add (gint64 a, gint64 b, gint64 *result)
+{
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < -INT64_MAX - b))
+        return FALSE;
+    *result = a + b;
+    return TRUE;
+}
+
+/* factor must be positive. */
+static inline gboolean
+checked_scale (gint64 a, gint64 factor, gint64 *result)
+{
+    if (factor != 1 && (a > INT64_MAX / factor || a < -INT64_MAX / factor))
+        return FALSE;
+    *result = a * factor;
+    return TRUE;
+}
+
+/* Brings a and b to their lowest common denominator when one denominator
+ * divides the other, as with currency amounts whose SCUs are powers of
+ * ten. */
+static inline gboolean
+common_denom (gnc_numeric a, gnc_numeric b,
+              gint64 *anum, gint64 *bnum, gint64 *lcd)
+{
+    if (a.denom <= 0 || b.denom <= 0 ||
+        a.num == INT64_MIN || b.num == INT64_MIN)
+        return FALSE;
+    *anum = a.num;
+    *bnum = b.num;
+    if (a.denom == b.denom)
+    {
+        *lcd = a.denom;
+        return TRUE;
+    }
+    if (a.denom % b.denom == 0)
+    {
+        *lcd = a.denom;
+        return checked_scale (b.num, a.denom / b.denom, bnum);
+    }
+    if (b.denom % a.denom == 0)
+    {
+        *lcd = b.denom;
+        return checked_scale (a.num, b.denom / a.denom, anum);
+    }
+    return FALSE;
+}
+
 /* =============================================================== */
 /* This function is small, simple, and used everywhere below,
  * lets try to inline it.
@@ -169,7 +221,7 @@ gnc_numeric_positive_p(gnc_numeric a)
 int
 gnc_numeric_compare(gnc_numeric a, gnc_numeric b)
 {
-    gint64 aa, bb;
+    gint64 aa, bb, denom;
 
     if (gnc_numeric_check(a) || gnc_numeric_check(b))
     {
@@ -183,6 +235,13 @@ gnc_numeric_compare(gnc_numeric a, gnc_numeric b)
         return -1;
     }
 
+    if (common_denom (a, b, &aa, &bb, &denom))
+    {
+        if (aa == bb) return 0;
+        if (aa > bb) return 1;
+        return -1;
+    }
+
     GncNumeric an (a), bn (b);
 
     return (an.m_num * bn.m_den).cmp(bn.m_num * an.m_den);
@@ -248,15 +307,60 @@ gnc_numeric_same(gnc_numeric a, gnc_numeric b, gint64 denom,
  *  gnc_numeric_add
  ********************************************************************/
 
+/* Adds without GncRational when the operands have a common denominator in
+ * 64 bits and the result needs no rounding or reduction: that is, when the
+ * requested denominator is the common one or an exact multiple of it.
+ * Returns FALSE if the general code must do the addition. */
+static inline gboolean
+add_fast (gnc_numeric a, gnc_numeric b, gint64 denom, gint how,
+          gnc_numeric *result)
+{
+    gint64 anum, bnum, lcd, num;
+
+    if (!common_denom (a, b, &anum, &bnum, &lcd))
+        return FALSE;
+    if (denom == GNC_DENOM_AUTO)
+    {
+        switch (how & GNC_NUMERIC_DENOM_MASK)
+        {
+        case GNC_HOW_DENOM_FIXED:
+            if (a.denom != b.denom)
+                return FALSE;
+            /* Fall through */
+        case 0:
+        case GNC_HOW_DENOM_EXACT:
+        case GNC_HOW_DENOM_LCD:
+            denom = lcd;
+            break;
+        default:
+            return FALSE;
+        }
+    }
+    else if (denom < 0 || denom % lcd != 0)
+        return FALSE;
+
+    if (!checked_add (anum, bnum, &num) ||
+        !checked_scale (num, denom / lcd, &num))
+        return FALSE;
+    result->num = num;
+    result->denom = denom;
+    return TRUE;
+}
+
 gnc_numeric
 gnc_numeric_add(gnc_numeric a, gnc_numeric b,
                 gint64 denom, gint how)
 {
+    gnc_numeric sum;
+
     if (gnc_numeric_check(a) || gnc_numeric_check(b))
     {
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
 
+    if (add_fast (a, b, denom, how, &sum))
+        return sum;
+
     GncNumeric an (a), bn (b);
     GncDenom new_denom (an, bn, denom, how);
     if (new_denom.m_error)
@@ -285,6 +389,103 @@ gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
     return gnc_numeric_add (a, nb, denom, how);
 }
 
+/* *******************************************************************
+ *  gnc_numeric_sum_fixed
+ ********************************************************************/
+
+#define SUM_BLOCK 256
+/* SUM_BLOCK values smaller than this can't overflow a 64-bit lane. */
+#define SUM_LANE_LIMIT (INT64_C(1) << 54)
+
+/* Adds a block of at most SUM_BLOCK values. If all of the nonzero values
+ * share a denominator, each sum is taken in a 64-bit lane and applied at
+ * once, provided no partial sum can leave the range of gint64; otherwise
+ * the selected values are added one at a time. */
+static void
+sum_fixed_block (const gnc_numeric *values, const guint8 *masks, gsize n,
+                 guint n_sums, gnc_numeric *sums)
+{
+    gint64 nums[SUM_BLOCK];
+    guint64 mags[SUM_BLOCK];
+    guint8 bits[SUM_BLOCK];
+    gint64 denom = 0;
+    guint64 all_mags = 0;
+    gboolean uniform = TRUE;
+    gsize i;
+    guint k;
+
+    for (i = 0; i < n; i++)
+    {
+        gnc_numeric v = values[i];
+        bits[i] = masks ? masks[i] : 0xff;
+        nums[i] = v.num;
+        mags[i] = v.num < 0 ? -static_cast<guint64>(v.num) : v.num;
+        all_mags |= mags[i];
+        if (v.denom <= 0)
+            uniform = FALSE;
+        else if (v.num != 0)
+        {
+            if (denom == 0)
+                denom = v.denom;
+            else if (v.denom != denom)
+                uniform = FALSE;
+        }
+    }
+    if (all_mags >= SUM_LANE_LIMIT)
+        uniform = FALSE;
+
+    for (k = 0; k < n_sums; k++)
+    {
+        gnc_numeric acc = sums[k];
+        gint64 lane = 0;
+        guint64 lane_mag = 0, acc_mag;
+
+        /* Branch-free so that the compiler can vectorize it. */
+        for (i = 0; i < n; i++)
+        {
+            gint64 select = -static_cast<gint64>((bits[i] >> k) & 1);
+            lane += nums[i] & select;
+            lane_mag += mags[i] & static_cast<guint64>(select);
+        }
+
+        acc_mag = acc.num < 0 ? -static_cast<guint64>(acc.num) : acc.num;
+        if (uniform && gnc_numeric_check (acc) == GNC_ERROR_OK &&
+            acc.denom > 0 && acc_mag <= static_cast<guint64>(INT64_MAX) &&
+            (lane_mag == 0 || acc.num == 0 || acc.denom == denom) &&
+            lane_mag <= static_cast<guint64>(INT64_MAX) - acc_mag)
+        {
+            /* A zero sum takes the denominator of the first nonzero value
+             * added to it. */
+            if (lane_mag != 0)
+            {
+                acc.num += lane;
+                acc.denom = denom;
+            }
+        }
+        else
+        {
+            for (i = 0; i < n; i++)
+                if ((bits[i] >> k) & 1)
+                    acc = gnc_numeric_add_fixed (acc, values[i]);
+        }
+        sums[k] = acc;
+    }
+}
+
+void
+gnc_numeric_sum_fixed (const gnc_numeric *values, const guint8 *masks,
+                       gsize n, guint n_sums, gnc_numeric *sums)
+{
+    gsize start;
+
+    g_return_if_fail (n_sums <= 8);
+    g_return_if_fail (n == 0 || (values && sums));
+
+    for (start = 0; start < n; start += SUM_BLOCK)
+        sum_fixed_block (values + start, masks ? masks + start : NULL,
+                         MIN (SUM_BLOCK, n - start), n_sums, sums);
+}
+
 /* *******************************************************************
  *  gnc_numeric_mul
  ********************************************************************/
@@ -448,6 +448,24 @@ gnc_numeric gnc_numeric_sub_fixed(gnc_numeric a, gnc_numeric b)
     return gnc_numeric_sub(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
+
+/**
+ * Adds up an array of values as a sequence of gnc_numeric_add_fixed calls
+ * would, but in blocks of 64-bit lanes where the values share a
+ * denominator and can't overflow. Up to eight sums can be accumulated in
+ * one pass, each over the values selected by its bit in masks.
+ *
+ * @param values The values to add.
+ * @param masks Bit k of masks[i] says whether values[i] is added to
+ * sums[k], or NULL to add every value to every sum.
+ * @param n The number of values.
+ * @param n_sums The number of sums, at most 8.
+ * @param sums The starting values of the sums, which are replaced by the
+ * results. The results, including any error, are the same as
+ * gnc_numeric_add_fixed would give.
+ */
+void gnc_numeric_sum_fixed(const gnc_numeric *values, const guint8 *masks,
+                           gsize n, guint n_sums, gnc_numeric *sums);
 /** @} */
 
 /** @name Arithmetic Functions with Exact Error Returns
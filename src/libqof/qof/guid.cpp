@@ -231,10 +231,34 @@ guid_compare (const GncGUID *guid_1, const GncGUID *guid_2)
     return 1;
 }
 
+/* The finalizer of MurmurHash3, which makes every input bit affect every
+ * output bit. */
+static inline guint64
+mix64 (guint64 h)
+{
+    h ^= h >> 33;
+    h *= UINT64_C(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64_C(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+guint64
+guid_hash64 (const GncGUID *guid)
+{
+    guint64 high, low;
+
+    g_return_val_if_fail (guid, 0);
+    memcpy (&high, guid->reserved, sizeof (high));
+    memcpy (&low, guid->reserved + sizeof (high), sizeof (low));
+    return mix64 (high ^ mix64 (low));
+}
+
 guint
 guid_hash_to_guint (gconstpointer ptr)
 {
-    const boost::uuids::uuid * guid = reinterpret_cast<const boost::uuids::uuid*> (ptr);
+    auto guid = reinterpret_cast<const GncGUID*> (ptr);
 
     if (!guid)
     {
@@ -242,14 +266,8 @@ guid_hash_to_guint (gconstpointer ptr)
         return 0;
     }
 
-    guint hash {0};
-    unsigned retspot {0};
-    for (auto guidspot : *guid)
-    {
-        hash <<= 4;
-        hash |= guidspot;
-    }
-    return hash;
+    auto hash = guid_hash64 (guid);
+    return static_cast<guint> (hash ^ (hash >> 32));
 }
 
 gint
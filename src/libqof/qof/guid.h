@@ -161,6 +161,9 @@ gboolean string_to_guid(const gchar * string, /*@ out @*/ GncGUID * guid);
 gboolean guid_equal(const GncGUID *guid_1, const GncGUID *guid_2);
 gint     guid_compare(const GncGUID *g1, const GncGUID *g2);
 
+/** Hash all 128 bits of a GUID to 64 bits. */
+guint64 guid_hash64(const GncGUID *guid);
+
 /** Hash function for a GUID. Given a GncGUID *, hash it to a guint */
 guint guid_hash_to_guint(gconstpointer ptr);
 
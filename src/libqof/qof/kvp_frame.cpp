@@ -38,6 +38,7 @@ extern "C"
 #include <sstream>
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = "qof.kvp";
@@ -46,12 +47,13 @@ static const char delim = '/';
 
 KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
 {
+    m_valuemap.reserve(rhs.m_valuemap.size());
     std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
         [this](const map_type::value_type & a)
         {
             auto key = static_cast<char *>(qof_string_cache_insert(a.first));
             auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            this->m_valuemap.push_back({key,val});
         }
     );
 }
@@ -67,45 +69,125 @@ KvpFrameImpl::~KvpFrameImpl() noexcept
     m_valuemap.clear();
 }
 
-static inline Path
-make_vector(std::string key)
+/* Compares a NUL-terminated key with the len characters at token, which
+ * needn't be terminated. */
+static inline int
+key_compare(const char* key, const char* token, size_t len) noexcept
 {
-    Path path;
-    for (auto length = key.find(delim); length != std::string::npos;)
-    {
-        if (length != 0)
-            path.push_back(key.substr(0, length));
-        key = key.substr(length + 1);
-        length = key.find(delim);
-    }
-    if (!key.empty())
-	path.push_back(key);
-    return path;
+    auto ret = strncmp(key, token, len);
+    if (ret == 0 && key[len] != '\0')
+        return 1;
+    return ret;
+}
+
+/* Finds the next non-empty token of a '/'-delimited path, advancing path past
+ * it. Returns false if there are no more tokens. */
+static inline bool
+next_token(const char*& path, const char*& token, size_t& len) noexcept
+{
+    while (*path == delim)
+        ++path;
+    if (*path == '\0')
+        return false;
+    token = path;
+    len = strcspn(path, "/");
+    path += len;
+    return true;
+}
+
+KvpFrameImpl::map_type::const_iterator
+KvpFrameImpl::find_key(const char* key, size_t len) const noexcept
+{
+    return std::lower_bound(m_valuemap.begin(), m_valuemap.end(), key,
+        [len](const map_type::value_type& a, const char* k)
+        {
+            return key_compare(a.first, k, len) < 0;
+        }
+    );
 }
 
 KvpValue*
-KvpFrameImpl::set(const char* key, KvpValue* value) noexcept
+KvpFrameImpl::get_local(const char* key, size_t len) const noexcept
 {
-    if (!key) return nullptr;
-    if (strchr(key, delim))
-        return set(make_vector(key), value);
-    KvpValue* ret {nullptr};
-    auto spot = m_valuemap.find(key);
-    if (spot != m_valuemap.end())
+    auto spot = find_key(key, len);
+    if (spot == m_valuemap.end() || key_compare(spot->first, key, len) != 0)
+        return nullptr;
+    return spot->second;
+}
+
+KvpValue*
+KvpFrameImpl::set_local(const char* key, size_t len, KvpValue* value) noexcept
+{
+    auto spot = m_valuemap.begin() + (find_key(key, len) - m_valuemap.begin());
+    if (spot != m_valuemap.end() && key_compare(spot->first, key, len) == 0)
     {
-        qof_string_cache_remove(spot->first);
-        ret = spot->second;
-        m_valuemap.erase(spot);
+        auto ret = spot->second;
+        if (value)
+        {
+            spot->second = value;
+        }
+        else
+        {
+            qof_string_cache_remove(spot->first);
+            m_valuemap.erase(spot);
+        }
+        return ret;
     }
 
     if (value)
     {
+        std::string keystr{key, len};
         auto cachedkey =
-            static_cast<const char *>(qof_string_cache_insert(key));
-        m_valuemap.insert({cachedkey,value});
+            static_cast<const char *>(qof_string_cache_insert(keystr.c_str()));
+        m_valuemap.insert(spot, {cachedkey, value});
     }
+    return nullptr;
+}
 
-    return ret;
+/* Returns the subframe at key, replacing whatever else is there with a new
+ * frame. */
+KvpFrameImpl*
+KvpFrameImpl::make_frame(const char* key, size_t len) noexcept
+{
+    auto slot = get_local(key, len);
+    if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+    {
+        auto new_frame = new KvpFrame;
+        delete set_local(key, len, new KvpValue{new_frame});
+        return new_frame;
+    }
+    return slot->get<KvpFrame*>();
+}
+
+static inline KvpFrameImpl*
+as_frame(KvpValue* slot) noexcept
+{
+    if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+        return nullptr;
+    return slot->get<KvpFrame*>();
+}
+
+KvpValue*
+KvpFrameImpl::set(const char* key, KvpValue* value) noexcept
+{
+    if (!key) return nullptr;
+    if (!strchr(key, delim))
+        return set_local(key, strlen(key), value);
+
+    const char *token, *next;
+    size_t len, next_len;
+    if (!next_token(key, token, len))
+        return nullptr;
+    auto cur_frame = this;
+    while (next_token(key, next, next_len))
+    {
+        cur_frame = as_frame(cur_frame->get_local(token, len));
+        if (cur_frame == nullptr)
+            return nullptr;
+        token = next;
+        len = next_len;
+    }
+    return cur_frame->set_local(token, len, value);
 }
 
 static inline KvpFrameImpl*
@@ -114,10 +196,9 @@ walk_path_or_nullptr(const KvpFrameImpl* frame, Path& path)
     KvpFrameImpl* cur_frame = const_cast<KvpFrameImpl*>(frame);
     for(auto key:path)
     {
-        auto slot = cur_frame->get_slot(key.c_str());
-        if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
+        cur_frame = as_frame(cur_frame->get_slot(key.c_str()));
+        if (cur_frame == nullptr)
             return nullptr;
-        cur_frame = slot->get<KvpFrame*>();
     }
     return cur_frame;
 }
@@ -125,57 +206,58 @@ walk_path_or_nullptr(const KvpFrameImpl* frame, Path& path)
 KvpValue*
 KvpFrameImpl::set(Path path, KvpValue* value) noexcept
 {
+    if (path.empty())
+        return nullptr;
     auto last_key = path.back();
     path.pop_back();
     auto cur_frame = walk_path_or_nullptr(this, path);
     if (cur_frame == nullptr)
         return nullptr;
-    if (last_key.find(delim) != std::string::npos)
-        return set(make_vector(last_key), value);
     return cur_frame->set(last_key.c_str(), value);
 }
 
-static inline KvpFrameImpl*
-walk_path_and_create(KvpFrameImpl* frame, Path path)
+KvpValue*
+KvpFrameImpl::set_path(const char* path, KvpValue* value) noexcept
 {
-     for(auto key:path)
+    if (!path) return nullptr;
+    const char *token, *next;
+    size_t len, next_len;
+    if (!next_token(path, token, len))
+        return nullptr;
+    auto cur_frame = this;
+    while (next_token(path, next, next_len))
     {
-	if (key.empty())
-	    continue;
-        if (key.find(delim) != std::string::npos)
-        {
-            frame = walk_path_and_create(frame, make_vector(key));
-            continue;
-        }
-        auto slot = frame->get_slot(key.c_str());
-        if (slot == nullptr || slot->get_type() != KvpValue::Type::FRAME)
-        {
-            auto new_frame = new KvpFrame;
-            delete frame->set(key.c_str(), new KvpValue{new_frame});
-            frame = new_frame;
-            continue;
-        }
-        frame = slot->get<KvpFrame*>();
+        cur_frame = cur_frame->make_frame(token, len);
+        token = next;
+        len = next_len;
     }
-    return frame;
+    return cur_frame->set_local(token, len, value);
 }
 
 KvpValue*
-KvpFrameImpl::set_path(const char* path, KvpValue* value) noexcept
+KvpFrameImpl::set_path(Path path, KvpValue* value) noexcept
 {
-    return set_path(make_vector(path), value);
+    if (path.empty())
+        return nullptr;
+    std::string joined;
+    for (auto key : path)
+    {
+        joined += delim;
+        joined += key;
+    }
+    return set_path(joined.c_str(), value);
 }
 
 KvpValue*
-KvpFrameImpl::set_path(Path path, KvpValue* value) noexcept
+KvpFrameImpl::set_path(const KvpPathImpl* path, KvpValue* value) noexcept
 {
+    if (!path || path->m_keys.empty())
+        return nullptr;
     auto cur_frame = this;
-    auto last_key = path.back();
-    path.pop_back();
-    cur_frame = walk_path_and_create(const_cast<KvpFrame*>(this), path);
-    if (last_key.find(delim) != std::string::npos)
-        return set_path(make_vector(last_key), value);
-    return cur_frame->set(last_key.c_str(), value);
+    auto last = path->m_keys.end() - 1;
+    for (auto key = path->m_keys.begin(); key != last; ++key)
+        cur_frame = cur_frame->make_frame(*key, strlen(*key));
+    return cur_frame->set_local(*last, strlen(*last), value);
 }
 
 std::string
@@ -205,6 +287,7 @@ std::vector<std::string>
 KvpFrameImpl::get_keys() const noexcept
 {
     std::vector<std::string> ret;
+    ret.reserve(m_valuemap.size());
     std::for_each(m_valuemap.begin(), m_valuemap.end(),
         [&ret](const KvpFrameImpl::map_type::value_type &a)
         {
@@ -232,26 +315,83 @@ KvpValueImpl *
 KvpFrameImpl::get_slot(const char * key) const noexcept
 {
     if (!key) return nullptr;
-    if (strchr(key, delim))
-        return get_slot(make_vector(key));
-    auto spot = m_valuemap.find(key);
-    if (spot == m_valuemap.end())
-        return nullptr;
-    return spot->second;
+    if (!strchr(key, delim))
+        return get_local(key, strlen(key));
+
+    const char* token;
+    size_t len;
+    KvpValue* slot = nullptr;
+    auto cur_frame = this;
+    while (next_token(key, token, len))
+    {
+        if (slot)
+        {
+            cur_frame = as_frame(slot);
+            if (cur_frame == nullptr)
+                return nullptr;
+        }
+        slot = cur_frame->get_local(token, len);
+        if (slot == nullptr)
+            return nullptr;
+    }
+    return slot;
 }
 
 KvpValueImpl *
 KvpFrameImpl::get_slot(Path path) const noexcept
 {
+    if (path.empty())
+        return nullptr;
     auto last_key = path.back();
     path.pop_back();
     auto cur_frame = walk_path_or_nullptr(this, path);
     if (cur_frame == nullptr)
         return nullptr;
-    if (last_key.find(delim) != std::string::npos)
-        return get_slot(make_vector(last_key));
     return cur_frame->get_slot(last_key.c_str());
+}
 
+KvpValueImpl *
+KvpFrameImpl::get_slot(const KvpPathImpl* path) const noexcept
+{
+    if (!path || path->m_keys.empty())
+        return nullptr;
+    KvpValue* slot = nullptr;
+    auto cur_frame = this;
+    for (auto key : path->m_keys)
+    {
+        if (slot)
+        {
+            cur_frame = as_frame(slot);
+            if (cur_frame == nullptr)
+                return nullptr;
+        }
+        slot = cur_frame->get_local(key, strlen(key));
+        if (slot == nullptr)
+            return nullptr;
+    }
+    return slot;
+}
+
+const KvpPathImpl*
+KvpPathImpl::intern(const char* path) noexcept
+{
+    static std::unordered_map<std::string, KvpPathImpl*> paths;
+    if (!path) return nullptr;
+    auto spot = paths.find(path);
+    if (spot != paths.end())
+        return spot->second;
+
+    auto ret = new KvpPathImpl;
+    const char* token;
+    size_t len;
+    for (auto rest = path; next_token(rest, token, len);)
+    {
+        std::string key{token, len};
+        ret->m_keys.push_back(static_cast<const char*>(
+                                  qof_string_cache_insert(key.c_str())));
+    }
+    paths.insert({path, ret});
+    return ret;
 }
 
 int compare(const KvpFrameImpl * one, const KvpFrameImpl * two) noexcept
@@ -273,12 +413,12 @@ int compare(const KvpFrameImpl & one, const KvpFrameImpl & two) noexcept
 {
     for (const auto & a : one.m_valuemap)
     {
-        auto otherspot = two.m_valuemap.find(a.first);
-        if (otherspot == two.m_valuemap.end())
+        auto otherslot = two.get_local(a.first, strlen(a.first));
+        if (otherslot == nullptr)
         {
             return 1;
         }
-        auto comparison = compare(a.second,otherspot->second);
+        auto comparison = compare(a.second,otherslot);
 
         if (comparison != 0)
             return comparison;
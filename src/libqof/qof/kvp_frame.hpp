@@ -36,8 +36,9 @@
  * owned by the kvp_frame.  Make copies as needed.
  *
  * A 'path' is a sequence of keys that can be followed to a value.  Paths are
- * passed as either '/'-delimited strings or as std::vectors of keys. Unlike
- * file system paths, the tokens '.' and '..' have no special meaning.
+ * passed as either '/'-delimited strings, as std::vectors of keys or as
+ * interned KvpPathImpl handles. Unlike file system paths, the tokens '.' and
+ * '..' have no special meaning.
  *
  * KVP is an implementation detail whose direct use should be avoided; create an
  * abstraction object in libqof to keep KVP encapsulated here and ensure that
@@ -89,12 +90,28 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
-#include <map>
 #include <string>
 #include <vector>
 #include <cstring>
 using Path = std::vector<std::string>;
 
+/** A path of keys parsed once from a '/'-delimited string.
+ *  Frequently used paths can be interned with KvpPathImpl::intern and the
+ *  handle kept, so that accessing the slot doesn't split the string again.
+ *  The keys come from the string cache, and interned paths last for the
+ *  life of the program.
+ */
+struct KvpPathImpl
+{
+    /** Get the interned path for a '/'-delimited string, parsing it the
+     * first time it's seen. Empty tokens are ignored as in set_path.
+     * @param path: The '/'-delimited path.
+     * @return The path, or nullptr if path is nullptr.
+     */
+    static const KvpPathImpl* intern(const char* path) noexcept;
+    std::vector<const char*> m_keys;
+};
+
 /** Implements KvpFrame.
  *  It's a struct because QofInstance needs to use the typename to declare a
  *  KvpFrame* member, and QofInstance's API is C until its children are all
@@ -109,17 +126,10 @@ using Path = std::vector<std::string>;
  */
 struct KvpFrameImpl
 {
-    class cstring_comparer
-    {
-    public:
-	/* Returns true if one is less than two. */
-	bool operator()(const char * one, const char * two) const
-	    {
-		auto ret = std::strcmp(one, two) < 0;
-		return ret;
-	    }
-    };
-    using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    /* The slots are kept in a vector sorted by key, which is smaller and
+     * faster to search than a node per slot for the few keys most frames
+     * hold. Keys are string-cache entries. */
+    using map_type = std::vector<std::pair<const char *, KvpValue*>>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -182,6 +192,16 @@ struct KvpFrameImpl
      * @return The old value if there was one or nullptr.
      */
     KvpValue* set_path(Path path, KvpValue* newvalue) noexcept;
+    /**
+     * Set the value at an interned path, replacing and returning the old
+     * value if it exists or nullptr if it doesn't. Creates any missing
+     * intermediate frames. Takes ownership of new value and releases
+     * ownership of the returned old value.
+     * @param path: The interned path.
+     * @param newvalue: The value to set at the end of path.
+     * @return The old value if there was one or nullptr.
+     */
+    KvpValue* set_path(const KvpPathImpl* path, KvpValue* newvalue) noexcept;
     /**
      * Make a string representation of the frame. Mostly useful for debugging.
      * @return A std::string representing the frame and all its children.
@@ -204,6 +224,11 @@ struct KvpFrameImpl
      * @return The value at the key or nullptr.
      */
     KvpValue* get_slot(Path keys) const noexcept;
+    /** Get the value at an interned path or nullptr if it doesn't exist.
+     * @param path: The interned path.
+     * @return The value at the path or nullptr.
+     */
+    KvpValue* get_slot(const KvpPathImpl* path) const noexcept;
     /** Convenience wrapper for std::for_each, which should be preferred.
      */
     void for_each_slot(void (*proc)(const char *key, KvpValue *value,
@@ -217,6 +242,10 @@ struct KvpFrameImpl
     friend int compare(const KvpFrameImpl&, const KvpFrameImpl&) noexcept;
 
     private:
+    map_type::const_iterator find_key(const char* key, size_t len) const noexcept;
+    KvpValue* get_local(const char* key, size_t len) const noexcept;
+    KvpValue* set_local(const char* key, size_t len, KvpValue* newvalue) noexcept;
+    KvpFrameImpl* make_frame(const char* key, size_t len) noexcept;
     map_type m_valuemap;
 };
 
@@ -34,9 +34,16 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    gchar *type;            /* NULL for every type */
+    QofEventId event_mask;
+    guint serial;           /* registration order */
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
 void qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data);
 
+/* drops the events a batch holds for entity; called when it is disposed */
+void qof_event_forget_instance (QofInstance *entity);
+
 #endif
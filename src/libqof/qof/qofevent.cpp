@@ -29,6 +29,7 @@ extern "C"
 
 #include "config.h"
 #include <glib.h>
+#include <string.h>
 
 #ifdef __cplusplus
 }
@@ -40,10 +41,26 @@ extern "C"
 /* Static Variables ************************************************/
 static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
+static guint   next_serial       = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
 
+/* The same HandlerInfo records as in handlers, indexed for dispatch:
+ * handlers registered for every type go in untyped_handlers, the rest
+ * in typed_handlers keyed by their type.  All three lists are kept
+ * newest first. */
+static GList      *untyped_handlers = NULL;
+static GHashTable *typed_handlers   = NULL;
+
+/* Batch mode: events without event data are held per instance as an
+ * or-ed mask, in first-seen order, until the outermost batch ends. */
+static guint       batch_level   = 0;
+static GHashTable *batch_pending = NULL;
+static GPtrArray  *batch_order   = NULL;
+
+static QofEventStats event_stats;
+
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -78,13 +95,69 @@ find_next_handler_id(void)
     return handler_id;
 }
 
+static void
+handler_index_add (HandlerInfo *hi)
+{
+    GList *list;
+
+    if (!hi->type)
+    {
+        untyped_handlers = g_list_prepend (untyped_handlers, hi);
+        return;
+    }
+
+    if (!typed_handlers)
+        typed_handlers = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                g_free, NULL);
+    list = static_cast<GList*>(g_hash_table_lookup (typed_handlers, hi->type));
+    list = g_list_prepend (list, hi);
+    g_hash_table_insert (typed_handlers, g_strdup (hi->type), list);
+}
+
+static void
+handler_index_remove (HandlerInfo *hi)
+{
+    GList *list;
+
+    if (!hi->type)
+    {
+        untyped_handlers = g_list_remove (untyped_handlers, hi);
+        return;
+    }
+
+    list = static_cast<GList*>(g_hash_table_lookup (typed_handlers, hi->type));
+    list = g_list_remove (list, hi);
+    if (list)
+        g_hash_table_insert (typed_handlers, g_strdup (hi->type), list);
+    else
+        g_hash_table_remove (typed_handlers, hi->type);
+}
+
+static void
+handler_free (HandlerInfo *hi)
+{
+    handler_index_remove (hi);
+    g_free (hi->type);
+    g_free (hi);
+}
+
 gint
 qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+{
+    return qof_event_register_handler_filtered (handler, user_data, NULL, ~0);
+}
+
+gint
+qof_event_register_handler_filtered (QofEventHandler handler,
+                                     gpointer user_data,
+                                     QofIdTypeConst type,
+                                     QofEventId event_mask)
 {
     HandlerInfo *hi;
     gint handler_id;
 
-    ENTER ("(handler=%p, data=%p)", handler, user_data);
+    ENTER ("(handler=%p, data=%p, type=%s, mask=%x)", handler, user_data,
+           type ? type : "(all)", event_mask);
 
     /* sanity check */
     if (!handler)
@@ -102,8 +175,12 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
     hi->handler = handler;
     hi->user_data = user_data;
     hi->handler_id = handler_id;
+    hi->type = g_strdup (type);
+    hi->event_mask = event_mask;
+    hi->serial = next_serial++;
 
     handlers = g_list_prepend (handlers, hi);
+    handler_index_add (hi);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
@@ -137,7 +214,7 @@ qof_event_unregister_handler (gint handler_id)
         {
             handlers = g_list_remove_link (handlers, node);
             g_list_free_1 (node);
-            g_free (hi);
+            handler_free (hi);
         }
         else
         {
@@ -177,6 +254,8 @@ static void
 qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                              gpointer event_data)
 {
+    GList *untyped;
+    GList *typed = NULL;
     GList *node;
     GList *next_node = NULL;
 
@@ -191,16 +270,36 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     }
     }
 
+    untyped = untyped_handlers;
+    if (typed_handlers && entity->e_type)
+        typed = static_cast<GList*>(g_hash_table_lookup (typed_handlers,
+                                                         entity->e_type));
+
+    /* Both lists are newest first; merging them on the serial number
+     * calls the handlers in the same order as a single list would. */
     handler_run_level++;
-    for (node = handlers; node; node = next_node)
+    while (untyped || typed)
     {
-        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        HandlerInfo *hi;
 
-        next_node = node->next;
-        if (hi->handler)
+        if (!typed || (untyped &&
+                       static_cast<HandlerInfo*>(untyped->data)->serial >
+                       static_cast<HandlerInfo*>(typed->data)->serial))
+        {
+            hi = static_cast<HandlerInfo*>(untyped->data);
+            untyped = untyped->next;
+        }
+        else
+        {
+            hi = static_cast<HandlerInfo*>(typed->data);
+            typed = typed->next;
+        }
+
+        if (hi->handler && (hi->event_mask & event_id))
         {
             PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
                   hi->handler, event_data);
+            event_stats.delivered++;
             hi->handler (entity, event_id, hi->user_data, event_data);
         }
     }
@@ -220,19 +319,105 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                 /* remove this node from the list, then free this node */
                 handlers = g_list_remove_link (handlers, node);
                 g_list_free_1 (node);
-                g_free (hi);
+                handler_free (hi);
             }
         }
         pending_deletes = 0;
     }
 }
 
+/* Delivers the events held for entity, one call per event bit. */
+static void
+batch_flush_instance (QofInstance *entity)
+{
+    gpointer value;
+    guint mask;
+    guint bit;
+
+    if (!batch_pending)
+        return;
+    value = g_hash_table_lookup (batch_pending, entity);
+    if (!value)
+        return;
+    g_hash_table_remove (batch_pending, entity);
+
+    mask = GPOINTER_TO_UINT (value);
+    for (bit = 0; bit < sizeof (mask) * 8; bit++)
+        if (mask & (1u << bit))
+            qof_event_generate_internal (entity, (QofEventId)(1u << bit), NULL);
+}
+
+void
+qof_event_begin_batch (void)
+{
+    if (batch_level++ > 0)
+        return;
+
+    if (!batch_pending)
+    {
+        batch_pending = g_hash_table_new (g_direct_hash, g_direct_equal);
+        batch_order = g_ptr_array_new ();
+    }
+}
+
+void
+qof_event_end_batch (void)
+{
+    GPtrArray *order;
+    guint i;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+    if (--batch_level > 0)
+        return;
+
+    /* Handlers run from here may start a new batch; give it a fresh
+     * list so it can't grow the one being walked. */
+    order = batch_order;
+    batch_order = g_ptr_array_new ();
+    for (i = 0; i < order->len; i++)
+        batch_flush_instance (static_cast<QofInstance*>(g_ptr_array_index (order, i)));
+    g_ptr_array_free (order, TRUE);
+}
+
+gboolean
+qof_event_in_batch (void)
+{
+    return batch_level > 0;
+}
+
+void
+qof_event_forget_instance (QofInstance *entity)
+{
+    /* A stale pointer may stay in batch_order; without a mask in
+     * batch_pending it is skipped when the batch ends. */
+    if (batch_pending)
+        g_hash_table_remove (batch_pending, entity);
+}
+
+void
+qof_event_get_stats (QofEventStats *stats)
+{
+    g_return_if_fail (stats);
+    *stats = event_stats;
+}
+
+void
+qof_event_reset_stats (void)
+{
+    memset (&event_stats, 0, sizeof (event_stats));
+}
+
 void
 qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data)
 {
     if (!entity)
         return;
 
+    event_stats.generated++;
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
@@ -245,6 +430,34 @@ qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
     if (suspend_counter)
         return;
 
+    event_stats.generated++;
+
+    if (batch_level > 0 && event_id != QOF_EVENT_NONE)
+    {
+        gpointer value;
+
+        /* Event data may live on the caller's stack, so only events
+         * without it can wait for the end of the batch.  One that can't,
+         * or a destroy, is delivered right away, after what the instance
+         * has pending so handlers still see its events in order. */
+        if ((event_id & QOF_EVENT_DESTROY) || event_data != NULL)
+        {
+            batch_flush_instance (entity);
+        }
+        else
+        {
+            value = g_hash_table_lookup (batch_pending, entity);
+            if (!value)
+                g_ptr_array_add (batch_order, entity);
+            else if ((GPOINTER_TO_UINT (value) & event_id) == (guint)event_id)
+                event_stats.coalesced++;
+            g_hash_table_insert (batch_pending, entity,
+                                 GUINT_TO_POINTER (GPOINTER_TO_UINT (value) |
+                                                   event_id));
+            return;
+        }
+    }
+
     qof_event_generate_internal (entity, event_id, event_data);
 }
 
@@ -98,6 +98,26 @@ typedef void (*QofEventHandler) (QofInstance *ent,  QofEventId event_type,
  */
 gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data);
 
+/** \brief Register a handler for some events only.
+ *
+ * The handler is only invoked for instances whose e_type is type and
+ * for events that have a bit in common with event_mask, so it isn't
+ * called at all for the rest.  Unregister it with
+ * qof_event_unregister_handler() as usual.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ * @param type:      the instance type to listen to, or NULL for all types
+ * @param event_mask: the events to listen to, e.g.
+ *                   QOF_EVENT_MODIFY | QOF_EVENT_DESTROY
+ *
+ * @return id identifying handler
+ */
+gint qof_event_register_handler_filtered (QofEventHandler handler,
+                                          gpointer handler_data,
+                                          QofIdTypeConst type,
+                                          QofEventId event_mask);
+
 /** \brief Unregister an event handler.
  *
  * @param handler_id: the id of the handler to unregister
@@ -139,6 +159,37 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start coalescing events.
+ *
+ * Until the matching qof_event_end_batch(), events generated without
+ * event data are held back and each (instance, event) pair is delivered
+ * once when the batch ends, in the order the instances first generated
+ * an event.  Events with event data are delivered immediately, as is
+ * QOF_EVENT_DESTROY; both first deliver what the instance has pending.
+ *
+ * Batches nest; only the outermost qof_event_end_batch() delivers.
+ */
+void qof_event_begin_batch (void);
+
+/** End a batch started with qof_event_begin_batch(). */
+void qof_event_end_batch (void);
+
+/** TRUE between qof_event_begin_batch() and the matching end. */
+gboolean qof_event_in_batch (void);
+
+typedef struct
+{
+    guint64 generated;  /**< events generated while not suspended */
+    guint64 delivered;  /**< handler invocations */
+    guint64 coalesced;  /**< events dropped as duplicates in a batch */
+} QofEventStats;
+
+/** Copy the event counters into stats. */
+void qof_event_get_stats (QofEventStats *stats);
+
+/** Reset the event counters to zero. */
+void qof_event_reset_stats (void);
+
 #ifdef __cplusplus
 }
 #endif
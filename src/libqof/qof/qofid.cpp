@@ -39,15 +39,117 @@ extern "C"
 #include "qof.h"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
+#include <vector>
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* The entities of a collection, in an open-addressing table that holds a copy
+ * of each GUID next to its entity, so that a lookup probes one array instead
+ * of following a hash node to the key in the entity. Collisions are resolved
+ * by linear probing, and removal shifts the rest of the run back instead of
+ * leaving tombstones. The table doubles when it is 70% full. */
+class EntityTable
+{
+public:
+    EntityTable() : m_slots(min_slots), m_count{0} {}
+    QofInstance* lookup(const GncGUID* guid) const noexcept
+    {
+        return m_slots[find(guid)].ent;
+    }
+    /* Adds the entity, replacing any other with the same GUID. */
+    void insert(const GncGUID* guid, QofInstance* ent) noexcept;
+    void remove(const GncGUID* guid) noexcept;
+    guint size() const noexcept { return m_count; }
+    GList* values() const noexcept;
+
+private:
+    struct Slot
+    {
+        GncGUID guid;
+        QofInstance* ent;       /* nullptr if the slot is empty */
+    };
+    static const size_t min_slots = 64;
+    size_t home(const GncGUID* guid) const noexcept
+    {
+        return guid_hash64(guid) & (m_slots.size() - 1);
+    }
+    /* The slot holding guid, or the empty slot where it would go. */
+    size_t find(const GncGUID* guid) const noexcept;
+    void grow() noexcept;
+    std::vector<Slot> m_slots;
+    guint m_count;
+};
+
+size_t
+EntityTable::find(const GncGUID* guid) const noexcept
+{
+    auto mask = m_slots.size() - 1;
+    auto i = home(guid);
+    while (m_slots[i].ent &&
+           memcmp(&m_slots[i].guid, guid, sizeof(GncGUID)) != 0)
+        i = (i + 1) & mask;
+    return i;
+}
+
+void
+EntityTable::grow() noexcept
+{
+    std::vector<Slot> old(m_slots.size() * 2);
+    m_slots.swap(old);
+    for (const auto& slot : old)
+        if (slot.ent)
+            m_slots[find(&slot.guid)] = slot;
+}
+
+void
+EntityTable::insert(const GncGUID* guid, QofInstance* ent) noexcept
+{
+    if ((m_count + 1) * 10 > m_slots.size() * 7)
+        grow();
+    auto i = find(guid);
+    if (!m_slots[i].ent)
+        ++m_count;
+    m_slots[i] = {*guid, ent};
+}
+
+void
+EntityTable::remove(const GncGUID* guid) noexcept
+{
+    auto mask = m_slots.size() - 1;
+    auto hole = find(guid);
+    if (!m_slots[hole].ent)
+        return;
+    /* Move back each following entry of the run whose home isn't
+     * cyclically between the hole and its own slot. */
+    for (auto i = (hole + 1) & mask; m_slots[i].ent; i = (i + 1) & mask)
+    {
+        auto h = home(&m_slots[i].guid);
+        if (((i - h) & mask) >= ((i - hole) & mask))
+        {
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+    }
+    m_slots[hole].ent = nullptr;
+    --m_count;
+}
+
+GList*
+EntityTable::values() const noexcept
+{
+    GList* ret = nullptr;
+    for (const auto& slot : m_slots)
+        if (slot.ent)
+            ret = g_list_prepend(ret, slot.ent);
+    return ret;
+}
+
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    EntityTable* entities;
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
@@ -59,7 +161,7 @@ qof_collection_new (QofIdType type)
     QofCollection *col;
     col = g_new0(QofCollection, 1);
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->entities = new EntityTable;
     col->data = NULL;
     return col;
 }
@@ -68,9 +170,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
+    delete col->entities;
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
+    col->entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
     g_free (col);
 }
@@ -96,7 +198,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    col->entities->remove (guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -110,7 +212,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    col->entities->insert (guid, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -136,7 +238,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    coll->entities->insert (guid, ent);
     return TRUE;
 }
 
@@ -220,12 +322,9 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    return col->entities->lookup (guid);
 }
 
 QofCollection *
@@ -252,7 +351,7 @@ qof_collection_count (const QofCollection *col)
 {
     guint c;
 
-    c = g_hash_table_size(col->hash_of_entities);
+    c = col->entities->size();
     return c;
 }
 
@@ -337,12 +436,12 @@ qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
     iter.fcn = cb_func;
     iter.data = user_data;
 
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s before is %d", col->e_type, col->entities->size());
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
+    entries = col->entities->values();
     g_list_foreach (entries, foreach_cb, &iter);
     g_list_free (entries);
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s after is %d", col->e_type, col->entities->size());
 }
 /* =============================================================== */
@@ -130,6 +130,37 @@ void qof_instance_set_kvp (QofInstance *inst, const gchar *key, const GValue *va
  */
 void qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue
 *value);
+
+#ifndef __KVP_PATH
+typedef struct KvpPathImpl KvpPath;
+#define __KVP_PATH
+#endif
+/** Parses a '/'-delimited KVP path once and returns a handle to it that can
+ * be kept and passed to qof_instance_set_kvp_path and
+ * qof_instance_get_kvp_path. Equal strings get the same handle, which is
+ * never freed.
+ * @param path: The '/'-delimited path.
+ * @return The interned path.
+ */
+const KvpPath* qof_kvp_path_intern (const gchar *path);
+/** Sets a KVP slot to a value from a GValue like qof_instance_set_kvp, at an
+ * interned path.
+ * @param inst: The QofInstance on which to set the value.
+ * @param path: The path from qof_kvp_path_intern.
+ * @param value: A GValue containing an item of a type which KvpValue knows
+ * how to store.
+ */
+void qof_instance_set_kvp_path (QofInstance *inst, const KvpPath *path,
+                                const GValue *value);
+/** Retrieves the contents of a KVP slot into a provided GValue like
+ * qof_instance_get_kvp, from an interned path.
+ * @param inst: The QofInstance
+ * @param path: The path from qof_kvp_path_intern.
+ * @param value: A GValue into which to store the value of the slot. It will be
+ *               set to the correct type.
+ */
+void qof_instance_get_kvp_path (const QofInstance *inst, const KvpPath *path,
+                                GValue *value);
 /** @} Close out the DOxygen ingroup */
 /* Functions to isolate the KVP mechanism inside QOF for cases where
 GValue * operations won't work.
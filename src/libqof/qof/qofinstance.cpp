@@ -40,6 +40,7 @@ extern "C"
 #include "qofid-p.h"
 #include "kvp_frame.hpp"
 #include "qofinstance-p.h"
+#include "qofevent-p.h"
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
@@ -318,6 +319,8 @@ qof_instance_dispose (GObject *instp)
     QofInstancePrivate *priv;
     QofInstance* inst = QOF_INSTANCE(instp);
 
+    qof_event_forget_instance (inst);
+
     priv = GET_PRIVATE(instp);
     if (!priv->collection)
         return;
@@ -1062,13 +1065,13 @@ qof_instance_has_kvp (QofInstance *inst)
 void
 qof_instance_set_kvp (QofInstance *inst, const gchar *key, const GValue *value)
 {
-    delete inst->kvp_data->set_path({key}, kvp_value_from_gvalue(value));
+    delete inst->kvp_data->set_path(key, kvp_value_from_gvalue(value));
 }
 
-void
-qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
+static void
+gvalue_set_from_kvp (GValue *value, const KvpValue *slot)
 {
-    auto temp = gvalue_from_kvp_value (inst->kvp_data->get_slot(key));
+    auto temp = gvalue_from_kvp_value (slot);
     if (G_IS_VALUE (temp))
     {
         if (G_IS_VALUE (value))
@@ -1079,6 +1082,32 @@ qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
     }
 }
 
+void
+qof_instance_get_kvp (const QofInstance *inst, const gchar *key, GValue *value)
+{
+    gvalue_set_from_kvp (value, inst->kvp_data->get_slot(key));
+}
+
+const KvpPath*
+qof_kvp_path_intern (const gchar *path)
+{
+    return KvpPathImpl::intern (path);
+}
+
+void
+qof_instance_set_kvp_path (QofInstance *inst, const KvpPath *path,
+                           const GValue *value)
+{
+    delete inst->kvp_data->set_path(path, kvp_value_from_gvalue(value));
+}
+
+void
+qof_instance_get_kvp_path (const QofInstance *inst, const KvpPath *path,
+                           GValue *value)
+{
+    gvalue_set_from_kvp (value, inst->kvp_data->get_slot(path));
+}
+
 void
 qof_instance_copy_kvp (QofInstance *to, const QofInstance *from)
 {
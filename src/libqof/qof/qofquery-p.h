@@ -58,6 +58,35 @@ QofQueryPredData *qof_query_term_get_pred_data (const QofQueryTerm *queryterm);
 gboolean qof_query_term_is_inverted (const QofQueryTerm *queryterm);
 
 
+/* Query indexes
+ *
+ * An object type can register an index which the query planner asks
+ * for the candidate objects of an OR-term instead of visiting every
+ * object of that type in the book.  The index looks at the AND-ed
+ * terms it understands and ignores the rest; every object it returns
+ * is still checked against all of the terms, so it may return objects
+ * that don't match, but it must not miss any that do.
+ */
+typedef struct
+{
+    /* A short description, for qof_query_print */
+    const char *name;
+
+    /* Return how many objects of the book the index would visit for
+     * the AND-ed terms, or -1 if it can't narrow them down. */
+    gint64 (*estimate) (QofBook *book, const GList *and_terms);
+
+    /* Call cb once for each object of the book which may satisfy the
+     * AND-ed terms. */
+    void (*foreach) (QofBook *book, const GList *and_terms,
+                     QofInstanceForeachCB cb, gpointer user_data);
+} QofQueryIndex;
+
+/* Register the index for queries searching for objects of the given
+ * type.  The index is not copied and must outlive the registration. */
+void qof_query_register_index (QofIdTypeConst type, const QofQueryIndex *index);
+
+
 /* Functions to get and look at QuerySorts */
 
 /* This function returns the primary, secondary, and tertiary sorts.
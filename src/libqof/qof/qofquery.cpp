@@ -47,6 +47,9 @@ extern "C"
 
 static QofLogModule log_module = QOF_MOD_QUERY;
 
+/* The registered indexes, keyed by the object type they index. */
+static GHashTable *query_indexes = NULL;
+
 struct _QofQueryTerm
 {
     QofQueryParamList *     param_list;
@@ -110,15 +113,32 @@ struct _QofQuery
     gint              changed;
 
     GList *           results;
+
+    /* The query plan: for each of the OR-terms, its AND-terms in the
+     * order check_object evaluates them.  Built by compile_terms. */
+    GList *           plan;
 };
 
+typedef struct
+{
+    gpointer          object;
+    gint              seq;      /* The order in which it was found */
+} QofQueryTopEntry;
+
 typedef struct _QofQueryCB
 {
     QofQuery *        query;
     GList *           list;
     gint              count;
+
+    /* If the results get sorted and cropped to max_results, only the
+     * ones that survive the cropping are kept, in a heap of
+     * QofQueryTopEntry instead of the list. */
+    GArray *          top;
 } QofQueryCB;
 
+static void query_free_plan (QofQuery *q);
+
 /* initial_term will be owned by the new Query */
 static void query_init (QofQuery *q, QofQueryTerm *initial_term)
 {
@@ -148,6 +168,8 @@ static void query_init (QofQuery *q, QofQueryTerm *initial_term)
     g_slist_free (q->secondary_sort.param_fcns);
     g_slist_free (q->tertiary_sort.param_fcns);
 
+    query_free_plan (q);
+
     ht = q->be_compiled;
     memset (q, 0, sizeof (*q));
     q->be_compiled = ht;
@@ -280,6 +302,8 @@ static void free_members (QofQuery *q)
 
     g_list_free(q->results);
     q->results = NULL;
+
+    query_free_plan (q);
 }
 
 static int cmp_func (const QofQuerySort *sort, QofSortFunc default_sort,
@@ -376,7 +400,7 @@ check_object (const QofQuery *q, gpointer object)
     const QofQueryTerm * qt;
     int       and_terms_ok = 1;
 
-    for (or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+    for (or_ptr = q->plan; or_ptr; or_ptr = or_ptr->next)
     {
         and_terms_ok = 1;
         for (and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
@@ -514,6 +538,118 @@ compile_sort (QofQuerySort *sort, QofIdType obj)
     LEAVE ("sort=%p id=%s", sort, obj);
 }
 
+/********************************************************************/
+/* The query planner.  Nothing is known about the data, so the terms
+ * are ordered by a guess at how much evaluating them costs: each step
+ * of the parameter path is a getter call, comparing strings is dearer
+ * than comparing numbers, and a regular expression dearer still.  The
+ * AND-terms are pure predicates, so their order doesn't change the
+ * result, only how soon a failing object is rejected.
+ */
+
+static gint
+query_term_cost (const QofQueryTerm *qt)
+{
+    const QofQueryPredData *pd = qt->pdata;
+    gint cost = 2 * g_slist_length (qt->param_list);
+
+    if (!g_strcmp0 (pd->type_name, QOF_TYPE_STRING))
+        cost += ((const query_string_def*)pd)->is_regex ? 16 : 4;
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_GUID))
+        cost += 1 + g_list_length (((const query_guid_def*)pd)->guids);
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_CHOICE))
+        cost += 1 + g_list_length (((const query_choice_def*)pd)->guids);
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_COLLECT))
+        cost += 1 + g_list_length (((const query_coll_def*)pd)->guids);
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_KVP))
+        cost += 8;
+    else if (!g_strcmp0 (pd->type_name, QOF_TYPE_NUMERIC) ||
+             !g_strcmp0 (pd->type_name, QOF_TYPE_DEBCRED) ||
+             !g_strcmp0 (pd->type_name, QOF_TYPE_DOUBLE))
+        cost += 2;
+    else
+        cost += 1;
+
+    return cost;
+}
+
+static gint
+query_term_cost_cmp (gconstpointer a, gconstpointer b)
+{
+    return query_term_cost (static_cast<const QofQueryTerm*>(a)) -
+           query_term_cost (static_cast<const QofQueryTerm*>(b));
+}
+
+/* Copy the OR-list of AND-lists of terms, with each AND-list sorted
+ * cheapest first.  The terms themselves are shared. */
+static GList *
+query_plan_terms (const GList *terms)
+{
+    GList *plan = NULL;
+    const GList *or_ptr;
+
+    for (or_ptr = terms; or_ptr; or_ptr = or_ptr->next)
+    {
+        GList *and_terms = g_list_copy (static_cast<GList*>(or_ptr->data));
+        plan = g_list_prepend (plan, g_list_sort (and_terms,
+                                                  query_term_cost_cmp));
+    }
+    return g_list_reverse (plan);
+}
+
+static void
+query_plan_free (GList *plan)
+{
+    GList *node;
+
+    for (node = plan; node; node = node->next)
+        g_list_free (static_cast<GList*>(node->data));
+    g_list_free (plan);
+}
+
+static void
+query_free_plan (QofQuery *q)
+{
+    query_plan_free (q->plan);
+    q->plan = NULL;
+}
+
+/* Choose how to find the candidate objects in a book.  Returns the
+ * index registered for the searched-for type if it can narrow every
+ * OR-term of the plan down and visits fewer objects than a full scan,
+ * or NULL to scan the book.  *visits is set to the number of objects
+ * the chosen way visits and *count to the number in the book. */
+static const QofQueryIndex *
+query_plan_index (QofIdTypeConst search_for, const GList *plan,
+                  QofBook *book, gint64 *visits, gint64 *count)
+{
+    const QofQueryIndex *index = NULL;
+    const GList *node;
+    gint64 total = 0;
+
+    *count = qof_collection_count (qof_book_get_collection (book, search_for));
+    *visits = *count;
+
+    if (plan && query_indexes)
+        index = static_cast<const QofQueryIndex*>(
+                    g_hash_table_lookup (query_indexes, search_for));
+    if (!index)
+        return NULL;
+
+    for (node = plan; node; node = node->next)
+    {
+        gint64 n = index->estimate (book, static_cast<GList*>(node->data));
+        if (n < 0)
+            return NULL;
+        total += n;
+        if (total >= *count)
+            return NULL;
+    }
+
+    *visits = total;
+    return index;
+}
+
 static void compile_terms (QofQuery *q)
 {
     GList *or_ptr, *and_ptr, *node;
@@ -548,6 +684,9 @@ static void compile_terms (QofQuery *q)
         }
     }
 
+    query_free_plan (q);
+    q->plan = query_plan_terms (q->terms);
+
     /* Update the sort functions */
     compile_sort (&(q->primary_sort), q->search_for);
     compile_sort (&(q->secondary_sort), q->search_for);
@@ -571,6 +710,77 @@ static void compile_terms (QofQuery *q)
     LEAVE (" query=%p", q);
 }
 
+/* The sort order of the query, with ties broken by the order in which
+ * the objects were found.  That is the order in which the stable sort
+ * of the whole list of matches leaves them. */
+static int
+query_top_entry_cmp (gconstpointer a, gconstpointer b, gpointer q)
+{
+    const QofQueryTopEntry *ea = static_cast<const QofQueryTopEntry*>(a);
+    const QofQueryTopEntry *eb = static_cast<const QofQueryTopEntry*>(b);
+    int retval = sort_func (ea->object, eb->object, q);
+
+    if (retval)
+        return retval;
+    return (ea->seq > eb->seq) - (ea->seq < eb->seq);
+}
+
+/* Keep the object if it is among the max_results last ones in sort
+ * order found so far.  The heap has the first of those at its root,
+ * which is the one to drop when a later object turns up. */
+static void query_top_add (QofQueryCB* ql, gpointer object)
+{
+    QofQueryTopEntry entry = { object, ql->count };
+    GArray *heap = ql->top;
+    QofQueryTopEntry *e;
+    guint i, child;
+
+    if (heap->len < (guint) ql->query->max_results)
+    {
+        g_array_append_val (heap, entry);
+        e = &g_array_index (heap, QofQueryTopEntry, 0);
+        for (i = heap->len - 1; i > 0; i = (i - 1) / 2)
+        {
+            if (query_top_entry_cmp (&e[(i - 1) / 2], &entry, ql->query) <= 0)
+                break;
+            e[i] = e[(i - 1) / 2];
+        }
+        e[i] = entry;
+        return;
+    }
+
+    if (heap->len == 0)
+        return;
+    e = &g_array_index (heap, QofQueryTopEntry, 0);
+    if (query_top_entry_cmp (&entry, &e[0], ql->query) < 0)
+        return;
+    for (i = 0; (child = 2 * i + 1) < heap->len; i = child)
+    {
+        if (child + 1 < heap->len &&
+            query_top_entry_cmp (&e[child + 1], &e[child], ql->query) < 0)
+            child++;
+        if (query_top_entry_cmp (&entry, &e[child], ql->query) <= 0)
+            break;
+        e[i] = e[child];
+    }
+    e[i] = entry;
+}
+
+/* Free the heap and return its objects in sort order. */
+static GList * query_top_list (QofQueryCB* ql)
+{
+    GList *list = NULL;
+    guint i;
+
+    g_array_sort_with_data (ql->top, query_top_entry_cmp, ql->query);
+    for (i = ql->top->len; i > 0; i--)
+        list = g_list_prepend (list, g_array_index (ql->top, QofQueryTopEntry,
+                                                    i - 1).object);
+    g_array_free (ql->top, TRUE);
+    ql->top = NULL;
+    return list;
+}
+
 static void check_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
@@ -579,7 +789,10 @@ static void check_item_cb (gpointer object, gpointer user_data)
 
     if (check_object (ql->query, object))
     {
-        ql->list = g_list_prepend (ql->list, object);
+        if (ql->top)
+            query_top_add (ql, object);
+        else
+            ql->list = g_list_prepend (ql->list, object);
         ql->count++;
     }
     return;
@@ -732,6 +945,7 @@ static GList * qof_query_run_internal (QofQuery *q,
 {
     GList *matching_objects = NULL;
     int        object_count = 0;
+    gboolean   sorted;
 
     if (!q) return NULL;
     g_return_val_if_fail (q->search_for, NULL);
@@ -739,9 +953,8 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_return_val_if_fail (run_cb, NULL);
     ENTER (" q=%p", q);
 
-    /* XXX: Prioritize the query terms? */
-
-    /* prepare the Query for processing */
+    /* prepare the Query for processing; this also plans the order in
+     * which the terms get evaluated. */
     if (q->changed)
     {
         query_clear_compiles (q);
@@ -752,6 +965,9 @@ static GList * qof_query_run_internal (QofQuery *q,
     if (qof_log_check (log_module, QOF_LOG_DEBUG))
         qof_query_print (q);
 
+    sorted = (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+              (q->primary_sort.use_default && q->defaultSort));
+
     /* Now run the query over all the objects and save the results */
     {
         QofQueryCB qcb;
@@ -759,25 +975,40 @@ static GList * qof_query_run_internal (QofQuery *q,
         memset (&qcb, 0, sizeof (qcb));
         qcb.query = q;
 
+        /* If the matches get sorted and cropped, only keep the last
+         * max_results of them in sort order rather than sorting them
+         * all and throwing most away. */
+        if (sorted && q->max_results > -1)
+            qcb.top = g_array_sized_new (FALSE, FALSE, sizeof (QofQueryTopEntry),
+                                         MIN (q->max_results, 1024));
+
         /* Run the query callback */
         run_cb(&qcb, cb_arg);
 
-        matching_objects = qcb.list;
-        object_count = qcb.count;
+        if (qcb.top)
+        {
+            /* Already sorted and cropped */
+            matching_objects = query_top_list (&qcb);
+            object_count = MIN (qcb.count, q->max_results);
+            sorted = FALSE;
+        }
+        else
+        {
+            /* There is no absolute need to reverse this list, since
+             * it's being sorted below. However, in the common case, we
+             * will be searching in a confined location where the
+             * objects are already in order, thus reversing will put us
+             * in the correct order we want and make the sorting go much
+             * faster.
+             */
+            matching_objects = g_list_reverse (qcb.list);
+            object_count = qcb.count;
+        }
+        PINFO ("matching objects=%p count=%d", matching_objects, qcb.count);
     }
-    PINFO ("matching objects=%p count=%d", matching_objects, object_count);
-
-    /* There is no absolute need to reverse this list, since it's being
-     * sorted below. However, in the common case, we will be searching
-     * in a confined location where the objects are already in order,
-     * thus reversing will put us in the correct order we want and make
-     * the sorting go much faster.
-     */
-    matching_objects = g_list_reverse(matching_objects);
 
     /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
+    if (sorted)
     {
         matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
     }
@@ -818,6 +1049,60 @@ static GList * qof_query_run_internal (QofQuery *q,
     return matching_objects;
 }
 
+typedef struct
+{
+    QofQueryCB *      qcb;
+    GHashTable *      seen;
+} QofQueryUnionCB;
+
+static void check_unseen_item_cb (QofInstance *inst, gpointer user_data)
+{
+    QofQueryUnionCB* ucb = static_cast<QofQueryUnionCB*>(user_data);
+
+    if (g_hash_table_lookup (ucb->seen, inst))
+        return;
+    g_hash_table_insert (ucb->seen, inst, inst);
+    check_item_cb (inst, ucb->qcb);
+}
+
+/* Check the objects of the book which may match the query: the ones
+ * an index returns for each OR-term if the planner picked one, else
+ * all of them. */
+static void query_foreach_candidate (QofQueryCB* qcb, QofBook *book)
+{
+    QofQuery *q = qcb->query;
+    const QofQueryIndex *index;
+    QofQueryUnionCB ucb;
+    gint64 visits, count;
+    GList *node;
+
+    index = query_plan_index (q->search_for, q->plan, book, &visits, &count);
+    if (!index)
+    {
+        qof_object_foreach (q->search_for, book,
+                            (QofInstanceForeachCB) check_item_cb, qcb);
+        return;
+    }
+
+    PINFO ("index %s: %" G_GINT64_FORMAT " of %" G_GINT64_FORMAT " objects",
+           index->name, visits, count);
+    if (!q->plan->next)
+    {
+        index->foreach (book, static_cast<GList*>(q->plan->data),
+                        (QofInstanceForeachCB) check_item_cb, qcb);
+        return;
+    }
+
+    /* An object can be a candidate for more than one OR-term, but
+     * must only be checked once. */
+    ucb.qcb = qcb;
+    ucb.seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+    for (node = q->plan; node; node = node->next)
+        index->foreach (book, static_cast<GList*>(node->data),
+                        check_unseen_item_cb, &ucb);
+    g_hash_table_destroy (ucb.seen);
+}
+
 static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
 {
     GList *node;
@@ -842,9 +1127,8 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* And then iterate over the candidate objects */
+        query_foreach_candidate (qcb, book);
     }
 }
 
@@ -1014,6 +1298,7 @@ QofQuery * qof_query_copy (QofQuery *q)
     memcpy (copy, q, sizeof (QofQuery));
 
     copy->be_compiled = ht;
+    copy->plan = NULL;
     copy->terms = copy_or_terms (q->terms);
     copy->books = g_list_copy (q->books);
     copy->results = g_list_copy (q->results);
@@ -1352,10 +1637,28 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    if (query_indexes)
+    {
+        g_hash_table_destroy (query_indexes);
+        query_indexes = NULL;
+    }
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
 
+void qof_query_register_index (QofIdTypeConst type, const QofQueryIndex *index)
+{
+    g_return_if_fail (type);
+
+    if (!query_indexes)
+        query_indexes = g_hash_table_new (g_str_hash, g_str_equal);
+
+    if (index)
+        g_hash_table_insert (query_indexes, (gpointer)type, (gpointer)index);
+    else
+        g_hash_table_remove (query_indexes, type);
+}
+
 int qof_query_get_max_results (const QofQuery *q)
 {
     if (!q) return 0;
@@ -1497,6 +1800,7 @@ gboolean qof_query_equal (const QofQuery *q1, const QofQuery *q2)
 /* Static prototypes */
 static GList *qof_query_printSearchFor (QofQuery * query, GList * output);
 static GList *qof_query_printTerms (QofQuery * query, GList * output);
+static GList *qof_query_printPlan (QofQuery * query, GList * output);
 static GList *qof_query_printSorts (QofQuerySort *s[], const gint numSorts,
                                     GList * output);
 static GList *qof_query_printAndTerms (GList * terms, GList * output);
@@ -1541,6 +1845,7 @@ qof_query_print (QofQuery * query)
 
     output = qof_query_printSearchFor (query, output);
     output = qof_query_printTerms (query, output);
+    output = qof_query_printPlan (query, output);
 
     qof_query_get_sorts (query, &s[0], &s[1], &s[2]);
 
@@ -1622,6 +1927,61 @@ qof_query_printTerms (QofQuery * query, GList * output)
     return output;
 }       /* qof_query_printTerms */
 
+/*
+        Explain the query plan: the order in which the AND terms
+        get evaluated, and how the candidate objects of each book
+        are found.
+*/
+static GList *
+qof_query_printPlan (QofQuery * query, GList * output)
+{
+    GList *plan, *lst;
+
+    plan = query_plan_terms (query->terms);
+
+    output = g_list_append (output, g_string_new ("Query Plan:"));
+    for (lst = query->books; lst; lst = lst->next)
+    {
+        QofBook *book = static_cast<QofBook*>(lst->data);
+        const QofQueryIndex *index;
+        gint64 visits, count;
+        GString *gs = g_string_new (" ");
+
+        if (!query->search_for)
+            break;
+        index = query_plan_index (query->search_for, plan, book,
+                                  &visits, &count);
+        if (index)
+            g_string_printf (gs, "  Book %p: index %s, %" G_GINT64_FORMAT
+                             " of %" G_GINT64_FORMAT " objects", book,
+                             index->name, visits, count);
+        else
+            g_string_printf (gs, "  Book %p: scan all %" G_GINT64_FORMAT
+                             " objects", book, count);
+        output = g_list_append (output, gs);
+    }
+
+    for (lst = plan; lst; lst = lst->next)
+    {
+        GList *and_ptr;
+
+        output = g_list_append (output,
+                                g_string_new ("  Evaluate AND Terms in order:"));
+        for (and_ptr = static_cast<GList*>(lst->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            QofQueryTerm *qt = static_cast<QofQueryTerm*>(and_ptr->data);
+            GString *gs = qof_query_printParamPath (qt->param_list);
+
+            g_string_append_printf (gs, " (cost %d)", query_term_cost (qt));
+            output = g_list_append (output, gs);
+        }
+    }
+
+    query_plan_free (plan);
+    return output;
+}       /* qof_query_printPlan */
+
 /*
         Process the sort parameters
         If this function is called, the assumption is that the first sort
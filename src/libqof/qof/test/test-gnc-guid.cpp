@@ -186,6 +186,24 @@ static void test_gnc_guid_from_string (void) {
     guid_free (guid);
 }
 
+/* Every byte of the GUID must reach the hash, and flipping any one bit
+should change the 32-bit hash used by GHashTables.*/
+static void test_gnc_guid_hash (void) {
+    GncGUID guid;
+    guid_replace (&guid);
+    auto hash64 = guid_hash64 (&guid);
+    auto hash = guid_hash_to_guint (&guid);
+    for (int byte = 0; byte < GUID_DATA_SIZE; ++byte)
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            GncGUID other {guid};
+            other.reserved[byte] ^= 1 << bit;
+            g_assert (guid_hash64 (&other) != hash64);
+            g_assert (guid_hash_to_guint (&other) != hash);
+        }
+    g_assert (guid_hash64 (&guid) == hash64);
+}
+
 void test_suite_gnc_guid (void)
 {
     GNC_TEST_ADD_FUNC (suitename, "gnc create guid", test_create_gnc_guid);
@@ -195,5 +213,6 @@ void test_suite_gnc_guid (void)
     GNC_TEST_ADD_FUNC (suitename, "gnc guid string roundtrip", test_gnc_guid_roundtrip);
     GNC_TEST_ADD_FUNC (suitename, "gnc guid from string", test_gnc_guid_from_string);
     GNC_TEST_ADD_FUNC (suitename, "gnc guid replace", test_gnc_guid_replace);
+    GNC_TEST_ADD_FUNC (suitename, "gnc guid hash", test_gnc_guid_hash);
 }
 
@@ -40,8 +40,231 @@ test_gnc_numeric_add (void)
     g_assert (gnc_numeric_equal (result, goal_ab));
 }
 
+/* Amounts with related denominators are added and compared in 64 bits; the
+ * results must match the general code's. */
+static void
+test_gnc_numeric_add_related_denoms (void)
+{
+    gnc_numeric a = { 12345, 100 };
+    gnc_numeric b = { -6789, 100 };
+    gnc_numeric c = { 5, 1000 };
+    gnc_numeric big = { G_MAXINT64 - 10, 100 };
+    gnc_numeric result;
+
+    result = gnc_numeric_add (a, b, 100, GNC_HOW_RND_ROUND);
+    g_assert_cmpint (result.num, ==, 5556);
+    g_assert_cmpint (result.denom, ==, 100);
+    result = gnc_numeric_sub (a, b, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    g_assert_cmpint (result.num, ==, 19134);
+    g_assert_cmpint (result.denom, ==, 100);
+    result = gnc_numeric_add (a, c, GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD);
+    g_assert_cmpint (result.num, ==, 123455);
+    g_assert_cmpint (result.denom, ==, 1000);
+    result = gnc_numeric_add (a, b, 10000, GNC_HOW_RND_NEVER);
+    g_assert_cmpint (result.num, ==, 555600);
+    g_assert_cmpint (result.denom, ==, 10000);
+    /* These need rounding or reduction. */
+    result = gnc_numeric_add (a, c, 100, GNC_HOW_RND_ROUND);
+    g_assert_cmpint (result.num, ==, 12346);
+    g_assert_cmpint (result.denom, ==, 100);
+    result = gnc_numeric_add (a, c, GNC_DENOM_AUTO, GNC_HOW_DENOM_REDUCE);
+    g_assert_cmpint (result.num, ==, 24691);
+    g_assert_cmpint (result.denom, ==, 200);
+    result = gnc_numeric_add (a, c, GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_DENOM_DIFF);
+    /* 64-bit overflow. */
+    result = gnc_numeric_add (big, a, 100, GNC_HOW_RND_NEVER);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_OVERFLOW);
+    result = gnc_numeric_add (big, b, 1000, GNC_HOW_RND_NEVER);
+    g_assert_cmpint (gnc_numeric_check (result), ==, GNC_ERROR_OVERFLOW);
+
+    g_assert_cmpint (gnc_numeric_compare (a, c), ==, 1);
+    g_assert_cmpint (gnc_numeric_compare (c, a), ==, -1);
+    g_assert_cmpint (gnc_numeric_compare (a, gnc_numeric_create (123450, 1000)), ==, 0);
+    g_assert_cmpint (gnc_numeric_compare (big, gnc_numeric_create (1, 1000)), ==, 1);
+    g_assert (gnc_numeric_equal (gnc_numeric_create (5, 10), gnc_numeric_create (50, 100)));
+}
+
+static void
+sum_scalar (const gnc_numeric *values, const guint8 *masks, gsize n,
+            guint n_sums, gnc_numeric *sums)
+{
+    gsize i;
+    guint k;
+
+    for (i = 0; i < n; i++)
+        for (k = 0; k < n_sums; k++)
+            if (!masks || (masks[i] >> k) & 1)
+                sums[k] = gnc_numeric_add_fixed (sums[k], values[i]);
+}
+
+static void
+check_sums (const gnc_numeric *values, const guint8 *masks, gsize n)
+{
+    gnc_numeric batch[3] = { { 0, 1 }, { 0, 1 }, { 5, 100 } };
+    gnc_numeric scalar[3];
+    guint k;
+
+    memcpy (scalar, batch, sizeof (batch));
+    gnc_numeric_sum_fixed (values, masks, n, 3, batch);
+    sum_scalar (values, masks, n, 3, scalar);
+    for (k = 0; k < 3; k++)
+    {
+        g_assert_cmpint (batch[k].num, ==, scalar[k].num);
+        g_assert_cmpint (batch[k].denom, ==, scalar[k].denom);
+    }
+}
+
+/* The batch sums must match gnc_numeric_add_fixed step for step, including
+ * the denominator of zero sums and any error. */
+static void
+test_gnc_numeric_sum_fixed (void)
+{
+    GRand *rand = g_rand_new_with_seed (1);
+    gnc_numeric values[1000];
+    guint8 masks[1000];
+    gsize i;
+
+    for (i = 0; i < 1000; i++)
+    {
+        values[i] = gnc_numeric_create (g_rand_int_range (rand, -100000, 100000),
+                                        100);
+        masks[i] = g_rand_int_range (rand, 0, 8);
+        if (i % 7 == 0)
+            values[i].num = 0;
+    }
+    check_sums (values, masks, 1000);
+    check_sums (values, NULL, 1000);
+    check_sums (values, masks, 300);
+
+    /* Zeros with other denominators don't change the sum. */
+    values[10] = gnc_numeric_create (0, 1000);
+    check_sums (values, masks, 1000);
+    /* A different denominator is an error from then on. */
+    values[600] = gnc_numeric_create (1, 1000);
+    masks[600] = 7;
+    check_sums (values, masks, 1000);
+    values[600] = gnc_numeric_create (1, 100);
+    /* So is overflow, even if a later value would bring the sum back. */
+    values[700] = gnc_numeric_create (G_MAXINT64 - 5, 100);
+    values[701] = gnc_numeric_create (-G_MAXINT64 + 5, 100);
+    masks[700] = masks[701] = 7;
+    check_sums (values, masks, 1000);
+    values[700] = gnc_numeric_error (GNC_ERROR_OVERFLOW);
+    check_sums (values, masks, 1000);
+    g_rand_free (rand);
+}
+
+#define PERF_REPS 5000000
+
+typedef gnc_numeric (*BinaryOp) (gnc_numeric, gnc_numeric, gint64, gint);
+
+static void
+time_binary_op (const gchar *name, BinaryOp op, gint64 a_denom,
+                gint64 b_denom, gint64 denom, gint how)
+{
+    gnc_numeric sum = { 0, a_denom };
+    gnc_numeric step = { 3, b_denom };
+    int i;
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_REPS; i++)
+        sum = op (sum, step, denom, how);
+    g_test_minimized_result (g_test_timer_elapsed (), "%d %s, denominators %"
+                             G_GINT64_FORMAT " and %" G_GINT64_FORMAT,
+                             PERF_REPS, name, a_denom, b_denom);
+    g_assert (gnc_numeric_check (sum) == GNC_ERROR_OK);
+}
+
+static void
+time_compare (gint64 a_denom, gint64 b_denom)
+{
+    gnc_numeric a = { 0, a_denom };
+    gnc_numeric b = { 12345, b_denom };
+    int i, less = 0;
+
+    g_test_timer_start ();
+    for (i = 0; i < PERF_REPS; i++)
+    {
+        a.num = i;
+        if (gnc_numeric_compare (a, b) < 0)
+            ++less;
+    }
+    g_test_minimized_result (g_test_timer_elapsed (), "%d compares, "
+                             "denominators %" G_GINT64_FORMAT " and %"
+                             G_GINT64_FORMAT, PERF_REPS, a_denom, b_denom);
+    g_assert_cmpint (less, >, 0);
+}
+
+/* Shared and power-of-ten denominators take the 64-bit paths; thirds and
+ * hundredths need the general rational code, for comparison. */
+static void
+test_gnc_numeric_perf (void)
+{
+    time_binary_op ("adds", gnc_numeric_add, 100, 100, 100, GNC_HOW_RND_ROUND);
+    time_binary_op ("adds", gnc_numeric_add, 1000, 100, 1000, GNC_HOW_RND_ROUND);
+    time_binary_op ("adds", gnc_numeric_add, 1000, 100, GNC_DENOM_AUTO,
+                    GNC_HOW_DENOM_LCD);
+    time_binary_op ("adds", gnc_numeric_add, 100, 3, 100, GNC_HOW_RND_ROUND);
+    time_binary_op ("subtracts", gnc_numeric_sub, 100, 100, 100,
+                    GNC_HOW_RND_ROUND);
+    time_binary_op ("subtracts", gnc_numeric_sub, 1000, 100, GNC_DENOM_AUTO,
+                    GNC_HOW_DENOM_EXACT);
+    time_binary_op ("subtracts", gnc_numeric_sub, 100, 3, 100,
+                    GNC_HOW_RND_ROUND);
+    time_compare (100, 100);
+    time_compare (100, 1000);
+    time_compare (100, 3);
+}
+
+#define SUM_PERF_VALUES 10000000
+
+/* Balance, cleared and reconciled sums over ten million amounts, as
+ * xaccSplitListSumAmounts takes them. */
+static void
+test_gnc_numeric_sum_perf (void)
+{
+    gnc_numeric *values = g_new (gnc_numeric, SUM_PERF_VALUES);
+    guint8 *masks = g_new (guint8, SUM_PERF_VALUES);
+    gnc_numeric batch[3], scalar[3];
+    gsize i;
+    guint k;
+
+    for (i = 0; i < SUM_PERF_VALUES; i++)
+    {
+        values[i] = gnc_numeric_create ((i * 7919) % 200001 - 100000, 100);
+        masks[i] = 1 | (i % 3 ? 2 : 0) | (i % 5 ? 4 : 0);
+    }
+    for (k = 0; k < 3; k++)
+        batch[k] = scalar[k] = gnc_numeric_zero ();
+
+    g_test_timer_start ();
+    sum_scalar (values, masks, SUM_PERF_VALUES, 3, scalar);
+    g_test_minimized_result (g_test_timer_elapsed (), "%d amounts summed "
+                             "one at a time", SUM_PERF_VALUES);
+    g_test_timer_start ();
+    gnc_numeric_sum_fixed (values, masks, SUM_PERF_VALUES, 3, batch);
+    g_test_minimized_result (g_test_timer_elapsed (), "%d amounts summed "
+                             "in batches", SUM_PERF_VALUES);
+
+    for (k = 0; k < 3; k++)
+        g_assert (gnc_numeric_equal (batch[k], scalar[k]));
+    g_free (values);
+    g_free (masks);
+}
+
 void
 test_suite_gnc_numeric ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "gnc-numeric add", test_gnc_numeric_add );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric add related denominators",
+                       test_gnc_numeric_add_related_denoms );
+    GNC_TEST_ADD_FUNC( suitename, "gnc-numeric sum fixed",
+                       test_gnc_numeric_sum_fixed );
+    if (g_test_perf ())
+    {
+        GNC_TEST_ADD_FUNC( suitename, "gnc-numeric perf", test_gnc_numeric_perf );
+        GNC_TEST_ADD_FUNC( suitename, "gnc-numeric sum perf",
+                           test_gnc_numeric_sum_perf );
+    }
 }
@@ -26,6 +26,9 @@
 #include "../kvp_frame.hpp"
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
 
 class KvpFrameTest : public ::testing::Test
 {
@@ -201,3 +204,85 @@ TEST_F (KvpFrameTest, Empty)
     EXPECT_TRUE(f1.empty());
     EXPECT_FALSE(f2.empty());
 }
+
+TEST_F (KvpFrameTest, InternedPath)
+{
+    auto path1 = KvpPathImpl::intern ("/top//second/twenty-first/");
+    auto path2 = KvpPathImpl::intern ("top/third/thirty-first");
+    auto path3 = KvpPathImpl::intern ("top/first");
+    auto v1 = new KvpValueImpl {15.0};
+
+    ASSERT_NE (nullptr, path1);
+    EXPECT_EQ (3, path1->m_keys.size ());
+    EXPECT_EQ (path1, KvpPathImpl::intern ("/top//second/twenty-first/"));
+    EXPECT_EQ (nullptr, KvpPathImpl::intern (nullptr));
+    EXPECT_EQ (t_int_val, t_root.get_slot (path3));
+    EXPECT_EQ (nullptr, t_root.get_slot (path1));
+    EXPECT_EQ (nullptr, t_root.set_path (path1, v1));
+    EXPECT_EQ (v1, t_root.get_slot (path1));
+    EXPECT_EQ (v1, t_root.get_slot ("top/second/twenty-first"));
+    EXPECT_EQ (v1, t_root.set_path (path1, nullptr));
+    EXPECT_EQ (nullptr, t_root.get_slot (path1));
+    /* "third" holds a string, so it's replaced with a frame. */
+    EXPECT_EQ (nullptr, t_root.set_path (path2, v1));
+    EXPECT_EQ (v1, t_root.get_slot ("top/third/thirty-first"));
+}
+
+TEST_F (KvpFrameTest, KeysSorted)
+{
+    KvpFrameImpl frame;
+    for (auto key : {"m", "b", "z", "a", "ma", "mb"})
+        frame.set (key, new KvpValue {INT64_C(1)});
+    delete frame.set ("b", nullptr);
+    std::vector<std::string> expected {"a", "m", "ma", "mb", "z"};
+    EXPECT_EQ (expected, frame.get_keys ());
+    EXPECT_EQ (nullptr, frame.get_slot ("mc"));
+    EXPECT_EQ (nullptr, frame.get_slot ("b"));
+    KvpFrameImpl copy {frame};
+    EXPECT_EQ (0, compare (frame, copy));
+}
+
+/* Timings for deep and wide frames; run with
+ * --gtest_also_run_disabled_tests. */
+TEST (KvpFramePerf, DISABLED_DeepAndWide)
+{
+    const int depth = 8, width = 10000, reps = 100;
+    std::string deep;
+    for (int i = 0; i < depth; ++i)
+        deep += "/level-" + std::to_string (i);
+    auto deep_path = KvpPathImpl::intern (deep.c_str ());
+    KvpFrameImpl frame;
+    frame.set_path (deep.c_str (), new KvpValue {INT64_C(1)});
+    for (int i = 0; i < width; ++i)
+    {
+        auto key = "wide/token-" + std::to_string (i);
+        frame.set_path (key.c_str (), new KvpValue {INT64_C(1)});
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto start = clock::now ();
+    for (int i = 0; i < width * reps; ++i)
+        ASSERT_NE (nullptr, frame.get_slot (deep.c_str ()));
+    auto string_time = clock::now () - start;
+    start = clock::now ();
+    for (int i = 0; i < width * reps; ++i)
+        ASSERT_NE (nullptr, frame.get_slot (deep_path));
+    auto interned_time = clock::now () - start;
+    start = clock::now ();
+    for (int r = 0; r < reps; ++r)
+        for (int i = 0; i < width; ++i)
+        {
+            auto key = "wide/token-" + std::to_string (i);
+            ASSERT_NE (nullptr, frame.get_slot (key.c_str ()));
+        }
+    auto wide_time = clock::now () - start;
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    std::cout << "deep string path:   "
+              << duration_cast<microseconds>(string_time).count () << "us\n"
+              << "deep interned path: "
+              << duration_cast<microseconds>(interned_time).count () << "us\n"
+              << "wide frame:         "
+              << duration_cast<microseconds>(wide_time).count () << "us\n";
+}
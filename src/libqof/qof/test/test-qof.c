@@ -27,11 +27,13 @@
 
 extern void test_suite_qofbook();
 extern void test_suite_qofinstance();
+extern void test_suite_qofevent();
 extern void test_suite_qofobject();
 extern void test_suite_qofsession();
 extern void test_suite_gnc_date();
 extern void test_suite_qof_string_cache();
 extern void test_suite_gnc_guid ( void );
+extern void test_suite_gnc_numeric ( void );
 
 int
 main (int   argc,
@@ -46,10 +48,12 @@ main (int   argc,
     test_suite_gnc_guid();
     test_suite_qofbook();
     test_suite_qofinstance();
+    test_suite_qofevent();
     test_suite_qofobject();
     test_suite_qofsession();
     test_suite_gnc_date();
     test_suite_qof_string_cache();
+    test_suite_gnc_numeric();
 
     return g_test_run( );
 }
@@ -0,0 +1,195 @@
+/********************************************************************
+ * test-qofevent.c: GLib g_test test suite for qofevent.cpp.        *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+********************************************************************/
+#include "config.h"
+#include <glib.h>
+#include <unittest-support.h>
+#include "../qof.h"
+
+static const gchar *suitename = "/qof/qofevent";
+void test_suite_qofevent ( void );
+
+#define TYPE_A "test-event-a"
+#define TYPE_B "test-event-b"
+
+typedef struct
+{
+    QofBook *book;
+    QofInstance *a;
+    QofInstance *b;
+} Fixture;
+
+/* One record per handler call: which handler, for what. */
+typedef struct
+{
+    gint tag;
+    QofInstance *inst;
+    QofEventId event;
+} EventRecord;
+
+static GArray *received = NULL;
+
+static void
+record_handler (QofInstance *inst, QofEventId event_type,
+                gpointer handler_data, gpointer event_data)
+{
+    EventRecord rec;
+    rec.tag = GPOINTER_TO_INT (handler_data);
+    rec.inst = inst;
+    rec.event = event_type;
+    g_array_append_val (received, rec);
+}
+
+static EventRecord *
+record_nth (guint n)
+{
+    g_assert_cmpuint (n, <, received->len);
+    return &g_array_index (received, EventRecord, n);
+}
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    fixture->book = qof_book_new ();
+    fixture->a = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (fixture->a, TYPE_A, fixture->book);
+    fixture->b = g_object_new (QOF_TYPE_INSTANCE, NULL);
+    qof_instance_init_data (fixture->b, TYPE_B, fixture->book);
+    received = g_array_new (FALSE, FALSE, sizeof (EventRecord));
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    if (fixture->a)
+        g_object_unref (fixture->a);
+    if (fixture->b)
+        g_object_unref (fixture->b);
+    qof_book_destroy (fixture->book);
+    g_array_free (received, TRUE);
+    received = NULL;
+}
+
+static void
+test_qof_event_filtered (Fixture *fixture, gconstpointer pData)
+{
+    gint all = qof_event_register_handler (record_handler, GINT_TO_POINTER (1));
+    gint typed = qof_event_register_handler_filtered (record_handler,
+                                                      GINT_TO_POINTER (2),
+                                                      TYPE_A,
+                                                      QOF_EVENT_MODIFY);
+
+    qof_event_gen (fixture->a, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->a, QOF_EVENT_CREATE, NULL);
+    qof_event_gen (fixture->b, QOF_EVENT_MODIFY, NULL);
+
+    /* The newest handler still runs first. */
+    g_assert_cmpuint (received->len, ==, 4);
+    g_assert_cmpint (record_nth (0)->tag, ==, 2);
+    g_assert (record_nth (0)->inst == fixture->a);
+    g_assert_cmpint (record_nth (1)->tag, ==, 1);
+    g_assert_cmpint (record_nth (2)->tag, ==, 1);
+    g_assert_cmpint (record_nth (2)->event, ==, QOF_EVENT_CREATE);
+    g_assert_cmpint (record_nth (3)->tag, ==, 1);
+    g_assert (record_nth (3)->inst == fixture->b);
+
+    qof_event_unregister_handler (typed);
+    g_array_set_size (received, 0);
+    qof_event_gen (fixture->a, QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (received->len, ==, 1);
+    g_assert_cmpint (record_nth (0)->tag, ==, 1);
+
+    qof_event_unregister_handler (all);
+}
+
+static void
+test_qof_event_batch (Fixture *fixture, gconstpointer pData)
+{
+    QofEventStats stats;
+    gint data = 0;
+    gint id = qof_event_register_handler (record_handler, NULL);
+
+    qof_event_reset_stats ();
+    qof_event_begin_batch ();
+    g_assert (qof_event_in_batch ());
+    qof_event_gen (fixture->b, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->a, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->b, QOF_EVENT_MODIFY, NULL);
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->a, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->b, QOF_EVENT_ADD, NULL);
+    qof_event_end_batch ();
+    /* Events with data aren't held back, but what the instance has
+     * pending goes first so its events arrive in order. */
+    qof_event_gen (fixture->a, QOF_EVENT_REMOVE, &data);
+    g_assert_cmpuint (received->len, ==, 2);
+    g_assert (record_nth (0)->inst == fixture->a);
+    g_assert_cmpint (record_nth (0)->event, ==, QOF_EVENT_MODIFY);
+    g_assert (record_nth (1)->inst == fixture->a);
+    g_assert_cmpint (record_nth (1)->event, ==, QOF_EVENT_REMOVE);
+    qof_event_end_batch ();
+    g_assert (!qof_event_in_batch ());
+
+    /* The rest one call per event, each instance's in order. */
+    g_assert_cmpuint (received->len, ==, 4);
+    g_assert (record_nth (2)->inst == fixture->b);
+    g_assert_cmpint (record_nth (2)->event, ==, QOF_EVENT_MODIFY);
+    g_assert (record_nth (3)->inst == fixture->b);
+    g_assert_cmpint (record_nth (3)->event, ==, QOF_EVENT_ADD);
+
+    qof_event_get_stats (&stats);
+    g_assert_cmpuint (stats.generated, ==, 6);
+    g_assert_cmpuint (stats.coalesced, ==, 2);
+    g_assert_cmpuint (stats.delivered, ==, 4);
+
+    qof_event_unregister_handler (id);
+}
+
+static void
+test_qof_event_batch_destroy (Fixture *fixture, gconstpointer pData)
+{
+    gint id = qof_event_register_handler (record_handler, NULL);
+
+    qof_event_begin_batch ();
+    qof_event_gen (fixture->a, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->b, QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (fixture->a, QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (received->len, ==, 2);
+    g_assert (record_nth (0)->inst == fixture->a);
+    g_assert_cmpint (record_nth (0)->event, ==, QOF_EVENT_MODIFY);
+    g_assert_cmpint (record_nth (1)->event, ==, QOF_EVENT_DESTROY);
+
+    /* A disposed instance's events are dropped. */
+    qof_event_gen (fixture->b, QOF_EVENT_CREATE, NULL);
+    g_object_unref (fixture->b);
+    fixture->b = NULL;
+    qof_event_end_batch ();
+    g_assert_cmpuint (received->len, ==, 2);
+
+    qof_event_unregister_handler (id);
+}
+
+void
+test_suite_qofevent (void)
+{
+    GNC_TEST_ADD( suitename, "qof event filtered", Fixture, NULL, setup, test_qof_event_filtered, teardown );
+    GNC_TEST_ADD( suitename, "qof event batch", Fixture, NULL, setup, test_qof_event_batch, teardown );
+    GNC_TEST_ADD( suitename, "qof event batch destroy", Fixture, NULL, setup, test_qof_event_batch_destroy, teardown );
+}
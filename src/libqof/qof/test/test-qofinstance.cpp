@@ -820,6 +820,109 @@ test_instance_get_referring_object_list_from_collection( void )
     g_object_unref( ref );
 }
 
+static void
+count_entity_cb (QofInstance *inst, gpointer user_data)
+{
+    ++*static_cast<guint*>(user_data);
+}
+
+static void
+test_collection_lookup_entity( void )
+{
+    QofIdType type = "test type";
+    const guint n_entities = 5000;
+    QofBook *book = qof_book_new();
+    QofCollection *col = qof_book_get_collection( book, type );
+    GPtrArray *insts = g_ptr_array_new();
+    GncGUID guid;
+    guint i, visited = 0;
+
+    for ( i = 0; i < n_entities; i++ )
+    {
+        auto inst = static_cast<QofInstance*>(g_object_new( QOF_TYPE_INSTANCE, NULL ));
+        qof_instance_init_data( inst, type, book );
+        g_ptr_array_add( insts, inst );
+    }
+    g_assert_cmpuint( qof_collection_count( col ), == , n_entities );
+    for ( i = 0; i < n_entities; i++ )
+    {
+        auto inst = static_cast<QofInstance*>(g_ptr_array_index( insts, i ));
+        g_assert( qof_collection_lookup_entity( col, qof_instance_get_guid( inst )) == inst );
+    }
+
+    g_test_message( "Test that changing a guid moves the entity" );
+    auto moved = static_cast<QofInstance*>(g_ptr_array_index( insts, 0 ));
+    guid = *qof_instance_get_guid( moved );
+    GncGUID new_guid;
+    guid_replace( &new_guid );
+    qof_instance_set_guid( moved, &new_guid );
+    g_assert( qof_collection_lookup_entity( col, &guid ) == NULL );
+    g_assert( qof_collection_lookup_entity( col, &new_guid ) == moved );
+    g_assert( !qof_collection_add_entity( col, moved ));
+
+    g_test_message( "Test lookups after removing every other entity" );
+    for ( i = 0; i < n_entities; i += 2 )
+        g_object_unref( g_ptr_array_index( insts, i ));
+    g_assert_cmpuint( qof_collection_count( col ), == , n_entities / 2 );
+    for ( i = 1; i < n_entities; i += 2 )
+    {
+        auto inst = static_cast<QofInstance*>(g_ptr_array_index( insts, i ));
+        g_assert( qof_collection_lookup_entity( col, qof_instance_get_guid( inst )) == inst );
+    }
+    guid_replace( &guid );
+    g_assert( qof_collection_lookup_entity( col, &guid ) == NULL );
+    g_assert( qof_collection_lookup_entity( col, guid_null() ) == NULL );
+    qof_collection_foreach( col, count_entity_cb, &visited );
+    g_assert_cmpuint( visited, == , n_entities / 2 );
+
+    for ( i = 1; i < n_entities; i += 2 )
+        g_object_unref( g_ptr_array_index( insts, i ));
+    g_assert_cmpuint( qof_collection_count( col ), == , 0 );
+    g_ptr_array_free( insts, TRUE );
+    qof_book_destroy( book );
+}
+
+static void
+test_collection_lookup_perf( void )
+{
+    QofIdType type = "test type";
+    const guint n_entities = 500000, n_lookups = 5000000;
+    QofBook *book = qof_book_new();
+    QofCollection *col = qof_book_get_collection( book, type );
+    GPtrArray *insts = g_ptr_array_new();
+    GncGUID *guids = g_new( GncGUID, n_lookups );
+    guint i, found = 0;
+
+    for ( i = 0; i < n_entities; i++ )
+    {
+        auto inst = static_cast<QofInstance*>(g_object_new( QOF_TYPE_INSTANCE, NULL ));
+        qof_instance_init_data( inst, type, book );
+        g_ptr_array_add( insts, inst );
+    }
+    /* Half of the lookups hit. */
+    for ( i = 0; i < n_lookups; i++ )
+    {
+        if ( i % 2 )
+            guid_replace( &guids[i] );
+        else
+            guids[i] = *qof_instance_get_guid( static_cast<QofInstance*>(
+                           g_ptr_array_index( insts, g_test_rand_int_range( 0, n_entities ))));
+    }
+
+    g_test_timer_start();
+    for ( i = 0; i < n_lookups; i++ )
+        if ( qof_collection_lookup_entity( col, &guids[i] ))
+            ++found;
+    g_test_minimized_result( g_test_timer_elapsed(),
+                             "%u lookups in %u entities", n_lookups, n_entities );
+    g_assert_cmpuint( found, == , n_lookups / 2 );
+
+    g_ptr_array_foreach( insts, (GFunc) g_object_unref, NULL );
+    g_ptr_array_free( insts, TRUE );
+    g_free( guids );
+    qof_book_destroy( book );
+}
+
 static struct
 {
     gpointer inst;
@@ -1054,4 +1157,7 @@ test_suite_qofinstance ( void )
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list from collection", test_instance_get_referring_object_list_from_collection );
     GNC_TEST_ADD_FUNC( suitename, "instance get typed referring object list", test_instance_get_typed_referring_object_list);
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list", test_instance_get_referring_object_list );
+    GNC_TEST_ADD_FUNC( suitename, "collection lookup entity", test_collection_lookup_entity );
+    if ( g_test_perf() )
+        GNC_TEST_ADD_FUNC( suitename, "collection lookup perf", test_collection_lookup_perf );
 }